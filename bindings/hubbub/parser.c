@@ -52,10 +52,17 @@ struct dom_hubbub_parser {
 	dom_script script;      /**< Script callback function */
 
 	void *mctx;		/**< Pointer to client data */
+
+	bool suppress_mutation_events;
+			/**< Whether to skip mutation events while parsing */
+	bool mutation_events;
+			/**< Whether the document dispatched mutation events
+			 * before parsing began */
 };
 
 /* Forward declaration to break reference loop */
-static hubbub_error add_attributes(void *parser, void *node,
+static hubbub_error init_attributes(dom_hubbub_parser *dom_parser,
+		struct dom_element *element,
 		const hubbub_attribute *attributes, uint32_t n_attributes);
 
 
@@ -73,7 +80,8 @@ static hubbub_error create_comment(void *parser, const hubbub_string *data,
 
 	*result = NULL;
 
-	err = dom_string_create(data->ptr, data->len, &str);
+	err = _dom_string_create_in_document(dom_parser->doc,
+			data->ptr, data->len, &str);
 	if (err != DOM_NO_ERR) {
 		dom_parser->msg(DOM_MSG_CRITICAL, dom_parser->mctx,
 				"Can't create comment node text");
@@ -223,10 +231,12 @@ static hubbub_error create_element(void *parser, const hubbub_tag *tag,
 	assert(element != NULL);
 
 	if (tag->n_attributes > 0) {
-		herr = add_attributes(parser, element, tag->attributes,
+		herr = init_attributes(dom_parser, element, tag->attributes,
 				tag->n_attributes);
-		if (herr != HUBBUB_OK)
+		if (herr != HUBBUB_OK) {
+			dom_node_unref(element);
 			goto clean1;
+		}
 	}
 
 	/* Now do some special per-element-type handling */
@@ -286,7 +296,8 @@ static hubbub_error create_text(void *parser, const hubbub_string *data,
 
 	*result = NULL;
 
-	err = dom_string_create(data->ptr, data->len, &str);
+	err = _dom_string_create_in_document(dom_parser->doc,
+			data->ptr, data->len, &str);
 	if (err != DOM_NO_ERR) {
 		dom_parser->msg(DOM_MSG_CRITICAL, dom_parser->mctx,
 				"Can't create text '%.*s'", data->len,
@@ -576,7 +587,8 @@ static hubbub_error add_attributes(void *parser, void *node,
 			goto fail;
 		}
 
-		err = dom_string_create(attributes[i].value.ptr,
+		err = _dom_string_create_in_document(dom_parser->doc,
+				attributes[i].value.ptr,
 				attributes[i].value.len, &value);
 		if (err != DOM_NO_ERR) {
 			dom_parser->msg(DOM_MSG_CRITICAL, dom_parser->mctx,
@@ -617,6 +629,124 @@ fail:
 	return HUBBUB_UNKNOWN;
 }
 
+/** The number of attributes init_attributes can handle without mallocing */
+#define INIT_ATTRIBUTES_ON_STACK 16
+
+/**
+ * Give a newly created element the attributes of its start tag
+ *
+ * \param dom_parser    The parser
+ * \param element       The element, which has no attributes yet
+ * \param attributes    The attributes
+ * \param n_attributes  The number of attributes
+ * \return HUBBUB_OK on success, appropriate error otherwise
+ *
+ * Hubbub has already dropped any duplicate attributes from the tag, so
+ * the element's attributes can be built in one go, rather than added one
+ * at a time as add_attributes() must.
+ */
+static hubbub_error init_attributes(dom_hubbub_parser *dom_parser,
+		struct dom_element *element,
+		const hubbub_attribute *attributes, uint32_t n_attributes)
+{
+	dom_string *stack[3 * INIT_ATTRIBUTES_ON_STACK];
+	dom_string **names = stack, **values, **namespaces;
+	hubbub_error herr = HUBBUB_OK;
+	dom_exception err;
+	uint32_t i, n = 0;
+
+	if (n_attributes > INIT_ATTRIBUTES_ON_STACK) {
+		names = malloc(3 * n_attributes * sizeof(dom_string *));
+		if (names == NULL) {
+			dom_parser->msg(DOM_MSG_CRITICAL, dom_parser->mctx,
+					"No memory for attributes");
+			return HUBBUB_NOMEM;
+		}
+	}
+	values = names + n_attributes;
+	namespaces = values + n_attributes;
+
+	for (n = 0; n < n_attributes; n++) {
+		const hubbub_attribute *attr = &attributes[n];
+
+		err = dom_string_create_interned(attr->name.ptr,
+				attr->name.len, &names[n]);
+		if (err != DOM_NO_ERR) {
+			dom_parser->msg(DOM_MSG_CRITICAL, dom_parser->mctx,
+					"Can't create attribute name");
+			herr = HUBBUB_UNKNOWN;
+			goto cleanup;
+		}
+
+		/* Un-namespaced names are set in lower case, as they would
+		 * be by dom_element_set_attribute.  Only the names of some
+		 * foreign attributes are in mixed case. */
+		if (attr->ns == HUBBUB_NS_NULL) {
+			size_t c;
+
+			for (c = 0; c < attr->name.len; c++) {
+				if (attr->name.ptr[c] >= 'A' &&
+						attr->name.ptr[c] <= 'Z')
+					break;
+			}
+
+			if (c < attr->name.len) {
+				dom_string *lower;
+
+				err = dom_string_tolower(names[n], true,
+						&lower);
+				if (err != DOM_NO_ERR) {
+					dom_string_unref(names[n]);
+					dom_parser->msg(DOM_MSG_CRITICAL,
+							dom_parser->mctx,
+							"Can't create "
+							"attribute name");
+					herr = HUBBUB_UNKNOWN;
+					goto cleanup;
+				}
+				dom_string_unref(names[n]);
+				names[n] = lower;
+			}
+		}
+
+		err = _dom_string_create_in_document(dom_parser->doc,
+				attr->value.ptr, attr->value.len, &values[n]);
+		if (err != DOM_NO_ERR) {
+			dom_parser->msg(DOM_MSG_CRITICAL, dom_parser->mctx,
+					"Can't create attribute value");
+			dom_string_unref(names[n]);
+			herr = HUBBUB_UNKNOWN;
+			goto cleanup;
+		}
+
+		namespaces[n] = attr->ns == HUBBUB_NS_NULL ? NULL :
+				dom_namespaces[attr->ns];
+	}
+
+	err = dom_element_init_attributes(element, n_attributes, names,
+			values, namespaces);
+	if (err == DOM_INVALID_CHARACTER_ERR) {
+		/* The others were added; drop those with bad names */
+		dom_parser->msg(DOM_MSG_WARNING, dom_parser->mctx,
+				"Ignoring attributes with invalid names");
+	} else if (err != DOM_NO_ERR) {
+		dom_parser->msg(DOM_MSG_CRITICAL, dom_parser->mctx,
+				"Can't add attributes");
+		herr = HUBBUB_UNKNOWN;
+	}
+
+cleanup:
+	for (i = 0; i < n; i++) {
+		dom_string_unref(names[i]);
+		dom_string_unref(values[i]);
+	}
+
+	if (names != stack)
+		free(names);
+
+	return herr;
+}
+
 static hubbub_error set_quirks_mode(void *parser, hubbub_quirks_mode mode)
 {
 	dom_hubbub_parser *dom_parser = (dom_hubbub_parser *) parser;
@@ -681,8 +811,16 @@ static hubbub_error complete_script(void *parser, void *script)
 	dom_hubbub_parser *dom_parser = (dom_hubbub_parser *) parser;
 	dom_hubbub_error err;
 
+	/* Changes made by scripts are not the parser's */
+	if (dom_parser->suppress_mutation_events)
+		dom_document_set_mutation_events(dom_parser->doc,
+				dom_parser->mutation_events);
+
 	err = dom_parser->script(dom_parser->mctx, (struct dom_node *)script);
 
+	if (dom_parser->suppress_mutation_events)
+		dom_document_set_mutation_events(dom_parser->doc, false);
+
 	if (err == DOM_HUBBUB_OK) {
 		return HUBBUB_OK;
 	}
@@ -738,6 +876,33 @@ dom_hubbub_parser_default_script(void *ctx, struct dom_node *node)
 	return DOM_HUBBUB_OK;
 }
 
+/**
+ * Stop the document dispatching mutation events, if requested
+ *
+ * \param parser  The parser object
+ */
+static void dom_hubbub_parser_suppress_events(dom_hubbub_parser *parser)
+{
+	if (parser->suppress_mutation_events) {
+		dom_document_get_mutation_events(parser->doc,
+				&parser->mutation_events);
+		dom_document_set_mutation_events(parser->doc, false);
+	}
+}
+
+/**
+ * Restore the document's dispatch of mutation events
+ *
+ * \param parser  The parser object
+ */
+static void dom_hubbub_parser_restore_events(dom_hubbub_parser *parser)
+{
+	if (parser->suppress_mutation_events) {
+		dom_document_set_mutation_events(parser->doc,
+				parser->mutation_events);
+	}
+}
+
 /**
  * Create a Hubbub parser instance
  *
@@ -791,6 +956,9 @@ dom_hubbub_parser_create(dom_hubbub_parser_params *params,
 	}
 	binding->mctx = params->ctx;
 
+	binding->suppress_mutation_events = false;
+	binding->mutation_events = true;
+
 	/* ensure script function is valid or use the default */
 	if (params->script == NULL) {
 		binding->script = dom_hubbub_parser_default_script;
@@ -922,6 +1090,9 @@ dom_hubbub_fragment_parser_create(dom_hubbub_parser_params *params,
 	}
 	binding->mctx = params->ctx;
 
+	binding->suppress_mutation_events = false;
+	binding->mutation_events = true;
+
 	/* ensure script function is valid or use the default */
 	if (params->script == NULL) {
 		binding->script = dom_hubbub_parser_default_script;
@@ -1021,7 +1192,9 @@ dom_hubbub_error dom_hubbub_parser_parse_chunk(dom_hubbub_parser *parser,
 {
 	hubbub_error err;
 
+	dom_hubbub_parser_suppress_events(parser);
 	err = hubbub_parser_parse_chunk(parser->parser, data, len);
+	dom_hubbub_parser_restore_events(parser);
 	if (err != HUBBUB_OK)
 		return DOM_HUBBUB_HUBBUB_ERR | err;
 
@@ -1040,7 +1213,9 @@ dom_hubbub_error dom_hubbub_parser_completed(dom_hubbub_parser *parser)
 {
 	hubbub_error err;
 
+	dom_hubbub_parser_suppress_events(parser);
 	err = hubbub_parser_completed(parser->parser);
+	dom_hubbub_parser_restore_events(parser);
 	if (err != HUBBUB_OK) {
 		parser->msg(DOM_MSG_ERROR, parser->mctx,
 				"hubbub_parser_completed failed: %d", err);
@@ -1088,3 +1263,20 @@ dom_hubbub_error dom_hubbub_parser_pause(dom_hubbub_parser *parser, bool pause)
 
 	return DOM_HUBBUB_OK;
 }
+
+/**
+ * Control whether mutation events are dispatched while parsing
+ *
+ * \param parser    The parser object
+ * \param suppress  Whether to skip mutation events for changes made to
+ *                  the document by the parser
+ *
+ * Mutation events are dispatched by default.  Changes made by scripts run
+ * by the script callback always dispatch them.  This must not be called
+ * from within a parser callback.
+ */
+void dom_hubbub_parser_suppress_mutation_events(dom_hubbub_parser *parser,
+		bool suppress)
+{
+	parser->suppress_mutation_events = suppress;
+}
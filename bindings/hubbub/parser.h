@@ -104,4 +104,8 @@ const char *dom_hubbub_parser_get_encoding(dom_hubbub_parser *parser,
  */
 dom_hubbub_error dom_hubbub_parser_pause(dom_hubbub_parser *parser, bool pause);
 
+/* Control whether mutation events are dispatched while parsing */
+void dom_hubbub_parser_suppress_mutation_events(dom_hubbub_parser *parser,
+		bool suppress);
+
 #endif
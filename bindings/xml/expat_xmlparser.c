@@ -29,10 +29,119 @@ struct dom_xml_parser {
 	struct dom_document *doc;	/**< DOM Document we're building */
 	struct dom_node *current;	/**< DOM node we're currently building */
 	bool is_cdata;			/**< If the character data is cdata or text */
+	bool suppress_mutation_events;	/**< Whether to skip mutation events
+					 * while parsing */
+	bool mutation_events;		/**< Whether the document dispatched
+					 * mutation events before parsing */
 };
 
 /* Binding functions */
 
+/**
+ * Stop the document dispatching mutation events, if requested
+ *
+ * \param parser  The XML parser instance
+ */
+static void
+expat_xmlparser_suppress_events(dom_xml_parser *parser)
+{
+	if (parser->suppress_mutation_events) {
+		dom_document_get_mutation_events(parser->doc,
+						 &parser->mutation_events);
+		dom_document_set_mutation_events(parser->doc, false);
+	}
+}
+
+/**
+ * Restore the document's dispatch of mutation events
+ *
+ * \param parser  The XML parser instance
+ */
+static void
+expat_xmlparser_restore_events(dom_xml_parser *parser)
+{
+	if (parser->suppress_mutation_events) {
+		dom_document_set_mutation_events(parser->doc,
+						 parser->mutation_events);
+	}
+}
+
+/**
+ * Give a newly created element its attributes
+ *
+ * \param elem  The element, which has no attributes yet
+ * \param atts  NULL-terminated array of attribute name, value pairs
+ * \return DOM_NO_ERR on success, appropriate error otherwise
+ *
+ * expat rejects documents with duplicate attributes, so the element's
+ * attributes can be built in one go.
+ */
+static dom_exception
+expat_xmlparser_init_attributes(dom_element *elem, const XML_Char **atts)
+{
+	dom_exception err = DOM_NO_ERR;
+	dom_string **names, **values, **namespaces;
+	const XML_Char *ns_sep;
+	uint32_t i, n, n_atts = 0;
+
+	while (atts[2 * n_atts] != NULL)
+		n_atts++;
+
+	names = malloc(3 * n_atts * sizeof(dom_string *));
+	if (names == NULL)
+		return DOM_NO_MEM_ERR;
+	values = names + n_atts;
+	namespaces = values + n_atts;
+
+	for (n = 0; n < n_atts; n++) {
+		const XML_Char *name = atts[2 * n];
+		const XML_Char *value = atts[2 * n + 1];
+
+		namespaces[n] = NULL;
+		ns_sep = strchr(name, '\n');
+		if (ns_sep != NULL) {
+			err = dom_string_create_interned((const uint8_t *)name,
+							 ns_sep - name,
+							 &namespaces[n]);
+			if (err != DOM_NO_ERR)
+				break;
+			name = ns_sep + 1;
+		}
+
+		err = dom_string_create_interned((const uint8_t *)name,
+						 strlen(name), &names[n]);
+		if (err != DOM_NO_ERR) {
+			if (namespaces[n] != NULL)
+				dom_string_unref(namespaces[n]);
+			break;
+		}
+
+		err = dom_string_create((const uint8_t *)value,
+					strlen(value), &values[n]);
+		if (err != DOM_NO_ERR) {
+			if (namespaces[n] != NULL)
+				dom_string_unref(namespaces[n]);
+			dom_string_unref(names[n]);
+			break;
+		}
+	}
+
+	if (err == DOM_NO_ERR)
+		err = dom_element_init_attributes(elem, n_atts, names, values,
+						  namespaces);
+
+	for (i = 0; i < n; i++) {
+		if (namespaces[i] != NULL)
+			dom_string_unref(namespaces[i]);
+		dom_string_unref(names[i]);
+		dom_string_unref(values[i]);
+	}
+
+	free(names);
+
+	return err;
+}
+
 static void
 expat_xmlparser_start_element_handler(void *_parser,
 				      const XML_Char *name,
@@ -90,63 +199,17 @@ expat_xmlparser_start_element_handler(void *_parser,
 		dom_string_unref(namespace);
 
 	/* Add attributes to the element */
-	while (*atts) {
-		dom_string *key, *value;
-		ns_sep = strchr(*atts, '\n');
-		if (ns_sep != NULL) {
-			err = dom_string_create_interned((const uint8_t *)(*atts),
-							 ns_sep - (*atts),
-							 &namespace);
-			if (err != DOM_NO_ERR) {
-				parser->msg(DOM_MSG_CRITICAL, parser->mctx,
-					    "No memory for attr namespace");
-				dom_node_unref(elem);
-				return;
-			}
-		} else
-			namespace = NULL;
-		if (ns_sep == NULL)
-			err = dom_string_create_interned((const uint8_t *)(*atts),
-							 strlen(*atts), &key);
-		else
-			err = dom_string_create_interned((const uint8_t *)(ns_sep + 1),
-							 strlen(ns_sep + 1),
-							 &key);
-		if (err != DOM_NO_ERR) {
-			parser->msg(DOM_MSG_CRITICAL, parser->mctx,
-				    "No memory for attribute name");
-			if (namespace != NULL)
-				dom_string_unref(namespace);
-			dom_node_unref(elem);
-			return;
-		}
-		atts++;
-		err = dom_string_create((const uint8_t *)(*atts),
-					strlen(*atts), &value);
-		if (err != DOM_NO_ERR) {
+	if (*atts != NULL) {
+		err = expat_xmlparser_init_attributes(elem, atts);
+		if (err == DOM_INVALID_CHARACTER_ERR) {
+			/* The others were added; drop those with bad names */
+			parser->msg(DOM_MSG_WARNING, parser->mctx,
+				    "Ignoring attributes of '%s' with invalid "
+				    "names", name);
+		} else if (err != DOM_NO_ERR) {
 			dom_node_unref(elem);
-			if (namespace != NULL)
-				dom_string_unref(namespace);
-			dom_string_unref(key);
 			parser->msg(DOM_MSG_CRITICAL, parser->mctx,
-				    "No memory for attribute value");
-			return;
-		}
-		atts++;
-
-		if (namespace == NULL)
-			err = dom_element_set_attribute(elem, key, value);
-		else
-			err = dom_element_set_attribute_ns(elem, namespace,
-							   key, value);
-	        if (namespace != NULL)
-			dom_string_unref(namespace);
-		dom_string_unref(key);
-		dom_string_unref(value);
-		if (err != DOM_NO_ERR) {
-			dom_node_unref(elem);
-			parser->msg(DOM_MSG_CRITICAL, parser->mctx,
-				    "No memory for setting attribute");
+				    "No memory for setting attributes");
 			return;
 		}
 	}
@@ -585,7 +648,9 @@ dom_xml_parser_parse_chunk(dom_xml_parser *parser, uint8_t *data, size_t len)
 {
 	enum XML_Status status;
 
+	expat_xmlparser_suppress_events(parser);
 	status = XML_Parse(parser->parser, (const char *)data, len, 0);
+	expat_xmlparser_restore_events(parser);
 	if (status != XML_STATUS_OK) {
 		parser->msg(DOM_MSG_ERROR, parser->mctx,
 			    "XML_Parse failed: %d", status);
@@ -608,7 +673,9 @@ dom_xml_parser_completed(dom_xml_parser *parser)
 {
 	enum XML_Status status;
 
+	expat_xmlparser_suppress_events(parser);
 	status = XML_Parse(parser->parser, "", 0, 1);
+	expat_xmlparser_restore_events(parser);
 	if (status != XML_STATUS_OK) {
 		parser->msg(DOM_MSG_ERROR, parser->mctx,
 			    "XML_Parse failed: %d", status);
@@ -618,3 +685,18 @@ dom_xml_parser_completed(dom_xml_parser *parser)
 	return DOM_XML_OK;
 
 }
+
+/**
+ * Control whether mutation events are dispatched while parsing
+ *
+ * \param parser    The XML parser instance
+ * \param suppress  Whether to skip mutation events for changes made to
+ *                  the document by the parser
+ *
+ * Mutation events are dispatched by default.
+ */
+void
+dom_xml_parser_suppress_mutation_events(dom_xml_parser *parser, bool suppress)
+{
+	parser->suppress_mutation_events = suppress;
+}
@@ -40,6 +40,8 @@ static void xml_parser_add_node(dom_xml_parser *parser, struct dom_node *parent,
 		xmlNodePtr child);
 static void xml_parser_add_element_node(dom_xml_parser *parser,
 		struct dom_node *parent, xmlNodePtr child);
+static dom_exception xml_parser_init_attributes(struct dom_element *el,
+		xmlNodePtr child);
 static void xml_parser_add_text_node(dom_xml_parser *parser,
 		struct dom_node *parent, xmlNodePtr child);
 static void xml_parser_add_cdata_section(dom_xml_parser *parser,
@@ -53,6 +55,9 @@ static void xml_parser_add_comment(dom_xml_parser *parser,
 static void xml_parser_add_document_type(dom_xml_parser *parser,
 		struct dom_node *parent, xmlNodePtr child);
 
+static void xml_parser_suppress_events(dom_xml_parser *parser);
+static void xml_parser_restore_events(dom_xml_parser *parser);
+
 static void xml_parser_internal_subset(void *ctx, const xmlChar *name,
 		const xmlChar *ExternalID, const xmlChar *SystemID);
 static int xml_parser_is_standalone(void *ctx);
@@ -92,10 +97,16 @@ struct dom_xml_parser {
 
 	struct dom_document *doc;	/**< DOM Document we're building */
 
-	dom_string *udkey;	/**< Key for DOM node user data */
+	uint32_t udslot;	/**< Slot for DOM node user data */
 
 	dom_msg msg;		/**< Informational message function */
 	void *mctx;		/**< Pointer to client data */
+
+	bool suppress_mutation_events;
+			/**< Whether to skip mutation events while parsing */
+	bool mutation_events;
+			/**< Whether the document dispatched mutation events
+			 * before parsing began */
 };
 
 /**
@@ -168,6 +179,7 @@ dom_xml_parser *dom_xml_parser_create(const char *enc, const char *int_enc,
 		dom_msg msg, void *mctx, dom_document **document)
 {
 	dom_xml_parser *parser;
+	dom_string *udkey;
 	dom_exception err;
 	int ret;
 
@@ -200,7 +212,17 @@ dom_xml_parser *dom_xml_parser_create(const char *enc, const char *int_enc,
 
 	/* Create key for user data registration */
 	err = dom_string_create((const uint8_t *) "__xmlnode", 
-			SLEN("__xmlnode"), &parser->udkey);
+			SLEN("__xmlnode"), &udkey);
+	if (err != DOM_NO_ERR) {
+		xmlFreeParserCtxt(parser->xml_ctx);
+		dom_xml_alloc(parser, 0, NULL);
+		msg(DOM_MSG_CRITICAL, mctx, "No memory for userdata key");
+		return NULL;
+	}
+
+	/* And get its slot, which is the same for every parser */
+	err = dom_node_register_user_data_key(udkey, &parser->udslot);
+	dom_string_unref(udkey);
 	if (err != DOM_NO_ERR) {
 		xmlFreeParserCtxt(parser->xml_ctx);
 		dom_xml_alloc(parser, 0, NULL);
@@ -219,7 +241,6 @@ dom_xml_parser *dom_xml_parser_create(const char *enc, const char *int_enc,
 
 	if (err != DOM_NO_ERR) {
 		xmlFreeParserCtxt(parser->xml_ctx);
-		dom_string_unref(parser->udkey);
 		dom_xml_alloc(parser, 0, NULL);
 		parser->msg(DOM_MSG_CRITICAL, parser->mctx,
 				"Failed creating document");
@@ -231,6 +252,9 @@ dom_xml_parser *dom_xml_parser_create(const char *enc, const char *int_enc,
 	parser->msg = msg;
 	parser->mctx = mctx;
 
+	parser->suppress_mutation_events = false;
+	parser->mutation_events = true;
+
 	return parser;
 }
 
@@ -241,7 +265,6 @@ dom_xml_parser *dom_xml_parser_create(const char *enc, const char *int_enc,
  */
 void dom_xml_parser_destroy(dom_xml_parser *parser)
 {
-	dom_string_unref(parser->udkey);
 	dom_node_unref(parser->doc);
 
 	xmlFreeDoc(parser->xml_ctx->myDoc);
@@ -264,7 +287,9 @@ dom_xml_error dom_xml_parser_parse_chunk(dom_xml_parser *parser,
 {
 	xmlParserErrors err;
 
+	xml_parser_suppress_events(parser);
 	err = xmlParseChunk(parser->xml_ctx, (char *) data, len, 0);
+	xml_parser_restore_events(parser);
 	if (err != XML_ERR_OK) {
 		parser->msg(DOM_MSG_ERROR, parser->mctx, 
 				"xmlParseChunk failed: %d", err);
@@ -286,7 +311,9 @@ dom_xml_error dom_xml_parser_completed(dom_xml_parser *parser)
 {
 	xmlParserErrors err;
 
+	xml_parser_suppress_events(parser);
 	err = xmlParseChunk(parser->xml_ctx, "", 0, 1);
+	xml_parser_restore_events(parser);
 	if (err != XML_ERR_OK) {
 		parser->msg(DOM_MSG_ERROR, parser->mctx,
 				"xmlParseChunk failed: %d", err);
@@ -296,6 +323,48 @@ dom_xml_error dom_xml_parser_completed(dom_xml_parser *parser)
 	return DOM_XML_OK;
 }
 
+/**
+ * Control whether mutation events are dispatched while parsing
+ *
+ * \param parser    The XML parser instance
+ * \param suppress  Whether to skip mutation events for changes made to
+ *                  the document by the parser
+ *
+ * Mutation events are dispatched by default.
+ */
+void dom_xml_parser_suppress_mutation_events(dom_xml_parser *parser,
+		bool suppress)
+{
+	parser->suppress_mutation_events = suppress;
+}
+
+/**
+ * Stop the document dispatching mutation events, if requested
+ *
+ * \param parser  The XML parser instance
+ */
+void xml_parser_suppress_events(dom_xml_parser *parser)
+{
+	if (parser->suppress_mutation_events) {
+		dom_document_get_mutation_events(parser->doc,
+				&parser->mutation_events);
+		dom_document_set_mutation_events(parser->doc, false);
+	}
+}
+
+/**
+ * Restore the document's dispatch of mutation events
+ *
+ * \param parser  The XML parser instance
+ */
+void xml_parser_restore_events(dom_xml_parser *parser)
+{
+	if (parser->suppress_mutation_events) {
+		dom_document_set_mutation_events(parser->doc,
+				parser->mutation_events);
+	}
+}
+
 /**
  * Handle a document start SAX event
  *
@@ -344,8 +413,8 @@ void xml_parser_end_document(void *ctx)
 	 * children which occur after the last Element node in the list */
 
 	/* Get XML node */
-	err = dom_node_get_user_data((struct dom_node *) parser->doc,
-			parser->udkey, (void **) (void *) &node);
+	err = dom_node_get_user_data_slot((struct dom_node *) parser->doc,
+			parser->udslot, (void **) (void *) &node);
 	if (err != DOM_NO_ERR) {
 		parser->msg(DOM_MSG_WARNING, parser->mctx,
 				"Failed finding XML node");
@@ -523,7 +592,7 @@ dom_exception xml_parser_link_nodes(dom_xml_parser *parser,
 	dom_exception err;
 
 	/* Register XML node as user data for DOM node */
-	err = dom_node_set_user_data(dom, parser->udkey, xml, NULL,
+	err = dom_node_set_user_data_slot(dom, parser->udslot, xml, NULL,
 			&prev_data);
 	if (err != DOM_NO_ERR) {
 		parser->msg(DOM_MSG_ERROR, parser->mctx,
@@ -700,8 +769,24 @@ void xml_parser_add_element_node(dom_xml_parser *parser,
 		dom_string_unref(qname);
 	}
 
-	/* Add attributes to created element */
-	for (a = child->properties; a != NULL; a = a->next) {
+	/* Give the element its attributes in one go, if possible */
+	err = xml_parser_init_attributes(el, child);
+	if (err == DOM_INVALID_CHARACTER_ERR) {
+		/* The others were added; drop those with bad names */
+		parser->msg(DOM_MSG_WARNING, parser->mctx,
+				"Ignoring attributes of '%s' with invalid names",
+				child->name);
+		err = DOM_NO_ERR;
+	} else if (err != DOM_NO_ERR && err != DOM_NOT_SUPPORTED_ERR) {
+		parser->msg(DOM_MSG_CRITICAL, parser->mctx,
+				"Failed adding attributes to '%s'",
+				child->name);
+		goto cleanup;
+	}
+
+	/* Otherwise, add attributes to created element one by one */
+	for (a = err == DOM_NO_ERR ? NULL : child->properties; a != NULL;
+			a = a->next) {
 		struct dom_attr *attr, *prev_attr;
 		xmlNodePtr c;
 
@@ -871,6 +956,113 @@ cleanup:
 	return;
 }
 
+/**
+ * Give a newly created element the attributes of an xmlNode in one go
+ *
+ * \param el     The element, which has no attributes yet
+ * \param child  The xmlNode which ::el mirrors
+ * \return DOM_NO_ERR            on success,
+ *         DOM_NOT_SUPPORTED_ERR if an attribute's value is not plain text,
+ *         in which case ::el is left without attributes,
+ *         appropriate dom_exception on other failure.
+ *
+ * Attribute values containing entity references must be mirrored node by
+ * node; they are rare enough that any element with one is left to the
+ * caller.  libxml has already rejected duplicate attributes.
+ */
+dom_exception xml_parser_init_attributes(struct dom_element *el,
+		xmlNodePtr child)
+{
+	dom_string **names, **values, **namespaces;
+	dom_exception err = DOM_NO_ERR;
+	uint32_t i, n = 0, n_attributes = 0;
+	xmlAttrPtr a;
+
+	for (a = child->properties; a != NULL; a = a->next) {
+		if (a->children != NULL && (a->children->type != XML_TEXT_NODE
+				|| a->children->next != NULL))
+			return DOM_NOT_SUPPORTED_ERR;
+
+		n_attributes++;
+	}
+
+	if (n_attributes == 0)
+		return DOM_NO_ERR;
+
+	names = malloc(3 * n_attributes * sizeof(dom_string *));
+	if (names == NULL)
+		return DOM_NO_MEM_ERR;
+	values = names + n_attributes;
+	namespaces = values + n_attributes;
+
+	for (a = child->properties; a != NULL; a = a->next, n++) {
+		const xmlChar *value = a->children != NULL ?
+				a->children->content : NULL;
+
+		namespaces[n] = NULL;
+
+		if (a->ns == NULL) {
+			err = dom_string_create(a->name,
+					strlen((const char *) a->name),
+					&names[n]);
+		} else {
+			size_t qnamelen = (a->ns->prefix != NULL ?
+				strlen((const char *) a->ns->prefix) : 0) +
+				(a->ns->prefix != NULL ? 1 : 0) /* ':' */ +
+				strlen((const char *) a->name);
+			uint8_t qnamebuf[qnamelen + 1 /* '\0' */];
+
+			err = dom_string_create(a->ns->href,
+					strlen((const char *) a->ns->href),
+					&namespaces[n]);
+			if (err != DOM_NO_ERR)
+				break;
+
+			/* QName is "prefix:localname",
+			 * or "localname" if there is no prefix */
+			sprintf((char *) qnamebuf, "%s%s%s",
+				a->ns->prefix != NULL ?
+					(const char *) a->ns->prefix : "",
+				a->ns->prefix != NULL ? ":" : "",
+				(const char *) a->name);
+
+			err = dom_string_create(qnamebuf, qnamelen,
+					&names[n]);
+		}
+		if (err != DOM_NO_ERR) {
+			if (namespaces[n] != NULL)
+				dom_string_unref(namespaces[n]);
+			break;
+		}
+
+		err = dom_string_create(value != NULL ? value :
+					(const xmlChar *) "",
+				value != NULL ? strlen((const char *) value) : 0,
+				&values[n]);
+		if (err != DOM_NO_ERR) {
+			if (namespaces[n] != NULL)
+				dom_string_unref(namespaces[n]);
+			dom_string_unref(names[n]);
+			break;
+		}
+	}
+
+	if (err == DOM_NO_ERR)
+		err = dom_element_init_attributes(el, n_attributes, names,
+				values, namespaces);
+
+	for (i = 0; i < n; i++) {
+		if (namespaces[i] != NULL)
+			dom_string_unref(namespaces[i]);
+		dom_string_unref(names[i]);
+		dom_string_unref(values[i]);
+	}
+
+	free(names);
+
+	return err;
+}
+
 /**
  * Add a text node to the DOM
  *
@@ -8,6 +8,7 @@
 #ifndef xml_xmlparser_h_
 #define xml_xmlparser_h_
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <inttypes.h>
 
@@ -31,4 +32,8 @@ dom_xml_error dom_xml_parser_parse_chunk(dom_xml_parser *parser,
 /* Notify parser that datastream is empty */
 dom_xml_error dom_xml_parser_completed(dom_xml_parser *parser);
 
+/* Control whether mutation events are dispatched while parsing */
+void dom_xml_parser_suppress_mutation_events(dom_xml_parser *parser,
+		bool suppress);
+
 #endif
@@ -0,0 +1,265 @@
+/*
+ * This file is part of LibDOM.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+/*
+ * Time how quickly LibDOM can walk a document to fill HTML collections.
+ *
+ * A document holding a large table is built, with a link in each row and
+ * an image and a few plain elements in each cell.  A fresh collection is
+ * then made and counted the requested number of times, so that each count
+ * is a full walk of the collection's root, testing every element found.
+ * The throughput reported is the number of elements tested per second.
+ *
+ * Usage:
+ *      collection-benchmark [-n iterations] [rows]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <dom/dom.h>
+
+
+/**
+ * A collection getter under test
+ */
+struct benchmark {
+	const char *name;	/**< The collection's name */
+	dom_exception (*get)(dom_html_document *doc,
+			dom_html_collection **col);
+				/**< Function to make the collection */
+};
+
+/**
+ * Get the current time, in seconds
+ *
+ * \return the time from an arbitrary fixed point
+ */
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Create an element and append it to a parent
+ *
+ * \param doc     The document
+ * \param parent  The node to append the element to
+ * \param name    The element's tag name
+ * \param result  Updated to the new element, which the caller must unref
+ * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
+ */
+static dom_exception append(dom_document *doc, dom_node *parent,
+		const char *name, dom_element **result)
+{
+	dom_string *tag;
+	dom_element *element;
+	dom_node *added;
+	dom_exception err;
+
+	err = dom_string_create((const uint8_t *) name, strlen(name), &tag);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	err = dom_document_create_element(doc, tag, &element);
+	dom_string_unref(tag);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	err = dom_node_append_child(parent, element, &added);
+	if (err != DOM_NO_ERR) {
+		dom_node_unref(element);
+		return err;
+	}
+	dom_node_unref(added);
+
+	*result = element;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Build the document to walk
+ *
+ * \param rows  The number of rows in the table
+ * \param doc   Updated to the new document
+ * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
+ */
+static dom_exception build(uint32_t rows, dom_document **doc)
+{
+	static const char *cell_content[] = { "img", "span", "b", "em" };
+	dom_element *html, *body, *table, *tbody;
+	dom_string *href, *url;
+	dom_exception err;
+	uint32_t r, c, i;
+
+	err = dom_implementation_create_document(DOM_IMPLEMENTATION_HTML,
+			NULL, "html", NULL, NULL, NULL, doc);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	err = dom_document_get_document_element(*doc, &html);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	err = append(*doc, (dom_node *) html, "body", &body);
+	dom_node_unref(html);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	err = append(*doc, (dom_node *) body, "table", &table);
+	dom_node_unref(body);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	err = append(*doc, (dom_node *) table, "tbody", &tbody);
+	dom_node_unref(table);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	err = dom_string_create((const uint8_t *) "href", 4, &href);
+	if (err != DOM_NO_ERR) {
+		dom_node_unref(tbody);
+		return err;
+	}
+
+	err = dom_string_create((const uint8_t *) "#", 1, &url);
+	if (err != DOM_NO_ERR) {
+		dom_string_unref(href);
+		dom_node_unref(tbody);
+		return err;
+	}
+
+	for (r = 0; r < rows && err == DOM_NO_ERR; r++) {
+		dom_element *tr, *td, *el;
+
+		err = append(*doc, (dom_node *) tbody, "tr", &tr);
+		if (err != DOM_NO_ERR)
+			break;
+
+		for (c = 0; c < 4 && err == DOM_NO_ERR; c++) {
+			err = append(*doc, (dom_node *) tr, "td", &td);
+			if (err != DOM_NO_ERR)
+				break;
+
+			for (i = 0; i < 4 && err == DOM_NO_ERR; i++) {
+				err = append(*doc, (dom_node *) td,
+						cell_content[i], &el);
+				if (err == DOM_NO_ERR)
+					dom_node_unref(el);
+			}
+
+			if (err == DOM_NO_ERR && c == 0) {
+				err = append(*doc, (dom_node *) td, "a", &el);
+				if (err == DOM_NO_ERR) {
+					err = dom_element_set_attribute(el,
+							href, url);
+					dom_node_unref(el);
+				}
+			}
+
+			dom_node_unref(td);
+		}
+
+		dom_node_unref(tr);
+	}
+
+	dom_string_unref(url);
+	dom_string_unref(href);
+	dom_node_unref(tbody);
+
+	return err;
+}
+
+static const struct benchmark benchmarks[] = {
+	{ "images", dom_html_document_get_images },
+	{ "links", dom_html_document_get_links },
+	{ "forms", dom_html_document_get_forms },
+};
+
+int main(int argc, char **argv)
+{
+	int iterations = 100;
+	uint32_t rows = 10000;
+	uint32_t elements;
+	dom_document *doc;
+	dom_exception err;
+	size_t b;
+	int first = 1;
+	int i;
+
+	if (first + 1 < argc && strcmp(argv[first], "-n") == 0) {
+		iterations = atoi(argv[first + 1]);
+		first += 2;
+	}
+
+	if (first < argc)
+		rows = strtoul(argv[first++], NULL, 10);
+
+	if (first != argc || iterations <= 0 || rows == 0) {
+		fprintf(stderr, "Usage: %s [-n iterations] [rows]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	err = build(rows, &doc);
+	if (err != DOM_NO_ERR) {
+		fprintf(stderr, "Can't build document: %d\n", err);
+		return EXIT_FAILURE;
+	}
+
+	/* html, body, table and tbody, and then per row a tr, and 4 td
+	 * holding 4 elements each, and a link */
+	elements = 4 + rows * (1 + 4 * 5 + 1);
+
+	printf("Document: %u rows, %u elements\n", rows, elements);
+
+	for (b = 0; b < sizeof(benchmarks) / sizeof(benchmarks[0]); b++) {
+		double start, elapsed;
+		uint32_t len = 0;
+
+		start = now();
+
+		for (i = 0; i < iterations; i++) {
+			dom_html_collection *col;
+
+			err = benchmarks[b].get((dom_html_document *) doc,
+					&col);
+			if (err != DOM_NO_ERR)
+				break;
+
+			err = dom_html_collection_get_length(col, &len);
+			dom_html_collection_unref(col);
+			if (err != DOM_NO_ERR)
+				break;
+		}
+
+		elapsed = now() - start;
+
+		if (err != DOM_NO_ERR) {
+			fprintf(stderr, "Can't walk %s: %d\n",
+					benchmarks[b].name, err);
+			break;
+		}
+
+		printf("%s: %u found, %.3f ms per walk, "
+				"%.1f M elements/s\n",
+				benchmarks[b].name, len,
+				elapsed * 1000 / iterations,
+				(double) elements * iterations / elapsed / 1e6);
+	}
+
+	dom_node_unref(doc);
+
+	return err == DOM_NO_ERR ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,279 @@
+/*
+ * This file is part of LibDOM.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+/*
+ * Time how quickly LibDOM can sort nodes into document order.
+ *
+ * A document is built with the requested number of elements, each added
+ * to one of the elements made shortly before it, so that the tree is
+ * both deep and wide.  The elements are shuffled and then sorted with
+ * qsort(), comparing them with dom_node_compare_document_position(),
+ * and the result is checked against a walk of the document.
+ *
+ * Usage:
+ *      order-benchmark [-n iterations] [nodes]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <dom/dom.h>
+
+/** Number of recently made elements which a new element may be added to */
+#define RECENT 64
+
+/** Number of comparisons made by the sorts */
+static uint64_t comparisons;
+
+/**
+ * Get the current time, in seconds
+ *
+ * \return the time from an arbitrary fixed point
+ */
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Make a pseudo-random number, the same sequence on every run
+ *
+ * \return the next number in the sequence
+ */
+static uint32_t random_next(void)
+{
+	static uint32_t state = 2463534242u;
+
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+
+	return state;
+}
+
+/**
+ * Build the document to sort the elements of
+ *
+ * \param count     The number of elements to make
+ * \param doc       Updated to the new document
+ * \param elements  Array to receive the elements, in the order made
+ * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
+ */
+static dom_exception build(uint32_t count, dom_document **doc,
+		dom_node **elements)
+{
+	static const char *names[] = { "div", "span", "p", "em" };
+	dom_element *html;
+	dom_string *tags[4];
+	dom_exception err;
+	uint32_t i;
+
+	err = dom_implementation_create_document(DOM_IMPLEMENTATION_HTML,
+			NULL, "html", NULL, NULL, NULL, doc);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	err = dom_document_get_document_element(*doc, &html);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	for (i = 0; i < 4; i++) {
+		err = dom_string_create((const uint8_t *) names[i],
+				strlen(names[i]), &tags[i]);
+		if (err != DOM_NO_ERR) {
+			while (i-- > 0)
+				dom_string_unref(tags[i]);
+			dom_node_unref(html);
+			return err;
+		}
+	}
+
+	for (i = 0; i < count && err == DOM_NO_ERR; i++) {
+		dom_node *parent, *added;
+		dom_element *element;
+
+		if (i == 0)
+			parent = (dom_node *) html;
+		else if (i < RECENT)
+			parent = elements[random_next() % i];
+		else
+			parent = elements[i - 1 - random_next() % RECENT];
+
+		err = dom_document_create_element(*doc, tags[i % 4],
+				&element);
+		if (err != DOM_NO_ERR)
+			break;
+
+		err = dom_node_append_child(parent, element, &added);
+		if (err == DOM_NO_ERR)
+			dom_node_unref(added);
+
+		/* The document holds the element once it is added */
+		elements[i] = (dom_node *) element;
+		dom_node_unref(element);
+	}
+
+	for (i = 0; i < 4; i++)
+		dom_string_unref(tags[i]);
+	dom_node_unref(html);
+
+	return err;
+}
+
+/**
+ * Compare two nodes' positions in their document, for qsort()
+ *
+ * \param a  Pointer to the first node
+ * \param b  Pointer to the second node
+ * \return negative if the first node comes first, positive otherwise.
+ */
+static int compare(const void *a, const void *b)
+{
+	dom_node *node = *(dom_node * const *) a;
+	dom_node *other = *(dom_node * const *) b;
+	uint16_t position;
+
+	comparisons++;
+
+	if (node == other)
+		return 0;
+
+	if (dom_node_compare_document_position(node, other, &position) !=
+			DOM_NO_ERR)
+		abort();
+
+	return (position & DOM_DOCUMENT_POSITION_FOLLOWING) ? -1 : 1;
+}
+
+/**
+ * Check that elements are in document order, by walking the document
+ *
+ * \param html      The root element
+ * \param elements  The elements, which are all descendants of html
+ * \param count     The number of elements
+ * \return true if the elements are in order, false otherwise.
+ */
+static bool check(dom_node *html, dom_node **elements, uint32_t count)
+{
+	dom_node *node = html, *next;
+	uint32_t i = 0;
+
+	/* The walk holds no references, as the document holds the nodes */
+	while (node != NULL) {
+		if (node != html) {
+			if (i == count || elements[i] != node)
+				return false;
+			i++;
+		}
+
+		dom_node_get_first_child(node, &next);
+		while (next == NULL && node != html) {
+			dom_node_get_next_sibling(node, &next);
+			if (next == NULL) {
+				dom_node_get_parent_node(node, &node);
+				dom_node_unref(node);
+			}
+		}
+		if (next != NULL)
+			dom_node_unref(next);
+		node = next;
+	}
+
+	return i == count;
+}
+
+int main(int argc, char **argv)
+{
+	int iterations = 10;
+	uint32_t count = 100000;
+	dom_document *doc;
+	dom_element *html;
+	dom_node **elements, **sorted;
+	dom_exception err;
+	double elapsed = 0;
+	bool ok = true;
+	int first = 1;
+	uint32_t i;
+	int n;
+
+	if (first + 1 < argc && strcmp(argv[first], "-n") == 0) {
+		iterations = atoi(argv[first + 1]);
+		first += 2;
+	}
+
+	if (first < argc)
+		count = strtoul(argv[first++], NULL, 10);
+
+	if (first != argc || iterations <= 0 || count == 0) {
+		fprintf(stderr, "Usage: %s [-n iterations] [nodes]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	elements = malloc(count * sizeof(*elements));
+	sorted = malloc(count * sizeof(*sorted));
+	if (elements == NULL || sorted == NULL) {
+		fprintf(stderr, "No memory for %u nodes\n", count);
+		return EXIT_FAILURE;
+	}
+
+	err = build(count, &doc, elements);
+	if (err != DOM_NO_ERR) {
+		fprintf(stderr, "Can't build document: %d\n", err);
+		return EXIT_FAILURE;
+	}
+
+	err = dom_document_get_document_element(doc, &html);
+	if (err != DOM_NO_ERR) {
+		fprintf(stderr, "Can't find root element: %d\n", err);
+		return EXIT_FAILURE;
+	}
+
+	printf("Document: %u elements\n", count);
+
+	for (n = 0; n < iterations && ok; n++) {
+		double start;
+
+		memcpy(sorted, elements, count * sizeof(*sorted));
+
+		/* Fisher-Yates shuffle */
+		for (i = count - 1; i > 0; i--) {
+			uint32_t j = random_next() % (i + 1);
+			dom_node *tmp = sorted[i];
+
+			sorted[i] = sorted[j];
+			sorted[j] = tmp;
+		}
+
+		start = now();
+		qsort(sorted, count, sizeof(*sorted), compare);
+		elapsed += now() - start;
+
+		ok = check((dom_node *) html, sorted, count);
+	}
+
+	if (ok) {
+		printf("%.3f ms per sort, %.1f ns per comparison\n",
+				elapsed * 1000 / iterations,
+				elapsed * 1e9 / comparisons);
+	} else {
+		fprintf(stderr, "Sort isn't in document order\n");
+	}
+
+	dom_node_unref(html);
+	dom_node_unref(doc);
+	free(sorted);
+	free(elements);
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
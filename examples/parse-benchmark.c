@@ -0,0 +1,181 @@
+/*
+ * This file is part of LibDOM.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+/*
+ * Time how long LibDOM takes to build documents from a corpus of HTML files.
+ *
+ * Each file is read into memory once, and then parsed into a fresh
+ * document with Hubbub the requested number of times.  Parsing and
+ * document destruction are both timed, as the cost of allocating and
+ * freeing nodes and strings is what this benchmark is meant to expose.
+ *
+ * Usage:
+ *      parse-benchmark [-n iterations] [-m] file.html [file.html ...]
+ *
+ * With -m, the parser is asked not to dispatch mutation events.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <dom/dom.h>
+#include <dom/bindings/hubbub/parser.h>
+
+
+/**
+ * Get the current time, in seconds
+ *
+ * \return the time from an arbitrary fixed point
+ */
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Read a file into memory
+ *
+ * \param file  The file path
+ * \param len   Updated to the length of the file
+ * \return  the file's contents, or NULL on error
+ */
+static uint8_t *load_file(const char *file, size_t *len)
+{
+	FILE *handle;
+	uint8_t *data;
+	long size;
+
+	handle = fopen(file, "rb");
+	if (handle == NULL)
+		return NULL;
+
+	fseek(handle, 0, SEEK_END);
+	size = ftell(handle);
+	fseek(handle, 0, SEEK_SET);
+
+	data = malloc(size > 0 ? size : 1);
+	if (data == NULL || fread(data, 1, size, handle) != (size_t) size) {
+		free(data);
+		fclose(handle);
+		return NULL;
+	}
+
+	fclose(handle);
+
+	*len = size;
+
+	return data;
+}
+
+/**
+ * Parse a buffer of HTML into a new document, and destroy it again
+ *
+ * \param data   The HTML
+ * \param len    The length of the HTML
+ * \param quiet  Whether to suppress mutation events while parsing
+ * \return  true on success, or false on error
+ */
+static bool parse(const uint8_t *data, size_t len, bool quiet)
+{
+	dom_hubbub_parser *parser = NULL;
+	dom_hubbub_parser_params params;
+	dom_hubbub_error error;
+	dom_document *doc;
+
+	params.enc = NULL;
+	params.fix_enc = true;
+	params.enable_script = false;
+	params.msg = NULL;
+	params.script = NULL;
+	params.ctx = NULL;
+	params.daf = NULL;
+
+	error = dom_hubbub_parser_create(&params, &parser, &doc);
+	if (error != DOM_HUBBUB_OK)
+		return false;
+
+	dom_hubbub_parser_suppress_mutation_events(parser, quiet);
+
+	error = dom_hubbub_parser_parse_chunk(parser, data, len);
+	if (error == DOM_HUBBUB_OK)
+		error = dom_hubbub_parser_completed(parser);
+
+	dom_hubbub_parser_destroy(parser);
+
+	dom_node_unref(doc);
+
+	return error == DOM_HUBBUB_OK;
+}
+
+int main(int argc, char **argv)
+{
+	int iterations = 10;
+	bool quiet = false;
+	size_t total = 0;
+	double start, elapsed;
+	int first = 1;
+	int i, f;
+
+	while (first < argc) {
+		if (first + 1 < argc && strcmp(argv[first], "-n") == 0) {
+			iterations = atoi(argv[first + 1]);
+			first += 2;
+		} else if (strcmp(argv[first], "-m") == 0) {
+			quiet = true;
+			first++;
+		} else {
+			break;
+		}
+	}
+
+	if (first >= argc || iterations <= 0) {
+		fprintf(stderr, "Usage: %s [-n iterations] [-m] file.html ...\n",
+				argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	for (f = first; f < argc; f++) {
+		uint8_t *data;
+		size_t len;
+
+		data = load_file(argv[f], &len);
+		if (data == NULL) {
+			fprintf(stderr, "Can't read %s\n", argv[f]);
+			return EXIT_FAILURE;
+		}
+
+		start = now();
+
+		for (i = 0; i < iterations; i++) {
+			if (parse(data, len, quiet) == false) {
+				fprintf(stderr, "Can't parse %s\n", argv[f]);
+				free(data);
+				return EXIT_FAILURE;
+			}
+		}
+
+		elapsed = now() - start;
+
+		printf("%s: %zu bytes, %.3f ms per parse, %.1f MB/s\n",
+				argv[f], len, elapsed * 1000 / iterations,
+				len * iterations / elapsed / 1e6);
+
+		total += len;
+		free(data);
+	}
+
+	printf("Corpus: %zu bytes in %d files\n", total, argc - first);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,385 @@
+/*
+ * This file is part of LibDOM.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+/*
+ * Time how quickly LibDOM can find the elements matching CSS selectors.
+ *
+ * A document holding a large table is built, with a class on every other
+ * row and a link in each row's first cell.  The table is nested in some
+ * divs, as content often is.  Each selector is then run the
+ * requested number of times with dom_element_query_selector_all() from the
+ * root element.  The first selector is also found by walking the document
+ * with the public node and element API, as could be done without a
+ * selector engine, to compare against.  The last selectors have no
+ * matches, and are rejected by the ancestor filter kept as the document is
+ * walked, without visiting each element's ancestors.
+ *
+ * Usage:
+ *      selector-benchmark [-n iterations] [-d depth] [rows]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <dom/dom.h>
+
+/** The selectors timed */
+static const char *selectors[] = {
+	"tr.odd td > a",
+	"td a",
+	"#cell-7",
+	"a[href^='#r']",
+	"td:first-child + td",
+	"ul td",
+	"tr.even td > a",
+};
+
+/**
+ * Get the current time, in seconds
+ *
+ * \return the time from an arbitrary fixed point
+ */
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Create an element and append it to a parent
+ *
+ * \param doc     The document
+ * \param parent  The node to append the element to
+ * \param name    The element's tag name
+ * \param result  Updated to the new element, which the caller must unref
+ * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
+ */
+static dom_exception append(dom_document *doc, dom_node *parent,
+		const char *name, dom_element **result)
+{
+	dom_string *tag;
+	dom_element *element;
+	dom_node *added;
+	dom_exception err;
+
+	err = dom_string_create((const uint8_t *) name, strlen(name), &tag);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	err = dom_document_create_element(doc, tag, &element);
+	dom_string_unref(tag);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	err = dom_node_append_child(parent, element, &added);
+	if (err != DOM_NO_ERR) {
+		dom_node_unref(element);
+		return err;
+	}
+	dom_node_unref(added);
+
+	*result = element;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Set an attribute on an element
+ *
+ * \param element  The element
+ * \param name     The attribute's name
+ * \param value    The attribute's value
+ * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
+ */
+static dom_exception set(dom_element *element, const char *name,
+		const char *value)
+{
+	dom_string *n, *v;
+	dom_exception err;
+
+	err = dom_string_create((const uint8_t *) name, strlen(name), &n);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	err = dom_string_create((const uint8_t *) value, strlen(value), &v);
+	if (err != DOM_NO_ERR) {
+		dom_string_unref(n);
+		return err;
+	}
+
+	err = dom_element_set_attribute(element, n, v);
+	dom_string_unref(v);
+	dom_string_unref(n);
+
+	return err;
+}
+
+/**
+ * Build the document to search
+ *
+ * \param rows   The number of rows in the table
+ * \param depth  The number of divs to nest the table in
+ * \param doc    Updated to the new document
+ * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
+ */
+static dom_exception build(uint32_t rows, uint32_t depth,
+		dom_document **doc)
+{
+	dom_element *html, *body, *div, *table;
+	dom_exception err;
+	char value[32];
+	uint32_t r, c;
+
+	err = dom_implementation_create_document(DOM_IMPLEMENTATION_HTML,
+			NULL, "html", NULL, NULL, NULL, doc);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	err = dom_document_get_document_element(*doc, &html);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	err = append(*doc, (dom_node *) html, "body", &body);
+	dom_node_unref(html);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	for (r = 0; r < depth; r++) {
+		err = append(*doc, (dom_node *) body, "div", &div);
+		dom_node_unref(body);
+		if (err != DOM_NO_ERR)
+			return err;
+
+		body = div;
+	}
+
+	err = append(*doc, (dom_node *) body, "table", &table);
+	dom_node_unref(body);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	for (r = 0; r < rows && err == DOM_NO_ERR; r++) {
+		dom_element *tr, *td, *a;
+
+		err = append(*doc, (dom_node *) table, "tr", &tr);
+		if (err != DOM_NO_ERR)
+			break;
+
+		if (r % 2 == 1)
+			err = set(tr, "class", "odd");
+
+		for (c = 0; c < 4 && err == DOM_NO_ERR; c++) {
+			err = append(*doc, (dom_node *) tr, "td", &td);
+			if (err != DOM_NO_ERR)
+				break;
+
+			snprintf(value, sizeof(value), "cell-%u", r * 4 + c);
+			err = set(td, "id", value);
+
+			if (err == DOM_NO_ERR && c == 0) {
+				err = append(*doc, (dom_node *) td, "a", &a);
+				if (err == DOM_NO_ERR) {
+					snprintf(value, sizeof(value),
+							"#r%u", r);
+					err = set(a, "href", value);
+					dom_node_unref(a);
+				}
+			}
+
+			dom_node_unref(td);
+		}
+
+		dom_node_unref(tr);
+	}
+
+	dom_node_unref(table);
+
+	return err;
+}
+
+/**
+ * Test whether a node is an element with a given name
+ *
+ * \param node  The node
+ * \param name  The name to test for
+ * \return true if ::node is an element named ::name, false otherwise
+ */
+static bool is_named(dom_node *node, lwc_string *name)
+{
+	dom_node_type type;
+	dom_string *node_name;
+	bool match;
+
+	if (dom_node_get_node_type(node, &type) != DOM_NO_ERR ||
+			type != DOM_ELEMENT_NODE)
+		return false;
+
+	if (dom_node_get_node_name(node, &node_name) != DOM_NO_ERR)
+		return false;
+
+	match = dom_string_caseless_lwc_isequal(node_name, name);
+	dom_string_unref(node_name);
+
+	return match;
+}
+
+/**
+ * Count the matches of "tr.odd td > a" by walking the document
+ *
+ * \param node   The node to search below
+ * \param names  Interned "tr", "td", "a" and "odd"
+ * \return the number of matches
+ *
+ * This follows the approach of an embedding without a selector engine,
+ * testing each link found with the public API.
+ */
+static uint32_t walk(dom_node *node, lwc_string **names)
+{
+	dom_node *child, *next;
+	uint32_t count = 0;
+
+	if (dom_node_get_first_child(node, &child) != DOM_NO_ERR)
+		return 0;
+
+	while (child != NULL) {
+		if (is_named(child, names[2])) {
+			dom_element *td, *tr;
+			bool odd = false;
+
+			dom_element_named_parent_node((dom_element *) child,
+					names[1], &td);
+			if (td != NULL)
+				dom_element_named_ancestor_node(td, names[0],
+						&tr);
+			if (td != NULL && tr != NULL)
+				dom_element_has_class(tr, names[3], &odd);
+			if (odd)
+				count++;
+		}
+
+		count += walk(child, names);
+
+		dom_node_get_next_sibling(child, &next);
+		dom_node_unref(child);
+		child = next;
+	}
+
+	return count;
+}
+
+int main(int argc, char **argv)
+{
+	static const char *walk_names[] = { "tr", "td", "a", "odd" };
+	int iterations = 20;
+	uint32_t rows = 10000;
+	uint32_t depth = 10;
+	lwc_string *names[4];
+	dom_document *doc;
+	dom_element *html;
+	dom_exception err;
+	double start, elapsed;
+	uint32_t len = 0;
+	size_t s;
+	int first = 1;
+	int i;
+
+	if (first + 1 < argc && strcmp(argv[first], "-n") == 0) {
+		iterations = atoi(argv[first + 1]);
+		first += 2;
+	}
+
+	if (first + 1 < argc && strcmp(argv[first], "-d") == 0) {
+		depth = strtoul(argv[first + 1], NULL, 10);
+		first += 2;
+	}
+
+	if (first < argc)
+		rows = strtoul(argv[first++], NULL, 10);
+
+	if (first != argc || iterations <= 0 || rows == 0) {
+		fprintf(stderr, "Usage: %s [-n iterations] [-d depth] [rows]\n",
+				argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	err = build(rows, depth, &doc);
+	if (err == DOM_NO_ERR)
+		err = dom_document_get_document_element(doc, &html);
+	if (err != DOM_NO_ERR) {
+		fprintf(stderr, "Can't build document: %d\n", err);
+		return EXIT_FAILURE;
+	}
+
+	printf("Document: %u rows, depth %u, %u elements\n", rows, depth,
+			3 + depth + rows * 6);
+
+	for (s = 0; s < sizeof(names) / sizeof(names[0]); s++) {
+		if (lwc_intern_string(walk_names[s], strlen(walk_names[s]),
+				&names[s]) != lwc_error_ok) {
+			fprintf(stderr, "Can't intern names\n");
+			return EXIT_FAILURE;
+		}
+	}
+
+	start = now();
+	for (i = 0; i < iterations; i++)
+		len = walk((dom_node *) html, names);
+	elapsed = now() - start;
+
+	printf("%-22s %6u found, %8.3f ms per walk\n", "(walk) tr.odd td > a",
+			len, elapsed * 1000 / iterations);
+
+	for (s = 0; s < sizeof(selectors) / sizeof(selectors[0]); s++) {
+		dom_string *selector;
+
+		err = dom_string_create((const uint8_t *) selectors[s],
+				strlen(selectors[s]), &selector);
+		if (err != DOM_NO_ERR)
+			break;
+
+		start = now();
+
+		for (i = 0; i < iterations; i++) {
+			dom_nodelist *list;
+
+			err = dom_element_query_selector_all(html, selector,
+					&list);
+			if (err != DOM_NO_ERR)
+				break;
+
+			err = dom_nodelist_get_length(list, &len);
+			dom_nodelist_unref(list);
+			if (err != DOM_NO_ERR)
+				break;
+		}
+
+		elapsed = now() - start;
+		dom_string_unref(selector);
+
+		if (err != DOM_NO_ERR) {
+			fprintf(stderr, "Can't query %s: %d\n",
+					selectors[s], err);
+			break;
+		}
+
+		printf("%-22s %6u found, %8.3f ms per query\n", selectors[s],
+				len, elapsed * 1000 / iterations);
+	}
+
+	for (s = 0; s < sizeof(names) / sizeof(names[0]); s++)
+		lwc_string_unref(names[s]);
+	dom_node_unref(html);
+	dom_node_unref(doc);
+
+	return err == DOM_NO_ERR ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,272 @@
+/*
+ * This file is part of LibDOM.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+/*
+ * Time LibDOM's ASCII case operations on strings of several lengths.
+ *
+ * Each of dom_string_toupper(), dom_string_tolower() and
+ * dom_string_caseless_isequal() is run against a copy of the byte loop
+ * it used to be, built on the public string API, so that the two can be
+ * compared on the same machine.  The strings converted are mixed case
+ * text, compared with a lower case copy, so every byte is looked at.
+ *
+ * Usage:
+ *      string-benchmark [-n iterations]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <dom/dom.h>
+
+/** Largest string length measured */
+#define MAX_LENGTH 4096
+
+/**
+ * A pair of implementations of an operation under test
+ */
+struct benchmark {
+	const char *name;	/**< The operation's name */
+	bool (*old)(dom_string *s1, dom_string *s2);
+				/**< The byte loop it replaced */
+	bool (*new)(dom_string *s1, dom_string *s2);
+				/**< The library's function */
+};
+
+/**
+ * Get the current time, in seconds
+ *
+ * \return the time from an arbitrary fixed point
+ */
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Convert a string's case a byte at a time, as LibDOM used to
+ *
+ * \param source  The string to convert
+ * \param from    The first letter to convert
+ * \param delta   Amount to add to each letter converted
+ * \param result  Updated to the converted string
+ * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
+ */
+static dom_exception old_recase(dom_string *source, uint8_t from,
+		int delta, dom_string **result)
+{
+	const uint8_t *orig_s = (const uint8_t *) dom_string_data(source);
+	const size_t nbytes = dom_string_byte_length(source);
+	uint8_t *copy_s;
+	size_t index;
+	dom_exception exc;
+
+	copy_s = malloc(nbytes);
+	if (copy_s == NULL)
+		return DOM_NO_MEM_ERR;
+	memcpy(copy_s, orig_s, nbytes);
+
+	for (index = 0; index < nbytes; index++) {
+		if (orig_s[index] >= from && orig_s[index] <= from + 25)
+			copy_s[index] += delta;
+	}
+
+	exc = dom_string_create(copy_s, nbytes, result);
+
+	free(copy_s);
+
+	return exc;
+}
+
+static bool old_toupper(dom_string *s1, dom_string *s2)
+{
+	dom_string *result;
+
+	(void) s2;
+
+	if (old_recase(s1, 'a', 'A' - 'a', &result) != DOM_NO_ERR)
+		return false;
+	dom_string_unref(result);
+
+	return true;
+}
+
+static bool new_toupper(dom_string *s1, dom_string *s2)
+{
+	dom_string *result;
+
+	(void) s2;
+
+	if (dom_string_toupper(s1, true, &result) != DOM_NO_ERR)
+		return false;
+	dom_string_unref(result);
+
+	return true;
+}
+
+static bool old_tolower(dom_string *s1, dom_string *s2)
+{
+	dom_string *result;
+
+	(void) s2;
+
+	if (old_recase(s1, 'A', 'a' - 'A', &result) != DOM_NO_ERR)
+		return false;
+	dom_string_unref(result);
+
+	return true;
+}
+
+static bool new_tolower(dom_string *s1, dom_string *s2)
+{
+	dom_string *result;
+
+	(void) s2;
+
+	if (dom_string_tolower(s1, true, &result) != DOM_NO_ERR)
+		return false;
+	dom_string_unref(result);
+
+	return true;
+}
+
+static bool old_caseless(dom_string *s1, dom_string *s2)
+{
+	const uint8_t *d1 = (const uint8_t *) dom_string_data(s1);
+	const uint8_t *d2 = (const uint8_t *) dom_string_data(s2);
+	size_t len = dom_string_byte_length(s1);
+
+	if (len != dom_string_byte_length(s2))
+		return false;
+
+	while (len > 0) {
+		uint8_t c1 = *d1, c2 = *d2;
+
+		if (c1 >= 'A' && c1 <= 'Z')
+			c1 += 'a' - 'A';
+		if (c2 >= 'A' && c2 <= 'Z')
+			c2 += 'a' - 'A';
+		if (c1 != c2)
+			return false;
+
+		d1++;
+		d2++;
+		len--;
+	}
+
+	return true;
+}
+
+static bool new_caseless(dom_string *s1, dom_string *s2)
+{
+	return dom_string_caseless_isequal(s1, s2);
+}
+
+static const struct benchmark benchmarks[] = {
+	{ "toupper", old_toupper, new_toupper },
+	{ "tolower", old_tolower, new_tolower },
+	{ "caseless_isequal", old_caseless, new_caseless },
+};
+
+/**
+ * Time one implementation of an operation
+ *
+ * \param op          The implementation
+ * \param s1          The first string to pass
+ * \param s2          The second string to pass
+ * \param iterations  The number of times to run it
+ * \return the time taken per run in nanoseconds, or -1 if it failed.
+ */
+static double measure(bool (*op)(dom_string *s1, dom_string *s2),
+		dom_string *s1, dom_string *s2, int iterations)
+{
+	double start = now();
+	int i;
+
+	for (i = 0; i < iterations; i++) {
+		if (op(s1, s2) == false)
+			return -1;
+	}
+
+	return (now() - start) * 1e9 / iterations;
+}
+
+int main(int argc, char **argv)
+{
+	static const size_t lengths[] = { 8, 32, 256, MAX_LENGTH };
+	static const char text[] = "The Quick Brown Fox, jumps over 12 "
+			"Lazy DOGS! ";
+	uint8_t mixed[MAX_LENGTH], lower[MAX_LENGTH];
+	int iterations = 1000000;
+	size_t b, l, i;
+	int first = 1;
+
+	if (first + 1 < argc && strcmp(argv[first], "-n") == 0) {
+		iterations = atoi(argv[first + 1]);
+		first += 2;
+	}
+
+	if (first != argc || iterations <= 0) {
+		fprintf(stderr, "Usage: %s [-n iterations]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	for (i = 0; i < MAX_LENGTH; i++) {
+		uint8_t c = text[i % (sizeof(text) - 1)];
+
+		mixed[i] = c;
+		lower[i] = (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+	}
+
+	for (l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+		/* Keep the bytes processed per length about the same */
+		int n = iterations * 8 / lengths[l];
+		dom_string *s1, *s2;
+
+		if (n == 0)
+			n = 1;
+
+		if (dom_string_create(mixed, lengths[l], &s1) != DOM_NO_ERR ||
+				dom_string_create(lower, lengths[l], &s2) !=
+						DOM_NO_ERR) {
+			fprintf(stderr, "Can't create strings\n");
+			return EXIT_FAILURE;
+		}
+
+		printf("%zu bytes:\n", lengths[l]);
+
+		for (b = 0; b < sizeof(benchmarks) / sizeof(benchmarks[0]);
+				b++) {
+			double old, new;
+
+			old = measure(benchmarks[b].old, s1, s2, n);
+			new = measure(benchmarks[b].new, s1, s2, n);
+
+			if (old < 0 || new < 0) {
+				fprintf(stderr, "%s failed\n",
+						benchmarks[b].name);
+				return EXIT_FAILURE;
+			}
+
+			printf("  %-16s %10.1f ns old %10.1f ns new "
+					"%6.1fx\n", benchmarks[b].name,
+					old, new, old / new);
+		}
+
+		dom_string_unref(s2);
+		dom_string_unref(s1);
+	}
+
+	return EXIT_SUCCESS;
+}
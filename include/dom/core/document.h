@@ -468,4 +468,16 @@ static inline dom_exception dom_document_set_quirks_mode(
 #define dom_document_set_quirks_mode(d, q) \
 	dom_document_set_quirks_mode((dom_document *) (d), (q))
 
+/* Mutation event control is non-virtual since it doesn't need to be */
+
+dom_exception _dom_document_get_mutation_events(dom_document *doc,
+		bool *enabled);
+#define dom_document_get_mutation_events(d, e) \
+	_dom_document_get_mutation_events((dom_document *) (d), (e))
+
+dom_exception _dom_document_set_mutation_events(dom_document *doc,
+		bool enabled);
+#define dom_document_set_mutation_events(d, e) \
+	_dom_document_set_mutation_events((dom_document *) (d), (e))
+
 #endif
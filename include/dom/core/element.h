@@ -346,6 +346,20 @@ static inline dom_exception dom_element_has_class(
 		(lwc_string *) (n), (bool *) (m))
 
 
+/* Bulk attribute initialisation, for parser bindings.  Attributes with
+ * invalid names are skipped, names are not checked for duplicates, and no
+ * events are dispatched. */
+dom_exception dom_element_init_attributes(dom_element *element, uint32_t n,
+		dom_string **names, dom_string **values,
+		dom_string **namespaces);
+
+/* Selectors API.  The list returned by dom_element_query_selector_all() is
+ * static: it is not updated when the document changes. */
+dom_exception dom_element_query_selector(dom_element *element,
+		dom_string *selectors, dom_element **result);
+dom_exception dom_element_query_selector_all(dom_element *element,
+		dom_string *selectors, struct dom_nodelist **result);
+
 /* Functions for implementing some libcss selection callbacks.
  * Note that they don't take a reference to the returned element, as such they
  * are UNSAFE if you require the returned element to live beyond the next time
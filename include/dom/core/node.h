@@ -210,6 +210,23 @@ dom_exception _dom_node_contains(struct dom_node_internal *node,
 #define dom_node_contains(n, o, c) \
 	_dom_node_contains((dom_node_internal *)(n), (dom_node_internal *)(o), (c))
 
+/* User data slots are non-virtual, as they are used for fast lookups */
+
+dom_exception dom_node_register_user_data_key(dom_string *key,
+		uint32_t *slot);
+dom_exception _dom_node_set_user_data_slot(struct dom_node_internal *node,
+		uint32_t slot, void *data, dom_user_data_handler handler,
+		void **result);
+#define dom_node_set_user_data_slot(n, s, d, h, r) \
+	_dom_node_set_user_data_slot((dom_node_internal *) (n), (s), \
+			(void *) (d), (dom_user_data_handler) (h), \
+			(void **) (r))
+dom_exception _dom_node_get_user_data_slot(struct dom_node_internal *node,
+		uint32_t slot, void **result);
+#define dom_node_get_user_data_slot(n, s, r) \
+	_dom_node_get_user_data_slot((dom_node_internal *) (n), (s), \
+			(void **) (r))
+
 /* All the rest are virtual */
 
 static inline dom_exception dom_node_get_node_name(struct dom_node *node,
@@ -0,0 +1,52 @@
+/*
+ * This file is part of libdom.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#ifndef dom_core_walk_h_
+#define dom_core_walk_h_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dom/core/exceptions.h>
+
+struct dom_element;
+struct dom_node;
+
+/**
+ * A depth-first walk of the elements below a node
+ *
+ * As well as its position, a walk keeps a counting bloom filter of the
+ * names, IDs and classes of the ancestors of the element it is at.  A
+ * selector matcher may test the filter before walking up the tree for a
+ * descendant or child combinator: if any key of the selector to the left
+ * of the combinator is missing, no ancestor can match it.  The filter may
+ * give false positives, but never false negatives.
+ */
+typedef struct dom_walk dom_walk;
+
+/**
+ * The kinds of key kept in a walk's ancestor filter
+ */
+typedef enum dom_walk_key {
+	DOM_WALK_KEY_NAME,	/**< An element's name */
+	DOM_WALK_KEY_ID,	/**< An element's ID */
+	DOM_WALK_KEY_CLASS	/**< One of an element's classes */
+} dom_walk_key;
+
+dom_exception dom_walk_create(struct dom_node *root, dom_walk **result);
+void dom_walk_destroy(dom_walk *walk);
+
+dom_exception dom_walk_next(dom_walk *walk, struct dom_element **element);
+void dom_walk_skip_children(dom_walk *walk);
+
+/* Keys are hashed ignoring ASCII case, so that a hash may be tested for
+ * case insensitive matches too. */
+uint32_t dom_walk_hash(dom_walk_key key, const uint8_t *data, size_t len);
+bool dom_walk_ancestors_may_have(dom_walk *walk, dom_walk_key key,
+		uint32_t hash);
+
+#endif
@@ -37,6 +37,7 @@
 #include <dom/core/pi.h>
 #include <dom/core/typeinfo.h>
 #include <dom/core/comment.h>
+#include <dom/core/walk.h>
 
 /* DOM HTML headers */
 #include <dom/html/html_collection.h>
@@ -117,7 +118,10 @@ typedef enum dom_namespace {
  */
 extern dom_string *dom_namespaces[DOM_NAMESPACE_COUNT];
 
-/* Optional client-callable namespace cleanup function */
+/* Optional client-callable cleanup function, for the namespaces and the
+ * other state shared by documents.  Call it once every document has been
+ * destroyed.
+ */
 extern dom_exception dom_namespace_finalise(void);
 
 #endif
@@ -20,6 +20,7 @@
 #include "core/document.h"
 #include "core/entity_ref.h"
 #include "core/node.h"
+#include "core/string.h"
 #include "core/element.h"
 #include "utils/utils.h"
 
@@ -95,7 +96,7 @@ dom_exception _dom_attr_create(struct dom_document *doc,
 	dom_exception err;
 
 	/* Allocate the attribute node */
-	a = malloc(sizeof(struct dom_attr));
+	a = _dom_node_alloc(doc, sizeof(struct dom_attr));
 	if (a == NULL)
 		return DOM_NO_MEM_ERR;
 
@@ -107,7 +108,7 @@ dom_exception _dom_attr_create(struct dom_document *doc,
 	err = _dom_attr_initialise(a, doc, name, namespace, prefix, specified, 
 			result);
 	if (err != DOM_NO_ERR) {
-		free(a);
+		_dom_node_free(a);
 		return err;
 	}
 
@@ -178,7 +179,7 @@ void _dom_attr_destroy(struct dom_attr *attr)
 {
 	_dom_attr_finalise(attr);
 
-	free(attr);
+	_dom_node_free(attr);
 }
 
 /*-----------------------------------------------------------------------*/
@@ -443,7 +444,7 @@ dom_exception _dom_attr_get_value(struct dom_attr *attr,
 {
 	struct dom_node_internal *a = (struct dom_node_internal *) attr;
 	struct dom_node_internal *c;
-	dom_string *value, *temp;
+	dom_string_builder sb;
 	dom_exception err;
         
 	/* Attempt to shortcut for a single text node child with value */
@@ -451,42 +452,36 @@ dom_exception _dom_attr_get_value(struct dom_attr *attr,
 	    (a->first_child == a->last_child) &&
 	    (a->first_child->type == DOM_TEXT_NODE) &&
 	    (a->first_child->value != NULL)) {
+		err = _dom_string_unpool(&a->first_child->value);
+		if (err != DOM_NO_ERR)
+			return err;
+
 		*result = dom_string_ref(a->first_child->value);
 		return DOM_NO_ERR;
 	}
 	
-	err = dom_string_create(NULL, 0, &value);
-	if (err != DOM_NO_ERR) {
-		return err;
-	}
-
 	/* Force unknown types to strings, if necessary */
 	if (attr->type == DOM_ATTR_UNSET && a->first_child != NULL) {
 		attr->type = DOM_ATTR_STRING;
 	}
 
+	_dom_string_builder_init(&sb);
+
 	/* If this attribute node is not a string one, we just return an empty
 	 * string */
 	if (attr->type != DOM_ATTR_STRING) {
-		*result = value;
-		return DOM_NO_ERR;
+		return _dom_string_builder_finish(&sb, result);
 	}
 
 	/* Traverse children, building a string representation as we go */
 	for (c = a->first_child; c != NULL; c = c->next) {
 		if (c->type == DOM_TEXT_NODE && c->value != NULL) {
 			/* Append to existing value */
-			err = dom_string_concat(value, c->value, &temp);
+			err = _dom_string_builder_append(&sb, c->value);
 			if (err != DOM_NO_ERR) {
-				dom_string_unref(value);
+				_dom_string_builder_finalise(&sb);
 				return err;
 			}
-
-			/* Finished with previous value */
-			dom_string_unref(value);
-
-			/* Claim new value */
-			value = temp;
 		} else if (c->type == DOM_ENTITY_REFERENCE_NODE) {
 			dom_string *tr;
 
@@ -495,32 +490,24 @@ dom_exception _dom_attr_get_value(struct dom_attr *attr,
 					(struct dom_entity_reference *) c,
 					&tr);
 			if (err != DOM_NO_ERR) {
-				dom_string_unref(value);
+				_dom_string_builder_finalise(&sb);
 				return err;
 			}
 
 			/* Append to existing value */
-			err = dom_string_concat(value, tr, &temp);
-			if (err != DOM_NO_ERR) {
-				dom_string_unref(tr);
-				dom_string_unref(value);
-				return err;
-			}
+			err = _dom_string_builder_append(&sb, tr);
 
-			/* No int32_ter need textual representation */
+			/* No longer need textual representation */
 			dom_string_unref(tr);
 
-			/* Finished with previous value */
-			dom_string_unref(value);
-
-			/* Claim new value */
-			value = temp;
+			if (err != DOM_NO_ERR) {
+				_dom_string_builder_finalise(&sb);
+				return err;
+			}
 		}
 	}
 
-	*result = value;
-
-	return DOM_NO_ERR;
+	return _dom_string_builder_finish(&sb, result);
 }
 
 /**
@@ -586,12 +573,18 @@ dom_exception _dom_attr_set_value(struct dom_attr *attr,
 	/* And insert the text node as the value */
 	((struct dom_node_internal *) text)->parent = a;
 	a->first_child = a->last_child = (struct dom_node_internal *) text;
+	_dom_document_tree_changed(a->owner);
 	dom_node_unref(text);
 	dom_node_remove_pending(text);
 
 	/* Now the attribute node is specified */
 	attr->specified = true;
 
+	/* The owning element's attributes have changed */
+	if (a->parent != NULL)
+		_dom_document_element_changed(a->owner,
+				(struct dom_element *) a->parent);
+
 	return DOM_NO_ERR;
 }
 
@@ -770,19 +763,20 @@ void __dom_attr_destroy(dom_node_internal *node)
 }
 
 /* The memory allocator of this class */
-dom_exception _dom_attr_copy(dom_node_internal *n, dom_node_internal **copy)
+dom_exception _dom_attr_copy(dom_node_internal *n,
+		struct dom_document *doc, dom_node_internal **copy)
 {
 	dom_attr *old = (dom_attr *) n;
 	dom_attr *a;
 	dom_exception err;
 	
-	a = malloc(sizeof(struct dom_attr));
+	a = _dom_node_alloc(doc, sizeof(struct dom_attr));
 	if (a == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_node_copy_internal(n, a);
 	if (err != DOM_NO_ERR) {
-		free(a);
+		_dom_node_free(a);
 		return err;
 	}
 	
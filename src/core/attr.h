@@ -104,7 +104,7 @@ dom_exception _dom_attr_lookup_namespace(dom_node_internal *node,
 /* The protected virtual functions */
 void __dom_attr_destroy(dom_node_internal *node);
 dom_exception _dom_attr_copy(dom_node_internal *old,
-		dom_node_internal **copy);
+		struct dom_document *doc, dom_node_internal **copy);
 
 #define DOM_ATTR_PROTECT_VTABLE \
 	__dom_attr_destroy, \
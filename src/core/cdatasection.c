@@ -45,7 +45,7 @@ dom_exception _dom_cdata_section_create(dom_document *doc,
 	dom_exception err;
 
 	/* Allocate the comment node */
-	c = malloc(sizeof(dom_cdata_section));
+	c = _dom_node_alloc(doc, sizeof(dom_cdata_section));
 	if (c == NULL)
 		return DOM_NO_MEM_ERR;
 	
@@ -57,7 +57,7 @@ dom_exception _dom_cdata_section_create(dom_document *doc,
 	err = _dom_cdata_section_initialise(&c->base, doc,
 			DOM_CDATA_SECTION_NODE, name, value);
 	if (err != DOM_NO_ERR) {
-		free(c);
+		_dom_node_free(c);
 		return err;
 	}
 
@@ -79,7 +79,7 @@ void _dom_cdata_section_destroy(dom_cdata_section *cdata)
 	_dom_cdata_section_finalise(&cdata->base);
 
 	/* Destroy the node */
-	free(cdata);
+	_dom_node_free(cdata);
 }
 
 /*--------------------------------------------------------------------------*/
@@ -93,19 +93,19 @@ void __dom_cdata_section_destroy(dom_node_internal *node)
 }
 
 /* The copy constructor of this class */
-dom_exception _dom_cdata_section_copy(dom_node_internal *old, 
-		dom_node_internal **copy)
+dom_exception _dom_cdata_section_copy(dom_node_internal *old,
+		struct dom_document *doc, dom_node_internal **copy)
 {
 	dom_cdata_section *new_cdata;
 	dom_exception err;
 
-	new_cdata = malloc(sizeof(dom_cdata_section));
+	new_cdata = _dom_node_alloc(doc, sizeof(dom_cdata_section));
 	if (new_cdata == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_text_copy_internal(old, new_cdata);
 	if (err != DOM_NO_ERR) {
-		free(new_cdata);
+		_dom_node_free(new_cdata);
 		return err;
 	}
 
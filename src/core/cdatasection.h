@@ -26,8 +26,8 @@ void _dom_cdata_section_destroy(dom_cdata_section *cdata);
 
 /* Following comes the protected vtable  */
 void __dom_cdata_section_destroy(struct dom_node_internal *node);
-dom_exception _dom_cdata_section_copy(struct dom_node_internal *old, 
-		struct dom_node_internal **copy);
+dom_exception _dom_cdata_section_copy(struct dom_node_internal *old,
+		struct dom_document *doc, struct dom_node_internal **copy);
 
 #define DOM_CDATA_SECTION_PROTECT_VTABLE \
 	__dom_cdata_section_destroy, \
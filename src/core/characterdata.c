@@ -16,6 +16,7 @@
 #include "core/characterdata.h"
 #include "core/document.h"
 #include "core/node.h"
+#include "core/string.h"
 #include "utils/utils.h"
 #include "events/mutation_event.h"
 
@@ -31,11 +32,29 @@ const struct dom_characterdata_vtable characterdata_vtable = {
 	DOM_CHARACTERDATA_VTABLE
 };
 
+/**
+ * Note a change to a character data node's content
+ *
+ * \param doc  The document owning the node
+ * \param c    The modified node
+ *
+ * Text within an attribute forms its value, so changing it changes the
+ * owning element.
+ */
+static inline void _dom_characterdata_value_changed(struct dom_document *doc,
+		struct dom_node_internal *c)
+{
+	if (c->parent != NULL && c->parent->type == DOM_ATTRIBUTE_NODE &&
+			c->parent->parent != NULL)
+		_dom_document_element_changed(doc,
+				(dom_element *) c->parent->parent);
+}
 
 /* Create a DOM characterdata node and compose the vtable */
 dom_characterdata *_dom_characterdata_create(void)
 {
-	dom_characterdata *cdata = malloc(sizeof(struct dom_characterdata));
+	dom_characterdata *cdata = _dom_node_alloc(NULL,
+			sizeof(struct dom_characterdata));
 	if (cdata == NULL)
 		return NULL;
 
@@ -87,7 +106,7 @@ void _dom_characterdata_finalise(struct dom_characterdata *cdata)
  *
  * \param cdata  Character data node to retrieve data from
  * \param data   Pointer to location to receive data
- * \return DOM_NO_ERR.
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
  *
  * The returned string will have its reference count increased. It is
  * the responsibility of the caller to unref the string once it has
@@ -100,6 +119,11 @@ dom_exception _dom_characterdata_get_data(struct dom_characterdata *cdata,
 		dom_string **data)
 {
 	struct dom_node_internal *c = (struct dom_node_internal *) cdata;
+	dom_exception err;
+
+	err = _dom_string_unpool(&c->value);
+	if (err != DOM_NO_ERR)
+		return err;
 
 	if (c->value != NULL) {
 		dom_string_ref(c->value);
@@ -147,6 +171,8 @@ dom_exception _dom_characterdata_set_data(struct dom_characterdata *cdata,
 	dom_string_ref(data);
 	c->value = data;
 
+	_dom_characterdata_value_changed(doc, c);
+
 	success = true;
 	return _dom_dispatch_subtree_modified_event(doc, c->parent, &success);
 }
@@ -258,6 +284,8 @@ dom_exception _dom_characterdata_append_data(struct dom_characterdata *cdata,
 
 	c->value = temp;
 
+	_dom_characterdata_value_changed(doc, c);
+
 	success = true;
 	return _dom_dispatch_subtree_modified_event(doc, c->parent, &success);
 }
@@ -320,6 +348,8 @@ dom_exception _dom_characterdata_insert_data(struct dom_characterdata *cdata,
 
 	c->value = temp;
 
+	_dom_characterdata_value_changed(doc, c);
+
 	success = true;
 	return _dom_dispatch_subtree_modified_event(doc, c->parent, &success);
 }
@@ -388,6 +418,8 @@ dom_exception _dom_characterdata_delete_data(struct dom_characterdata *cdata,
 
 	c->value = temp;
 
+	_dom_characterdata_value_changed(doc, c);
+
 	success = true;
 	return _dom_dispatch_subtree_modified_event(doc, c->parent, &success);
 }
@@ -454,6 +486,8 @@ dom_exception _dom_characterdata_replace_data(struct dom_characterdata *cdata,
 
 	c->value = temp;
 
+	_dom_characterdata_value_changed(doc, c);
+
 	success = true;
 	return _dom_dispatch_subtree_modified_event(doc, c->parent, &success);
 }
@@ -484,19 +518,19 @@ void _dom_characterdata_destroy(struct dom_node_internal *node)
 }
 
 /* The copy constructor of this class */
-dom_exception _dom_characterdata_copy(dom_node_internal *old, 
-		dom_node_internal **copy)
+dom_exception _dom_characterdata_copy(dom_node_internal *old,
+		struct dom_document *doc, dom_node_internal **copy)
 {
 	dom_characterdata *new_node;
 	dom_exception err;
 
-	new_node = malloc(sizeof(dom_characterdata));
+	new_node = _dom_node_alloc(doc, sizeof(dom_characterdata));
 	if (new_node == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_characterdata_copy_internal(old, new_node);
 	if (err != DOM_NO_ERR) {
-		free(new_node);
+		_dom_node_free(new_node);
 		return err;
 	}
 
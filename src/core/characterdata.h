@@ -109,8 +109,8 @@ dom_exception _dom_characterdata_set_text_content(
  * Only the _copy function can be used by sub-class of this.
  */
 void _dom_characterdata_destroy(dom_node_internal *node);
-dom_exception _dom_characterdata_copy(dom_node_internal *old, 
-		dom_node_internal **copy);
+dom_exception _dom_characterdata_copy(dom_node_internal *old,
+		struct dom_document *doc, dom_node_internal **copy);
 
 #define DOM_CHARACTERDATA_PROTECT_VTABLE \
 	_dom_characterdata_destroy, \
@@ -47,7 +47,7 @@ dom_exception _dom_comment_create(dom_document *doc,
 	dom_exception err;
 
 	/* Allocate the comment node */
-	c = malloc(sizeof(dom_comment));
+	c = _dom_node_alloc(doc, sizeof(dom_comment));
 	if (c == NULL)
 		return DOM_NO_MEM_ERR;
 
@@ -59,7 +59,7 @@ dom_exception _dom_comment_create(dom_document *doc,
 	err = _dom_characterdata_initialise(&c->base, doc, DOM_COMMENT_NODE,
 			name, value);
 	if (err != DOM_NO_ERR) {
-		free(c);
+		_dom_node_free(c);
 		return err;
 	}
 
@@ -81,7 +81,7 @@ void _dom_comment_destroy(dom_comment *comment)
 	_dom_characterdata_finalise(&comment->base);
 
 	/* Free node */
-	free(comment);
+	_dom_node_free(comment);
 }
 
 
@@ -95,19 +95,19 @@ void __dom_comment_destroy(dom_node_internal *node)
 }
 
 /* The copy constructor of this class */
-dom_exception _dom_comment_copy(dom_node_internal *old, 
-		dom_node_internal **copy)
+dom_exception _dom_comment_copy(dom_node_internal *old,
+		struct dom_document *doc, dom_node_internal **copy)
 {
 	dom_comment *new_comment;
 	dom_exception err;
 
-	new_comment = malloc(sizeof(dom_comment));
+	new_comment = _dom_node_alloc(doc, sizeof(dom_comment));
 	if (new_comment == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_characterdata_copy_internal(old, new_comment);
 	if (err != DOM_NO_ERR) {
-		free(new_comment);
+		_dom_node_free(new_comment);
 		return err;
 	}
 
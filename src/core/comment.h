@@ -25,8 +25,8 @@ void _dom_comment_destroy(dom_comment *comment);
 
 /* Following comes the protected vtable  */
 void __dom_comment_destroy(dom_node_internal *node);
-dom_exception _dom_comment_copy(dom_node_internal *old, 
-		dom_node_internal **copy);
+dom_exception _dom_comment_copy(dom_node_internal *old,
+		struct dom_document *doc, dom_node_internal **copy);
 
 #define DOM_COMMENT_PROTECT_VTABLE \
 	__dom_comment_destroy, \
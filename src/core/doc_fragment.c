@@ -54,7 +54,7 @@ dom_exception _dom_document_fragment_create(dom_document *doc,
 	dom_document_fragment *f;
 	dom_exception err;
 
-	f = malloc(sizeof(dom_document_fragment));
+	f = _dom_node_alloc(doc, sizeof(dom_document_fragment));
 	if (f == NULL)
 		return DOM_NO_MEM_ERR;
 
@@ -65,7 +65,7 @@ dom_exception _dom_document_fragment_create(dom_document *doc,
 	err = _dom_document_fragment_initialise(&f->base, doc, 
 			DOM_DOCUMENT_FRAGMENT_NODE, name, value, NULL, NULL);
 	if (err != DOM_NO_ERR) {
-		free(f);
+		_dom_node_free(f);
 		return err;
 	}
 
@@ -87,7 +87,7 @@ void _dom_document_fragment_destroy(dom_document_fragment *frag)
 	_dom_document_fragment_finalise(&frag->base);
 
 	/* Destroy fragment */
-	free(frag);
+	_dom_node_free(frag);
 }
 
 /*-----------------------------------------------------------------------*/
@@ -101,18 +101,19 @@ void _dom_df_destroy(dom_node_internal *node)
 }
 
 /* The copy constructor of this class */
-dom_exception _dom_df_copy(dom_node_internal *old, dom_node_internal **copy)
+dom_exception _dom_df_copy(dom_node_internal *old,
+		struct dom_document *doc, dom_node_internal **copy)
 {
 	dom_document_fragment *new_f;
 	dom_exception err;
 
-	new_f = malloc(sizeof(dom_document_fragment));
+	new_f = _dom_node_alloc(doc, sizeof(dom_document_fragment));
 	if (new_f == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_node_copy_internal(old, new_f);
 	if (err != DOM_NO_ERR) {
-		free(new_f);
+		_dom_node_free(new_f);
 		return err;
 	}
 
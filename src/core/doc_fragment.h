@@ -23,7 +23,8 @@ void _dom_document_fragment_destroy(dom_document_fragment *frag);
 
 /* Following comes the protected vtable */
 void _dom_df_destroy(dom_node_internal *node);
-dom_exception _dom_df_copy(dom_node_internal *old, dom_node_internal **copy);
+dom_exception _dom_df_copy(dom_node_internal *old,
+		struct dom_document *doc, dom_node_internal **copy);
 
 #define DOM_DF_PROTECT_VTABLE \
 	_dom_df_destroy, \
@@ -7,8 +7,11 @@
  */
 
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include <dom/dom.h>
 #include <dom/functypes.h>
 #include <dom/core/attr.h>
 #include <dom/core/element.h>
@@ -27,6 +30,8 @@
 #include "core/nodelist.h"
 #include "core/pi.h"
 #include "core/text.h"
+#include "html/html_document.h"
+#include "html/html_element.h"
 #include "utils/validate.h"
 #include "utils/namespace.h"
 #include "utils/utils.h"
@@ -41,6 +46,20 @@ struct dom_doc_nl {
 	struct dom_doc_nl *prev;	/**< Previous item */
 };
 
+/**
+ * Entry in the ID index
+ */
+struct dom_doc_id_entry {
+	dom_string *id;			/**< The ID, also the hash key */
+
+	uint32_t n_elements;		/**< Number of elements with the ID */
+	uint32_t alloc;			/**< Allocated size of elements */
+	dom_element *elements[];	/**< Elements with the ID, unordered */
+};
+
+/** Number of chains in the ID index hash table */
+#define DOM_DOC_ID_INDEX_CHAINS 1031
+
 /* The virtual functions of this dom_document */
 static const struct dom_document_vtable document_vtable = {
 	{
@@ -56,6 +75,59 @@ static const struct dom_node_protect_vtable document_protect_vtable = {
 	DOM_DOCUMENT_PROTECT_VTABLE
 };
 
+/**
+ * Indices of the strings shared by every document
+ */
+enum {
+	ds_document,
+	ds_about_blank,
+	ds_id,
+	ds_class,
+	ds_script,
+	ds_empty,
+	ds_domnodeinserted,
+	ds_domnoderemoved,
+	ds_domnodeinsertedintodocument,
+	ds_domnoderemovedfromdocument,
+	ds_domattrmodified,
+	ds_domcharacterdatamodified,
+	ds_domsubtreemodified,
+
+	ds_COUNT
+};
+
+/* The strings shared by every document */
+static const char *const document_strings[ds_COUNT] = {
+	[ds_document] = "#document",
+	[ds_about_blank] = "about:blank",
+	[ds_id] = "id",
+	[ds_class] = "class",
+	[ds_script] = "script",
+	[ds_empty] = "",
+	[ds_domnodeinserted] = "DOMNodeInserted",
+	[ds_domnoderemoved] = "DOMNodeRemoved",
+	[ds_domnodeinsertedintodocument] = "DOMNodeInsertedIntoDocument",
+	[ds_domnoderemovedfromdocument] = "DOMNodeRemovedFromDocument",
+	[ds_domattrmodified] = "DOMAttrModified",
+	[ds_domcharacterdatamodified] = "DOMCharacterDataModified",
+	[ds_domsubtreemodified] = "DOMSubtreeModified"
+};
+
+/**
+ * Table of strings shared by every document
+ *
+ * The table is created with the first document, and is then kept until
+ * dom_namespace_finalise() is called.  Each document also holds a
+ * reference to the table, so that it outlives the documents that use it.
+ */
+struct dom_document_strings {
+	uint32_t refcnt;			/**< Reference count */
+	dom_string *strings[ds_COUNT];		/**< The strings */
+};
+
+/** The table for new documents to use, or NULL if it is not created */
+static struct dom_document_strings *shared_strings;
+
 
 /*----------------------------------------------------------------------*/
 
@@ -63,6 +135,18 @@ static const struct dom_node_protect_vtable document_protect_vtable = {
 static dom_exception dom_document_dup_node(dom_document *doc, 
 		dom_node *node, bool deep, dom_node **result, 
 		dom_node_operation opt);
+static void _dom_document_id_index_build(dom_document *doc);
+static void _dom_document_id_index_drop(dom_document *doc);
+static void _dom_document_id_index_update(dom_document *doc,
+		dom_element *ele);
+static uint16_t _dom_document_walk_position(dom_node_internal *node,
+		dom_node_internal *other, dom_node_internal **root,
+		uint32_t *steps);
+static void _dom_document_order_build(dom_document *doc);
+static dom_exception _dom_document_strings_get(
+		struct dom_document_strings **result);
+static void _dom_document_strings_release(
+		struct dom_document_strings *strings);
 
 
 /*----------------------------------------------------------------------*/
@@ -117,173 +201,61 @@ dom_exception _dom_document_initialise(dom_document *doc,
 				       void *daf_ctx)
 {
 	dom_exception err;
-	dom_string *name;
+	struct dom_document_strings *strings;
 
-	err = dom_string_create((const uint8_t *) "#document", 
-			SLEN("#document"), &name);
+	err = _dom_document_strings_get(&strings);
 	if (err != DOM_NO_ERR)
 		return err;
 
-	err = dom_string_create_interned((const uint8_t *) "about:blank",
-			SLEN("about:blank"), &doc->uri);
-	if (err != DOM_NO_ERR) {
-		dom_string_unref(name);
-		return err;
-	}
+	doc->strings = strings;
+	doc->uri = dom_string_ref(strings->strings[ds_about_blank]);
 
 	doc->nodelists = NULL;
 
 	err = _dom_node_initialise(&doc->base, doc, DOM_DOCUMENT_NODE,
-			name, NULL, NULL, NULL);
-	dom_string_unref(name);
+			strings->strings[ds_document], NULL, NULL, NULL);
 	if (err != DOM_NO_ERR) {
 		dom_string_unref(doc->uri);
+		_dom_document_strings_release(strings);
 		return err;
 	}
 
 	list_init(&doc->pending_nodes);
 
-	err = dom_string_create_interned((const uint8_t *) "id",
-					 SLEN("id"), &doc->id_name);
-	if (err != DOM_NO_ERR) {
-		dom_string_unref(doc->uri);
-		return err;
-	}
-	doc->quirks = DOM_DOCUMENT_QUIRKS_MODE_NONE;
-
-	err = dom_string_create_interned((const uint8_t *) "class",
-			SLEN("class"), &doc->class_string);
-	if (err != DOM_NO_ERR) {
-		dom_string_unref(doc->uri);
-		dom_string_unref(doc->id_name);
-		return err;
-	}
-
-	err = dom_string_create_interned((const uint8_t *) "script",
-			SLEN("script"), &doc->script_string);
-	if (err != DOM_NO_ERR) {
-		dom_string_unref(doc->uri);
-		dom_string_unref(doc->id_name);
-		dom_string_unref(doc->class_string);
-		return err;
-	}
+	doc->id_index = NULL;
+	doc->tree_generation = 0;
+	doc->attr_generation = 0;
 
-	/* Intern the empty string. The use of a space in the constant
-	 * is to prevent the compiler warning about an empty string.
-	 */
-	err = dom_string_create_interned((const uint8_t *) " ", 0,
-					 &doc->_memo_empty);
-	if (err != DOM_NO_ERR) {
-		dom_string_unref(doc->uri);
-		dom_string_unref(doc->id_name);
-		dom_string_unref(doc->class_string);
-		dom_string_unref(doc->script_string);
-		return err;
-	}
+	doc->order_stamp = 0;
+	doc->order_generation = 0;
+	doc->order_size = 0;
+	doc->order_work = 0;
 
-	err = dom_string_create_interned((const uint8_t *) "DOMNodeInserted",
-					 SLEN("DOMNodeInserted"),
-					 &doc->_memo_domnodeinserted);
-	if (err != DOM_NO_ERR) {
-		dom_string_unref(doc->_memo_empty);
-		dom_string_unref(doc->uri);
-		dom_string_unref(doc->id_name);
-		dom_string_unref(doc->class_string);
-		dom_string_unref(doc->script_string);
-		return err;
-	}
-
-	err = dom_string_create_interned((const uint8_t *) "DOMNodeRemoved",
-					 SLEN("DOMNodeRemoved"),
-					 &doc->_memo_domnoderemoved);
-	if (err != DOM_NO_ERR) {
-		dom_string_unref(doc->_memo_domnodeinserted);
-		dom_string_unref(doc->_memo_empty);
-		dom_string_unref(doc->uri);
-		dom_string_unref(doc->id_name);
-		dom_string_unref(doc->class_string);
-		dom_string_unref(doc->script_string);
-		return err;
-	}
-
-	err = dom_string_create_interned((const uint8_t *) "DOMNodeInsertedIntoDocument",
-					 SLEN("DOMNodeInsertedIntoDocument"),
-					 &doc->_memo_domnodeinsertedintodocument);
-	if (err != DOM_NO_ERR) {
-		dom_string_unref(doc->_memo_domnoderemoved);
-		dom_string_unref(doc->_memo_domnodeinserted);
-		dom_string_unref(doc->_memo_empty);
-		dom_string_unref(doc->uri);
-		dom_string_unref(doc->id_name);
-		dom_string_unref(doc->class_string);
-		dom_string_unref(doc->script_string);
-		return err;
-	}
-
-	err = dom_string_create_interned((const uint8_t *) "DOMNodeRemovedFromDocument",
-					 SLEN("DOMNodeRemovedFromDocument"),
-					 &doc->_memo_domnoderemovedfromdocument);
-	if (err != DOM_NO_ERR) {
-		dom_string_unref(doc->_memo_domnodeinsertedintodocument);
-		dom_string_unref(doc->_memo_domnoderemoved);
-		dom_string_unref(doc->_memo_domnodeinserted);
-		dom_string_unref(doc->_memo_empty);
-		dom_string_unref(doc->uri);
-		dom_string_unref(doc->id_name);
-		dom_string_unref(doc->class_string);
-		dom_string_unref(doc->script_string);
-		return err;
-	}
-
-	err = dom_string_create_interned((const uint8_t *) "DOMAttrModified",
-					 SLEN("DOMAttrModified"),
-					 &doc->_memo_domattrmodified);
-	if (err != DOM_NO_ERR) {
-		dom_string_unref(doc->_memo_domnoderemovedfromdocument);
-		dom_string_unref(doc->_memo_domnodeinsertedintodocument);
-		dom_string_unref(doc->_memo_domnoderemoved);
-		dom_string_unref(doc->_memo_domnodeinserted);
-		dom_string_unref(doc->_memo_empty);
-		dom_string_unref(doc->uri);
-		dom_string_unref(doc->id_name);
-		dom_string_unref(doc->class_string);
-		dom_string_unref(doc->script_string);
-		return err;
-	}
-
-	err = dom_string_create_interned((const uint8_t *) "DOMCharacterDataModified",
-					 SLEN("DOMCharacterDataModified"),
-					 &doc->_memo_domcharacterdatamodified);
-	if (err != DOM_NO_ERR) {
-		dom_string_unref(doc->_memo_domattrmodified);
-		dom_string_unref(doc->_memo_domnoderemovedfromdocument);
-		dom_string_unref(doc->_memo_domnodeinsertedintodocument);
-		dom_string_unref(doc->_memo_domnoderemoved);
-		dom_string_unref(doc->_memo_domnodeinserted);
-		dom_string_unref(doc->_memo_empty);
-		dom_string_unref(doc->uri);
-		dom_string_unref(doc->id_name);
-		dom_string_unref(doc->class_string);
-		dom_string_unref(doc->script_string);
-		return err;
-	}
-
-	err = dom_string_create_interned((const uint8_t *) "DOMSubtreeModified",
-					 SLEN("DOMSubtreeModified"),
-					 &doc->_memo_domsubtreemodified);
-	if (err != DOM_NO_ERR) {
-		dom_string_unref(doc->_memo_domcharacterdatamodified);
-		dom_string_unref(doc->_memo_domattrmodified);
-		dom_string_unref(doc->_memo_domnoderemovedfromdocument);
-		dom_string_unref(doc->_memo_domnodeinsertedintodocument);
-		dom_string_unref(doc->_memo_domnoderemoved);
-		dom_string_unref(doc->_memo_domnodeinserted);
-		dom_string_unref(doc->_memo_empty);
+	doc->id_name = dom_string_ref(strings->strings[ds_id]);
+	doc->quirks = DOM_DOCUMENT_QUIRKS_MODE_NONE;
+	doc->mutation_events = true;
+
+	doc->class_string = strings->strings[ds_class];
+	doc->script_string = strings->strings[ds_script];
+	doc->_memo_empty = strings->strings[ds_empty];
+	doc->_memo_domnodeinserted = strings->strings[ds_domnodeinserted];
+	doc->_memo_domnoderemoved = strings->strings[ds_domnoderemoved];
+	doc->_memo_domnodeinsertedintodocument =
+			strings->strings[ds_domnodeinsertedintodocument];
+	doc->_memo_domnoderemovedfromdocument =
+			strings->strings[ds_domnoderemovedfromdocument];
+	doc->_memo_domattrmodified = strings->strings[ds_domattrmodified];
+	doc->_memo_domcharacterdatamodified =
+			strings->strings[ds_domcharacterdatamodified];
+	doc->_memo_domsubtreemodified =
+			strings->strings[ds_domsubtreemodified];
+
+	doc->node_pool = _dom_pool_create();
+	if (doc->node_pool == NULL) {
 		dom_string_unref(doc->uri);
 		dom_string_unref(doc->id_name);
-		dom_string_unref(doc->class_string);
-		dom_string_unref(doc->script_string);
-		return err;
+		_dom_document_strings_release(strings);
+		return DOM_NO_MEM_ERR;
 	}
 
 	/* We should not pass a NULL when all things hook up */
@@ -294,6 +266,9 @@ dom_exception _dom_document_initialise(dom_document *doc,
 /* Finalise the document */
 bool _dom_document_finalise(dom_document *doc)
 {
+	/* The ID index refers to nodes in the tree, so discard it first */
+	_dom_document_id_index_drop(doc);
+
 	/* Finalise base class, delete the tree in force */
 	_dom_node_finalise(&doc->base);
 
@@ -320,22 +295,99 @@ bool _dom_document_finalise(dom_document *doc)
 		dom_string_unref(doc->id_name);
 
 	dom_string_unref(doc->uri);
-	dom_string_unref(doc->class_string);
-	dom_string_unref(doc->script_string);
-	dom_string_unref(doc->_memo_empty);
-	dom_string_unref(doc->_memo_domnodeinserted);
-	dom_string_unref(doc->_memo_domnoderemoved);
-	dom_string_unref(doc->_memo_domnodeinsertedintodocument);
-	dom_string_unref(doc->_memo_domnoderemovedfromdocument);
-	dom_string_unref(doc->_memo_domattrmodified);
-	dom_string_unref(doc->_memo_domcharacterdatamodified);
-	dom_string_unref(doc->_memo_domsubtreemodified);
+
+	_dom_document_strings_release(doc->strings);
+	doc->strings = NULL;
+
+	/* The pool's slabs are freed once every node allocated from it
+	 * has been destroyed, which may not have happened yet if we are
+	 * being destroyed from within a node's destructor */
+	_dom_pool_release(doc->node_pool);
+	doc->node_pool = NULL;
 	
 	_dom_document_event_internal_finalise(&doc->dei);
 
 	return true;
 }
 
+/**
+ * Get the table of strings shared by every document
+ *
+ * \param result  Pointer to location to receive the table
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ *
+ * The table is created if there is none.  The caller must release its
+ * reference to the table with _dom_document_strings_release().
+ */
+dom_exception _dom_document_strings_get(struct dom_document_strings **result)
+{
+	struct dom_document_strings *strings = shared_strings;
+	dom_exception err;
+	int i;
+
+	if (strings == NULL) {
+		strings = malloc(sizeof(*strings));
+		if (strings == NULL)
+			return DOM_NO_MEM_ERR;
+
+		for (i = 0; i < ds_COUNT; i++) {
+			err = dom_string_create_interned(
+					(const uint8_t *) document_strings[i],
+					strlen(document_strings[i]),
+					&strings->strings[i]);
+			if (err != DOM_NO_ERR) {
+				while (i-- > 0)
+					dom_string_unref(strings->strings[i]);
+				free(strings);
+				return err;
+			}
+		}
+
+		/* Held until dom_namespace_finalise() */
+		strings->refcnt = 1;
+		shared_strings = strings;
+	}
+
+	strings->refcnt++;
+	*result = strings;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Release a reference to a table of strings shared by documents
+ *
+ * \param strings  The table, which is destroyed with its last reference
+ */
+void _dom_document_strings_release(struct dom_document_strings *strings)
+{
+	int i;
+
+	if (--strings->refcnt > 0)
+		return;
+
+	for (i = 0; i < ds_COUNT; i++)
+		dom_string_unref(strings->strings[i]);
+
+	free(strings);
+}
+
+/**
+ * Finalise the strings shared by documents
+ *
+ * The shared strings are destroyed once every existing document has been
+ * destroyed.  Documents created afterwards make a new set.
+ */
+void _dom_document_strings_finalise(void)
+{
+	if (shared_strings != NULL) {
+		_dom_document_strings_release(shared_strings);
+		shared_strings = NULL;
+	}
+
+	_dom_html_document_strings_finalise();
+}
+
 
 
 /*----------------------------------------------------------------------*/
@@ -665,7 +717,9 @@ dom_exception _dom_document_get_elements_by_tag_name(dom_document *doc,
  * \param result  Pointer to location to receive imported node in this document.
  * \return DOM_NO_ERR                on success,
  *         DOM_INVALID_CHARACTER_ERR if any of the names are invalid,
- *         DOM_NOT_SUPPORTED_ERR     if the type of \p node is unsupported
+ *         DOM_NOT_SUPPORTED_ERR     if the type of \p node is unsupported,
+ *                                   or it holds HTML elements and \p doc
+ *                                   is not an HTML document
  *
  * The returned node will have its reference count increased. It is
  * the responsibility of the caller to unref the node once it has
@@ -848,21 +902,46 @@ dom_exception _dom_document_get_element_by_id(dom_document *doc,
 		dom_string *id, dom_element **result)
 {
 	dom_node_internal *root;
+	struct dom_doc_id_entry *entry;
 	dom_exception err;
+	uint32_t i;
 
 	*result = NULL;
 
-	err = dom_document_get_document_element(doc, (void *) &root);
-	if (err != DOM_NO_ERR)
+	if (doc->id_index == NULL)
+		_dom_document_id_index_build(doc);
+
+	if (doc->id_index == NULL) {
+		/* No memory for an index; fall back to searching the tree */
+		err = dom_document_get_document_element(doc, (void *) &root);
+		if (err != DOM_NO_ERR)
+			return err;
+
+		err = _dom_find_element_by_id(root, id, result);
+		dom_node_unref(root);
+
+		if (*result != NULL)
+			dom_node_ref(*result);
+
 		return err;
+	}
+
+	entry = _dom_hash_get(doc->id_index, id);
+	if (entry == NULL)
+		return DOM_NO_ERR;
 
-	err = _dom_find_element_by_id(root, id, result);
-	dom_node_unref(root);
+	/* Duplicate IDs are permitted; the first in tree order wins */
+	*result = entry->elements[0];
+	for (i = 1; i < entry->n_elements; i++) {
+		if (_dom_document_precedes(
+				(dom_node_internal *) entry->elements[i],
+				(dom_node_internal *) *result))
+			*result = entry->elements[i];
+	}
 
-	if (*result != NULL)
-		dom_node_ref(*result);
+	dom_node_ref(*result);
 
-	return err;
+	return DOM_NO_ERR;
 }
 
 /**
@@ -1067,7 +1146,9 @@ dom_exception _dom_document_set_uri(dom_document *doc,
  * \return DOM_NO_ERR                      on success,
  *         DOM_NO_MODIFICATION_ALLOWED_ERR if \p node is readonly,
  *         DOM_NOT_SUPPORTED_ERR           if \p node is of type Document or
- *                                         DocumentType
+ *                                         DocumentType, or it holds HTML
+ *                                         elements and \p doc is not an
+ *                                         HTML document
  *
  * The returned node will have its reference count increased. It is
  * the responsibility of the caller to unref the node once it has
@@ -1245,10 +1326,11 @@ void _dom_document_destroy(dom_node_internal *node)
 }
 
 /* The copy constructor function of this class */
-dom_exception _dom_document_copy(dom_node_internal *old, 
-		dom_node_internal **copy)
+dom_exception _dom_document_copy(dom_node_internal *old,
+		struct dom_document *doc, dom_node_internal **copy)
 {
 	UNUSED(old);
+	UNUSED(doc);
 	UNUSED(copy);
 
 	return DOM_NOT_SUPPORTED_ERR;
@@ -1416,15 +1498,48 @@ dom_exception _dom_find_element_by_id(dom_node_internal *root,
 	return DOM_NO_ERR;
 }
 
+/**
+ * Test whether a subtree holds any HTML elements
+ *
+ * \param root  The root of the subtree
+ * \return true if ::root or any of its descendants is an HTML element
+ */
+static bool _dom_document_subtree_has_html(dom_node_internal *root)
+{
+	dom_node_internal *node = root;
+
+	while (node != NULL) {
+		if (_dom_html_node_get_element_type(node) !=
+				DOM_HTML_ELEMENT_TYPE__UNKNOWN)
+			return true;
+
+		if (node->first_child != NULL) {
+			node = node->first_child;
+			continue;
+		}
+
+		while (node != root && node->next == NULL)
+			node = node->parent;
+
+		node = (node != root) ? node->next : NULL;
+	}
+
+	return false;
+}
+
 /**
  * Duplicate a Node
  *
- * \param doc     The documen
+ * \param doc     The document which will own the duplicate
  * \param node    The node to duplicate
  * \param deep    Whether to make a deep copy
  * \param result  The returned node
  * \param opt     Whether this is adopt or import operation
  * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
+ *
+ * The duplicate is allocated from ::doc's node pool, so it does not keep
+ * the memory of ::node's document alive.  HTML elements may only be
+ * duplicated into HTML documents, as they use their owner's HTML strings.
  */
 dom_exception dom_document_dup_node(dom_document *doc, dom_node *node,
 		bool deep, dom_node **result, dom_node_operation opt)
@@ -1432,8 +1547,6 @@ dom_exception dom_document_dup_node(dom_document *doc, dom_node *node,
 	dom_node_internal *n = (dom_node_internal *) node;
 	dom_node_internal *ret;
 	dom_exception err;
-	dom_node_internal *child, *r;
-	dom_user_data *ud;
 
 	if (opt == DOM_NODE_ADOPTED && _dom_node_readonly(n))
 		return DOM_NO_MODIFICATION_ALLOWED_ERR;
@@ -1442,12 +1555,16 @@ dom_exception dom_document_dup_node(dom_document *doc, dom_node *node,
 			n->type == DOM_DOCUMENT_TYPE_NODE)
 		return DOM_NOT_SUPPORTED_ERR;
 
-	err = dom_node_copy(node, &ret);
+	if (_dom_document_is_html(doc) == false &&
+			_dom_document_subtree_has_html(n))
+		return DOM_NOT_SUPPORTED_ERR;
+
+	err = dom_node_copy(node, doc, &ret);
 	if (err != DOM_NO_ERR)
 		return err;
 
 	if (n->type == DOM_ATTRIBUTE_NODE) {
-		_dom_attr_set_specified((dom_attr *) node, true);
+		_dom_attr_set_specified((dom_attr *) ret, true);
 		deep = true;
 	}
 
@@ -1468,36 +1585,16 @@ dom_exception dom_document_dup_node(dom_document *doc, dom_node *node,
 	}
 
 	if (deep == true) {
-		child = ((dom_node_internal *) node)->first_child;
-		while (child != NULL) {
-			err = dom_document_import_node(doc, child, deep,
-					(void *) &r);
-			if (err != DOM_NO_ERR) {
-				dom_node_unref(ret);
-				return err;
-			}
-
-			err = dom_node_append_child(ret, r, (void *) &r);
-			if (err != DOM_NO_ERR) {
-				dom_node_unref(ret);
-				dom_node_unref(r);
-				return err;
-			}
-			dom_node_unref(r);
-
-			child = child->next;
+		/* Imported EntityReferences are not given children */
+		err = _dom_node_copy_children(n, ret, false);
+		if (err != DOM_NO_ERR) {
+			dom_node_unref(ret);
+			return err;
 		}
 	}
 
 	/* Call the dom_user_data_handlers */
-	ud = n->user_data;
-	while (ud != NULL) {
-		if (ud->handler != NULL) {
-			ud->handler(opt, ud->key, ud->data, node, 
-					(dom_node *) ret);
-		}
-		ud = ud->next;
-	}
+	_dom_node_call_user_data_handlers(n, ret, opt);
 
 	*result = (dom_node *) ret;
 
@@ -1534,6 +1631,522 @@ void _dom_document_set_id_name(dom_document *doc, dom_string *name)
 	if (doc->id_name != NULL)
 		dom_string_unref(doc->id_name);
 	doc->id_name = dom_string_ref(name);
+
+	/* Every element's ID may have changed; rebuild on next lookup */
+	_dom_document_id_index_drop(doc);
+}
+
+/**
+ * Note a change to an element's attributes
+ *
+ * \param doc  The document owning the element, or NULL
+ * \param ele  The element
+ *
+ * This is also used for changes to other element state which decides
+ * membership of an HTMLCollection, such as a form control's form.
+ */
+void _dom_document_element_changed(dom_document *doc, dom_element *ele)
+{
+	if (doc == NULL)
+		return;
+
+	doc->attr_generation++;
+
+	_dom_document_id_index_update(doc, ele);
+}
+
+/*-----------------------------------------------------------------------*/
+/* The ID index */
+
+/**
+ * Determine whether a node is attached to the document's tree
+ *
+ * \param doc   The document
+ * \param node  The node to test
+ * \return true if ::node is in ::doc's tree, false otherwise
+ *
+ * Attributes, and the content of attributes, are considered to be in the
+ * tree if their owning element is.
+ */
+bool _dom_document_contains(dom_document *doc, dom_node_internal *node)
+{
+	while (node->parent != NULL)
+		node = node->parent;
+
+	return node == &doc->base;
+}
+
+/**
+ * Determine whether one node precedes another in tree order
+ *
+ * \param a  The first node
+ * \param b  The second node, which must be in the same tree as ::a
+ * \return true if ::a precedes ::b, false otherwise
+ */
+bool _dom_document_precedes(dom_node_internal *a, dom_node_internal *b)
+{
+	if (a == b)
+		return false;
+
+	return (_dom_document_compare_position(b, a) &
+			DOM_DOCUMENT_POSITION_PRECEDING) != 0;
+}
+
+/**
+ * Compare the positions of two nodes in tree order
+ *
+ * \param node   The reference node
+ * \param other  The node to compare, which is not ::node
+ * \return the position of ::other relative to ::node, as a bitfield of
+ *         dom_document_position values.
+ *
+ * An Attr is treated as the root of a tree, holding its children, as it
+ * has no parent node.  Attrs should be replaced by their elements before
+ * calling this, as the DOM places them between their element and its
+ * children.
+ *
+ * Nodes in a document's tree are compared using the document's order
+ * index.  The index is rebuilt in one pass over the tree, so while the
+ * tree is changing nodes are instead compared by walking their ancestors.
+ * The index is rebuilt once the steps walked since the tree last changed
+ * add up to the number of nodes it last held, so the cost of a query is
+ * amortised O(1) when queries outnumber changes, and is never worse than
+ * about twice the cost of walking.
+ */
+uint16_t _dom_document_compare_position(dom_node_internal *node,
+		dom_node_internal *other)
+{
+	dom_document *doc = node->owner;
+	dom_node_internal *root;
+	uint32_t steps;
+	uint16_t position;
+
+	if (doc != NULL && other->owner == doc && doc->order_stamp != 0 &&
+			doc->order_generation == doc->tree_generation &&
+			node->order_stamp == doc->order_stamp &&
+			other->order_stamp == doc->order_stamp) {
+		if (other->order < node->order && node->order <=
+				other->order_last)
+			return DOM_DOCUMENT_POSITION_CONTAINS |
+					DOM_DOCUMENT_POSITION_PRECEDING;
+
+		if (node->order < other->order && other->order <=
+				node->order_last)
+			return DOM_DOCUMENT_POSITION_CONTAINED_BY |
+					DOM_DOCUMENT_POSITION_FOLLOWING;
+
+		return other->order < node->order ?
+				DOM_DOCUMENT_POSITION_PRECEDING :
+				DOM_DOCUMENT_POSITION_FOLLOWING;
+	}
+
+	position = _dom_document_walk_position(node, other, &root, &steps);
+
+	if (doc != NULL && root == &doc->base) {
+		doc->order_work += steps;
+		if (doc->order_work >= doc->order_size)
+			_dom_document_order_build(doc);
+	}
+
+	return position;
+}
+
+/**
+ * Compare the positions of two nodes by walking their ancestors
+ *
+ * \param node   The reference node
+ * \param other  The node to compare, which is not ::node
+ * \param root   Pointer to location to receive the root of the nodes'
+ *               tree, or NULL if they are in different trees
+ * \param steps  Pointer to location to receive the number of nodes visited
+ * \return the position of ::other relative to ::node.
+ */
+uint16_t _dom_document_walk_position(dom_node_internal *node,
+		dom_node_internal *other, dom_node_internal **root,
+		uint32_t *steps)
+{
+	dom_node_internal *a, *b, *n;
+	uint32_t depth_a = 0, depth_b = 0;
+
+	for (a = node; a->parent != NULL &&
+			a->type != DOM_ATTRIBUTE_NODE; a = a->parent)
+		depth_a++;
+	for (b = other; b->parent != NULL &&
+			b->type != DOM_ATTRIBUTE_NODE; b = b->parent)
+		depth_b++;
+
+	*steps = depth_a + depth_b;
+
+	if (a != b) {
+		/* Disconnected nodes are ordered consistently, but
+		 * arbitrarily */
+		*root = NULL;
+		return DOM_DOCUMENT_POSITION_DISCONNECTED |
+				DOM_DOCUMENT_POSITION_IMPLEMENTATION_SPECIFIC |
+				((uintptr_t) other < (uintptr_t) node ?
+				DOM_DOCUMENT_POSITION_PRECEDING :
+				DOM_DOCUMENT_POSITION_FOLLOWING);
+	}
+
+	*root = a;
+
+	/* Bring both nodes up to the same depth. If one is then the other,
+	 * it is an ancestor of the other. */
+	for (a = node; depth_a > depth_b; depth_a--)
+		a = a->parent;
+	if (a == other)
+		return DOM_DOCUMENT_POSITION_CONTAINS |
+				DOM_DOCUMENT_POSITION_PRECEDING;
+
+	for (b = other; depth_b > depth_a; depth_b--)
+		b = b->parent;
+	if (b == node)
+		return DOM_DOCUMENT_POSITION_CONTAINED_BY |
+				DOM_DOCUMENT_POSITION_FOLLOWING;
+
+	/* Climb to the children of the nearest common ancestor */
+	while (a->parent != b->parent) {
+		a = a->parent;
+		b = b->parent;
+	}
+
+	for (n = a->next; n != NULL; n = n->next) {
+		(*steps)++;
+
+		if (n == b)
+			return DOM_DOCUMENT_POSITION_FOLLOWING;
+	}
+
+	return DOM_DOCUMENT_POSITION_PRECEDING;
+}
+
+/**
+ * Build a document's order index
+ *
+ * \param doc  The document
+ *
+ * Each node in the tree is numbered in tree order, and also records the
+ * number of its last descendant, so that one node contains another if
+ * the other's number lies between those two.
+ */
+void _dom_document_order_build(dom_document *doc)
+{
+	dom_node_internal *root = &doc->base;
+	dom_node_internal *node = root;
+	uint32_t order = 0;
+	uint32_t stamp = doc->order_stamp + 1;
+
+	/* Nodes not in any index have a stamp of 0 */
+	if (stamp == 0)
+		stamp = 1;
+
+	while (node != NULL) {
+		node->order = order++;
+		node->order_stamp = stamp;
+
+		if (node->first_child != NULL) {
+			node = node->first_child;
+			continue;
+		}
+
+		/* Close the subtrees which end here */
+		while (node != root && node->next == NULL) {
+			node->order_last = order - 1;
+			node = node->parent;
+		}
+
+		node->order_last = order - 1;
+
+		node = (node != root) ? node->next : NULL;
+	}
+
+	doc->order_stamp = stamp;
+	doc->order_generation = doc->tree_generation;
+	doc->order_size = order;
+	doc->order_work = 0;
+}
+
+/**
+ * Advance a depth-first walk of a subtree
+ *
+ * \param root  The root of the subtree
+ * \param node  The current position of the walk
+ * \return The next node in tree order, or NULL at the end of the subtree
+ */
+static dom_node_internal *_dom_document_walk_next(dom_node_internal *root,
+		dom_node_internal *node)
+{
+	if (node->first_child != NULL)
+		return node->first_child;
+
+	while (node != root) {
+		if (node->next != NULL)
+			return node->next;
+
+		node = node->parent;
+	}
+
+	return NULL;
+}
+
+static uint32_t id_index_hash(void *key, void *pw)
+{
+	UNUSED(pw);
+
+	return dom_string_hash(key);
+}
+
+static bool id_index_key_isequal(void *key1, void *key2, void *pw)
+{
+	UNUSED(pw);
+
+	return dom_string_isequal(key1, key2);
+}
+
+static void id_index_destroy_key(void *key, void *pw)
+{
+	/* The key is owned by the entry, see id_index_destroy_value */
+	UNUSED(key);
+	UNUSED(pw);
+}
+
+static void id_index_destroy_value(void *value, void *pw)
+{
+	struct dom_doc_id_entry *entry = value;
+
+	UNUSED(pw);
+
+	dom_string_unref(entry->id);
+	free(entry);
+}
+
+/* The index is never cloned, so the clone functions are not provided */
+static const dom_hash_vtable id_index_vtable = {
+	id_index_hash,
+	NULL,
+	id_index_destroy_key,
+	NULL,
+	id_index_destroy_value,
+	id_index_key_isequal
+};
+
+/**
+ * File an element in the ID index under its current ID
+ *
+ * \param doc  The document, which must have an ID index
+ * \param ele  The element, which must be in the document's tree
+ * \return true on success, false on memory exhaustion
+ */
+static bool _dom_document_id_index_file(dom_document *doc, dom_element *ele)
+{
+	struct dom_doc_id_entry *entry, *temp;
+	dom_string *id;
+
+	if (_dom_element_get_id(ele, &id) != DOM_NO_ERR)
+		return false;
+
+	if (ele->indexed_id != NULL) {
+		if (id != NULL && dom_string_isequal(id, ele->indexed_id)) {
+			/* Already filed under the right ID */
+			dom_string_unref(id);
+			return true;
+		}
+
+		_dom_document_id_index_remove(doc, ele);
+	}
+
+	if (id == NULL)
+		return true;
+
+	entry = _dom_hash_get(doc->id_index, id);
+	if (entry == NULL) {
+		entry = malloc(sizeof(*entry) + sizeof(dom_element *));
+		if (entry == NULL) {
+			dom_string_unref(id);
+			return false;
+		}
+
+		entry->id = dom_string_ref(id);
+		entry->n_elements = 0;
+		entry->alloc = 1;
+
+		if (_dom_hash_add(doc->id_index, entry->id, entry,
+				false) == false) {
+			dom_string_unref(entry->id);
+			free(entry);
+			dom_string_unref(id);
+			return false;
+		}
+	} else if (entry->n_elements == entry->alloc) {
+		temp = realloc(entry, sizeof(*entry) +
+				2 * entry->alloc * sizeof(dom_element *));
+		if (temp == NULL) {
+			dom_string_unref(id);
+			return false;
+		}
+
+		entry = temp;
+		entry->alloc *= 2;
+
+		/* The key is unchanged, so this only replaces the value */
+		_dom_hash_add(doc->id_index, entry->id, entry, true);
+	}
+
+	entry->elements[entry->n_elements++] = ele;
+
+	/* Transfer our reference to the element */
+	ele->indexed_id = id;
+
+	return true;
+}
+
+/**
+ * Build the document's ID index from its tree
+ *
+ * \param doc  The document
+ *
+ * On memory exhaustion, the document is left without an index.
+ */
+void _dom_document_id_index_build(dom_document *doc)
+{
+	doc->id_index = _dom_hash_create(DOM_DOC_ID_INDEX_CHAINS,
+			&id_index_vtable, NULL);
+	if (doc->id_index != NULL)
+		_dom_document_id_index_add_subtree(doc, &doc->base);
+}
+
+/**
+ * Discard the document's ID index
+ *
+ * \param doc  The document
+ *
+ * The index will be rebuilt by the next call to getElementById.
+ */
+void _dom_document_id_index_drop(dom_document *doc)
+{
+	dom_hash_table *index = doc->id_index;
+	dom_node_internal *node;
+
+	if (index == NULL)
+		return;
+
+	doc->id_index = NULL;
+
+	/* Only elements in the tree can be filed in the index */
+	for (node = &doc->base; node != NULL;
+			node = _dom_document_walk_next(&doc->base, node)) {
+		if (node->type == DOM_ELEMENT_NODE)
+			_dom_document_id_index_remove(doc,
+					(dom_element *) node);
+	}
+
+	_dom_hash_destroy(index);
+}
+
+/**
+ * Add the elements of a subtree which was just inserted into the tree
+ *
+ * \param doc   The document, or NULL
+ * \param root  The root of the subtree
+ */
+void _dom_document_id_index_add_subtree(dom_document *doc,
+		dom_node_internal *root)
+{
+	dom_node_internal *node;
+
+	if (doc == NULL || doc->id_index == NULL ||
+			_dom_document_contains(doc, root) == false)
+		return;
+
+	for (node = root; node != NULL;
+			node = _dom_document_walk_next(root, node)) {
+		if (node->type != DOM_ELEMENT_NODE)
+			continue;
+
+		if (_dom_document_id_index_file(doc,
+				(dom_element *) node) == false) {
+			_dom_document_id_index_drop(doc);
+			return;
+		}
+	}
+}
+
+/**
+ * Remove the elements of a subtree which is about to leave the tree
+ *
+ * \param doc   The document, or NULL
+ * \param root  The root of the subtree
+ */
+void _dom_document_id_index_remove_subtree(dom_document *doc,
+		dom_node_internal *root)
+{
+	dom_node_internal *node;
+
+	if (doc == NULL || doc->id_index == NULL)
+		return;
+
+	for (node = root; node != NULL;
+			node = _dom_document_walk_next(root, node)) {
+		if (node->type == DOM_ELEMENT_NODE)
+			_dom_document_id_index_remove(doc,
+					(dom_element *) node);
+	}
+}
+
+/**
+ * Refile an element whose ID may have changed
+ *
+ * \param doc  The document
+ * \param ele  The element
+ */
+void _dom_document_id_index_update(dom_document *doc, dom_element *ele)
+{
+	if (doc->id_index == NULL)
+		return;
+
+	if (_dom_document_contains(doc, (dom_node_internal *) ele) == false) {
+		_dom_document_id_index_remove(doc, ele);
+		return;
+	}
+
+	if (_dom_document_id_index_file(doc, ele) == false)
+		_dom_document_id_index_drop(doc);
+}
+
+/**
+ * Remove an element from the ID index
+ *
+ * \param doc  The document
+ * \param ele  The element
+ */
+void _dom_document_id_index_remove(dom_document *doc, dom_element *ele)
+{
+	struct dom_doc_id_entry *entry;
+	uint32_t i;
+
+	if (ele->indexed_id == NULL)
+		return;
+
+	if (doc->id_index != NULL) {
+		entry = _dom_hash_get(doc->id_index, ele->indexed_id);
+		assert(entry != NULL);
+
+		for (i = 0; i < entry->n_elements; i++) {
+			if (entry->elements[i] == ele) {
+				entry->elements[i] =
+					entry->elements[--entry->n_elements];
+				break;
+			}
+		}
+
+		if (entry->n_elements == 0) {
+			_dom_hash_del(doc->id_index, entry->id);
+			id_index_destroy_value(entry, NULL);
+		}
+	}
+
+	dom_string_unref(ele->indexed_id);
+	ele->indexed_id = NULL;
 }
 
 /*-----------------------------------------------------------------------*/
@@ -1552,3 +2165,37 @@ dom_exception _dom_document_set_quirks_mode(dom_document *doc,
 	doc->quirks = quirks;
 	return DOM_NO_ERR;
 }
+
+/**
+ * Determine whether a document dispatches mutation events
+ *
+ * \param doc      The document
+ * \param enabled  Pointer to location to receive result
+ * \return DOM_NO_ERR.
+ */
+dom_exception _dom_document_get_mutation_events(dom_document *doc,
+		bool *enabled)
+{
+	*enabled = doc->mutation_events;
+	return DOM_NO_ERR;
+}
+
+/**
+ * Control whether a document dispatches mutation events
+ *
+ * \param doc      The document
+ * \param enabled  Whether mutation events should be dispatched
+ * \return DOM_NO_ERR.
+ *
+ * While mutation events are disabled, changes to the document's nodes
+ * neither create nor dispatch DOMNodeInserted, DOMNodeRemoved,
+ * DOMNodeInsertedIntoDocument, DOMNodeRemovedFromDocument,
+ * DOMAttrModified, DOMCharacterDataModified or DOMSubtreeModified events.
+ * This is intended for bulk tree construction, such as parsing.
+ */
+dom_exception _dom_document_set_mutation_events(dom_document *doc,
+		bool enabled)
+{
+	doc->mutation_events = enabled;
+	return DOM_NO_ERR;
+}
@@ -30,6 +30,7 @@
 
 #include "utils/hashtable.h"
 #include "utils/list.h"
+#include "utils/pool.h"
 
 #include "events/document_event.h"
 
@@ -45,6 +46,12 @@ struct dom_document {
 
 	struct dom_doc_nl *nodelists;	/**< List of active nodelists */
 
+	/* The class and script strings, and the memoised strings below,
+	 * are borrowed from the shared strings: the document holds no
+	 * references to them */
+	struct dom_document_strings *strings;
+			/**< Strings shared with other documents */
+
 	dom_string *uri;		/**< The uri of this document */
 
 	struct list_entry pending_nodes;
@@ -52,6 +59,24 @@ struct dom_document {
 
 	dom_string *id_name;		/**< The ID attribute's name */
 
+	dom_hash_table *id_index;	/**< Map of ID to elements, built
+					 * lazily by getElementById */
+
+	uint64_t tree_generation;	/**< Incremented whenever the
+					 * structure of the tree changes */
+	uint64_t attr_generation;	/**< Incremented whenever an
+					 * element's attributes change */
+
+	uint32_t order_stamp;		/**< Stamp of the nodes in the order
+					 * index, or 0 if it isn't built */
+	uint64_t order_generation;	/**< Tree generation the order index
+					 * was built for */
+	uint32_t order_size;		/**< Nodes in the order index */
+	uint32_t order_work;		/**< Steps walked comparing nodes
+					 * since the index was built */
+
+	dom_pool *node_pool;		/**< Memory for the document's nodes */
+
 	dom_string *class_string;	/**< The string "class". */
 
 	dom_string *script_string;	/**< The string "script". */
@@ -60,6 +85,8 @@ struct dom_document {
 			/**< The DocumentEvent interface */
 	dom_document_quirks_mode quirks;
 				/**< Document is in quirks mode */
+	bool mutation_events;		/**< Whether mutation events are
+					 * dispatched */
 	dom_string *_memo_empty;	/**< The string ''. */
 
 	/* Memoised event strings */
@@ -85,6 +112,9 @@ dom_exception _dom_document_initialise(dom_document *doc,
 /* Finalise the document */
 bool _dom_document_finalise(dom_document *doc);
 
+/* Finalise the strings shared by documents */
+void _dom_document_strings_finalise(void);
+
 /* Begin the virtual functions */
 dom_exception _dom_document_get_doctype(dom_document *doc,
 		dom_document_type **result);
@@ -245,8 +275,8 @@ dom_exception _dom_document_set_text_content(dom_node_internal *node,
 
 /* Following comes the protected vtable  */
 void _dom_document_destroy(dom_node_internal *node);
-dom_exception _dom_document_copy(dom_node_internal *old, 
-		dom_node_internal **copy);
+dom_exception _dom_document_copy(dom_node_internal *old,
+		struct dom_document *doc, dom_node_internal **copy);
 
 #define DOM_DOCUMENT_PROTECT_VTABLE \
 	_dom_document_destroy, \
@@ -275,6 +305,39 @@ dom_exception _dom_find_element_by_id(dom_node_internal *root,
 /* Set the ID attribute name of this document */
 void _dom_document_set_id_name(dom_document *doc, dom_string *name);
 
+/* Maintain the document's ID index */
+void _dom_document_id_index_add_subtree(dom_document *doc,
+		dom_node_internal *root);
+void _dom_document_id_index_remove_subtree(dom_document *doc,
+		dom_node_internal *root);
+void _dom_document_id_index_remove(dom_document *doc,
+		dom_element *ele);
+
+/* Note a change to an element's attributes */
+void _dom_document_element_changed(dom_document *doc, dom_element *ele);
+
+/* Tree order helpers */
+bool _dom_document_contains(dom_document *doc, dom_node_internal *node);
+bool _dom_document_precedes(dom_node_internal *a, dom_node_internal *b);
+uint16_t _dom_document_compare_position(dom_node_internal *node,
+		dom_node_internal *other);
+
 #define _dom_document_get_id_name(d) (d->id_name)
 
+/**
+ * Note a change to the structure of a document's tree
+ *
+ * \param doc  The document, or NULL
+ *
+ * Anything which caches the result of walking the tree compares the
+ * generation it saw against the current one to see if it is stale.
+ * Generations are 64 bits wide so that they never wrap: a cache of node
+ * pointers which matched after a wrap would hold freed nodes.
+ */
+static inline void _dom_document_tree_changed(dom_document *doc)
+{
+	if (doc != NULL)
+		doc->tree_generation++;
+}
+
 #endif
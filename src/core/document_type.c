@@ -69,7 +69,7 @@ dom_exception _dom_document_type_create(dom_string *qname,
 	dom_exception err;
 
 	/* Create node */
-	result = malloc(sizeof(dom_document_type));
+	result = _dom_node_alloc(NULL, sizeof(dom_document_type));
 	if (result == NULL)
 		return DOM_NO_MEM_ERR;
 
@@ -80,7 +80,7 @@ dom_exception _dom_document_type_create(dom_string *qname,
 	err = _dom_document_type_initialise(result, qname, 
 			public_id, system_id);
 	if (err != DOM_NO_ERR) {
-		free(result);
+		_dom_node_free(result);
 		return err;
 	}
 
@@ -104,7 +104,7 @@ void _dom_document_type_destroy(dom_node_internal *doctypenode)
 	_dom_document_type_finalise(doctype);
 
 	/* Free doctype */
-	free(doctype);
+	_dom_node_free(doctype);
 }
 
 /* Initialise this document_type */
@@ -333,9 +333,11 @@ void _dom_dt_destroy(dom_node_internal *node)
 }
 
 /* The copy constructor of this class */
-dom_exception _dom_dt_copy(dom_node_internal *old, dom_node_internal **copy)
+dom_exception _dom_dt_copy(dom_node_internal *old,
+		struct dom_document *doc, dom_node_internal **copy)
 {
 	UNUSED(old);
+	UNUSED(doc);
 	UNUSED(copy);
 
 	return DOM_NOT_SUPPORTED_ERR;
@@ -98,7 +98,8 @@ dom_exception _dom_document_type_set_text_content(dom_node_internal *node,
 
 /* Following comes the protected vtable  */
 void _dom_dt_destroy(dom_node_internal *node);
-dom_exception _dom_dt_copy(dom_node_internal *old, dom_node_internal **copy);
+dom_exception _dom_dt_copy(dom_node_internal *old,
+		struct dom_document *doc, dom_node_internal **copy);
 
 #define DOM_DT_PROTECT_VTABLE \
 	_dom_dt_destroy, \
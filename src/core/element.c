@@ -26,10 +26,11 @@
 #include "core/element.h"
 #include "core/node.h"
 #include "core/namednodemap.h"
+#include "core/nodelist.h"
+#include "core/selector.h"
 #include "utils/validate.h"
 #include "utils/namespace.h"
 #include "utils/utils.h"
-#include "utils/list.h"
 #include "events/mutation_event.h"
 
 const struct dom_element_vtable _dom_element_vtable = {
@@ -50,13 +51,36 @@ static const struct dom_element_protected_vtable element_protect_vtable = {
 };
 
 
+/** The number of attributes an element's attribute list starts out with */
+#define DOM_ATTR_LIST_INITIAL 4
+
+/** The number of attributes above which a list maintains a hashed index */
+#define DOM_ATTR_LIST_INDEX_THRESHOLD 8
+
+typedef struct dom_attr_list_entry {
+	struct dom_attr *attr;		/**< The attribute node */
+
+	struct dom_string *name;	/**< The attribute's name */
+	struct dom_string *namespace;	/**< The attribute's namespace */
+} dom_attr_list_entry;
+
+/**
+ * An element's attributes, in the order they were added
+ *
+ * The entries are stored inline, so an element's attributes take a single
+ * allocation and can be indexed directly.  Short lists are searched
+ * linearly; longer ones also keep an open addressed hash table of entry
+ * numbers keyed on (namespace, name).
+ */
 typedef struct dom_attr_list {
-	struct list_entry list; /**< Linked list links to prev/next entries */
-	
-	struct dom_attr *attr;
+	uint32_t n_entries;	/**< The number of attributes */
+	uint32_t alloc_entries;	/**< The number of entries allocated */
 
-	struct dom_string *name;
-	struct dom_string *namespace;
+	uint32_t *index;	/**< Entry number + 1 for each hash slot, or
+				 * NULL if the list is searched linearly */
+	uint32_t index_size;	/**< The number of hash slots, a power of 2 */
+
+	dom_attr_list_entry entries[];	/**< The attributes */
 } dom_attr_list;
 
 
@@ -147,44 +171,89 @@ error:
 	return DOM_NO_MEM_ERR;
 }
 
-/* Attribute linked list releated functions */
+/* Attribute list releated functions */
 
 /**
- * Get the next attribute in the list
+ * Test whether an attribute list entry has the given name
  *
- * \param n  The attribute list node
- * \return The next attribute node
+ * \param entry      The attribute list entry
+ * \param name       The name to test for
+ * \param namespace  The namespace to test for (may be NULL)
+ * \return true if the entry matches, false otherwise
  */
-static dom_attr_list * _dom_element_attr_list_next(const dom_attr_list *n)
+static inline bool _dom_element_attr_list_entry_matches(
+		const dom_attr_list_entry *entry, dom_string *name,
+		dom_string *namespace)
 {
-	return (dom_attr_list *)(n->list.next);
+	/* Both have NULL namespace or matching namespace, and both have
+	 * same name */
+	return ((namespace == NULL && entry->namespace == NULL) ||
+			(namespace != NULL && entry->namespace != NULL &&
+					dom_string_isequal(namespace,
+					entry->namespace))) &&
+			dom_string_isequal(name, entry->name);
 }
 
 /**
- * Unlink an attribute list node from its linked list
+ * Add an entry to an attribute list's hashed index
+ *
+ * \param list   The attribute list
+ * \param entry  The number of the entry to add
  *
- * \param n  The attribute list node
+ * Only the name is hashed; attributes which differ only by namespace are
+ * rare enough that they may share a probe sequence.
  */
-static void _dom_element_attr_list_node_unlink(dom_attr_list *n)
+static void _dom_element_attr_list_index_insert(dom_attr_list *list,
+		uint32_t entry)
 {
-	if (n == NULL)
-		return;
+	uint32_t mask = list->index_size - 1;
+	uint32_t slot = dom_string_hash(list->entries[entry].name) & mask;
 
-	list_del(&n->list);
+	while (list->index[slot] != 0)
+		slot = (slot + 1) & mask;
+
+	list->index[slot] = entry + 1;
 }
 
 /**
- * Insert attribute list node into attribute list
+ * (Re)build an attribute list's hashed index
+ *
+ * \param list  The attribute list
  *
- * \param list      The list header
- * \param new_attr  The attribute node to insert
+ * The index is dropped if the list is short enough to be searched
+ * linearly.  If there is no memory for the index, the list is searched
+ * linearly until the index is next rebuilt.
  */
-static void _dom_element_attr_list_insert(dom_attr_list *list,
-		dom_attr_list *new_attr)
+static void _dom_element_attr_list_index_build(dom_attr_list *list)
 {
-	assert(list != NULL);
-	assert(new_attr != NULL);
-	list_append(&list->list, &new_attr->list);
+	uint32_t size = 2 * DOM_ATTR_LIST_INDEX_THRESHOLD;
+	uint32_t i;
+
+	if (list->n_entries <= DOM_ATTR_LIST_INDEX_THRESHOLD) {
+		free(list->index);
+		list->index = NULL;
+		list->index_size = 0;
+		return;
+	}
+
+	/* Keep the load factor at or below a half */
+	while (size < 2 * list->alloc_entries)
+		size *= 2;
+
+	if (list->index_size != size) {
+		free(list->index);
+		list->index = calloc(size, sizeof(uint32_t));
+		if (list->index == NULL) {
+			list->index_size = 0;
+			return;
+		}
+		list->index_size = size;
+	} else {
+		memset(list->index, 0, size * sizeof(uint32_t));
+	}
+
+	for (i = 0; i < list->n_entries; i++)
+		_dom_element_attr_list_index_insert(list, i);
 }
 
 /**
@@ -194,29 +263,37 @@ static void _dom_element_attr_list_insert(dom_attr_list *list,
  * \param name  The name of the attribute to search for
  * \param name  The namespace of the attribute to search for (may be NULL)
  * \return the matching attribute, or NULL if none found
+ *
+ * The returned entry is only valid until the list is next modified.
  */
-static dom_attr_list * _dom_element_attr_list_find_by_name(
+static dom_attr_list_entry * _dom_element_attr_list_find_by_name(
 		dom_attr_list *list, dom_string *name, dom_string *namespace)
 {
-	dom_attr_list *attr = list;
+	uint32_t i;
 
 	if (list == NULL || name == NULL)
 		return NULL;
 
-	do {
-		if (((namespace == NULL && attr->namespace == NULL) ||
-				(namespace != NULL && attr->namespace != NULL &&
-						dom_string_isequal(namespace,
-						attr->namespace))) &&
-				dom_string_isequal(name, attr->name)) {
-			/* Both have NULL namespace or matching namespace,
-			 * and both have same name */
-			return attr;
+	if (list->index != NULL) {
+		uint32_t mask = list->index_size - 1;
+		uint32_t slot = dom_string_hash(name) & mask;
+
+		while ((i = list->index[slot]) != 0) {
+			if (_dom_element_attr_list_entry_matches(
+					&list->entries[i - 1], name, namespace))
+				return &list->entries[i - 1];
+
+			slot = (slot + 1) & mask;
 		}
 
-		attr = _dom_element_attr_list_next(attr);
-		assert(attr != NULL);
-	} while (attr != list);
+		return NULL;
+	}
+
+	for (i = 0; i < list->n_entries; i++) {
+		if (_dom_element_attr_list_entry_matches(&list->entries[i],
+				name, namespace))
+			return &list->entries[i];
+	}
 
 	return NULL;
 }
@@ -229,202 +306,238 @@ static dom_attr_list * _dom_element_attr_list_find_by_name(
  */
 static unsigned int _dom_element_attr_list_length(dom_attr_list *list)
 {
-	dom_attr_list *attr = list;
-	unsigned int count = 0;
-
 	if (list == NULL)
-		return count;
+		return 0;
 
-	do {
-		count++;
-
-		attr = _dom_element_attr_list_next(attr);
-	} while (attr != list);
-
-	return count;
+	return list->n_entries;
 }
 
 /**
- * Get the attribute list node at the given index
+ * Get the attribute list entry at the given index
  *
  * \param list   The attribute list
- * \param index  The index number
- * \return the attribute list node at given index
+ * \param index  The index number, based on zero
+ * \return the attribute list entry at given index, or NULL if out of range
  */
-static dom_attr_list * _dom_element_attr_list_get_by_index(dom_attr_list *list,
-		unsigned int index)
+static dom_attr_list_entry * _dom_element_attr_list_get_by_index(
+		dom_attr_list *list, unsigned int index)
 {
-	dom_attr_list *attr = list;
-
-	if (list == NULL)
+	if (list == NULL || index >= list->n_entries)
 		return NULL;
 
-	do {
-		if (--index == 0)
-			return attr;
+	return &list->entries[index];
+}
 
-		attr = _dom_element_attr_list_next(attr);
-	} while (attr != list);
+/**
+ * Detach an attribute from its element, destroying it if unreferenced
+ *
+ * \param attr  The attribute
+ */
+static void _dom_element_attr_release(dom_attr *attr)
+{
+	dom_node_internal *a = (dom_node_internal *) attr;
 
-	return NULL;
+	a->parent = NULL;
+	dom_node_try_destroy(a);
 }
 
 /**
- * Destroy an attribute list node, and its attribute
+ * Release an attribute list entry's references, and its attribute
  *
- * \param n  The attribute list node to destroy
+ * \param entry  The attribute list entry to release
  */
-static void _dom_element_attr_list_node_destroy(dom_attr_list *n)
+static void _dom_element_attr_list_entry_release(dom_attr_list_entry *entry)
 {
-	dom_node_internal *a;
-	dom_document *doc;
+	assert(entry->attr != NULL);
+	assert(entry->name != NULL);
+
+	dom_string_unref(entry->name);
 
-	assert(n != NULL);
-	assert(n->attr != NULL);
-	assert(n->name != NULL);
+	if (entry->namespace != NULL)
+		dom_string_unref(entry->namespace);
+
+	_dom_element_attr_release(entry->attr);
+}
 
-	a = (dom_node_internal *) n->attr;
+/**
+ * Destroy an attribute list entry, and its attribute
+ *
+ * \param ele    The element owning the entry
+ * \param entry  The attribute list entry to destroy
+ */
+static void _dom_element_attr_list_entry_destroy(dom_element *ele,
+		dom_attr_list_entry *entry)
+{
+	dom_document *doc = ((dom_node_internal *) ele)->owner;
 
 	/* Need to destroy classes cache, when removing class attribute */
-	doc = a->owner;
-	if (n->namespace == NULL &&
-			dom_string_isequal(n->name, doc->class_string)) {
-		_dom_element_destroy_classes((dom_element *)(a->parent));
+	if (entry->namespace == NULL &&
+			dom_string_isequal(entry->name, doc->class_string)) {
+		_dom_element_destroy_classes(ele);
 	}
 
-	/* Destroy rest of list node */
-	dom_string_unref(n->name);
+	_dom_element_attr_list_entry_release(entry);
+}
+
+/**
+ * Ensure an element's attribute list has room for more attributes
+ *
+ * \param ele    The element
+ * \param extra  The number of attributes about to be added
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ */
+static dom_exception _dom_element_attr_list_reserve(dom_element *ele,
+		uint32_t extra)
+{
+	dom_attr_list *list = ele->attributes;
+	uint32_t used = list == NULL ? 0 : list->n_entries;
+	dom_attr_list *new_list;
+
+	if (list != NULL && list->alloc_entries - used >= extra)
+		return DOM_NO_ERR;
 
-	if (n->namespace != NULL)
-		dom_string_unref(n->namespace);
+	new_list = realloc(list, sizeof(*new_list) +
+			(used + extra) * sizeof(dom_attr_list_entry));
+	if (new_list == NULL)
+		return DOM_NO_MEM_ERR;
 
-	a->parent = NULL;
-	dom_node_try_destroy(a);
+	if (list == NULL) {
+		new_list->n_entries = 0;
+		new_list->index = NULL;
+		new_list->index_size = 0;
+	}
+	new_list->alloc_entries = used + extra;
+
+	ele->attributes = new_list;
 
-	free(n);
+	return DOM_NO_ERR;
 }
 
 /**
- * Create an attribute list node
+ * Append an attribute to an element's attribute list
  *
- * \param attr       The attribute to create a list node for
+ * \param ele        The element
+ * \param attr       The attribute to add
  * \param name       The attribute name
  * \param namespace  The attribute namespace (may be NULL)
- * \return the new attribute list node, or NULL on failure
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ *
+ * ::name and ::namespace will have their reference counts increased.
+ * The list takes over the caller's ownership of ::attr on success.
  */
-static dom_attr_list * _dom_element_attr_list_node_create(dom_attr *attr,
-		dom_element *ele, dom_string *name, dom_string *namespace)
+static dom_exception _dom_element_attr_list_add(dom_element *ele,
+		dom_attr *attr, dom_string *name, dom_string *namespace)
 {
-	dom_attr_list *new_list_node;
-	dom_node_internal *a;
-	dom_document *doc;
+	dom_attr_list *list = ele->attributes;
+	dom_attr_list_entry *entry;
+	dom_document *doc = ((dom_node_internal *) attr)->owner;
 
 	if (attr == NULL || name == NULL)
-		return NULL;
+		return DOM_NO_MEM_ERR;
 
-	new_list_node = malloc(sizeof(*new_list_node));
-	if (new_list_node == NULL)
-		return NULL;
+	if (list == NULL || list->n_entries == list->alloc_entries) {
+		dom_exception err;
 
-	list_init(&new_list_node->list);
+		err = _dom_element_attr_list_reserve(ele, list == NULL ?
+				DOM_ATTR_LIST_INITIAL : list->alloc_entries);
+		if (err != DOM_NO_ERR)
+			return err;
 
-	new_list_node->attr = attr;
-	new_list_node->name = name;
-	new_list_node->namespace = namespace;
+		list = ele->attributes;
+	}
 
-	a = (dom_node_internal *) attr;
-	doc = a->owner;
 	if (namespace == NULL &&
 			dom_string_isequal(name, doc->class_string)) {
 		dom_string *value;
+		dom_exception err;
 
-		if (DOM_NO_ERR != _dom_attr_get_value(attr, &value)) {
-			_dom_element_attr_list_node_destroy(new_list_node);
-			return NULL;
-		}
-
-		if (DOM_NO_ERR != _dom_element_create_classes(ele,
-				dom_string_data(value))) {
-			_dom_element_attr_list_node_destroy(new_list_node);
-			dom_string_unref(value);
-			return NULL;
-		}
+		err = _dom_attr_get_value(attr, &value);
+		if (err != DOM_NO_ERR)
+			return err;
 
+		err = _dom_element_create_classes(ele,
+				dom_string_data(value));
 		dom_string_unref(value);
+		if (err != DOM_NO_ERR)
+			return err;
+	}
+
+	entry = &list->entries[list->n_entries++];
+	entry->attr = attr;
+	entry->name = dom_string_ref(name);
+	entry->namespace = dom_string_ref(namespace);
+
+	if (list->n_entries > DOM_ATTR_LIST_INDEX_THRESHOLD) {
+		if (list->index != NULL &&
+				list->index_size >= 2 * list->alloc_entries)
+			_dom_element_attr_list_index_insert(list,
+					list->n_entries - 1);
+		else
+			_dom_element_attr_list_index_build(list);
 	}
 
-	return new_list_node;
+	return DOM_NO_ERR;
 }
 
 /**
- * Destroy an entire attribute list, and its attributes
+ * Remove an attribute from an element's attribute list, and destroy it
  *
- * \param list  The attribute list to destroy
+ * \param ele   The element
+ * \param attr  The attribute to remove
+ *
+ * The attribute is destroyed unless something else holds a reference to
+ * it.  Nothing happens if ::attr is not in the list.
  */
-static void _dom_element_attr_list_destroy(dom_attr_list *list)
+static void _dom_element_attr_list_remove(dom_element *ele, dom_attr *attr)
 {
-	dom_attr_list *attr = list;
-	dom_attr_list *next = list;
+	dom_attr_list *list = ele->attributes;
+	dom_attr_list_entry entry;
+	uint32_t i;
 
 	if (list == NULL)
 		return;
 
-	do {
-		attr = next;
-		next = _dom_element_attr_list_next(attr);
+	for (i = 0; i < list->n_entries; i++) {
+		if (list->entries[i].attr == attr)
+			break;
+	}
+
+	if (i == list->n_entries)
+		return;
+
+	entry = list->entries[i];
 
-		_dom_element_attr_list_node_unlink(attr);
-		_dom_element_attr_list_node_destroy(attr);
-	} while (next != attr);
+	list->n_entries--;
+	memmove(&list->entries[i], &list->entries[i + 1],
+			(list->n_entries - i) * sizeof(dom_attr_list_entry));
 
-	return;
+	/* Entry numbers after the removed one have all changed */
+	if (list->index != NULL)
+		_dom_element_attr_list_index_build(list);
+
+	_dom_element_attr_list_entry_destroy(ele, &entry);
 }
 
 /**
- * Clone an attribute list node, and its attribute
+ * Destroy an element's attribute list, and its attributes
  *
- * \param n     The attribute list node to clone
- * \param newe  Element to clone attribute for
- * \return the new attribute list node, or NULL on failure
+ * \param ele  The element
  */
-static dom_attr_list *_dom_element_attr_list_node_clone(dom_attr_list *n,
-		dom_element *newe)
+static void _dom_element_attr_list_destroy(dom_element *ele)
 {
-	dom_attr *clone = NULL;
-	dom_attr_list *new_list_node;
-	dom_exception err;
-
-	assert(n != NULL);
-	assert(n->attr != NULL);
-	assert(n->name != NULL);
-
-	new_list_node = malloc(sizeof(*new_list_node));
-	if (new_list_node == NULL)
-		return NULL;
-
-	list_init(&new_list_node->list);
-
-	new_list_node->name = NULL;
-	new_list_node->namespace = NULL;
-
-	err = dom_node_clone_node(n->attr, true, (void *) &clone);
-	if (err != DOM_NO_ERR) {
-		free(new_list_node);
-		return NULL;
-	}
+	dom_attr_list *list = ele->attributes;
+	uint32_t i;
 
-	dom_node_set_parent(clone, newe);
-	dom_node_remove_pending(clone);
-	dom_node_unref(clone);
-	new_list_node->attr = clone;
+	if (list == NULL)
+		return;
 
-	if (n->name != NULL)
-		new_list_node->name = dom_string_ref(n->name);
+	for (i = 0; i < list->n_entries; i++)
+		_dom_element_attr_list_entry_destroy(ele, &list->entries[i]);
 
-	if (n->namespace != NULL)
-		new_list_node->namespace = dom_string_ref(n->namespace);
+	free(list->index);
+	free(list);
 
-	return new_list_node;
+	ele->attributes = NULL;
 }
 
 /**
@@ -433,34 +546,72 @@ static dom_attr_list *_dom_element_attr_list_node_clone(dom_attr_list *n,
  * \param list  The attribute list to clone
  * \param newe  Element to clone list for
  * \return the new attribute list, or NULL on failure
+ *
+ * The clones are owned by ::newe's owner, which need not be the owner of
+ * the attributes being cloned.
  */
 static dom_attr_list *_dom_element_attr_list_clone(dom_attr_list *list,
 		dom_element *newe)
 {
-	dom_attr_list *attr = list;
-
-	dom_attr_list *new_list = NULL;
-	dom_attr_list *new_list_node = NULL;
+	dom_attr_list *new_list;
+	dom_exception err;
+	uint32_t i;
 
 	if (list == NULL)
 		return NULL;
 
-	do {
-		new_list_node = _dom_element_attr_list_node_clone(attr, newe);
-		if (new_list_node == NULL) {
-			if (new_list != NULL)
-				_dom_element_attr_list_destroy(new_list);
+	new_list = malloc(sizeof(*new_list) +
+			list->alloc_entries * sizeof(dom_attr_list_entry));
+	if (new_list == NULL)
+		return NULL;
+
+	new_list->n_entries = 0;
+	new_list->alloc_entries = list->alloc_entries;
+	new_list->index = NULL;
+	new_list->index_size = 0;
+
+	for (i = 0; i < list->n_entries; i++) {
+		dom_attr_list_entry *n = &list->entries[i];
+		dom_attr_list_entry *new_entry = &new_list->entries[i];
+		dom_attr *clone = NULL;
+
+		err = dom_node_copy(n->attr, newe->base.owner, &clone);
+		if (err == DOM_NO_ERR) {
+			err = _dom_node_copy_children(
+					(dom_node_internal *) n->attr,
+					(dom_node_internal *) clone, true);
+			if (err != DOM_NO_ERR)
+				dom_node_unref(clone);
+		}
+		if (err != DOM_NO_ERR) {
+			/* The clone's class cache has not been set up yet, so
+			 * just release the entries made so far */
+			while (new_list->n_entries > 0) {
+				_dom_element_attr_list_entry_release(
+						&new_list->entries[
+						--new_list->n_entries]);
+			}
+			free(new_list);
 			return NULL;
 		}
 
-		if (new_list == NULL) {
-			new_list = new_list_node;
-		} else {
-			_dom_element_attr_list_insert(new_list, new_list_node);
-		}
+		_dom_attr_set_specified(clone, true);
+		_dom_node_call_user_data_handlers(
+				(dom_node_internal *) n->attr,
+				(dom_node_internal *) clone, DOM_NODE_CLONED);
+
+		dom_node_set_parent(clone, newe);
+		dom_node_remove_pending(clone);
+		dom_node_unref(clone);
 
-		attr = _dom_element_attr_list_next(attr);
-	} while (attr != list);
+		new_entry->attr = clone;
+		new_entry->name = dom_string_ref(n->name);
+		new_entry->namespace = dom_string_ref(n->namespace);
+
+		new_list->n_entries++;
+	}
+
+	_dom_element_attr_list_index_build(new_list);
 
 	return new_list;
 }
@@ -550,7 +701,7 @@ dom_exception _dom_element_create(struct dom_document *doc,
 		dom_string *prefix, struct dom_element **result)
 {
 	/* Allocate the element */
-	*result = malloc(sizeof(struct dom_element));
+	*result = _dom_node_alloc(doc, sizeof(struct dom_element));
 	if (*result == NULL)
 		return DOM_NO_MEM_ERR;
 
@@ -594,13 +745,14 @@ dom_exception _dom_element_initialise(struct dom_document *doc,
 	err = _dom_node_initialise(&el->base, doc, DOM_ELEMENT_NODE,
 			name, NULL, namespace, prefix);
 	if (err != DOM_NO_ERR) {
-		free(el);
+		_dom_node_free(el);
 		return err;
 	}
 
 	/* Perform our type-specific initialisation */
 	el->id_ns = NULL;
 	el->id_name = NULL;
+	el->indexed_id = NULL;
 	el->schema_type_info = NULL;
 
 	el->n_classes = 0;
@@ -616,11 +768,11 @@ dom_exception _dom_element_initialise(struct dom_document *doc,
  */
 void _dom_element_finalise(struct dom_element *ele)
 {
+	/* Ensure the document's ID index no longer refers to us */
+	_dom_document_id_index_remove(ele->base.owner, ele);
+
 	/* Destroy attributes attached to this node */
-	if (ele->attributes != NULL) {
-		_dom_element_attr_list_destroy(ele->attributes);
-		ele->attributes = NULL;
-	}
+	_dom_element_attr_list_destroy(ele);
 
 	if (ele->schema_type_info != NULL) {
 		/** \todo destroy schema type info */
@@ -645,7 +797,7 @@ void _dom_element_destroy(struct dom_element *element)
 	_dom_element_finalise(element);
 
 	/* Free the element */
-	free(element);
+	_dom_node_free(element);
 }
 
 /*----------------------------------------------------------------------*/
@@ -1315,6 +1467,129 @@ dom_exception dom_element_parent_node(dom_element *element,
 	return DOM_NO_ERR;
 }
 
+/**
+ * Find the first element below an element which matches a selector list
+ *
+ * \param element    The element to search below
+ * \param selectors  The selector list
+ * \param result     Pointer to location to receive the element found, or
+ *                   NULL if there is none
+ * \return DOM_NO_ERR                on success,
+ *         DOM_SYNTAX_ERR            if ::selectors is not a valid selector
+ *                                   list,
+ *         DOM_NOT_SUPPORTED_ERR     if ::selectors uses a feature which is
+ *                                   not supported,
+ *         DOM_NO_MEM_ERR            on memory exhaustion.
+ *
+ * Type, class, ID and attribute selectors, the descendant, child and
+ * sibling combinators, and the :root, :first-child, :last-child,
+ * :only-child and :empty pseudo-classes are supported.
+ *
+ * The returned element will have had its reference count increased.  The
+ * client should unref it once finished with it.
+ */
+dom_exception dom_element_query_selector(dom_element *element,
+		dom_string *selectors, dom_element **result)
+{
+	dom_node_internal **items;
+	uint32_t n_items;
+	dom_exception err;
+
+	err = _dom_selector_select((dom_node_internal *) element, selectors,
+			1, &items, &n_items);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	/* Transfer the reference to the element found */
+	*result = n_items > 0 ? (dom_element *) items[0] : NULL;
+
+	free(items);
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Find all the elements below an element which match a selector list
+ *
+ * \param element    The element to search below
+ * \param selectors  The selector list
+ * \param result     Pointer to location to receive a static node list of the
+ *                   elements found, in document order
+ * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
+ *
+ * See dom_element_query_selector() for the selectors which are supported
+ * and the errors returned.  Unlike the lists returned by
+ * dom_element_get_elements_by_tag_name(), the list is not updated when the
+ * document changes.
+ *
+ * The returned list will already be referenced, so the client need not
+ * do so explicitly. The client must unref the list once finished with it.
+ */
+dom_exception dom_element_query_selector_all(dom_element *element,
+		dom_string *selectors, struct dom_nodelist **result)
+{
+	dom_node_internal *node = (dom_node_internal *) element;
+	dom_node_internal **items;
+	uint32_t n_items;
+	dom_exception err;
+
+	err = _dom_selector_select(node, selectors, UINT32_MAX,
+			&items, &n_items);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	err = _dom_nodelist_create_static(node->owner, node, items, n_items,
+			result);
+	if (err != DOM_NO_ERR) {
+		while (n_items > 0)
+			dom_node_unref(items[--n_items]);
+		free(items);
+	}
+
+	return err;
+}
+
+/**
+ * Get the value of an attribute without a namespace, by an interned name
+ *
+ * \param ele       The element
+ * \param name      The attribute's name
+ * \param caseless  Whether to ignore the case of the name
+ * \param value     Pointer to location to receive the attribute's value,
+ *                  or NULL if there is no such attribute
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ *
+ * This is used to match attribute selectors.  The returned value, if any,
+ * must be unreffed by the caller.
+ */
+dom_exception _dom_element_get_attribute_lwc(struct dom_element *ele,
+		lwc_string *name, bool caseless, dom_string **value)
+{
+	dom_attr_list *list = ele->attributes;
+	uint32_t i;
+
+	*value = NULL;
+
+	if (list == NULL)
+		return DOM_NO_ERR;
+
+	for (i = 0; i < list->n_entries; i++) {
+		dom_attr_list_entry *entry = &list->entries[i];
+
+		if (entry->namespace != NULL)
+			continue;
+
+		if (caseless) {
+			if (dom_string_caseless_lwc_isequal(entry->name, name))
+				return _dom_attr_get_value(entry->attr, value);
+		} else if (dom_string_lwc_isequal(entry->name, name)) {
+			return _dom_attr_get_value(entry->attr, value);
+		}
+	}
+
+	return DOM_NO_ERR;
+}
+
 /*------------- The overload virtual functions ------------------------*/
 
 /* Overload function of Node, please refer src/core/node.c for detail */
@@ -1521,18 +1796,18 @@ void __dom_element_destroy(struct dom_node_internal *node)
  *	this will make _dom_element_copy can be used in them.
  */
 dom_exception _dom_element_copy(dom_node_internal *old,
-		dom_node_internal **copy)
+		struct dom_document *doc, dom_node_internal **copy)
 {
 	dom_element *new_node;
 	dom_exception err;
 
-	new_node = malloc(sizeof(dom_element));
+	new_node = _dom_node_alloc(doc, sizeof(dom_element));
 	if (new_node == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_element_copy_internal(old, new_node);
 	if (err != DOM_NO_ERR) {
-		free(new_node);
+		_dom_node_free(new_node);
 		return err;
 	}
 
@@ -1546,6 +1821,8 @@ dom_exception _dom_element_copy_internal(dom_element *old, dom_element *new)
 	dom_exception err;
 	uint32_t classnr;
 
+	new->indexed_id = NULL;
+
 	if (old->attributes != NULL) {
 		/* Copy the attribute list */
 		new->attributes = _dom_element_attr_list_clone(
@@ -1604,7 +1881,7 @@ error:
 dom_exception _dom_element_get_attr(struct dom_element *element,
 		dom_string *namespace, dom_string *name, dom_string **value)
 {
-	dom_attr_list *match;
+	dom_attr_list_entry *match;
 	dom_exception err = DOM_NO_ERR;
 
 	match = _dom_element_attr_list_find_by_name(element->attributes,
@@ -1632,7 +1909,7 @@ dom_exception _dom_element_get_attr(struct dom_element *element,
 dom_exception _dom_element_set_attr(struct dom_element *element,
 		dom_string *namespace, dom_string *name, dom_string *value)
 {
-	dom_attr_list *match;
+	dom_attr_list_entry *match;
 	dom_node_internal *e = (dom_node_internal *) element;
 	dom_exception err;
 
@@ -1652,21 +1929,22 @@ dom_exception _dom_element_set_attr(struct dom_element *element,
 		/* Dispatch a DOMAttrModified event */
 		dom_string *old = NULL;
 		struct dom_document *doc = dom_node_get_owner(element);
+		dom_attr *a = match->attr;
 		bool success = true;
-		err = dom_attr_get_value(match->attr, &old);
+		err = dom_attr_get_value(a, &old);
 		/* TODO: We did not support some node type such as entity
 		 * reference, in that case, we should ignore the error to
 		 * make sure the event model work as excepted. */
 		if (err != DOM_NO_ERR && err != DOM_NOT_SUPPORTED_ERR)
 			return err;
 		err = _dom_dispatch_attr_modified_event(doc, e, old, value,
-				match->attr, name, DOM_MUTATION_MODIFICATION,
+				a, name, DOM_MUTATION_MODIFICATION,
 				&success);
 		dom_string_unref(old);
 		if (err != DOM_NO_ERR)
 			return err;
 
-		err = dom_attr_set_value(match->attr, value);
+		err = dom_attr_set_value(a, value);
 		if (err != DOM_NO_ERR)
 			return err;
 
@@ -1678,7 +1956,6 @@ dom_exception _dom_element_set_attr(struct dom_element *element,
 	} else {
 		/* No existing attribute, so create one */
 		struct dom_attr *attr;
-		struct dom_attr_list *list_node;
 		struct dom_document *doc;
 		bool success = true;
 
@@ -1717,28 +1994,20 @@ dom_exception _dom_element_set_attr(struct dom_element *element,
 			return err;
 		}
 
-		/* Create attribute list node */
-		list_node = _dom_element_attr_list_node_create(attr, element,
-				name, namespace);
-		if (list_node == NULL) {
-			/* If we failed at this step, there must be no memory */
+		/* Link into element's attribute list */
+		err = _dom_element_attr_list_add(element, attr, name,
+				namespace);
+		if (err != DOM_NO_ERR) {
 			dom_node_set_parent(attr, NULL);
 			dom_node_unref(attr);
-			return DOM_NO_MEM_ERR;
+			return err;
 		}
-		dom_string_ref(name);
-		dom_string_ref(namespace);
-
-		/* Link into element's attribute list */
-		if (element->attributes == NULL)
-			element->attributes = list_node;
-		else
-			_dom_element_attr_list_insert(element->attributes,
-					list_node);
 
 		dom_node_unref(attr);
 		dom_node_remove_pending(attr);
 
+		_dom_document_element_changed(doc, element);
+
 		success = true;
 		err = _dom_dispatch_subtree_modified_event(doc,
 				(dom_event_target *) element, &success);
@@ -1749,6 +2018,108 @@ dom_exception _dom_element_set_attr(struct dom_element *element,
 	return DOM_NO_ERR;
 }
 
+/**
+ * Initialise the attributes of a newly created element
+ *
+ * \param element     The element, which must have no attributes yet
+ * \param n           The number of attributes
+ * \param names       Array of ::n attribute names
+ * \param values      Array of ::n attribute values
+ * \param namespaces  Array of ::n attribute namespaces, or NULL if no
+ *                    attribute has one.  Individual entries may be NULL.
+ * \return DOM_NO_ERR                on success,
+ *         DOM_INVALID_CHARACTER_ERR if any name is invalid,
+ *         DOM_INVALID_STATE_ERR     if ::element already has attributes or
+ *                                   has been inserted into a tree,
+ *         DOM_NO_MEM_ERR            on memory exhaustion.
+ *
+ * This is intended for parser bindings, which know all of an element's
+ * attributes when they create it.  Unlike dom_element_set_attribute(),
+ * no check is made for duplicates and no mutation events are dispatched:
+ * the caller guarantees that the names are distinct.  The name of a
+ * namespaced attribute may be qualified by a prefix, which is kept.
+ *
+ * An attribute with an invalid name is skipped, and the rest are added
+ * before DOM_INVALID_CHARACTER_ERR is returned, so that a parser may
+ * drop it and keep the element.  On any other failure, the attributes
+ * added before the error remain in place.
+ */
+dom_exception dom_element_init_attributes(dom_element *element, uint32_t n,
+		dom_string **names, dom_string **values,
+		dom_string **namespaces)
+{
+	dom_node_internal *e = (dom_node_internal *) element;
+	dom_string *namespace, *prefix, *name;
+	struct dom_attr *attr;
+	dom_exception err = DOM_NO_ERR;
+	bool invalid = false;
+	uint32_t i;
+
+	if (e->parent != NULL || (element->attributes != NULL &&
+			element->attributes->n_entries > 0))
+		return DOM_INVALID_STATE_ERR;
+
+	if (n == 0)
+		return DOM_NO_ERR;
+
+	err = _dom_element_attr_list_reserve(element, n);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	for (i = 0; i < n; i++) {
+		namespace = namespaces != NULL ? namespaces[i] : NULL;
+
+		if (_dom_validate_name(names[i]) == false) {
+			invalid = true;
+			continue;
+		}
+
+		if (namespace != NULL) {
+			err = _dom_namespace_split_qname(names[i],
+					&prefix, &name);
+			if (err != DOM_NO_ERR)
+				break;
+		} else {
+			prefix = NULL;
+			name = dom_string_ref(names[i]);
+		}
+
+		err = _dom_attr_create(e->owner, name, namespace, prefix,
+				true, &attr);
+		if (err == DOM_NO_ERR) {
+			/* Set its parent, so that value parsing works */
+			dom_node_set_parent(attr, element);
+
+			err = dom_attr_set_value(attr, values[i]);
+			if (err == DOM_NO_ERR)
+				err = _dom_element_attr_list_add(element,
+						attr, name, namespace);
+			if (err != DOM_NO_ERR) {
+				dom_node_set_parent(attr, NULL);
+				dom_node_unref(attr);
+			} else {
+				dom_node_unref(attr);
+				dom_node_remove_pending(attr);
+			}
+		}
+
+		if (prefix != NULL)
+			dom_string_unref(prefix);
+		dom_string_unref(name);
+
+		if (err != DOM_NO_ERR)
+			break;
+	}
+
+	/* The element's attributes have changed */
+	_dom_document_element_changed(e->owner, element);
+
+	if (err == DOM_NO_ERR && invalid)
+		err = DOM_INVALID_CHARACTER_ERR;
+
+	return err;
+}
+
 /**
  * Remove an attribute from an element by name
  *
@@ -1760,7 +2131,7 @@ dom_exception _dom_element_set_attr(struct dom_element *element,
 dom_exception _dom_element_remove_attr(struct dom_element *element,
 		dom_string *namespace, dom_string *name)
 {
-	dom_attr_list *match;
+	dom_attr_list_entry *match;
 	dom_exception err;
 	dom_node_internal *e = (dom_node_internal *) element;
 
@@ -1779,7 +2150,7 @@ dom_exception _dom_element_remove_attr(struct dom_element *element,
 		struct dom_document *doc = dom_node_get_owner(element);
 		dom_string *old = NULL;
 
-		err = dom_node_dispatch_node_change_event(doc, match->attr,
+		err = dom_node_dispatch_node_change_event(doc, a,
 				element, DOM_MUTATION_REMOVAL, &success);
 		if (err != DOM_NO_ERR)
 			return err;
@@ -1789,16 +2160,9 @@ dom_exception _dom_element_remove_attr(struct dom_element *element,
 
 
 		/* Delete the attribute node */
-		if (element->attributes == match) {
-			element->attributes =
-					_dom_element_attr_list_next(match);
-		}
-		if (element->attributes == match) {
-			/* match must be sole attribute */
-			element->attributes = NULL;
-		}
-		_dom_element_attr_list_node_unlink(match);
-		_dom_element_attr_list_node_destroy(match);
+		_dom_element_attr_list_remove(element, a);
+
+		_dom_document_element_changed(doc, element);
 
 		/* Dispatch a DOMAttrModified event */
 		success = true;
@@ -1844,7 +2208,7 @@ dom_exception _dom_element_get_attr_node(struct dom_element *element,
 		dom_string *namespace, dom_string *name,
 		struct dom_attr **result)
 {
-	dom_attr_list *match;
+	dom_attr_list_entry *match;
 
 	match = _dom_element_attr_list_find_by_name(element->attributes,
 			name, namespace);
@@ -1881,7 +2245,7 @@ dom_exception _dom_element_set_attr_node(struct dom_element *element,
 		dom_string *namespace, struct dom_attr *attr,
 		struct dom_attr **result)
 {
-	dom_attr_list *match;
+	dom_attr_list_entry *match;
 	dom_exception err;
 	dom_string *name = NULL;
 	dom_node_internal *e = (dom_node_internal *) element;
@@ -1928,8 +2292,9 @@ dom_exception _dom_element_set_attr_node(struct dom_element *element,
 
 		dom_node_ref(old_attr);
 
-		_dom_element_attr_list_node_unlink(match);
-		_dom_element_attr_list_node_destroy(match);
+		_dom_element_attr_list_remove(element, old_attr);
+
+		_dom_document_element_changed(doc, element);
 
 		/* Dispatch a DOMAttrModified event */
 		success = true;
@@ -1961,17 +2326,6 @@ dom_exception _dom_element_set_attr_node(struct dom_element *element,
 		}
 	}
 
-
-	match = _dom_element_attr_list_node_create(attr, element,
-			name, namespace);
-	if (match == NULL) {
-		dom_string_unref(name);
-		/* If we failed at this step, there must be no memory */
-		return DOM_NO_MEM_ERR;
-	}
-
-	dom_string_ref(name);
-	dom_string_ref(namespace);
 	dom_node_set_parent(attr, element);
 	dom_node_remove_pending(attr);
 
@@ -1983,7 +2337,8 @@ dom_exception _dom_element_set_attr_node(struct dom_element *element,
 	 * that case, we should ignore the error to make sure the event model
 	 * work as excepted. */
 	if (err != DOM_NO_ERR && err != DOM_NOT_SUPPORTED_ERR) {
-		_dom_element_attr_list_node_destroy(match);
+		dom_string_unref(name);
+		_dom_element_attr_release(attr);
 		return err;
 	}
 	err = _dom_dispatch_attr_modified_event(doc, e, NULL, new,
@@ -1991,16 +2346,17 @@ dom_exception _dom_element_set_attr_node(struct dom_element *element,
 			DOM_MUTATION_ADDITION, &success);
 	/* Cleanup */
 	dom_string_unref(new);
-	dom_string_unref(name);
 	if (err != DOM_NO_ERR) {
-		_dom_element_attr_list_node_destroy(match);
+		dom_string_unref(name);
+		_dom_element_attr_release(attr);
 		return err;
 	}
 
 	err = dom_node_dispatch_node_change_event(doc, attr, element, 
 			DOM_MUTATION_ADDITION, &success);
 	if (err != DOM_NO_ERR) {
-		_dom_element_attr_list_node_destroy(match);
+		dom_string_unref(name);
+		_dom_element_attr_release(attr);
 		return err;
 	}
 
@@ -2008,15 +2364,20 @@ dom_exception _dom_element_set_attr_node(struct dom_element *element,
 	err = _dom_dispatch_subtree_modified_event(doc,
 			(dom_event_target *) element, &success);
 	if (err != DOM_NO_ERR) {
-		_dom_element_attr_list_node_destroy(match);
+		dom_string_unref(name);
+		_dom_element_attr_release(attr);
 		return err;
 	}
 
 	/* Link into element's attribute list */
-	if (element->attributes == NULL)
-		element->attributes = match;
-	else
-		_dom_element_attr_list_insert(element->attributes, match);
+	err = _dom_element_attr_list_add(element, attr, name, namespace);
+	dom_string_unref(name);
+	if (err != DOM_NO_ERR) {
+		_dom_element_attr_release(attr);
+		return err;
+	}
+
+	_dom_document_element_changed(doc, element);
 
 	return DOM_NO_ERR;
 }
@@ -2040,7 +2401,7 @@ dom_exception _dom_element_remove_attr_node(struct dom_element *element,
 		dom_string *namespace, struct dom_attr *attr,
 		struct dom_attr **result)
 {
-	dom_attr_list *match;
+	dom_attr_list_entry *match;
 	dom_exception err;
 	dom_string *name;
 	dom_node_internal *e = (dom_node_internal *) element;
@@ -2081,15 +2442,9 @@ dom_exception _dom_element_remove_attr_node(struct dom_element *element,
 	dom_node_ref(a);
 
 	/* Delete the attribute node */
-	if (element->attributes == match) {
-		element->attributes = _dom_element_attr_list_next(match);
-	}
-	if (element->attributes == match) {
-		/* match must be sole attribute */
-		element->attributes = NULL;
-	}
-	_dom_element_attr_list_node_unlink(match);
-	_dom_element_attr_list_node_destroy(match);
+	_dom_element_attr_list_remove(element, a);
+
+	_dom_document_element_changed(doc, element);
 
 	/* Now, cleaup the dom_string */
 	dom_string_unref(name);
@@ -2139,7 +2494,7 @@ dom_exception _dom_element_remove_attr_node(struct dom_element *element,
 dom_exception _dom_element_has_attr(struct dom_element *element,
 		dom_string *namespace, dom_string *name, bool *result)
 {
-	dom_attr_list *match;
+	dom_attr_list_entry *match;
 
 	match = _dom_element_attr_list_find_by_name(element->attributes,
 			name, namespace);
@@ -2167,7 +2522,7 @@ dom_exception _dom_element_set_id_attr(struct dom_element *element,
 		dom_string *namespace, dom_string *name, bool is_id)
 {
 	
-	dom_attr_list *match;
+	dom_attr_list_entry *match;
 
 	match = _dom_element_attr_list_find_by_name(element->attributes,
 			name, namespace);
@@ -2176,7 +2531,7 @@ dom_exception _dom_element_set_id_attr(struct dom_element *element,
 	
 	if (is_id == true) {
 		/* Clear the previous id attribute if there is one */
-		dom_attr_list *old = _dom_element_attr_list_find_by_name(
+		dom_attr_list_entry *old = _dom_element_attr_list_find_by_name(
 				element->attributes, element->id_name,
 				element->id_ns);
 
@@ -2191,6 +2546,8 @@ dom_exception _dom_element_set_id_attr(struct dom_element *element,
 
 	_dom_attr_set_isid(match->attr, is_id);
 
+	_dom_document_element_changed(dom_node_get_owner(element), element);
+
 	return DOM_NO_ERR;
 }
 
@@ -2316,11 +2673,10 @@ dom_exception attributes_remove_named_item(
 dom_exception attributes_item(void *priv,
 		uint32_t index, struct dom_node **node)
 {
-	dom_attr_list * match = NULL;
-	unsigned int num = index + 1;
+	dom_attr_list_entry *match = NULL;
 	dom_element *e = (dom_element *) priv;
 
-	match = _dom_element_attr_list_get_by_index(e->attributes, num);
+	match = _dom_element_attr_list_get_by_index(e->attributes, index);
 
 	if (match != NULL) {
 		*node = (dom_node *) match->attr;
@@ -35,6 +35,9 @@ struct dom_element {
 
 	dom_string *id_name; 	/**< The id attribute's name */
 
+	dom_string *indexed_id;	/**< The ID this element is filed under in
+				 * its document's ID index, or NULL */
+
 	struct dom_type_info *schema_type_info;	/**< Type information */
 
 	lwc_string **classes;
@@ -220,8 +223,8 @@ dom_exception _dom_element_parse_attribute(dom_element *ele,
 		dom_string *name, dom_string *value,
 		dom_string **parsed);
 void __dom_element_destroy(dom_node_internal *node);
-dom_exception _dom_element_copy(dom_node_internal *old, 
-		dom_node_internal **copy);
+dom_exception _dom_element_copy(dom_node_internal *old,
+		struct dom_document *doc, dom_node_internal **copy);
 
 #define DOM_ELEMENT_PROTECT_VTABLE \
 	_dom_element_parse_attribute
@@ -237,6 +240,8 @@ dom_exception _dom_element_copy_internal(dom_element *old,
 		(dom_element *) (o), (dom_element *) (n))
 
 dom_exception _dom_element_get_id(struct dom_element *ele, dom_string **id);
+dom_exception _dom_element_get_attribute_lwc(struct dom_element *ele,
+		lwc_string *name, bool caseless, dom_string **value);
 
 extern const struct dom_element_vtable _dom_element_vtable;
 
@@ -53,7 +53,7 @@ dom_exception _dom_entity_reference_create(dom_document *doc,
 	dom_exception err;
 
 	/* Allocate the comment node */
-	e = malloc(sizeof(dom_entity_reference));
+	e = _dom_node_alloc(doc, sizeof(dom_entity_reference));
 	if (e == NULL)
 		return DOM_NO_MEM_ERR;
 
@@ -64,7 +64,7 @@ dom_exception _dom_entity_reference_create(dom_document *doc,
 	err = _dom_entity_reference_initialise(&e->base, doc, 
 			DOM_ENTITY_REFERENCE_NODE, name, value, NULL, NULL);
 	if (err != DOM_NO_ERR) {
-		free(e);
+		_dom_node_free(e);
 		return err;
 	}
 
@@ -86,7 +86,7 @@ void _dom_entity_reference_destroy(dom_entity_reference *entity)
 	_dom_entity_reference_finalise(&entity->base);
 
 	/* Destroy fragment */
-	free(entity);
+	_dom_node_free(entity);
 }
 
 /**
@@ -120,18 +120,19 @@ void _dom_er_destroy(dom_node_internal *node)
 }
 
 /* The copy constructor of this class */
-dom_exception _dom_er_copy(dom_node_internal *old, dom_node_internal **copy)
+dom_exception _dom_er_copy(dom_node_internal *old,
+		struct dom_document *doc, dom_node_internal **copy)
 {
 	dom_entity_reference *new_er;
 	dom_exception err;
 
-	new_er = malloc(sizeof(dom_entity_reference));
+	new_er = _dom_node_alloc(doc, sizeof(dom_entity_reference));
 	if (new_er == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_node_copy_internal(old, new_er);
 	if (err != DOM_NO_ERR) {
-		free(new_er);
+		_dom_node_free(new_er);
 		return err;
 	}
 
@@ -22,7 +22,8 @@ void _dom_entity_reference_destroy(dom_entity_reference *entity);
 
 /* Following comes the protected vtable  */
 void _dom_er_destroy(dom_node_internal *node);
-dom_exception _dom_er_copy(dom_node_internal *old, dom_node_internal **copy);
+dom_exception _dom_er_copy(dom_node_internal *old,
+		struct dom_document *doc, dom_node_internal **copy);
 
 #define DOM_ER_PROTECT_VTABLE \
 	_dom_er_destroy, \
@@ -12,6 +12,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <dom/dom.h>
 #include <dom/core/attr.h>
 #include <dom/core/text.h>
 #include <dom/core/document.h>
@@ -54,6 +55,22 @@ static inline dom_exception _dom_node_detach_range(dom_node_internal *first,
 		dom_node_internal *last);
 static inline void _dom_node_replace(dom_node_internal *old, 
 		dom_node_internal *replacement);
+static inline void _dom_node_children_changed(dom_node_internal *node);
+static bool _dom_node_find_user_data_key(dom_string *key, uint32_t *slot);
+static dom_keyed_user_data **_dom_node_find_keyed_user_data(
+		dom_node_internal *node, dom_string *key);
+static inline dom_user_data *_dom_node_user_data(dom_node_internal *node,
+		uint32_t slot);
+static void _dom_node_notify_user_data(dom_node_internal *node,
+		dom_node_operation operation, dom_node_internal *src,
+		dom_node_internal *dst);
+
+/** Keys of the registered user data slots, indexed by slot */
+static dom_string **user_data_keys;
+/** Number of registered user data slots */
+static uint32_t n_user_data_keys;
+/** Allocated size of user_data_keys */
+static uint32_t alloc_user_data_keys;
 
 static const struct dom_node_vtable node_vtable = {
 	{
@@ -72,10 +89,47 @@ static const struct dom_node_protect_vtable node_protect_vtable = {
 
 /* The constructor and destructor of this object */
 
+/**
+ * Allocate memory for a DOM node
+ *
+ * \param doc   The document which will own the node, or NULL
+ * \param size  The size of the node's structure
+ * \return the allocated memory, or NULL on memory exhaustion
+ *
+ * Nodes are allocated from their owning document's node pool, where one
+ * is available.  The memory must be released with _dom_node_free.
+ *
+ * The node's owner is set to ::doc, so that a copy being made for another
+ * document knows its owner before _dom_node_copy_internal() is reached.
+ */
+void *_dom_node_alloc(struct dom_document *doc, size_t size)
+{
+	dom_node_internal *node;
+
+	assert(size >= sizeof(dom_node_internal));
+
+	node = _dom_pool_alloc(doc != NULL ? doc->node_pool : NULL, size);
+	if (node != NULL)
+		node->owner = doc;
+
+	return node;
+}
+
+/**
+ * Free memory allocated by _dom_node_alloc
+ *
+ * \param node  The node's memory
+ */
+void _dom_node_free(void *node)
+{
+	_dom_pool_free(node);
+}
+
 /* Create a DOM node and compose the vtable */
 dom_node_internal * _dom_node_create(void)
 {
-	dom_node_internal *node = malloc(sizeof(struct dom_node_internal));
+	dom_node_internal *node = _dom_node_alloc(NULL,
+			sizeof(struct dom_node_internal));
 	if (node == NULL)
 		return NULL;
 
@@ -125,7 +179,7 @@ void _dom_node_destroy(struct dom_node_internal *node)
 	}
 
 	/* Release our memory */
-	free(node);
+	_dom_node_free(node);
 }
 
 /**
@@ -197,7 +251,12 @@ dom_exception _dom_node_initialise(dom_node_internal *node,
 	else
 		node->prefix = NULL;
 
-	node->user_data = NULL;
+	memset(node->user_data, 0, sizeof(node->user_data));
+	node->user_data_overflow = NULL;
+	node->n_user_data_overflow = 0;
+	node->keyed_user_data = NULL;
+
+	node->order_stamp = 0;
 
 	node->base.refcnt = 1;
 
@@ -220,22 +279,24 @@ dom_exception _dom_node_initialise(dom_node_internal *node,
  */
 void _dom_node_finalise(dom_node_internal *node)
 {
-	struct dom_user_data *u, *v;
+	struct dom_keyed_user_data *u, *v;
 	struct dom_node_internal *p;
 	struct dom_node_internal *n = NULL;
 
 	/* Destroy user data */
-	for (u = node->user_data; u != NULL; u = v) {
-		v = u->next;
+	_dom_node_notify_user_data(node, DOM_NODE_DELETED, NULL, NULL);
 
-		if (u->handler != NULL)
-			u->handler(DOM_NODE_DELETED, u->key, u->data, 
-					NULL, NULL);
+	free(node->user_data_overflow);
+	node->user_data_overflow = NULL;
+	node->n_user_data_overflow = 0;
+
+	for (u = node->keyed_user_data; u != NULL; u = v) {
+		v = u->next;
 
 		dom_string_unref(u->key);
 		free(u);
 	}
-	node->user_data = NULL;
+	node->keyed_user_data = NULL;
 
 	if (node->prefix != NULL) {
 		dom_string_unref(node->prefix);
@@ -277,7 +338,7 @@ void _dom_node_finalise(dom_node_internal *node)
 	 * dom_event_target_internal structure. 
 	 */
 	if (node->owner != NULL)
-		_dom_event_target_internal_finalise(&node->eti);
+		_dom_event_target_internal_finalise(node->owner, &node->eti);
 
 	/* Detach from the pending list, if we are in it,
 	 * this part of code should always be the end of this function. */
@@ -397,7 +458,7 @@ dom_exception _dom_node_get_node_name(dom_node_internal *node,
  *
  * \param node    The node to retrieve the value of
  * \param result  Pointer to location to receive node value
- * \return DOM_NO_ERR.
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
  *
  * The returned string will have its reference count increased. It is
  * the responsibility of the caller to unref the string once it has
@@ -409,6 +470,12 @@ dom_exception _dom_node_get_node_name(dom_node_internal *node,
 dom_exception _dom_node_get_node_value(dom_node_internal *node,
 		dom_string **result)
 {
+	dom_exception err;
+
+	err = _dom_string_unpool(&node->value);
+	if (err != DOM_NO_ERR)
+		return err;
+
 	if (node->value != NULL)
 		dom_string_ref(node->value);
 
@@ -821,6 +888,14 @@ dom_exception _dom_node_insert_before(dom_node_internal *node,
 			new_child->type == DOM_DOCUMENT_TYPE_NODE) {
 		/* See long comment in _dom_node_initialise as to why 
 		 * we don't ref the document here */
+		if (new_child->owner == NULL) {
+			/* Any listeners it has are new to the document */
+			err = _dom_event_target_internal_adopt(
+					(struct dom_document *) node,
+					&new_child->eti);
+			if (err != DOM_NO_ERR)
+				return err;
+		}
 		new_child->owner = (struct dom_document *) node;
 	}
 
@@ -1104,54 +1179,138 @@ dom_exception _dom_node_has_child_nodes(dom_node_internal *node, bool *result)
 dom_exception _dom_node_clone_node(dom_node_internal *node, bool deep,
 		dom_node_internal **result)
 {
-	dom_node_internal *n, *child, *r;
+	dom_node_internal *n;
 	dom_exception err;
-	dom_user_data *ud;
 
 	assert(node->owner != NULL);
 
-	err = dom_node_copy(node, &n);
+	err = dom_node_copy(node, node->owner, &n);
 	if (err != DOM_NO_ERR) {
 		return err;
 	}
 
 	if (deep) {
-		child = node->first_child;
-		while (child != NULL) {
-			err = dom_node_clone_node(child, deep, (void *) &r);
-			if (err != DOM_NO_ERR) {
-				dom_node_unref(n);
-				return err;
-			}
-
-			err = dom_node_append_child(n, r, (void *) &r);
-			if (err != DOM_NO_ERR) {
-				dom_node_unref(n);
-				return err;
-			}
-			
-			/* Clean up the new node, we have reference it two
-			 * times */
-			dom_node_unref(r);
-			dom_node_unref(r);
-			child = child->next;
+		err = _dom_node_copy_children(node, n, true);
+		if (err != DOM_NO_ERR) {
+			dom_node_unref(n);
+			return err;
 		}
 	}
 
 	*result = n;
 
 	/* Call the dom_user_data_handlers */
-	ud = node->user_data;
-	while (ud != NULL) {
-		if (ud->handler != NULL)
-			ud->handler(DOM_NODE_CLONED, ud->key, ud->data, 
-					(dom_node *) node, (dom_node *) n);
-		ud = ud->next;
+	_dom_node_call_user_data_handlers(node, n, DOM_NODE_CLONED);
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Copy the descendants of a node to another node
+ *
+ * \param node            The node whose descendants to copy
+ * \param copy            The copy of ::node, which has no children
+ * \param entity_children Whether to copy the children of EntityReferences
+ * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
+ *
+ * The subtree is copied by walking it, rather than by recursion, so its
+ * depth is not limited by the stack.  The copies are linked into place
+ * directly: as nothing else can yet see them, none of the checks made
+ * by dom_node_append_child() are needed, and no mutation events are
+ * dispatched.  User data handlers are not called.  The copies are owned
+ * by ::copy's owner, which need not be ::node's.
+ *
+ * On failure, the descendants copied so far are left in place, and are
+ * destroyed with ::copy.
+ */
+dom_exception _dom_node_copy_children(dom_node_internal *node,
+		dom_node_internal *copy, bool entity_children)
+{
+	dom_node_internal *child = node->first_child;
+	dom_node_internal *parent = copy;
+	dom_node_internal *n;
+	dom_exception err;
+
+	/* Throughout, parent is the copy of child's parent */
+	while (child != NULL) {
+		err = dom_node_copy(child, copy->owner, &n);
+		if (err != DOM_NO_ERR)
+			return err;
+
+		n->parent = parent;
+		n->previous = parent->last_child;
+		if (parent->last_child != NULL)
+			parent->last_child->next = n;
+		else
+			parent->first_child = n;
+		parent->last_child = n;
+
+		/* The copy now has a parent, which holds it */
+		dom_node_remove_pending(n);
+		dom_node_unref(n);
+
+		if (child->first_child != NULL && (entity_children ||
+				child->type != DOM_ENTITY_REFERENCE_NODE)) {
+			parent = n;
+			child = child->first_child;
+			continue;
+		}
+
+		while (child != node && child->next == NULL) {
+			child = child->parent;
+			parent = parent->parent;
+		}
+
+		child = (child != node) ? child->next : NULL;
 	}
 
 	return DOM_NO_ERR;
 }
 
+/**
+ * Call the user data handlers of a subtree's nodes
+ *
+ * \param node       The root of the subtree which was operated on
+ * \param copy       The copy of ::node, or NULL if there is none
+ * \param operation  The operation which was performed
+ *
+ * The copy of each node in the subtree is found by walking the copied
+ * subtree alongside it, so there is one pass over the subtree however
+ * many handlers are called.  Nodes which were not copied, such as the
+ * children of an uncopied EntityReference, are skipped.  Handlers must
+ * not modify either subtree.
+ */
+void _dom_node_call_user_data_handlers(dom_node_internal *node,
+		dom_node_internal *copy, dom_node_operation operation)
+{
+	dom_node_internal *n = node;
+	dom_node_internal *c = copy;
+
+	while (n != NULL) {
+		_dom_node_notify_user_data(n, operation, n, c);
+
+		if (c == NULL)
+			break;
+
+		if (n->first_child != NULL && c->first_child != NULL) {
+			n = n->first_child;
+			c = c->first_child;
+			continue;
+		}
+
+		while (n != node && (n->next == NULL || c->next == NULL)) {
+			n = n->parent;
+			c = c->parent;
+		}
+
+		if (n == node)
+			break;
+
+		n = n->next;
+		c = c->next;
+	}
+}
+
 /**
  * Normalize a DOM node
  *
@@ -1164,32 +1323,33 @@ dom_exception _dom_node_clone_node(dom_node_internal *node, bool deep,
  */
 dom_exception _dom_node_normalize(dom_node_internal *node)
 {
-	dom_node_internal *n, *p;
+	dom_node_internal *n, *last;
 	dom_exception err;
 
-	p = node->first_child;
-	if (p == NULL)
-		return DOM_NO_ERR;
-
-	n = p->next;
-
+	/* Walk the subtree in document order, without recursion, merging
+	 * each run of adjacent Text nodes as its first node is reached */
+	n = node->first_child;
 	while (n != NULL) {
-		if (n->type == DOM_TEXT_NODE && p->type == DOM_TEXT_NODE) {
-			err = _dom_merge_adjacent_text(p, n);
-			if (err != DOM_NO_ERR)
-				return err;
-
-			_dom_node_detach(n);
-			dom_node_unref(n);
-			n = p->next;
+		if (n->type == DOM_TEXT_NODE) {
+			last = n;
+			while (last->next != NULL &&
+					last->next->type == DOM_TEXT_NODE)
+				last = last->next;
+
+			if (last != n) {
+				err = _dom_merge_adjacent_text(n, last);
+				if (err != DOM_NO_ERR)
+					return err;
+			}
+		} else if (n->first_child != NULL) {
+			n = n->first_child;
 			continue;
 		}
-		if (n->type != DOM_TEXT_NODE) {
-			err = dom_node_normalize(n);
-			if (err != DOM_NO_ERR)
-				return err;
-		}
-		p = n;
+
+		while (n != node && n->next == NULL)
+			n = n->parent;
+		if (n == node)
+			break;
 		n = n->next;
 	}
 
@@ -1403,6 +1563,22 @@ dom_exception _dom_node_get_base(dom_node_internal *node,
 	return _dom_document_get_uri(doc, result);
 }
 
+/**
+ * Find the Attr holding a node
+ *
+ * \param node  The node
+ * \return ::node if it is an Attr, the Attr it lies within, or NULL.
+ */
+static dom_node_internal *_dom_node_containing_attr(dom_node_internal *node)
+{
+	/* Only Text and EntityReference nodes may lie within an Attr */
+	while (node->parent != NULL && (node->type == DOM_TEXT_NODE ||
+			node->type == DOM_ENTITY_REFERENCE_NODE))
+		node = node->parent;
+
+	return node->type == DOM_ATTRIBUTE_NODE ? node : NULL;
+}
+
 /**
  * Compare the positions of two nodes in a DOM tree
  *
@@ -1413,19 +1589,67 @@ dom_exception _dom_node_get_base(dom_node_internal *node,
  *         DOM_NOT_SUPPORTED_ERR when the nodes are from different DOM
  *                               implementations.
  *
- * The result is a bitfield of dom_document_position values.
+ * The result is a bitfield of dom_document_position values, describing
+ * the position of ::other relative to ::node.
  *
- * We don't support this API now, so this function call should always
- * return DOM_NOT_SUPPORTED_ERR.
+ * An Attr, with its children, is placed after its element, and before the
+ * element's children.  The order of two Attrs of the same element is
+ * implementation specific.
  */
 dom_exception _dom_node_compare_document_position(dom_node_internal *node,
 		dom_node_internal *other, uint16_t *result)
 {
-	UNUSED(node);
-	UNUSED(other);
-	UNUSED(result);
+	dom_node_internal *n1 = other, *n2 = node;
+	dom_node_internal *a1, *a2;
+
+	if (node == other) {
+		*result = 0;
+		return DOM_NO_ERR;
+	}
 
-	return DOM_NOT_SUPPORTED_ERR;
+	/* Compare nodes within Attrs by the Attrs' elements */
+	a1 = _dom_node_containing_attr(n1);
+	if (a1 != NULL)
+		n1 = a1->parent;
+	a2 = _dom_node_containing_attr(n2);
+	if (a2 != NULL)
+		n2 = a2->parent;
+
+	if (a1 != NULL && a1 == a2) {
+		/* Two nodes within one Attr */
+		*result = _dom_document_compare_position(node, other);
+	} else if (n1 == NULL || n2 == NULL) {
+		*result = DOM_DOCUMENT_POSITION_DISCONNECTED |
+				DOM_DOCUMENT_POSITION_IMPLEMENTATION_SPECIFIC |
+				((uintptr_t) other < (uintptr_t) node ?
+				DOM_DOCUMENT_POSITION_PRECEDING :
+				DOM_DOCUMENT_POSITION_FOLLOWING);
+	} else if (n1 == n2 && a1 != NULL && a2 != NULL) {
+		/* Two Attrs of one element */
+		*result = DOM_DOCUMENT_POSITION_IMPLEMENTATION_SPECIFIC |
+				((uintptr_t) a1 < (uintptr_t) a2 ?
+				DOM_DOCUMENT_POSITION_PRECEDING :
+				DOM_DOCUMENT_POSITION_FOLLOWING);
+	} else if (n1 == n2) {
+		/* An Attr and its element */
+		*result = (a2 != NULL) ?
+				DOM_DOCUMENT_POSITION_CONTAINS |
+				DOM_DOCUMENT_POSITION_PRECEDING :
+				DOM_DOCUMENT_POSITION_CONTAINED_BY |
+				DOM_DOCUMENT_POSITION_FOLLOWING;
+	} else {
+		*result = _dom_document_compare_position(n2, n1);
+
+		/* An Attr is contained by its element's ancestors, but
+		 * contains none of the element's descendants */
+		if (a1 != NULL && (*result & DOM_DOCUMENT_POSITION_CONTAINS))
+			*result = DOM_DOCUMENT_POSITION_PRECEDING;
+		if (a2 != NULL &&
+				(*result & DOM_DOCUMENT_POSITION_CONTAINED_BY))
+			*result = DOM_DOCUMENT_POSITION_FOLLOWING;
+	}
+
+	return DOM_NO_ERR;
 }
 
 /**
@@ -1433,7 +1657,7 @@ dom_exception _dom_node_compare_document_position(dom_node_internal *node,
  *
  * \param node    The node to retrieve the text content of
  * \param result  Pointer to location to receive text content
- * \return DOM_NO_ERR.
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
  *
  * The returned string will have its reference count increased. It is
  * the responsibility of the caller to unref the string once it has
@@ -1448,28 +1672,46 @@ dom_exception _dom_node_get_text_content(dom_node_internal *node,
 		dom_string **result)
 {
 	dom_node_internal *n;
-	dom_string *str = NULL;
-	dom_string *ret = NULL;
+	dom_string_builder sb;
+	bool found = false;
+	dom_exception err;
 
 	assert(node->owner != NULL);
-	
-	for (n = node->first_child; n != NULL; n = n->next) {
-		if (n->type == DOM_COMMENT_NODE ||
-		    n->type == DOM_PROCESSING_INSTRUCTION_NODE)
+
+	_dom_string_builder_init(&sb);
+
+	/* Walk the subtree in document order, gathering the text of the
+	 * Text and CDATASection nodes within it */
+	n = node->first_child;
+	while (n != NULL) {
+		if (n->type == DOM_TEXT_NODE ||
+				n->type == DOM_CDATA_SECTION_NODE) {
+			if (n->value != NULL) {
+				err = _dom_string_builder_append(&sb, n->value);
+				if (err != DOM_NO_ERR) {
+					_dom_string_builder_finalise(&sb);
+					return err;
+				}
+				found = true;
+			}
+		} else if (n->type != DOM_COMMENT_NODE &&
+				n->type != DOM_PROCESSING_INSTRUCTION_NODE &&
+				n->first_child != NULL) {
+			n = n->first_child;
 			continue;
-		dom_node_get_text_content(n, (str == NULL) ? &str : &ret);
-		if (ret != NULL) {
-			dom_string *new_str;
-			dom_string_concat(str, ret, &new_str);
-			dom_string_unref(str);
-			dom_string_unref(ret);
-			str = new_str;
 		}
+
+		while (n != node && n->next == NULL)
+			n = n->parent;
+		n = (n == node) ? NULL : n->next;
 	}
-	
-	*result = str;
 
-	return DOM_NO_ERR;
+	if (found == false) {
+		*result = NULL;
+		return DOM_NO_ERR;
+	}
+
+	return _dom_string_builder_finish(&sb, result);
 }
 
 /**
@@ -1756,66 +1998,72 @@ dom_exception _dom_node_get_feature(dom_node_internal *node,
  * \param data     The object to associate with key, or NULL to remove
  * \param handler  User handler function, or NULL if none
  * \param result   Pointer to location to receive previously associated object
- * \return DOM_NO_ERR.
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ *
+ * If the key has been registered with dom_node_register_user_data_key(),
+ * the object is stored in the key's slot.  Otherwise, it is kept in a list
+ * on the node, which is searched by key.
  */
 dom_exception _dom_node_set_user_data(dom_node_internal *node,
 		dom_string *key, void *data,
 		dom_user_data_handler handler, void **result)
 {
-	struct dom_user_data *ud = NULL;
-	void *prevdata = NULL;
+	struct dom_keyed_user_data **pud, *ud;
+	dom_exception err;
+	uint32_t slot;
 
-	/* Search for user data */
-	for (ud = node->user_data; ud != NULL; ud = ud->next) {
-		if (dom_string_isequal(ud->key, key))
-			break;
-	};
+	pud = _dom_node_find_keyed_user_data(node, key);
+	ud = *pud;
+
+	if (_dom_node_find_user_data_key(key, &slot)) {
+		err = _dom_node_set_user_data_slot(node, slot, data, handler,
+				result);
+		if (err != DOM_NO_ERR || ud == NULL)
+			return err;
+
+		/* Drop data set before the key was registered */
+		if (*result == NULL)
+			*result = ud->data;
 
-	/* Remove it, if found and no new data */
-	if (data == NULL && ud != NULL) {
+		*pud = ud->next;
 		dom_string_unref(ud->key);
+		free(ud);
 
-		if (ud->next != NULL)
-			ud->next->prev = ud->prev;
-		if (ud->prev != NULL)
-			ud->prev->next = ud->next;
-		else
-			node->user_data = ud->next;
+		return DOM_NO_ERR;
+	}
 
-		*result = ud->data;
+	/* Remove the entry, if found and no new data */
+	if (data == NULL) {
+		*result = NULL;
 
-		free(ud);
+		if (ud != NULL) {
+			*pud = ud->next;
+			*result = ud->data;
+
+			dom_string_unref(ud->key);
+			free(ud);
+		}
 
 		return DOM_NO_ERR;
 	}
 
-	/* Otherwise, create a new user data object if one wasn't found */
+	/* Otherwise, create a new entry if one wasn't found */
 	if (ud == NULL) {
-		ud = malloc(sizeof(struct dom_user_data));
+		ud = malloc(sizeof(struct dom_keyed_user_data));
 		if (ud == NULL)
 			return DOM_NO_MEM_ERR;
 
-		dom_string_ref(key);
-		ud->key = key;
+		ud->key = dom_string_ref(key);
 		ud->data = NULL;
-		ud->handler = NULL;
-
-		/* Insert into list */
-		ud->prev = NULL;
-		ud->next = node->user_data;
-		if (node->user_data)
-			node->user_data->prev = ud;
-		node->user_data = ud;
+		ud->next = node->keyed_user_data;
+		node->keyed_user_data = ud;
 	}
 
-	prevdata = ud->data;
+	*result = ud->data;
 
-	/* And associate data with it */
 	ud->data = data;
 	ud->handler = handler;
 
-	*result = prevdata;
-
 	return DOM_NO_ERR;
 }
 
@@ -1830,40 +2078,261 @@ dom_exception _dom_node_set_user_data(dom_node_internal *node,
 dom_exception _dom_node_get_user_data(dom_node_internal *node,
 		dom_string *key, void **result)
 {
-	struct dom_user_data *ud = NULL;
+	struct dom_keyed_user_data *ud;
+	uint32_t slot;
 
-	/* Search for user data */
-	for (ud = node->user_data; ud != NULL; ud = ud->next) {
-		if (dom_string_isequal(ud->key, key))
-			break;
-	};
+	*result = NULL;
+
+	if (_dom_node_find_user_data_key(key, &slot))
+		_dom_node_get_user_data_slot(node, slot, result);
 
-	if (ud != NULL)
-		*result = ud->data;
+	/* The data may have been set before the key was registered */
+	if (*result == NULL) {
+		ud = *_dom_node_find_keyed_user_data(node, key);
+		if (ud != NULL)
+			*result = ud->data;
+	}
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Register a key for user data, and get the slot it is stored in
+ *
+ * \param key   The key
+ * \param slot  Pointer to location to receive the key's slot
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ *
+ * Registering a key which is already registered gets its existing slot.
+ * Slots are shared by every node in the process, and remain registered
+ * until dom_namespace_finalise() is called, so only a fixed set of
+ * keys should be registered.  The first few slots are held in the nodes
+ * themselves, so the keys used most often should be registered first.
+ */
+dom_exception dom_node_register_user_data_key(dom_string *key,
+		uint32_t *slot)
+{
+	if (_dom_node_find_user_data_key(key, slot))
+		return DOM_NO_ERR;
+
+	if (n_user_data_keys == alloc_user_data_keys) {
+		uint32_t alloc = alloc_user_data_keys == 0 ?
+				DOM_NODE_USER_DATA_INLINE :
+				alloc_user_data_keys * 2;
+		dom_string **keys;
+
+		keys = realloc(user_data_keys, alloc * sizeof(*keys));
+		if (keys == NULL)
+			return DOM_NO_MEM_ERR;
+
+		user_data_keys = keys;
+		alloc_user_data_keys = alloc;
+	}
+
+	user_data_keys[n_user_data_keys] = dom_string_ref(key);
+	*slot = n_user_data_keys++;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Finalise the registered user data keys
+ *
+ * No node may hold any user data when this is called.  Slots got from
+ * dom_node_register_user_data_key() before this is called may not be
+ * used afterwards.
+ */
+void _dom_node_user_data_finalise(void)
+{
+	uint32_t slot;
+
+	for (slot = 0; slot < n_user_data_keys; slot++)
+		dom_string_unref(user_data_keys[slot]);
+
+	free(user_data_keys);
+	user_data_keys = NULL;
+	n_user_data_keys = 0;
+	alloc_user_data_keys = 0;
+}
+
+/**
+ * Associate an object with a user data slot on a node
+ *
+ * \param node     The node
+ * \param slot     The slot, from dom_node_register_user_data_key()
+ * \param data     The object to associate with the slot, or NULL to remove
+ * \param handler  User handler function, or NULL if none
+ * \param result   Pointer to location to receive previously associated object
+ * \return DOM_NO_ERR        on success,
+ *         DOM_NOT_FOUND_ERR if ::slot is not registered,
+ *         DOM_NO_MEM_ERR    on memory exhaustion.
+ */
+dom_exception _dom_node_set_user_data_slot(dom_node_internal *node,
+		uint32_t slot, void *data, dom_user_data_handler handler,
+		void **result)
+{
+	dom_user_data *ud;
+
+	if (slot >= n_user_data_keys)
+		return DOM_NOT_FOUND_ERR;
+
+	if (slot >= DOM_NODE_USER_DATA_INLINE + node->n_user_data_overflow) {
+		uint32_t count = slot + 1 - DOM_NODE_USER_DATA_INLINE;
+
+		if (data == NULL) {
+			*result = NULL;
+			return DOM_NO_ERR;
+		}
+
+		/* Make room for the slots up to this one */
+		ud = realloc(node->user_data_overflow, count * sizeof(*ud));
+		if (ud == NULL)
+			return DOM_NO_MEM_ERR;
+
+		memset(ud + node->n_user_data_overflow, 0,
+				(count - node->n_user_data_overflow) *
+				sizeof(*ud));
+
+		node->user_data_overflow = ud;
+		node->n_user_data_overflow = count;
+	}
+
+	ud = _dom_node_user_data(node, slot);
+
+	*result = ud->data;
+
+	ud->data = data;
+	ud->handler = (data != NULL) ? handler : NULL;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Retrieve the object associated with a user data slot on a node
+ *
+ * \param node    The node
+ * \param slot    The slot, from dom_node_register_user_data_key()
+ * \param result  Pointer to location to receive the object, or NULL
+ * \return DOM_NO_ERR.
+ */
+dom_exception _dom_node_get_user_data_slot(dom_node_internal *node,
+		uint32_t slot, void **result)
+{
+	if (slot < DOM_NODE_USER_DATA_INLINE + node->n_user_data_overflow)
+		*result = _dom_node_user_data(node, slot)->data;
 	else
 		*result = NULL;
 
 	return DOM_NO_ERR;
 }
 
+/**
+ * Find the slot of a registered user data key
+ *
+ * \param key   The key
+ * \param slot  Pointer to location to receive the key's slot
+ * \return true if ::key is registered, false otherwise.
+ */
+bool _dom_node_find_user_data_key(dom_string *key, uint32_t *slot)
+{
+	uint32_t i;
+
+	for (i = 0; i < n_user_data_keys; i++) {
+		if (dom_string_isequal(user_data_keys[i], key)) {
+			*slot = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Find a node's user data entry for an unregistered key
+ *
+ * \param node  The node
+ * \param key   The key
+ * \return the link to the entry, which points to NULL if there is none.
+ */
+dom_keyed_user_data **_dom_node_find_keyed_user_data(
+		dom_node_internal *node, dom_string *key)
+{
+	dom_keyed_user_data **pud;
+
+	for (pud = &node->keyed_user_data; *pud != NULL;
+			pud = &(*pud)->next) {
+		if (dom_string_isequal((*pud)->key, key))
+			break;
+	}
+
+	return pud;
+}
+
+/**
+ * Get a node's entry for a user data slot
+ *
+ * \param node  The node
+ * \param slot  The slot, which the node has an entry for
+ * \return the entry.
+ */
+dom_user_data *_dom_node_user_data(dom_node_internal *node, uint32_t slot)
+{
+	if (slot < DOM_NODE_USER_DATA_INLINE)
+		return &node->user_data[slot];
+
+	return &node->user_data_overflow[slot - DOM_NODE_USER_DATA_INLINE];
+}
+
+/**
+ * Call the user data handlers of a node
+ *
+ * \param node       The node whose user data to notify
+ * \param operation  The operation which was performed
+ * \param src        The node passed to the handlers as the source
+ * \param dst        The node passed to the handlers as the destination
+ */
+void _dom_node_notify_user_data(dom_node_internal *node,
+		dom_node_operation operation, dom_node_internal *src,
+		dom_node_internal *dst)
+{
+	uint32_t count = DOM_NODE_USER_DATA_INLINE + node->n_user_data_overflow;
+	dom_keyed_user_data *kud;
+	uint32_t slot;
+
+	for (slot = 0; slot < count; slot++) {
+		dom_user_data *ud = _dom_node_user_data(node, slot);
+
+		if (ud->handler != NULL)
+			ud->handler(operation, user_data_keys[slot], ud->data,
+					(dom_node *) src, (dom_node *) dst);
+	}
+
+	for (kud = node->keyed_user_data; kud != NULL; kud = kud->next) {
+		if (kud->handler != NULL)
+			kud->handler(operation, kud->key, kud->data,
+					(dom_node *) src, (dom_node *) dst);
+	}
+}
+
 
 /*--------------------------------------------------------------------------*/
 
 /* The protected virtual functions */
 
 /* Copy the internal attributes of a Node from old to new */
-dom_exception _dom_node_copy(dom_node_internal *old, dom_node_internal **copy)
+dom_exception _dom_node_copy(dom_node_internal *old,
+		struct dom_document *doc, dom_node_internal **copy)
 {
 	dom_node_internal *new_node;
 	dom_exception err;
 
-	new_node = malloc(sizeof(dom_node_internal));
+	new_node = _dom_node_alloc(doc, sizeof(dom_node_internal));
 	if (new_node == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = _dom_node_copy_internal(old, new_node);
 	if (err != DOM_NO_ERR) {
-		free(new_node);
+		_dom_node_free(new_node);
 		return err;
 	}
 
@@ -1875,6 +2344,15 @@ dom_exception _dom_node_copy(dom_node_internal *old, dom_node_internal **copy)
 dom_exception _dom_node_copy_internal(dom_node_internal *old, 
 		dom_node_internal *new)
 {
+	dom_exception err;
+
+	/* A copy for another document may not share our pooled value */
+	if (new->owner != old->owner) {
+		err = _dom_string_unpool(&old->value);
+		if (err != DOM_NO_ERR)
+			return err;
+	}
+
 	new->base.vtable = old->base.vtable;
 	new->vtable = old->vtable;
 
@@ -1889,9 +2367,9 @@ dom_exception _dom_node_copy_internal(dom_node_internal *old,
 	new->previous = NULL;
 	new->next = NULL;
 
-	assert(old->owner != NULL);
-
-	new->owner = old->owner;
+	/* The copy's owner, which may differ from the original's, was set
+	 * when it was allocated */
+	assert(new->owner != NULL);
 
 	if (old->namespace != NULL)
 		new->namespace = dom_string_ref(old->namespace);
@@ -1903,7 +2381,11 @@ dom_exception _dom_node_copy_internal(dom_node_internal *old,
 	else
 		new->prefix = NULL;
 
-	new->user_data = NULL;
+	memset(new->user_data, 0, sizeof(new->user_data));
+	new->user_data_overflow = NULL;
+	new->n_user_data_overflow = 0;
+	new->keyed_user_data = NULL;
+	new->order_stamp = 0;
 	new->base.refcnt = 1;
 
 	list_init(&new->pending_list);
@@ -2101,8 +2583,11 @@ dom_exception _dom_node_attach_range(dom_node_internal *first,
 	else
 		parent->last_child = last;
 
+	_dom_document_tree_changed(parent->owner);
+
 	for (n = first; n != last->next; n = n->next) {
 		n->parent = parent;
+		_dom_document_id_index_add_subtree(parent->owner, n);
 		/* Dispatch a DOMNodeInserted event */
 		err = dom_node_dispatch_node_change_event(parent->owner, 
 				n, parent, DOM_MUTATION_ADDITION, &success);
@@ -2110,6 +2595,8 @@ dom_exception _dom_node_attach_range(dom_node_internal *first,
 			return err;
 	}
 
+	_dom_node_children_changed(parent);
+
 	success = true;
 	err = _dom_dispatch_subtree_modified_event(parent->owner, parent,
 			&success);
@@ -2145,15 +2632,20 @@ dom_exception _dom_node_detach_range(dom_node_internal *first,
 	else
 		last->parent->last_child = first->previous;
 
+	_dom_document_tree_changed(first->owner);
+
 	parent = first->parent;
 	for (n = first; n != last->next; n = n->next) {
 		/* Dispatch a DOMNodeRemoval event */
 		err = dom_node_dispatch_node_change_event(n->owner, n,
 				n->parent, DOM_MUTATION_REMOVAL, &success);
 
+		_dom_document_id_index_remove_subtree(n->owner, n);
 		n->parent = NULL;
 	}
 
+	_dom_node_children_changed(parent);
+
 	success = true;
 	_dom_dispatch_subtree_modified_event(parent->owner, parent,
 			&success);
@@ -2180,8 +2672,12 @@ void _dom_node_replace(dom_node_internal *old,
 		dom_node_internal *replacement)
 {
 	dom_node_internal *first, *last;
+	dom_node_internal *parent = old->parent;
 	dom_node_internal *n;
 
+	_dom_document_id_index_remove_subtree(old->owner, old);
+	_dom_document_tree_changed(old->owner);
+
 	if (replacement->type == DOM_DOCUMENT_FRAGMENT_NODE) {
 		first = replacement->first_child;
 		last = replacement->last_child;
@@ -2201,6 +2697,7 @@ void _dom_node_replace(dom_node_internal *old,
 			old->parent->last_child = old->previous;
 		}
 		old->previous = old->next = old->parent = NULL;
+		_dom_node_children_changed(parent);
 		return;
 	}
 
@@ -2220,38 +2717,98 @@ void _dom_node_replace(dom_node_internal *old,
 
 	for (n = first; n != NULL && n != last->next; n = n->next) {
 		n->parent = old->parent;
+		_dom_document_id_index_add_subtree(n->owner, n);
 	}
 
 	old->previous = old->next = old->parent = NULL;
+	_dom_node_children_changed(parent);
 }
 
 /**
- * Merge two adjacent text nodes into one text node.
+ * Note a change to the list of a node's children
+ *
+ * \param node  The node whose children changed
  *
- * \param p  The first text node
- * \param n  The second text node
+ * The children of an attribute form its value, so changing them changes
+ * the owning element.
+ */
+void _dom_node_children_changed(dom_node_internal *node)
+{
+	if (node->type == DOM_ATTRIBUTE_NODE && node->parent != NULL)
+		_dom_document_element_changed(node->owner,
+				(dom_element *) node->parent);
+}
+
+/**
+ * Merge a run of adjacent text nodes into the first of them.
+ *
+ * \param first  The first text node in the run
+ * \param last   The last text node in the run
  * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
+ *
+ * The merged value is built once, so that the first node is modified only
+ * once however long the run is.  The other nodes are then detached from
+ * the tree together, and destroyed unless the client holds them.
  */
-dom_exception _dom_merge_adjacent_text(dom_node_internal *p,
-		dom_node_internal *n)
+dom_exception _dom_merge_adjacent_text(dom_node_internal *first,
+		dom_node_internal *last)
 {
+	dom_string_builder sb;
+	dom_node_internal *n, *next;
 	dom_string *str;
 	dom_exception err;
 
-	assert(p->type == DOM_TEXT_NODE);
-	assert(n->type == DOM_TEXT_NODE);
+	assert(first->type == DOM_TEXT_NODE);
+	assert(last->type == DOM_TEXT_NODE);
 
-	err = dom_text_get_whole_text(n, &str);
-	if (err != DOM_NO_ERR)
+	if (_dom_node_readonly(first))
+		return DOM_NO_MODIFICATION_ALLOWED_ERR;
+
+	_dom_string_builder_init(&sb);
+
+	for (n = first; n != last->next; n = n->next) {
+		assert(n->type == DOM_TEXT_NODE);
+
+		if (n->value == NULL)
+			continue;
+
+		err = _dom_string_builder_append(&sb, n->value);
+		if (err != DOM_NO_ERR) {
+			_dom_string_builder_finalise(&sb);
+			return err;
+		}
+	}
+
+	err = _dom_string_builder_finish(&sb, &str);
+	if (err != DOM_NO_ERR) {
+		_dom_string_builder_finalise(&sb);
 		return err;
-	
-	err = dom_characterdata_append_data(p, str);
+	}
+
+	err = dom_characterdata_set_data(first, str);
+	dom_string_unref(str);
 	if (err != DOM_NO_ERR)
 		return err;
 
-	dom_string_unref(str);
+	if (first == last)
+		return DOM_NO_ERR;
 
-	return DOM_NO_ERR;
+	/* When a Node is not in the document tree, it must be in the
+	 * pending list */
+	n = first->next;
+	for (next = n; next != last->next; next = next->next)
+		dom_node_mark_pending(next);
+
+	err = _dom_node_detach_range(n, last);
+
+	/* The detached nodes stay linked to each other until destroyed */
+	for (; n != NULL; n = next) {
+		next = n->next;
+		n->previous = n->next = NULL;
+		dom_node_try_destroy(n);
+	}
+
+	return err;
 }
 
 /**
@@ -2333,8 +2890,8 @@ dom_exception _dom_node_add_event_listener(dom_event_target *et,
 {
 	dom_node_internal *node = (dom_node_internal *) et;
 
-	return _dom_event_target_add_event_listener(&node->eti, type, 
-			listener, capture);
+	return _dom_event_target_add_event_listener(node->owner, &node->eti,
+			type, listener, capture);
 }
 
 dom_exception _dom_node_remove_event_listener(dom_event_target *et,
@@ -2343,8 +2900,8 @@ dom_exception _dom_node_remove_event_listener(dom_event_target *et,
 {
 	dom_node_internal *node = (dom_node_internal *) et;
 
-	return _dom_event_target_remove_event_listener(&node->eti,
-			type, listener, capture);
+	return _dom_event_target_remove_event_listener(node->owner,
+			&node->eti, type, listener, capture);
 }
 
 dom_exception _dom_node_add_event_listener_ns(dom_event_target *et,
@@ -2452,6 +3009,15 @@ dom_exception _dom_node_dispatch_event(dom_event_target *et,
 	
 	*success = true;
 
+	/* If nothing listens for this type of event, and there's no
+	 * default action for it, the dispatch can have no effect */
+	if (_dom_document_event_internal_is_handled(&doc->dei,
+			evt->type) == false) {
+		evt->target = et;
+		evt->phase = DOM_BUBBLING_PHASE;
+		return DOM_NO_ERR;
+	}
+
 	/* Initialise array of targets for capture/bubbling phases */
 	targets = NULL;
 	ntargets_allocated = 0;
@@ -2606,6 +3172,14 @@ dom_exception _dom_node_dispatch_node_change_event(dom_document *doc,
 	if (err != DOM_NO_ERR)
 		return err;
 
+	/* Avoid walking the subtree if there's nothing to dispatch */
+	if (doc->mutation_events == false || 
+			_dom_document_event_internal_is_handled(&doc->dei,
+			change == DOM_MUTATION_ADDITION ?
+			doc->_memo_domnodeinsertedintodocument :
+			doc->_memo_domnoderemovedfromdocument) == false)
+		return DOM_NO_ERR;
+
 	/* Fire document change event at subtree */
 	target = node->first_child;
 	while (target != NULL) {
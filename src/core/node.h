@@ -21,17 +21,31 @@
 #include "utils/list.h"
 
 /**
- * User data context attached to a DOM node
+ * The number of user data slots held in each node.  A node's entries for
+ * later slots are held in an array, allocated when it is first needed.
+ */
+#define DOM_NODE_USER_DATA_INLINE 2
+
+/**
+ * User data attached to a DOM node, in one of its slots
  */
 struct dom_user_data {
+	void *data;			/**< Client-specific data, or NULL */
+	dom_user_data_handler handler;	/**< Callback function */
+};
+typedef struct dom_user_data dom_user_data;
+
+/**
+ * User data attached to a DOM node by a key which has no slot
+ */
+struct dom_keyed_user_data {
 	dom_string *key;		/**< Key for data */
 	void *data;			/**< Client-specific data */
 	dom_user_data_handler handler;	/**< Callback function */
 
-	struct dom_user_data *next;	/**< Next in list */
-	struct dom_user_data *prev;	/**< Previous in list */
+	struct dom_keyed_user_data *next;	/**< Next in list */
 };
-typedef struct dom_user_data dom_user_data;
+typedef struct dom_keyed_user_data dom_keyed_user_data;
 
 /**
  * The internally used virtual function table.
@@ -41,9 +55,11 @@ typedef struct dom_node_protect_vtable {
 	void (*destroy)(dom_node_internal *n);
 					/**< The destroy virtual function, it 
 					 * should be private to client */
-	dom_exception (*copy)(dom_node_internal *old, dom_node_internal **copy);
+	dom_exception (*copy)(dom_node_internal *old, struct dom_document *doc,
+			dom_node_internal **copy);
 				/**< Copy the old to new as well as 
-				 * all its attributes, but not its children */
+				 * all its attributes, but not its children.
+				 * The copy is owned by doc */
 } dom_node_protect_vtable; 
 
 /**
@@ -71,13 +87,27 @@ struct dom_node_internal {
 	dom_string *namespace;		/**< Namespace URI */
 	dom_string *prefix;		/**< Namespace prefix */
 
-	struct dom_user_data *user_data;	/**< User data list */
+	struct dom_user_data user_data[DOM_NODE_USER_DATA_INLINE];
+					/**< User data in the first slots */
+	struct dom_user_data *user_data_overflow;
+					/**< User data in later slots */
+	uint32_t n_user_data_overflow;	/**< Entries in user_data_overflow */
+	struct dom_keyed_user_data *keyed_user_data;
+					/**< User data with unregistered keys */
+
+	uint32_t order;			/**< Position in the order index */
+	uint32_t order_last;		/**< Position of last descendant */
+	uint32_t order_stamp;		/**< Stamp of the order index the node
+					 * is in, or 0 */
 
 	struct list_entry pending_list; /**< The document delete pending list */
 
 	dom_event_target_internal eti;	/**< The EventTarget interface */
 };
 
+void *_dom_node_alloc(struct dom_document *doc, size_t size);
+void _dom_node_free(void *node);
+
 dom_node_internal * _dom_node_create(void);
 
 dom_exception _dom_node_initialise(struct dom_node_internal *node,
@@ -87,6 +117,9 @@ dom_exception _dom_node_initialise(struct dom_node_internal *node,
 
 void _dom_node_finalise(dom_node_internal *node);
 
+/* Finalise the registered user data keys */
+void _dom_node_user_data_finalise(void);
+
 bool _dom_node_readonly(const dom_node_internal *node);
 
 /* Event Target implementation */
@@ -235,8 +268,8 @@ dom_exception _dom_node_get_user_data(dom_node_internal *node,
 
 /* Following comes the protected vtable */
 void _dom_node_destroy(struct dom_node_internal *node);
-dom_exception _dom_node_copy(struct dom_node_internal *old, 
-		struct dom_node_internal **copy);
+dom_exception _dom_node_copy(struct dom_node_internal *old,
+		struct dom_document *doc, struct dom_node_internal **copy);
 
 #define DOM_NODE_PROTECT_VTABLE \
 	_dom_node_destroy, \
@@ -250,14 +283,14 @@ static inline void dom_node_destroy(struct dom_node_internal *node)
 }
 #define dom_node_destroy(n) dom_node_destroy((dom_node_internal *) (n))
 
-/* Copy the Node old to new */
-static inline dom_exception dom_node_copy(struct dom_node_internal *old, 
-		struct dom_node_internal **copy)
+/* Copy the Node old to new, which is owned by, and allocated from, doc */
+static inline dom_exception dom_node_copy(struct dom_node_internal *old,
+		struct dom_document *doc, struct dom_node_internal **copy)
 {
-	return ((dom_node_protect_vtable *) old->vtable)->copy(old, copy);
+	return ((dom_node_protect_vtable *) old->vtable)->copy(old, doc, copy);
 }
-#define dom_node_copy(o,c) dom_node_copy((dom_node_internal *) (o), \
-		(dom_node_internal **) (c))
+#define dom_node_copy(o,d,c) dom_node_copy((dom_node_internal *) (o), \
+		(struct dom_document *) (d), (dom_node_internal **) (c))
 
 /* Following are some helper functions */
 dom_exception _dom_node_copy_internal(dom_node_internal *old, 
@@ -277,8 +310,15 @@ dom_exception _dom_node_copy_internal(dom_node_internal *old,
 
 #define dom_node_get_refcount(n) ((dom_node_internal *) (n))->refcnt
 
-dom_exception _dom_merge_adjacent_text(dom_node_internal *p,
-		dom_node_internal *n);
+dom_exception _dom_merge_adjacent_text(dom_node_internal *first,
+		dom_node_internal *last);
+
+/* Copy the descendants of a node, without dispatching any events */
+dom_exception _dom_node_copy_children(dom_node_internal *node,
+		dom_node_internal *copy, bool entity_children);
+/* Call the user data handlers of a subtree's nodes */
+void _dom_node_call_user_data_handlers(dom_node_internal *node,
+		dom_node_internal *copy, dom_node_operation operation);
 
 /* Try to destroy the node, if its refcnt is not zero, then append it to the
  * owner document's pending list */
@@ -45,6 +45,13 @@ struct dom_nodelist {
 		} ns;			/**< Data for namespace matching */
 	} data;
 
+	dom_node_internal **items;	/**< Members found so far */
+	uint32_t n_items;		/**< Number of members found */
+	uint32_t alloc_items;		/**< Allocated size of items */
+	dom_node_internal *cursor;	/**< Next node to consider, or NULL
+					 * if all members have been found */
+	uint64_t generation;		/**< Tree generation items is from */
+
 	uint32_t refcnt;		/**< Reference count */
 };
 
@@ -123,6 +130,61 @@ dom_exception _dom_nodelist_create(dom_document *doc, nodelist_type type,
 		l->data.ns.localname = localname;
 	} 
 
+	l->items = NULL;
+	l->n_items = 0;
+	l->alloc_items = 0;
+	l->cursor = root->first_child;
+	l->generation = doc->tree_generation;
+
+	l->refcnt = 1;
+
+	*list = l;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Create a nodelist of fixed members
+ *
+ * \param doc      Owning document
+ * \param root     Root node of subtree that the members were found in
+ * \param items    Array of the members, or NULL if there are none
+ * \param n_items  Number of members
+ * \param list     Pointer to location to receive list
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion
+ *
+ * The list is not updated when the document changes, and so is not
+ * registered with the document.  On success, the list takes over ::items,
+ * which must have been allocated with malloc(), and the references held on
+ * the members.
+ *
+ * The returned list will already be referenced, so the client need not
+ * do so explicitly. The client must unref the list once finished with it.
+ */
+dom_exception _dom_nodelist_create_static(dom_document *doc,
+		dom_node_internal *root, dom_node_internal **items,
+		uint32_t n_items, dom_nodelist **list)
+{
+	dom_nodelist *l;
+
+	l = malloc(sizeof(dom_nodelist));
+	if (l == NULL)
+		return DOM_NO_MEM_ERR;
+
+	dom_node_ref(doc);
+	l->owner = doc;
+
+	dom_node_ref(root);
+	l->root = root;
+
+	l->type = DOM_NODELIST_STATIC;
+
+	l->items = items;
+	l->n_items = n_items;
+	l->alloc_items = n_items;
+	l->cursor = NULL;
+	l->generation = doc->tree_generation;
+
 	l->refcnt = 1;
 
 	*list = l;
@@ -160,6 +222,10 @@ void dom_nodelist_unref(dom_nodelist *list)
 		case DOM_NODELIST_CHILDREN:
 			/* Nothing to do */
 			break;
+		case DOM_NODELIST_STATIC:
+			while (list->n_items > 0)
+				dom_node_unref(list->items[--list->n_items]);
+			break;
 		case DOM_NODELIST_BY_NAMESPACE:
 		case DOM_NODELIST_BY_NAMESPACE_CASELESS:
 			if (list->data.ns.namespace != NULL)
@@ -177,9 +243,11 @@ void dom_nodelist_unref(dom_nodelist *list)
 		dom_node_unref(list->root);
 
 		/* Remove list from document */
-		_dom_document_remove_nodelist(list->owner, list);
+		if (list->type != DOM_NODELIST_STATIC)
+			_dom_document_remove_nodelist(list->owner, list);
 
 		/* Destroy the list object */
+		free(list->items);
 		free(list);
 
 		/* And release our reference on the owning document
@@ -190,97 +258,183 @@ void dom_nodelist_unref(dom_nodelist *list)
 }
 
 /**
- * Retrieve the length of a node list
+ * Determine whether a node belongs in a node list
  *
- * \param list    List to retrieve length of
- * \param length  Pointer to location to receive length
- * \return DOM_NO_ERR.
+ * \param list  The list
+ * \param cur   The node to test
+ * \return true if ::cur is a member of ::list, false otherwise
  */
-dom_exception dom_nodelist_get_length(dom_nodelist *list, uint32_t *length)
+static bool _dom_nodelist_contains(dom_nodelist *list, dom_node_internal *cur)
 {
-	dom_node_internal *cur = list->root->first_child;
-	uint32_t len = 0;
-
-	/* Traverse data structure */
-	while (cur != NULL) {
-		/* Process current node */
-		if (list->type == DOM_NODELIST_CHILDREN) {
-			len++;
-		} else if (list->type == DOM_NODELIST_BY_NAME) {
-			if (list->data.n.any_name == true || (
-					cur->name != NULL && 
-					dom_string_isequal(cur->name, 
-						list->data.n.name))) {
-				if (cur->type == DOM_ELEMENT_NODE)
-					len++;
-			}
-		} else if (list->type == DOM_NODELIST_BY_NAME_CASELESS) {
-			if (list->data.n.any_name == true || (
-					cur->name != NULL && 
-					dom_string_caseless_isequal(cur->name, 
-						list->data.n.name))) {
-				if (cur->type == DOM_ELEMENT_NODE)
-					len++;
-			}
-		} else if (list->type == DOM_NODELIST_BY_NAMESPACE) {
-			if (list->data.ns.any_namespace == true ||
-					dom_string_isequal(cur->namespace,
-					list->data.ns.namespace)) {
-				if (list->data.ns.any_localname == true ||
-						(cur->name != NULL &&
-						dom_string_isequal(cur->name,
-						list->data.ns.localname))) {
-					if (cur->type == DOM_ELEMENT_NODE)
-						len++;
-				}
-			}
-		} else if (list->type == DOM_NODELIST_BY_NAMESPACE_CASELESS) {
-			if (list->data.ns.any_namespace == true ||
-					dom_string_caseless_isequal(
-					cur->namespace,
-					list->data.ns.namespace)) {
-				if (list->data.ns.any_localname == true ||
-						(cur->name != NULL &&
-						dom_string_caseless_isequal(
-						cur->name,
-						list->data.ns.localname))) {
-					if (cur->type == DOM_ELEMENT_NODE)
-						len++;
-				}
-			}
-		} else {
-			assert("Unknown list type" == NULL);
+	switch (list->type) {
+	case DOM_NODELIST_CHILDREN:
+		return true;
+	case DOM_NODELIST_STATIC:
+		/* Static lists are never walked */
+		return false;
+	case DOM_NODELIST_BY_NAME:
+		return cur->type == DOM_ELEMENT_NODE &&
+			(list->data.n.any_name == true || (
+				cur->name != NULL && 
+				dom_string_isequal(cur->name, 
+					list->data.n.name)));
+	case DOM_NODELIST_BY_NAME_CASELESS:
+		return cur->type == DOM_ELEMENT_NODE &&
+			(list->data.n.any_name == true || (
+				cur->name != NULL && 
+				dom_string_caseless_isequal(cur->name, 
+					list->data.n.name)));
+	case DOM_NODELIST_BY_NAMESPACE:
+		return cur->type == DOM_ELEMENT_NODE &&
+			(list->data.ns.any_namespace == true ||
+				dom_string_isequal(cur->namespace,
+					list->data.ns.namespace)) &&
+			(list->data.ns.any_localname == true ||
+				(cur->name != NULL &&
+				dom_string_isequal(cur->name,
+					list->data.ns.localname)));
+	case DOM_NODELIST_BY_NAMESPACE_CASELESS:
+		return cur->type == DOM_ELEMENT_NODE &&
+			(list->data.ns.any_namespace == true ||
+				dom_string_caseless_isequal(cur->namespace,
+					list->data.ns.namespace)) &&
+			(list->data.ns.any_localname == true ||
+				(cur->name != NULL &&
+				dom_string_caseless_isequal(cur->name,
+					list->data.ns.localname)));
+	}
+
+	assert("Unknown list type" == NULL);
+	return false;
+}
+
+/**
+ * Find the next candidate node for a node list
+ *
+ * \param list  The list
+ * \param cur   The current node
+ * \return The next node to consider, or NULL if there are no more
+ */
+static dom_node_internal *_dom_nodelist_next(dom_nodelist *list,
+		dom_node_internal *cur)
+{
+	if (list->type == DOM_NODELIST_CHILDREN) {
+		/* Just interested in sibling list */
+		return cur->next;
+	}
+
+	/* Want a full in-order tree traversal */
+	if (cur->first_child != NULL) {
+		/* Has children */
+		return cur->first_child;
+	} else if (cur->next != NULL) {
+		/* No children, but has siblings */
+		return cur->next;
+	} else {
+		/* No children or siblings. 
+		 * Find first unvisited relation. */
+		dom_node_internal *parent = cur->parent;
+
+		while (parent != list->root &&
+				cur == parent->last_child) {
+			cur = parent;
+			parent = parent->parent;
 		}
 
-		/* Now, find next node */
-		if (list->type == DOM_NODELIST_CHILDREN) {
-			/* Just interested in sibling list */
-			cur = cur->next;
-		} else {
-			/* Want a full in-order tree traversal */
-			if (cur->first_child != NULL) {
-				/* Has children */
-				cur = cur->first_child;
-			} else if (cur->next != NULL) {
-				/* No children, but has siblings */
-				cur = cur->next;
-			} else {
-				/* No children or siblings. 
-				 * Find first unvisited relation. */
-				dom_node_internal *parent = cur->parent;
-
-				while (parent != list->root &&
-						cur == parent->last_child) {
-					cur = parent;
-					parent = parent->parent;
-				}
+		return cur->next;
+	}
+}
+
+/**
+ * Extend a node list's cache of members
+ *
+ * \param list   The list
+ * \param index  The index of the member required
+ * \return true if the cache holds member ::index, or all members if there
+ *         are fewer; false on memory exhaustion.
+ *
+ * The cache is discarded if the tree has changed since it was filled.
+ * Otherwise, the walk of the tree resumes from where it last stopped.
+ */
+static bool _dom_nodelist_fill(dom_nodelist *list, uint32_t index)
+{
+	dom_node_internal **items;
+	dom_node_internal *cur;
+
+	if (list->type == DOM_NODELIST_STATIC)
+		return true;
+
+	if (list->generation != list->owner->tree_generation) {
+		list->generation = list->owner->tree_generation;
+		list->n_items = 0;
+		list->cursor = list->root->first_child;
+	}
+
+	while (list->cursor != NULL && list->n_items <= index) {
+		cur = list->cursor;
 
-				cur = cur->next;
+		if (_dom_nodelist_contains(list, cur)) {
+			if (list->n_items == list->alloc_items) {
+				uint32_t alloc = list->alloc_items == 0 ?
+						16 : list->alloc_items * 2;
+
+				items = realloc(list->items,
+						alloc * sizeof(*items));
+				if (items == NULL)
+					return false;
+
+				list->items = items;
+				list->alloc_items = alloc;
 			}
+
+			list->items[list->n_items++] = cur;
 		}
+
+		list->cursor = _dom_nodelist_next(list, cur);
 	}
 
-	*length = len;
+	return true;
+}
+
+/**
+ * Find a node list member without using the cache
+ *
+ * \param list   The list
+ * \param index  The index of the member required
+ * \param count  Pointer to location to receive the number of members found
+ * \return The member, or NULL if there are fewer than ::index + 1 members
+ */
+static dom_node_internal *_dom_nodelist_walk(dom_nodelist *list,
+		uint32_t index, uint32_t *count)
+{
+	dom_node_internal *cur = list->root->first_child;
+
+	*count = 0;
+
+	for (; cur != NULL; cur = _dom_nodelist_next(list, cur)) {
+		if (_dom_nodelist_contains(list, cur) && (*count)++ == index)
+			return cur;
+	}
+
+	return NULL;
+}
+
+/**
+ * Retrieve the length of a node list
+ *
+ * \param list    List to retrieve length of
+ * \param length  Pointer to location to receive length
+ * \return DOM_NO_ERR.
+ */
+dom_exception dom_nodelist_get_length(dom_nodelist *list, uint32_t *length)
+{
+	if (_dom_nodelist_fill(list, UINT32_MAX) == false) {
+		/* Count the members the slow way */
+		(void) _dom_nodelist_walk(list, UINT32_MAX, length);
+		return DOM_NO_ERR;
+	}
+
+	*length = list->n_items;
 
 	return DOM_NO_ERR;
 }
@@ -305,93 +459,13 @@ dom_exception dom_nodelist_get_length(dom_nodelist *list, uint32_t *length)
 dom_exception _dom_nodelist_item(dom_nodelist *list,
 		uint32_t index, dom_node **node)
 {
-	dom_node_internal *cur = list->root->first_child;
-	uint32_t count = 0;
-
-	/* Traverse data structure */
-	while (cur != NULL) {
-		/* Process current node */
-		if (list->type == DOM_NODELIST_CHILDREN) {
-			count++;
-		} else if (list->type == DOM_NODELIST_BY_NAME) {
-			if (list->data.n.any_name == true || (
-					cur->name != NULL && 
-					dom_string_isequal(cur->name, 
-						list->data.n.name))) {
-				if (cur->type == DOM_ELEMENT_NODE)
-					count++;
-			}
-		} else if (list->type == DOM_NODELIST_BY_NAME_CASELESS) {
-			if (list->data.n.any_name == true || (
-					cur->name != NULL && 
-					dom_string_caseless_isequal(cur->name, 
-						list->data.n.name))) {
-				if (cur->type == DOM_ELEMENT_NODE)
-					count++;
-			}
-		} else if (list->type == DOM_NODELIST_BY_NAMESPACE) {
-			if (list->data.ns.any_namespace == true || 
-					(cur->namespace != NULL &&
-					dom_string_isequal(cur->namespace,
-						list->data.ns.namespace))) {
-				if (list->data.ns.any_localname == true ||
-						(cur->name != NULL &&
-						dom_string_isequal(cur->name,
-						list->data.ns.localname))) {
-					if (cur->type == DOM_ELEMENT_NODE)
-						count++;
-				}
-			}
-		} else if (list->type == DOM_NODELIST_BY_NAMESPACE_CASELESS) {
-			if (list->data.ns.any_namespace == true || 
-					(cur->namespace != NULL &&
-					dom_string_caseless_isequal(
-						cur->namespace,
-						list->data.ns.namespace))) {
-				if (list->data.ns.any_localname == true ||
-						(cur->name != NULL &&
-						dom_string_caseless_isequal(
-						cur->name,
-						list->data.ns.localname))) {
-					if (cur->type == DOM_ELEMENT_NODE)
-						count++;
-				}
-			}
-		} else {
-			assert("Unknown list type" == NULL);
-		}
+	dom_node_internal *cur = NULL;
+	uint32_t count;
 
-		/* Stop if this is the requested index */
-		if ((index + 1) == count) {
-			break;
-		}
-
-		/* Now, find next node */
-		if (list->type == DOM_NODELIST_CHILDREN) {
-			/* Just interested in sibling list */
-			cur = cur->next;
-		} else {
-			/* Want a full in-order tree traversal */
-			if (cur->first_child != NULL) {
-				/* Has children */
-				cur = cur->first_child;
-			} else if (cur->next != NULL) {
-				/* No children, but has siblings */
-				cur = cur->next;
-			} else {
-				/* No children or siblings.
-				 * Find first unvisited relation. */
-				dom_node_internal *parent = cur->parent;
-
-				while (parent != list->root &&
-						cur == parent->last_child) {
-					cur = parent;
-					parent = parent->parent;
-				}
-
-				cur = cur->next;
-			}
-		}
+	if (_dom_nodelist_fill(list, index) == false) {
+		cur = _dom_nodelist_walk(list, index, &count);
+	} else if (index < list->n_items) {
+		cur = list->items[index];
 	}
 
 	if (cur != NULL) {
@@ -426,6 +500,9 @@ bool _dom_nodelist_match(dom_nodelist *list, nodelist_type type,
 	switch (list->type) {
 	case DOM_NODELIST_CHILDREN:
 		return true;
+	case DOM_NODELIST_STATIC:
+		/* Static lists are never shared */
+		return false;
 	case DOM_NODELIST_BY_NAME:
 		return dom_string_isequal(list->data.n.name, tagname);
 	case DOM_NODELIST_BY_NAMESPACE:
@@ -452,6 +529,10 @@ bool _dom_nodelist_match(dom_nodelist *list, nodelist_type type,
  */
 bool _dom_nodelist_equal(dom_nodelist *l1, dom_nodelist *l2)
 {
+	if (l1->type == DOM_NODELIST_STATIC ||
+			l2->type == DOM_NODELIST_STATIC)
+		return l1 == l2;
+
 	return _dom_nodelist_match(l1, l1->type, l2->root, l2->data.n.name, 
 			l2->data.ns.namespace, l2->data.ns.localname);
 }
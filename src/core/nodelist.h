@@ -24,7 +24,8 @@ typedef enum {
 	DOM_NODELIST_BY_NAME,
 	DOM_NODELIST_BY_NAMESPACE,
 	DOM_NODELIST_BY_NAME_CASELESS,
-	DOM_NODELIST_BY_NAMESPACE_CASELESS
+	DOM_NODELIST_BY_NAMESPACE_CASELESS,
+	DOM_NODELIST_STATIC
 } nodelist_type;
 
 /* Create a nodelist */
@@ -33,6 +34,11 @@ dom_exception _dom_nodelist_create(struct dom_document *doc, nodelist_type type,
 		dom_string *namespace, dom_string *localname,
 		struct dom_nodelist **list);
 
+/* Create a nodelist of fixed members */
+dom_exception _dom_nodelist_create_static(struct dom_document *doc,
+		struct dom_node_internal *root, struct dom_node_internal **items,
+		uint32_t n_items, struct dom_nodelist **list);
+
 /* Match a nodelist instance against a set of nodelist creation parameters */
 bool _dom_nodelist_match(struct dom_nodelist *list, nodelist_type type,
 		struct dom_node_internal *root, dom_string *tagname, 
@@ -52,7 +52,7 @@ dom_exception _dom_processing_instruction_create(dom_document *doc,
 	dom_exception err;
 
 	/* Allocate the comment node */
-	p = malloc(sizeof(dom_processing_instruction));
+	p = _dom_node_alloc(doc, sizeof(dom_processing_instruction));
 	if (p == NULL)
 		return DOM_NO_MEM_ERR;
 	
@@ -64,7 +64,7 @@ dom_exception _dom_processing_instruction_create(dom_document *doc,
 			DOM_PROCESSING_INSTRUCTION_NODE,
 			name, value, NULL, NULL);
 	if (err != DOM_NO_ERR) {
-		free(p);
+		_dom_node_free(p);
 		return err;
 	}
 
@@ -86,7 +86,7 @@ void _dom_processing_instruction_destroy(dom_processing_instruction *pi)
 	_dom_processing_instruction_finalise(&pi->base);
 
 	/* Free processing instruction */
-	free(pi);
+	_dom_node_free(pi);
 }
 
 /*-----------------------------------------------------------------------*/
@@ -101,18 +101,20 @@ void _dom_pi_destroy(dom_node_internal *node)
 }
 
 /* The copy constructor of this class */
-dom_exception _dom_pi_copy(dom_node_internal *old, dom_node_internal **copy)
+dom_exception _dom_pi_copy(dom_node_internal *old,
+		struct dom_document *doc, dom_node_internal **copy)
 {
 	dom_processing_instruction *new_pi;
 	dom_exception err;
 
-	new_pi = malloc(sizeof(dom_processing_instruction));
+	new_pi = _dom_node_alloc(doc,
+			sizeof(dom_processing_instruction));
 	if (new_pi == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_node_copy_internal(old, new_pi);
 	if (err != DOM_NO_ERR) {
-		free(new_pi);
+		_dom_node_free(new_pi);
 		return err;
 	}
 
@@ -22,7 +22,8 @@ void _dom_processing_instruction_destroy(dom_processing_instruction *pi);
 
 /* Following comes the protected vtable  */
 void _dom_pi_destroy(dom_node_internal *node);
-dom_exception _dom_pi_copy(dom_node_internal *old, dom_node_internal **copy);
+dom_exception _dom_pi_copy(dom_node_internal *old,
+		struct dom_document *doc, dom_node_internal **copy);
 
 #define DOM_PI_PROTECT_VTABLE \
 	_dom_pi_destroy, \
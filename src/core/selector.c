@@ -0,0 +1,1386 @@
+/*
+ * This file is part of libdom.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libwapcaplet/libwapcaplet.h>
+
+#include <dom/core/node.h>
+#include <dom/core/string.h>
+#include <dom/core/walk.h>
+
+#include "core/document.h"
+#include "core/element.h"
+#include "core/node.h"
+#include "core/selector.h"
+
+#include "html/html_document.h"
+#include "html/html_element.h"
+
+#include "utils/ascii.h"
+#include "utils/utils.h"
+
+/**
+ * The operations of a compiled selector
+ *
+ * The tests of each compound selector are sorted into this order, so that
+ * the cheapest are tried first.
+ */
+typedef enum {
+	/* Tests of the element itself */
+	DOM_SELECTOR_TYPE,		/**< The element has a name */
+	DOM_SELECTOR_CLASS,		/**< The element has a class */
+	DOM_SELECTOR_ROOT,		/**< :root */
+	DOM_SELECTOR_FIRST_CHILD,	/**< :first-child */
+	DOM_SELECTOR_LAST_CHILD,	/**< :last-child */
+	DOM_SELECTOR_ONLY_CHILD,	/**< :only-child */
+	DOM_SELECTOR_EMPTY,		/**< :empty */
+	DOM_SELECTOR_ID,		/**< The element has an ID */
+	DOM_SELECTOR_ATTR_EXISTS,	/**< [name] */
+	DOM_SELECTOR_ATTR_EQUAL,	/**< [name=value] */
+	DOM_SELECTOR_ATTR_INCLUDES,	/**< [name~=value] */
+	DOM_SELECTOR_ATTR_DASHMATCH,	/**< [name|=value] */
+	DOM_SELECTOR_ATTR_PREFIX,	/**< [name^=value] */
+	DOM_SELECTOR_ATTR_SUFFIX,	/**< [name$=value] */
+	DOM_SELECTOR_ATTR_SUBSTRING,	/**< [name*=value] */
+
+	/* Combinators, leading to the next compound selector leftwards */
+	DOM_SELECTOR_DESCENDANT,	/**< Whitespace */
+	DOM_SELECTOR_CHILD,		/**< '>' */
+	DOM_SELECTOR_ADJACENT,		/**< '+' */
+	DOM_SELECTOR_SIBLING,		/**< '~' */
+
+	DOM_SELECTOR_END		/**< End of a complex selector */
+} dom_selector_op;
+
+/**
+ * A step of a compiled selector
+ */
+typedef struct dom_selector_test {
+	dom_selector_op op;	/**< The operation */
+	bool caseless;		/**< Compare the attribute value caselessly */
+	lwc_string *name;	/**< Type, class, ID or attribute name */
+	lwc_string *value;	/**< Attribute value to compare with */
+} dom_selector_test;
+
+/** The most ancestor keys tested in a walk's filter per complex selector */
+#define DOM_SELECTOR_MAX_HASHES 4
+
+/**
+ * Keys which the ancestors of an element must have to match a complex
+ * selector
+ */
+typedef struct dom_selector_hashes {
+	uint32_t n_hashes;			/**< Number of keys */
+	dom_walk_key keys[DOM_SELECTOR_MAX_HASHES];	/**< Their kinds */
+	uint32_t hashes[DOM_SELECTOR_MAX_HASHES];	/**< Their hashes */
+} dom_selector_hashes;
+
+/**
+ * A compiled selector list
+ *
+ * Each complex selector is stored as its compound selectors from right to
+ * left, each followed by the combinator joining it to the next, and then
+ * DOM_SELECTOR_END.  An element is matched by running the tests of the
+ * rightmost compound selector on it, and only then following combinators
+ * to the elements which the others must match, so most elements are
+ * rejected by a test or two of their own.
+ */
+struct dom_selector {
+	uint32_t n_complex;		/**< Number of complex selectors */
+	dom_selector_hashes *hashes;	/**< Ancestor keys of each complex
+					 * selector */
+	uint32_t n_tests;		/**< Number of tests */
+	dom_selector_test tests[];	/**< The tests, in matching order */
+};
+
+/**
+ * State of the selector parser
+ */
+typedef struct dom_selector_parser {
+	const uint8_t *pos;		/**< Next byte to read */
+	const uint8_t *end;		/**< End of the text */
+	uint8_t *buf;			/**< Space for a decoded name or string,
+					 * twice the length of the text */
+	dom_selector_test *tests;	/**< Tests parsed, in source order */
+	uint32_t n_tests;		/**< Number of tests parsed */
+	uint32_t alloc_tests;		/**< Allocated size of tests */
+} dom_selector_parser;
+
+/**
+ * The pseudo-classes which are supported
+ */
+static const struct {
+	const char *name;	/**< The pseudo-class's name */
+	size_t len;		/**< Length of name */
+	dom_selector_op op;	/**< The test of the pseudo-class */
+} pseudo_classes[] = {
+	{ "root", SLEN("root"), DOM_SELECTOR_ROOT },
+	{ "first-child", SLEN("first-child"), DOM_SELECTOR_FIRST_CHILD },
+	{ "last-child", SLEN("last-child"), DOM_SELECTOR_LAST_CHILD },
+	{ "only-child", SLEN("only-child"), DOM_SELECTOR_ONLY_CHILD },
+	{ "empty", SLEN("empty"), DOM_SELECTOR_EMPTY }
+};
+
+static dom_exception _dom_selector_parse_list(dom_selector_parser *p);
+static dom_exception _dom_selector_parse_compound(dom_selector_parser *p);
+static dom_exception _dom_selector_parse_simple(dom_selector_parser *p,
+		dom_selector_op op);
+static dom_exception _dom_selector_parse_attribute(dom_selector_parser *p);
+static dom_exception _dom_selector_parse_pseudo(dom_selector_parser *p);
+static dom_exception _dom_selector_parse_name(dom_selector_parser *p,
+		lwc_string **name);
+static dom_exception _dom_selector_parse_string(dom_selector_parser *p,
+		lwc_string **value);
+static size_t _dom_selector_parse_escape(dom_selector_parser *p,
+		uint8_t *out);
+static dom_selector_test *_dom_selector_add(dom_selector_parser *p,
+		dom_selector_op op);
+static void _dom_selector_release(dom_selector_test *tests, uint32_t n);
+static void _dom_selector_order(const dom_selector_test *src, uint32_t n,
+		dom_selector_test *dst);
+static dom_exception _dom_selector_hash(dom_selector *selector);
+
+static bool _dom_selector_may_match(const dom_selector_hashes *hashes,
+		dom_walk *walk);
+static bool _dom_selector_match_complex(const dom_selector_test *test,
+		dom_node_internal *node, const dom_selector_hashes *hashes,
+		dom_walk *walk, bool quirks);
+static bool _dom_selector_test(const dom_selector_test *test,
+		dom_node_internal *node, bool quirks);
+static bool _dom_selector_match_value(const dom_selector_test *test,
+		dom_string *value);
+
+/*----------------------------------------------------------------------*/
+/* Compiling */
+
+/**
+ * Compile a selector list
+ *
+ * \param text    The selector list
+ * \param result  Pointer to location to receive the compiled selector list
+ * \return DOM_NO_ERR                on success,
+ *         DOM_SYNTAX_ERR            if ::text is not a valid selector list,
+ *         DOM_NOT_SUPPORTED_ERR     if ::text uses a pseudo-class or
+ *                                   pseudo-element which is not supported,
+ *                                   or a namespace prefix,
+ *         DOM_NO_MEM_ERR            on memory exhaustion.
+ *
+ * Type selectors and attribute names are matched case insensitively, as
+ * by dom_element_named_ancestor_node().  Class and ID selectors are
+ * matched case insensitively if the document is in quirks mode.
+ *
+ * The returned selector list must be destroyed by the caller.
+ */
+dom_exception _dom_selector_create(dom_string *text, dom_selector **result)
+{
+	dom_selector_parser p;
+	dom_selector *selector = NULL;
+	size_t len = dom_string_byte_length(text);
+	dom_exception err;
+
+	p.pos = (const uint8_t *) dom_string_data(text);
+	p.end = p.pos + len;
+	p.tests = NULL;
+	p.n_tests = 0;
+	p.alloc_tests = 0;
+
+	/* An escape decodes to no more than half as much again as its
+	 * own length, or three bytes for a backslash ending the text */
+	p.buf = malloc(2 * len + 1);
+	if (p.buf == NULL)
+		return DOM_NO_MEM_ERR;
+
+	err = _dom_selector_parse_list(&p);
+
+	free(p.buf);
+
+	if (err == DOM_NO_ERR) {
+		selector = malloc(sizeof(*selector) +
+				p.n_tests * sizeof(dom_selector_test));
+		if (selector == NULL)
+			err = DOM_NO_MEM_ERR;
+	}
+
+	if (err != DOM_NO_ERR) {
+		_dom_selector_release(p.tests, p.n_tests);
+		free(p.tests);
+		return err;
+	}
+
+	/* The selector takes over the tests' references */
+	_dom_selector_order(p.tests, p.n_tests, selector->tests);
+	selector->n_tests = p.n_tests;
+
+	free(p.tests);
+
+	err = _dom_selector_hash(selector);
+	if (err != DOM_NO_ERR) {
+		_dom_selector_destroy(selector);
+		return err;
+	}
+
+	*result = selector;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Destroy a compiled selector list
+ *
+ * \param selector  The selector list to destroy
+ */
+void _dom_selector_destroy(dom_selector *selector)
+{
+	if (selector == NULL)
+		return;
+
+	_dom_selector_release(selector->tests, selector->n_tests);
+	free(selector->hashes);
+	free(selector);
+}
+
+/**
+ * Release the strings held by some tests
+ *
+ * \param tests  The tests
+ * \param n      The number of tests
+ */
+void _dom_selector_release(dom_selector_test *tests, uint32_t n)
+{
+	while (n-- > 0) {
+		if (tests[n].name != NULL)
+			lwc_string_unref(tests[n].name);
+		if (tests[n].value != NULL)
+			lwc_string_unref(tests[n].value);
+	}
+}
+
+/**
+ * Put the tests of a parsed selector list into matching order
+ *
+ * \param src  The tests in source order, each complex selector ended by
+ *             DOM_SELECTOR_END
+ * \param n    The number of tests
+ * \param dst  Location to receive the tests in matching order
+ */
+void _dom_selector_order(const dom_selector_test *src, uint32_t n,
+		dom_selector_test *dst)
+{
+	uint32_t first = 0, last, start, end, i;
+
+	while (first < n) {
+		for (last = first; src[last].op != DOM_SELECTOR_END; last++)
+			;
+
+		/* Copy the compound selectors from right to left, each
+		 * followed by the combinator before it in the source */
+		for (end = last; ; end = start - 1) {
+			dom_selector_test *compound = dst;
+
+			start = end;
+			while (start > first && src[start - 1].op <
+					DOM_SELECTOR_DESCENDANT)
+				start--;
+
+			/* Insertion sort, cheapest test first */
+			for (i = start; i < end; i++) {
+				dom_selector_op op = src[i].op;
+				size_t j;
+
+				for (j = dst - compound; j > 0 &&
+						compound[j - 1].op > op; j--)
+					compound[j] = compound[j - 1];
+				compound[j] = src[i];
+				dst++;
+			}
+
+			if (start == first)
+				break;
+
+			*dst++ = src[start - 1];
+		}
+
+		*dst++ = src[last];
+
+		first = last + 1;
+	}
+}
+
+/**
+ * Find the keys which a complex selector requires of ancestors
+ *
+ * \param selector  The selector list, with its tests in matching order
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ *
+ * A compound selector following a descendant or child combinator in
+ * matching order must match an ancestor of the element tested, whatever
+ * sibling combinators came before.  The names, classes and IDs it requires
+ * are collected, nearest ancestors first, for testing in a walk's filter.
+ */
+dom_exception _dom_selector_hash(dom_selector *selector)
+{
+	const dom_selector_test *test = selector->tests;
+	const dom_selector_test *end = test + selector->n_tests;
+	dom_selector_hashes *hashes;
+	bool ancestor = false;
+	uint32_t n;
+
+	selector->n_complex = 0;
+	selector->hashes = NULL;
+
+	for (; test < end; test++) {
+		if (test->op == DOM_SELECTOR_END)
+			selector->n_complex++;
+	}
+
+	hashes = calloc(selector->n_complex, sizeof(*hashes));
+	if (hashes == NULL)
+		return DOM_NO_MEM_ERR;
+
+	selector->hashes = hashes;
+
+	for (test = selector->tests; test < end; test++) {
+		dom_walk_key key;
+
+		switch (test->op) {
+		case DOM_SELECTOR_TYPE:
+			key = DOM_WALK_KEY_NAME;
+			break;
+		case DOM_SELECTOR_CLASS:
+			key = DOM_WALK_KEY_CLASS;
+			break;
+		case DOM_SELECTOR_ID:
+			key = DOM_WALK_KEY_ID;
+			break;
+		case DOM_SELECTOR_DESCENDANT:
+		case DOM_SELECTOR_CHILD:
+			ancestor = true;
+			continue;
+		case DOM_SELECTOR_ADJACENT:
+		case DOM_SELECTOR_SIBLING:
+			ancestor = false;
+			continue;
+		case DOM_SELECTOR_END:
+			ancestor = false;
+			hashes++;
+			continue;
+		default:
+			continue;
+		}
+
+		n = hashes->n_hashes;
+		if (ancestor && n < DOM_SELECTOR_MAX_HASHES) {
+			hashes->keys[n] = key;
+			hashes->hashes[n] = dom_walk_hash(key,
+					(const uint8_t *) lwc_string_data(
+							test->name),
+					lwc_string_length(test->name));
+			hashes->n_hashes++;
+		}
+	}
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Append a test to those parsed
+ *
+ * \param p   The parser
+ * \param op  The test's operation
+ * \return the new test, or NULL on memory exhaustion.
+ *
+ * The returned test is only valid until the next test is appended.
+ */
+dom_selector_test *_dom_selector_add(dom_selector_parser *p,
+		dom_selector_op op)
+{
+	dom_selector_test *test;
+
+	if (p->n_tests == p->alloc_tests) {
+		uint32_t alloc = p->alloc_tests == 0 ? 8 : p->alloc_tests * 2;
+
+		test = realloc(p->tests, alloc * sizeof(*test));
+		if (test == NULL)
+			return NULL;
+
+		p->tests = test;
+		p->alloc_tests = alloc;
+	}
+
+	test = &p->tests[p->n_tests++];
+	test->op = op;
+	test->caseless = false;
+	test->name = NULL;
+	test->value = NULL;
+
+	return test;
+}
+
+/**
+ * Skip whitespace in a selector
+ *
+ * \param p  The parser
+ * \return true if any whitespace was skipped, false otherwise.
+ */
+static bool _dom_selector_skip_space(dom_selector_parser *p)
+{
+	const uint8_t *start = p->pos;
+
+	while (p->pos < p->end && _dom_ascii_is_space(*p->pos))
+		p->pos++;
+
+	return p->pos != start;
+}
+
+/**
+ * Test whether a byte may start a name
+ *
+ * \param c  The byte
+ * \return true if ::c is a letter, '_' or part of a non-ASCII character
+ */
+static inline bool _dom_selector_is_name_start(uint8_t c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+			c == '_' || c >= 0x80;
+}
+
+/**
+ * Test whether a byte may continue a name
+ *
+ * \param c  The byte
+ * \return true if ::c may start a name, or is a digit or '-'
+ */
+static inline bool _dom_selector_is_name(uint8_t c)
+{
+	return _dom_selector_is_name_start(c) ||
+			(c >= '0' && c <= '9') || c == '-';
+}
+
+/**
+ * Get the value of a hex digit
+ *
+ * \param c  The byte
+ * \return the value of ::c, or -1 if it is not a hex digit
+ */
+static inline int _dom_selector_hex_value(uint8_t c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+/**
+ * Test whether a selector has an escape at some position
+ *
+ * \param p  The parser
+ * \param s  The position
+ * \return true if ::s is a backslash which is not followed by a newline
+ */
+static inline bool _dom_selector_is_escape(const dom_selector_parser *p,
+		const uint8_t *s)
+{
+	return s < p->end && s[0] == '\\' && (s + 1 == p->end ||
+			(s[1] != '\n' && s[1] != '\r' && s[1] != '\f'));
+}
+
+/**
+ * Test whether a selector has a name at the parser's position
+ *
+ * \param p  The parser
+ * \return true if a name starts at the parser's position
+ */
+static bool _dom_selector_at_name(const dom_selector_parser *p)
+{
+	const uint8_t *s = p->pos;
+
+	if (s < p->end && *s == '-') {
+		s++;
+		if (s < p->end && *s == '-')
+			return true;
+	}
+
+	return s < p->end && (_dom_selector_is_name_start(*s) ||
+			_dom_selector_is_escape(p, s));
+}
+
+/**
+ * Decode an escape in a selector
+ *
+ * \param p    The parser, positioned at the backslash
+ * \param out  Location to receive the character escaped, as UTF-8
+ * \return the number of bytes written to ::out
+ */
+size_t _dom_selector_parse_escape(dom_selector_parser *p, uint8_t *out)
+{
+	uint32_t c = 0;
+	int digits = 0, v;
+
+	p->pos++;
+
+	while (digits < 6 && p->pos < p->end &&
+			(v = _dom_selector_hex_value(*p->pos)) >= 0) {
+		c = (c << 4) | v;
+		digits++;
+		p->pos++;
+	}
+
+	if (digits == 0) {
+		if (p->pos < p->end) {
+			/* Any other byte stands for itself */
+			*out = *p->pos++;
+			return 1;
+		}
+
+		/* An escape at the end of the text stands for U+FFFD */
+	} else if (p->pos < p->end && _dom_ascii_is_space(*p->pos)) {
+		/* A single whitespace character may end a hex escape */
+		p->pos++;
+	}
+
+	if (c == 0 || (c >= 0xd800 && c <= 0xdfff) || c > 0x10ffff)
+		c = 0xfffd;
+
+	if (c < 0x80) {
+		out[0] = c;
+		return 1;
+	} else if (c < 0x800) {
+		out[0] = 0xc0 | (c >> 6);
+		out[1] = 0x80 | (c & 0x3f);
+		return 2;
+	} else if (c < 0x10000) {
+		out[0] = 0xe0 | (c >> 12);
+		out[1] = 0x80 | ((c >> 6) & 0x3f);
+		out[2] = 0x80 | (c & 0x3f);
+		return 3;
+	}
+
+	out[0] = 0xf0 | (c >> 18);
+	out[1] = 0x80 | ((c >> 12) & 0x3f);
+	out[2] = 0x80 | ((c >> 6) & 0x3f);
+	out[3] = 0x80 | (c & 0x3f);
+	return 4;
+}
+
+/**
+ * Parse a name in a selector
+ *
+ * \param p     The parser
+ * \param name  Pointer to location to receive the interned name
+ * \return DOM_NO_ERR on success, DOM_SYNTAX_ERR if there is no name at the
+ *         parser's position, DOM_NO_MEM_ERR on memory exhaustion.
+ */
+dom_exception _dom_selector_parse_name(dom_selector_parser *p,
+		lwc_string **name)
+{
+	size_t len = 0;
+
+	if (_dom_selector_at_name(p) == false)
+		return DOM_SYNTAX_ERR;
+
+	while (p->pos < p->end) {
+		if (_dom_selector_is_escape(p, p->pos))
+			len += _dom_selector_parse_escape(p, p->buf + len);
+		else if (_dom_selector_is_name(*p->pos))
+			p->buf[len++] = *p->pos++;
+		else
+			break;
+	}
+
+	if (lwc_intern_string((const char *) p->buf, len, name) !=
+			lwc_error_ok)
+		return DOM_NO_MEM_ERR;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Parse a quoted string in a selector
+ *
+ * \param p      The parser, positioned at the opening quote
+ * \param value  Pointer to location to receive the interned string
+ * \return DOM_NO_ERR on success, DOM_SYNTAX_ERR if the string is not ended,
+ *         DOM_NO_MEM_ERR on memory exhaustion.
+ */
+dom_exception _dom_selector_parse_string(dom_selector_parser *p,
+		lwc_string **value)
+{
+	uint8_t quote = *p->pos++;
+	size_t len = 0;
+
+	while (p->pos < p->end && *p->pos != quote) {
+		uint8_t c = *p->pos;
+
+		if (c == '\n' || c == '\r' || c == '\f')
+			return DOM_SYNTAX_ERR;
+
+		if (c != '\\') {
+			p->buf[len++] = c;
+			p->pos++;
+		} else if (_dom_selector_is_escape(p, p->pos)) {
+			len += _dom_selector_parse_escape(p, p->buf + len);
+		} else {
+			/* An escaped newline continues the string */
+			p->pos += 2;
+			if (p->pos[-1] == '\r' && p->pos < p->end &&
+					*p->pos == '\n')
+				p->pos++;
+		}
+	}
+
+	if (p->pos == p->end)
+		return DOM_SYNTAX_ERR;
+
+	p->pos++;
+
+	if (lwc_intern_string((const char *) p->buf, len, value) !=
+			lwc_error_ok)
+		return DOM_NO_MEM_ERR;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Parse a type, class or ID selector's name and append its test
+ *
+ * \param p   The parser, positioned after any '.' or '#'
+ * \param op  The test's operation
+ * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
+ */
+dom_exception _dom_selector_parse_simple(dom_selector_parser *p,
+		dom_selector_op op)
+{
+	dom_selector_test *test;
+	lwc_string *name;
+	dom_exception err;
+
+	err = _dom_selector_parse_name(p, &name);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	test = _dom_selector_add(p, op);
+	if (test == NULL) {
+		lwc_string_unref(name);
+		return DOM_NO_MEM_ERR;
+	}
+
+	test->name = name;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Parse an attribute selector and append its test
+ *
+ * \param p  The parser, positioned at the '['
+ * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
+ */
+dom_exception _dom_selector_parse_attribute(dom_selector_parser *p)
+{
+	dom_selector_test *test;
+	lwc_string *name;
+	dom_selector_op op;
+	dom_exception err;
+	char flag;
+
+	p->pos++;
+	_dom_selector_skip_space(p);
+
+	if (p->pos < p->end && (*p->pos == '*' || *p->pos == '|'))
+		return DOM_NOT_SUPPORTED_ERR;
+
+	err = _dom_selector_parse_simple(p, DOM_SELECTOR_ATTR_EXISTS);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	test = &p->tests[p->n_tests - 1];
+
+	_dom_selector_skip_space(p);
+	if (p->pos == p->end)
+		return DOM_SYNTAX_ERR;
+
+	switch (*p->pos) {
+	case ']':
+		p->pos++;
+		return DOM_NO_ERR;
+	case '=':
+		op = DOM_SELECTOR_ATTR_EQUAL;
+		break;
+	case '~':
+		op = DOM_SELECTOR_ATTR_INCLUDES;
+		break;
+	case '|':
+		op = DOM_SELECTOR_ATTR_DASHMATCH;
+		break;
+	case '^':
+		op = DOM_SELECTOR_ATTR_PREFIX;
+		break;
+	case '$':
+		op = DOM_SELECTOR_ATTR_SUFFIX;
+		break;
+	case '*':
+		op = DOM_SELECTOR_ATTR_SUBSTRING;
+		break;
+	default:
+		return DOM_SYNTAX_ERR;
+	}
+
+	if (op != DOM_SELECTOR_ATTR_EQUAL) {
+		p->pos++;
+		if (p->pos == p->end || *p->pos != '=') {
+			/* '|' not before '=' is a namespace prefix */
+			return op == DOM_SELECTOR_ATTR_DASHMATCH ?
+					DOM_NOT_SUPPORTED_ERR : DOM_SYNTAX_ERR;
+		}
+	}
+	p->pos++;
+
+	test->op = op;
+
+	_dom_selector_skip_space(p);
+	if (p->pos == p->end)
+		return DOM_SYNTAX_ERR;
+
+	if (*p->pos == '"' || *p->pos == '\'')
+		err = _dom_selector_parse_string(p, &test->value);
+	else
+		err = _dom_selector_parse_name(p, &test->value);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	_dom_selector_skip_space(p);
+
+	/* An 'i' or 's' flag chooses how the value is compared */
+	if (_dom_selector_at_name(p)) {
+		err = _dom_selector_parse_name(p, &name);
+		if (err != DOM_NO_ERR)
+			return err;
+
+		flag = lwc_string_data(name)[0] | 0x20;
+		if (lwc_string_length(name) != 1)
+			flag = 0;
+		lwc_string_unref(name);
+
+		if (flag != 'i' && flag != 's')
+			return DOM_SYNTAX_ERR;
+
+		test->caseless = flag == 'i';
+
+		_dom_selector_skip_space(p);
+	}
+
+	if (p->pos == p->end || *p->pos != ']')
+		return DOM_SYNTAX_ERR;
+	p->pos++;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Parse a pseudo-class and append its test
+ *
+ * \param p  The parser, positioned at the ':'
+ * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
+ */
+dom_exception _dom_selector_parse_pseudo(dom_selector_parser *p)
+{
+	dom_selector_op op = DOM_SELECTOR_END;
+	lwc_string *name;
+	dom_exception err;
+	size_t i;
+
+	p->pos++;
+
+	/* Pseudo-elements are never elements in the document */
+	if (p->pos < p->end && *p->pos == ':')
+		return DOM_NOT_SUPPORTED_ERR;
+
+	err = _dom_selector_parse_name(p, &name);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	/* Functional pseudo-classes are not supported */
+	for (i = 0; i < sizeof(pseudo_classes) / sizeof(pseudo_classes[0]) &&
+			(p->pos == p->end || *p->pos != '('); i++) {
+		if (lwc_string_length(name) == pseudo_classes[i].len &&
+				_dom_ascii_caseless_isequal(
+				(const uint8_t *) lwc_string_data(name),
+				(const uint8_t *) pseudo_classes[i].name,
+				pseudo_classes[i].len)) {
+			op = pseudo_classes[i].op;
+			break;
+		}
+	}
+
+	lwc_string_unref(name);
+
+	if (op == DOM_SELECTOR_END)
+		return DOM_NOT_SUPPORTED_ERR;
+
+	if (_dom_selector_add(p, op) == NULL)
+		return DOM_NO_MEM_ERR;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Parse a compound selector and append its tests
+ *
+ * \param p  The parser
+ * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
+ */
+dom_exception _dom_selector_parse_compound(dom_selector_parser *p)
+{
+	uint32_t first = p->n_tests;
+	bool universal = false;
+	dom_exception err = DOM_NO_ERR;
+
+	if (p->pos < p->end && *p->pos == '*') {
+		p->pos++;
+		universal = true;
+	} else if (_dom_selector_at_name(p)) {
+		err = _dom_selector_parse_simple(p, DOM_SELECTOR_TYPE);
+		if (err != DOM_NO_ERR)
+			return err;
+	}
+
+	/* Namespace prefixes are not supported */
+	if (p->pos < p->end && *p->pos == '|')
+		return DOM_NOT_SUPPORTED_ERR;
+
+	while (p->pos < p->end && err == DOM_NO_ERR) {
+		if (*p->pos == '#') {
+			p->pos++;
+			err = _dom_selector_parse_simple(p, DOM_SELECTOR_ID);
+		} else if (*p->pos == '.') {
+			p->pos++;
+			err = _dom_selector_parse_simple(p, DOM_SELECTOR_CLASS);
+		} else if (*p->pos == '[') {
+			err = _dom_selector_parse_attribute(p);
+		} else if (*p->pos == ':') {
+			err = _dom_selector_parse_pseudo(p);
+		} else {
+			break;
+		}
+	}
+
+	if (err == DOM_NO_ERR && universal == false && p->n_tests == first)
+		return DOM_SYNTAX_ERR;
+
+	return err;
+}
+
+/**
+ * Parse a selector list
+ *
+ * \param p  The parser
+ * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
+ */
+dom_exception _dom_selector_parse_list(dom_selector_parser *p)
+{
+	dom_selector_op op;
+	dom_exception err;
+	bool space;
+
+	_dom_selector_skip_space(p);
+
+	while (true) {
+		err = _dom_selector_parse_compound(p);
+		if (err != DOM_NO_ERR)
+			return err;
+
+		space = _dom_selector_skip_space(p);
+
+		if (p->pos == p->end || *p->pos == ',') {
+			if (_dom_selector_add(p, DOM_SELECTOR_END) == NULL)
+				return DOM_NO_MEM_ERR;
+
+			if (p->pos == p->end)
+				return DOM_NO_ERR;
+
+			p->pos++;
+			_dom_selector_skip_space(p);
+			continue;
+		}
+
+		switch (*p->pos) {
+		case '>':
+			op = DOM_SELECTOR_CHILD;
+			p->pos++;
+			break;
+		case '+':
+			op = DOM_SELECTOR_ADJACENT;
+			p->pos++;
+			break;
+		case '~':
+			op = DOM_SELECTOR_SIBLING;
+			p->pos++;
+			break;
+		default:
+			if (space == false)
+				return DOM_SYNTAX_ERR;
+			op = DOM_SELECTOR_DESCENDANT;
+			break;
+		}
+
+		if (_dom_selector_add(p, op) == NULL)
+			return DOM_NO_MEM_ERR;
+
+		_dom_selector_skip_space(p);
+	}
+}
+
+/*----------------------------------------------------------------------*/
+/* Matching */
+
+/**
+ * Get an element's parent element
+ *
+ * \param node  The element
+ * \return the parent, or NULL if the parent is not an element
+ */
+static inline dom_node_internal *_dom_selector_parent(dom_node_internal *node)
+{
+	node = node->parent;
+
+	return node != NULL && node->type == DOM_ELEMENT_NODE ? node : NULL;
+}
+
+/**
+ * Get an element's previous sibling element
+ *
+ * \param node  The element
+ * \return the previous sibling element, or NULL if there is none
+ */
+static inline dom_node_internal *_dom_selector_previous(
+		dom_node_internal *node)
+{
+	do
+		node = node->previous;
+	while (node != NULL && node->type != DOM_ELEMENT_NODE);
+
+	return node;
+}
+
+/**
+ * Get an element's next sibling element
+ *
+ * \param node  The element
+ * \return the next sibling element, or NULL if there is none
+ */
+static inline dom_node_internal *_dom_selector_next(dom_node_internal *node)
+{
+	do
+		node = node->next;
+	while (node != NULL && node->type != DOM_ELEMENT_NODE);
+
+	return node;
+}
+
+/**
+ * Test whether an element matches a compiled selector list
+ *
+ * \param selector  The selector list
+ * \param node      The element to test
+ * \param walk      A walk at ::node, or NULL
+ * \param quirks    Whether the element's document is in quirks mode
+ * \return true if ::node matches any of the selectors, false otherwise
+ *
+ * If a walk is given, complex selectors requiring keys which none of
+ * ::node's ancestors have are rejected without visiting the ancestors.
+ */
+bool _dom_selector_match(const dom_selector *selector,
+		dom_node_internal *node, dom_walk *walk, bool quirks)
+{
+	const dom_selector_test *test = selector->tests;
+	const dom_selector_test *end = test + selector->n_tests;
+	const dom_selector_hashes *hashes = selector->hashes;
+
+	for (; test < end; hashes++) {
+		if (_dom_selector_match_complex(test, node, hashes, walk,
+				quirks))
+			return true;
+
+		while (test->op != DOM_SELECTOR_END)
+			test++;
+		test++;
+	}
+
+	return false;
+}
+
+/**
+ * Test whether the ancestors of a walk's element may match a selector
+ *
+ * \param hashes  The keys required of ancestors by a complex selector
+ * \param walk    The walk
+ * \return false if the ancestors lack one of the keys, true otherwise
+ */
+bool _dom_selector_may_match(const dom_selector_hashes *hashes,
+		dom_walk *walk)
+{
+	uint32_t i;
+
+	for (i = 0; i < hashes->n_hashes; i++) {
+		if (dom_walk_ancestors_may_have(walk, hashes->keys[i],
+				hashes->hashes[i]) == false)
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Test whether an element matches a complex selector
+ *
+ * \param test    The first test of a compound selector
+ * \param node    The element to test
+ * \param hashes  The keys required of ancestors by the complex selector
+ * \param walk    A walk at ::node, or NULL
+ * \param quirks  Whether the element's document is in quirks mode
+ * \return true if ::node matches the compound selector and those to its
+ *         left, false otherwise
+ *
+ * Only descendant and general sibling combinators may need more than one
+ * element tried, and so recurse; the depth is bounded by the number of
+ * compound selectors.  The walk's filter is tested at the first child or
+ * descendant combinator, once ::node has passed its own tests.
+ */
+bool _dom_selector_match_complex(const dom_selector_test *test,
+		dom_node_internal *node, const dom_selector_hashes *hashes,
+		dom_walk *walk, bool quirks)
+{
+	while (true) {
+		for (; test->op < DOM_SELECTOR_DESCENDANT; test++) {
+			if (_dom_selector_test(test, node, quirks) == false)
+				return false;
+		}
+
+		if (walk != NULL && (test->op == DOM_SELECTOR_DESCENDANT ||
+				test->op == DOM_SELECTOR_CHILD)) {
+			if (_dom_selector_may_match(hashes, walk) == false)
+				return false;
+			walk = NULL;
+		}
+
+		switch (test->op) {
+		case DOM_SELECTOR_DESCENDANT:
+			while ((node = _dom_selector_parent(node)) != NULL) {
+				if (_dom_selector_match_complex(test + 1, node,
+						hashes, NULL, quirks))
+					return true;
+			}
+			return false;
+		case DOM_SELECTOR_CHILD:
+			node = _dom_selector_parent(node);
+			break;
+		case DOM_SELECTOR_ADJACENT:
+			node = _dom_selector_previous(node);
+			break;
+		case DOM_SELECTOR_SIBLING:
+			/* Siblings share the ancestors in the filter */
+			while ((node = _dom_selector_previous(node)) != NULL) {
+				if (_dom_selector_match_complex(test + 1, node,
+						hashes, walk, quirks))
+					return true;
+			}
+			return false;
+		default:
+			return true;
+		}
+
+		if (node == NULL)
+			return false;
+
+		test++;
+	}
+}
+
+/**
+ * Test whether the names of an element are matched caselessly
+ *
+ * \param node  The element
+ * \return true if ::node is an HTML element in an HTML document, false
+ *         otherwise.
+ */
+static inline bool _dom_selector_caseless_names(dom_node_internal *node)
+{
+	return _dom_document_is_html(node->owner) &&
+			_dom_html_node_is_element(node);
+}
+
+/**
+ * Run a single test of a compound selector
+ *
+ * \param test    The test
+ * \param node    The element to test
+ * \param quirks  Whether the element's document is in quirks mode
+ * \return true if ::node passes the test, false otherwise
+ *
+ * Element and attribute names are compared caselessly for HTML elements
+ * in HTML documents, and case sensitively for any other element.
+ */
+bool _dom_selector_test(const dom_selector_test *test,
+		dom_node_internal *node, bool quirks)
+{
+	struct dom_element *element = (struct dom_element *) node;
+	dom_node_internal *child;
+	dom_string *value;
+	bool match = false;
+	uint32_t i;
+
+	switch (test->op) {
+	case DOM_SELECTOR_TYPE:
+		if (_dom_selector_caseless_names(node))
+			return dom_string_caseless_lwc_isequal(node->name,
+					test->name);
+		return dom_string_lwc_isequal(node->name, test->name);
+	case DOM_SELECTOR_CLASS:
+		for (i = 0; i < element->n_classes && match == false; i++) {
+			if (quirks)
+				(void) lwc_string_caseless_isequal(test->name,
+						element->classes[i], &match);
+			else
+				(void) lwc_string_isequal(test->name,
+						element->classes[i], &match);
+		}
+		return match;
+	case DOM_SELECTOR_ROOT:
+		return node->parent != NULL &&
+				node->parent->type == DOM_DOCUMENT_NODE;
+	case DOM_SELECTOR_FIRST_CHILD:
+		return _dom_selector_previous(node) == NULL;
+	case DOM_SELECTOR_LAST_CHILD:
+		return _dom_selector_next(node) == NULL;
+	case DOM_SELECTOR_ONLY_CHILD:
+		return _dom_selector_previous(node) == NULL &&
+				_dom_selector_next(node) == NULL;
+	case DOM_SELECTOR_EMPTY:
+		for (child = node->first_child; child != NULL;
+				child = child->next) {
+			switch (child->type) {
+			case DOM_ELEMENT_NODE:
+			case DOM_ENTITY_REFERENCE_NODE:
+				return false;
+			case DOM_TEXT_NODE:
+			case DOM_CDATA_SECTION_NODE:
+				if (dom_string_byte_length(child->value) > 0)
+					return false;
+				break;
+			default:
+				break;
+			}
+		}
+		return true;
+	case DOM_SELECTOR_ID:
+		if (_dom_element_get_id(element, &value) != DOM_NO_ERR ||
+				value == NULL)
+			return false;
+
+		if (quirks)
+			match = dom_string_caseless_lwc_isequal(value,
+					test->name);
+		else
+			match = dom_string_lwc_isequal(value, test->name);
+
+		dom_string_unref(value);
+		return match;
+	default:
+		if (_dom_element_get_attribute_lwc(element, test->name,
+				_dom_selector_caseless_names(node),
+				&value) != DOM_NO_ERR || value == NULL)
+			return false;
+
+		match = _dom_selector_match_value(test, value);
+
+		dom_string_unref(value);
+		return match;
+	}
+}
+
+/**
+ * Compare some bytes of an attribute value with a selector's
+ *
+ * \param a         The first bytes
+ * \param b         The second bytes
+ * \param len       The number of bytes to compare
+ * \param caseless  Whether to compare case insensitively
+ * \return true if the bytes match, false otherwise
+ */
+static inline bool _dom_selector_bytes_equal(const uint8_t *a,
+		const uint8_t *b, size_t len, bool caseless)
+{
+	if (caseless)
+		return _dom_ascii_caseless_isequal(a, b, len);
+
+	return memcmp(a, b, len) == 0;
+}
+
+/**
+ * Test an attribute value against an attribute selector
+ *
+ * \param test   The attribute selector's test
+ * \param value  The attribute's value
+ * \return true if ::value matches, false otherwise
+ */
+bool _dom_selector_match_value(const dom_selector_test *test,
+		dom_string *value)
+{
+	const uint8_t *v = (const uint8_t *) dom_string_data(value);
+	size_t vlen = dom_string_byte_length(value);
+	const uint8_t *s;
+	size_t slen, i;
+
+	if (test->op == DOM_SELECTOR_ATTR_EXISTS)
+		return true;
+
+	s = (const uint8_t *) lwc_string_data(test->value);
+	slen = lwc_string_length(test->value);
+
+	switch (test->op) {
+	case DOM_SELECTOR_ATTR_EQUAL:
+		return vlen == slen &&
+				_dom_selector_bytes_equal(v, s, slen,
+						test->caseless);
+	case DOM_SELECTOR_ATTR_INCLUDES:
+		/* Compare with each whitespace separated word */
+		for (i = 0; slen > 0 && i < vlen; ) {
+			size_t word;
+
+			if (_dom_ascii_is_space(v[i])) {
+				i++;
+				continue;
+			}
+
+			for (word = i; i < vlen &&
+					_dom_ascii_is_space(v[i]) == false; i++)
+				;
+
+			if (i - word == slen && _dom_selector_bytes_equal(
+					v + word, s, slen, test->caseless))
+				return true;
+		}
+		return false;
+	case DOM_SELECTOR_ATTR_DASHMATCH:
+		return vlen >= slen &&
+				(vlen == slen || v[slen] == '-') &&
+				_dom_selector_bytes_equal(v, s, slen,
+						test->caseless);
+	case DOM_SELECTOR_ATTR_PREFIX:
+		return slen > 0 && vlen >= slen &&
+				_dom_selector_bytes_equal(v, s, slen,
+						test->caseless);
+	case DOM_SELECTOR_ATTR_SUFFIX:
+		return slen > 0 && vlen >= slen &&
+				_dom_selector_bytes_equal(v + vlen - slen, s,
+						slen, test->caseless);
+	case DOM_SELECTOR_ATTR_SUBSTRING:
+		for (i = 0; slen > 0 && i + slen <= vlen; i++) {
+			if (_dom_selector_bytes_equal(v + i, s, slen,
+					test->caseless))
+				return true;
+		}
+		return false;
+	default:
+		return false;
+	}
+}
+
+/*----------------------------------------------------------------------*/
+/* Selecting */
+
+/**
+ * Find the elements below a node which match a selector list
+ *
+ * \param root     The node to search below
+ * \param text     The selector list
+ * \param limit    The most elements to find
+ * \param items    Pointer to location to receive an array of the elements
+ *                 found, in document order
+ * \param n_items  Pointer to location to receive the number of elements
+ * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
+ *
+ * The selectors may match ::root's ancestors and their other descendants,
+ * but only elements below ::root are returned.
+ *
+ * The elements found will have had their reference counts increased.  The
+ * client must unref them, and free the array, which is NULL if none were
+ * found.
+ */
+dom_exception _dom_selector_select(dom_node_internal *root,
+		dom_string *text, uint32_t limit,
+		dom_node_internal ***items, uint32_t *n_items)
+{
+	dom_node_internal **found = NULL;
+	uint32_t n_found = 0, alloc = 0;
+	dom_selector *selector;
+	struct dom_element *element;
+	dom_node_internal *node;
+	dom_walk *walk;
+	dom_exception err;
+	bool quirks;
+	uint32_t i;
+
+	err = _dom_selector_create(text, &selector);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	err = dom_walk_create((struct dom_node *) root, &walk);
+	if (err != DOM_NO_ERR) {
+		_dom_selector_destroy(selector);
+		return err;
+	}
+
+	quirks = root->owner != NULL &&
+			root->owner->quirks != DOM_DOCUMENT_QUIRKS_MODE_NONE;
+
+	/* Walk the elements below root in document order, keeping a filter
+	 * of the keys of each element's ancestors */
+	while (n_found < limit) {
+		err = dom_walk_next(walk, &element);
+		if (err != DOM_NO_ERR || element == NULL)
+			break;
+
+		node = (dom_node_internal *) element;
+
+		if (_dom_selector_match(selector, node, walk, quirks)) {
+			if (n_found == alloc) {
+				dom_node_internal **temp;
+
+				alloc = alloc == 0 ? 16 : alloc * 2;
+				temp = realloc(found, alloc * sizeof(*temp));
+				if (temp == NULL) {
+					err = DOM_NO_MEM_ERR;
+					break;
+				}
+				found = temp;
+			}
+
+			found[n_found++] = node;
+		}
+	}
+
+	dom_walk_destroy(walk);
+	_dom_selector_destroy(selector);
+
+	if (err != DOM_NO_ERR) {
+		free(found);
+		return err;
+	}
+
+	for (i = 0; i < n_found; i++)
+		dom_node_ref(found[i]);
+
+	*items = found;
+	*n_items = n_found;
+
+	return DOM_NO_ERR;
+}
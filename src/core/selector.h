@@ -0,0 +1,37 @@
+/*
+ * This file is part of libdom.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#ifndef dom_internal_core_selector_h_
+#define dom_internal_core_selector_h_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <dom/core/exceptions.h>
+#include <dom/core/string.h>
+#include <dom/core/walk.h>
+
+struct dom_node_internal;
+
+typedef struct dom_selector dom_selector;
+
+/* Compile a selector list */
+dom_exception _dom_selector_create(dom_string *text, dom_selector **result);
+
+/* Destroy a compiled selector list */
+void _dom_selector_destroy(dom_selector *selector);
+
+/* Test whether an element matches a compiled selector list */
+bool _dom_selector_match(const dom_selector *selector,
+		struct dom_node_internal *node, dom_walk *walk,
+		bool quirks);
+
+/* Find the elements below a node which match a selector list */
+dom_exception _dom_selector_select(struct dom_node_internal *root,
+		dom_string *text, uint32_t limit,
+		struct dom_node_internal ***items, uint32_t *n_items);
+
+#endif
@@ -16,6 +16,7 @@
 
 #include "core/string.h"
 #include "core/document.h"
+#include "utils/ascii.h"
 #include "utils/utils.h"
 
 /**
@@ -26,14 +27,60 @@ enum dom_string_type {
 	DOM_STRING_INTERNED = 1
 };
 
+/* What is known of a DOM string's content */
+#define DOM_STRING_SCANNED	(1 << 0)	/**< ASCII flag is set */
+#define DOM_STRING_ASCII	(1 << 1)	/**< Content is all ASCII */
+#define DOM_STRING_LENGTH	(1 << 2)	/**< Length is set */
+
+/** Size of buffer on the stack for making short interned strings */
+#define DOM_STRING_STACK_BUFFER 256
+
+/** Number of characters between entries in a string's offset table */
+#define DOM_STRING_OFFSET_STRIDE 64
+
+/**
+ * The position of a character in a string
+ */
+typedef struct dom_string_offset {
+	uint32_t index;		/**< Character index */
+	uint32_t byte;		/**< Byte offset of the character */
+} dom_string_offset;
+
+/**
+ * Positions of characters in a string, in order, about every
+ * DOM_STRING_OFFSET_STRIDE characters.  The first character is left out.
+ */
+typedef struct dom_string_offsets {
+	uint32_t count;			/**< Number of entries */
+	dom_string_offset entries[];	/**< The positions */
+} dom_string_offsets;
+
 /**
  * A DOM string
  *
  * Strings are reference counted so destruction is performed correctly.
+ *
+ * The data of a CDATA string is stored immediately after its header, so
+ * each string takes a single allocation.  Strings are allocated with
+ * _dom_pool_alloc, either from a document's pool or from the heap.
+ *
+ * A string allocated from a document's pool keeps the pool alive until it
+ * is destroyed, so such strings are moved to the heap by _dom_string_unpool
+ * before they are handed out of the document.
+ *
+ * Strings never change, so what is learnt of their content is kept with
+ * them.  A string which is not ASCII may be given a table of the byte
+ * offsets of some of its characters, so that the offset of any character
+ * is found without stepping through the whole string.  Characters are
+ * counted as parserutils_charset_utf8_next() steps through them: one
+ * starts at the first byte, and at every byte which does not continue a
+ * multibyte sequence.
  */
 typedef struct dom_string_internal {
 	dom_string base;
 
+	uint32_t length;		/**< Length in characters, if known */
+
 	union {
 		struct {
 			uint8_t *ptr;	/**< Pointer to string data */
@@ -42,7 +89,15 @@ typedef struct dom_string_internal {
 		lwc_string *intern;	/**< Interned string */
 	} data;
 
+	dom_string_offsets *offsets;	/**< Offset table, or NULL */
+
 	enum dom_string_type type;	/**< String type */
+
+	uint8_t flags;		/**< What is known of the content */
+
+	bool pooled;		/**< Whether allocated from a document's pool */
+
+	uint8_t chars[];	/**< Storage for CDATA string data */
 } dom_string_internal;
 
 /**
@@ -50,8 +105,12 @@ typedef struct dom_string_internal {
  */
 static const dom_string_internal empty_string = {
 	{ 0 },
+	0,
 	{ { (uint8_t *) "", 0 } },
-	DOM_STRING_CDATA
+	NULL,
+	DOM_STRING_CDATA,
+	DOM_STRING_SCANNED | DOM_STRING_ASCII | DOM_STRING_LENGTH,
+	false
 };
 
 void dom_string_destroy(dom_string *str)
@@ -66,12 +125,77 @@ void dom_string_destroy(dom_string *str)
 			}
 			break;
 		case DOM_STRING_CDATA:
-			free(istr->data.cdata.ptr);
+			/* Data is stored inline */
 			break;
 		}
 
-		free(str);
+		free(istr->offsets);
+
+		_dom_pool_free(str);
+	}
+}
+
+/**
+ * Allocate a CDATA string
+ *
+ * \param pool  The pool to allocate from, or NULL to use the heap
+ * \param len   Length, in bytes, of the string's data
+ * \return the new string, with uninitialised data, or NULL on memory
+ *         exhaustion
+ *
+ * The returned string will already be referenced, and its data
+ * terminated.
+ */
+static dom_string_internal *_dom_string_alloc(dom_pool *pool, size_t len)
+{
+	dom_string_internal *ret;
+
+	ret = _dom_pool_alloc(pool, sizeof(*ret) + len + 1);
+	if (ret == NULL)
+		return NULL;
+
+	ret->data.cdata.ptr = ret->chars;
+	ret->data.cdata.ptr[len] = '\0';
+	ret->data.cdata.len = len;
+
+	ret->base.refcnt = 1;
+
+	ret->offsets = NULL;
+	ret->type = DOM_STRING_CDATA;
+	ret->flags = 0;
+	ret->pooled = (pool != NULL);
+
+	return ret;
+}
+
+/**
+ * Create a DOM string from a string of characters, in a pool
+ *
+ * \param pool   The pool to allocate from, or NULL to use the heap
+ * \param ptr    Pointer to string of characters
+ * \param len    Length, in bytes, of string of characters
+ * \param str    Pointer to location to receive result
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion
+ */
+static dom_exception _dom_string_create(dom_pool *pool, const uint8_t *ptr,
+		size_t len, dom_string **str)
+{
+	dom_string_internal *ret;
+
+	if (ptr == NULL || len == 0) {
+		ptr = (const uint8_t *) "";
+		len = 0;
 	}
+
+	ret = _dom_string_alloc(pool, len);
+	if (ret == NULL)
+		return DOM_NO_MEM_ERR;
+
+	memcpy(ret->data.cdata.ptr, ptr, len);
+
+	*str = (dom_string *)ret;
+
+	return DOM_NO_ERR;
 }
 
 /**
@@ -91,33 +215,71 @@ void dom_string_destroy(dom_string *str)
 dom_exception dom_string_create(const uint8_t *ptr, size_t len, 
 		dom_string **str)
 {
-	dom_string_internal *ret;
+	return _dom_string_create(NULL, ptr, len, str);
+}
 
-	if (ptr == NULL || len == 0) {
-		ptr = (const uint8_t *) "";
-		len = 0;
-	}
+/**
+ * Create a DOM string from a string of characters, using a document's pool
+ *
+ * \param doc    The document whose pool to allocate from
+ * \param ptr    Pointer to string of characters
+ * \param len    Length, in bytes, of string of characters
+ * \param str    Pointer to location to receive result
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion
+ *
+ * This is intended for the many short strings created by parsers, which
+ * are held by the document's nodes.  The returned string must only be
+ * referenced by the document: it must be passed through _dom_string_unpool
+ * before being handed to a client, or to another document.
+ */
+dom_exception _dom_string_create_in_document(struct dom_document *doc,
+		const uint8_t *ptr, size_t len, dom_string **str)
+{
+	return _dom_string_create(doc->node_pool, ptr, len, str);
+}
 
-	ret = malloc(sizeof(*ret));
-	if (ret == NULL)
-		return DOM_NO_MEM_ERR;
+/**
+ * Move a string out of a document's pool, so it may be handed out
+ *
+ * \param str  Pointer to location holding a reference to the string, or NULL
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion
+ *
+ * If the string was allocated from a pool, the reference at ::str is
+ * replaced by one to a copy on the heap; otherwise it is left alone.  The
+ * copy is made once, so later calls for the same location are cheap.
+ */
+dom_exception _dom_string_unpool(dom_string **str)
+{
+	dom_string_internal *istr = (void *) *str;
+	dom_string_internal *ret;
 
-	ret->data.cdata.ptr = malloc(len + 1);
-	if (ret->data.cdata.ptr == NULL) {
-		free(ret);
-		return DOM_NO_MEM_ERR;
-	}
+	if (istr == NULL || istr->pooled == false)
+		return DOM_NO_ERR;
 
-	memcpy(ret->data.cdata.ptr, ptr, len);
-	ret->data.cdata.ptr[len] = '\0';
+	if (istr->type == DOM_STRING_INTERNED) {
+		ret = _dom_pool_alloc(NULL, sizeof(*ret));
+		if (ret == NULL)
+			return DOM_NO_MEM_ERR;
 
-	ret->data.cdata.len = len;
+		ret->data.intern = lwc_string_ref(istr->data.intern);
+		ret->base.refcnt = 1;
+		ret->offsets = NULL;
+		ret->type = DOM_STRING_INTERNED;
+		ret->pooled = false;
+	} else {
+		ret = _dom_string_alloc(NULL, istr->data.cdata.len);
+		if (ret == NULL)
+			return DOM_NO_MEM_ERR;
 
-	ret->base.refcnt = 1;
+		memcpy(ret->data.cdata.ptr, istr->data.cdata.ptr,
+				istr->data.cdata.len);
+	}
 
-	ret->type = DOM_STRING_CDATA;
+	ret->flags = istr->flags;
+	ret->length = istr->length;
 
-	*str = (dom_string *)ret;
+	dom_string_unref(*str);
+	*str = (dom_string *) ret;
 
 	return DOM_NO_ERR;
 }
@@ -146,19 +308,22 @@ dom_exception dom_string_create_interned(const uint8_t *ptr, size_t len,
 		len = 0;
 	}
 
-	ret = malloc(sizeof(*ret));
+	ret = _dom_pool_alloc(NULL, sizeof(*ret));
 	if (ret == NULL)
 		return DOM_NO_MEM_ERR;
 
 	if (lwc_intern_string((const char *) ptr, len, 
 			&ret->data.intern) != lwc_error_ok) {
-		free(ret);
+		_dom_pool_free(ret);
 		return DOM_NO_MEM_ERR;
 	}
 
 	ret->base.refcnt = 1;
 
+	ret->offsets = NULL;
 	ret->type = DOM_STRING_INTERNED;
+	ret->flags = 0;
+	ret->pooled = false;
 
 	*str = (dom_string *)ret;
 
@@ -187,8 +352,7 @@ dom_exception dom_string_intern(dom_string *str,
 			return _dom_exception_from_lwc_error(lerr);
 		}
 
-		free(istr->data.cdata.ptr);
-
+		/* The inline data is simply abandoned */
 		istr->data.intern = ret;
 
 		istr->type = DOM_STRING_INTERNED;
@@ -199,6 +363,25 @@ dom_exception dom_string_intern(dom_string *str,
 	return DOM_NO_ERR;
 }
 
+/**
+ * Get the interned string behind a DOM string, if it has one
+ *
+ * \param str  The DOM string
+ * \return the interned string, or NULL if ::str is not interned.
+ *
+ * Unlike dom_string_intern(), this never interns the string, and the
+ * result is not referenced: it is valid for as long as ::str is.
+ */
+lwc_string *_dom_string_get_intern(const dom_string *str)
+{
+	const dom_string_internal *istr = (const void *) str;
+
+	if (istr->type != DOM_STRING_INTERNED)
+		return NULL;
+
+	return istr->data.intern;
+}
+
 /**
  * Case sensitively compare two DOM strings
  *
@@ -236,16 +419,6 @@ bool dom_string_isequal(const dom_string *s1, const dom_string *s2)
 	return 0 == memcmp(dom_string_data((dom_string *) is1), dom_string_data((dom_string *)is2), len);
 }
 
-/**
- * Trivial locale-agnostic lower case convertor
- */
-static inline uint8_t dolower(const uint8_t c)
-{
-	if ('A' <= c && c <= 'Z')
-		return c + 'a' - 'A';
-	return c;
-}
-
 /**
  * Case insensitively compare two DOM strings
  *
@@ -286,16 +459,7 @@ bool dom_string_caseless_isequal(const dom_string *s1, const dom_string *s2)
 	d1 = (const uint8_t *) dom_string_data((dom_string *) is1);
 	d2 = (const uint8_t *) dom_string_data((dom_string *)is2);
 
-	while (len > 0) {
-		if (dolower(*d1) != dolower(*d2))
-			return false;
-
-		d1++;
-		d2++;
-		len--;
-	}
-
-	return true;
+	return _dom_ascii_caseless_isequal(d1, d2, len);
 }
 
 
@@ -370,16 +534,342 @@ bool dom_string_caseless_lwc_isequal(const dom_string *s1, lwc_string *s2)
 	d1 = (const uint8_t *) dom_string_data(s1);
 	d2 = (const uint8_t *) lwc_string_data(s2);
 
-	while (len > 0) {
-		if (dolower(*d1) != dolower(*d2))
-			return false;
+	return _dom_ascii_caseless_isequal(d1, d2, len);
+}
+
+
+/**
+ * Test whether a byte continues a multibyte UTF-8 sequence
+ *
+ * \param c  The byte to test
+ * \return true if ::c is a continuation byte, false otherwise.
+ */
+static inline bool _dom_string_is_continuation(uint8_t c)
+{
+	return (c & 0xC0) == 0x80;
+}
+
+/**
+ * Find whether a string is ASCII, if that is not yet known
+ *
+ * \param istr  The string to examine
+ *
+ * The length of an ASCII string is its byte length, so that is set too.
+ */
+static void _dom_string_scan(dom_string_internal *istr)
+{
+	const uint8_t *s;
+	size_t slen, i;
+
+	if (istr->flags & DOM_STRING_SCANNED)
+		return;
+
+	s = (const uint8_t *) dom_string_data((dom_string *) istr);
+	slen = dom_string_byte_length((dom_string *) istr);
+
+	for (i = 0; i < slen; i++) {
+		if (s[i] >= 0x80)
+			break;
+	}
+
+	istr->flags |= DOM_STRING_SCANNED;
+
+	if (i == slen) {
+		istr->flags |= DOM_STRING_ASCII | DOM_STRING_LENGTH;
+		istr->length = slen;
+	}
+}
+
+/**
+ * Note that a new string is ASCII, as those it was made from were
+ *
+ * \param istr  The new string
+ */
+static void _dom_string_set_ascii(dom_string_internal *istr)
+{
+	istr->flags |= DOM_STRING_SCANNED | DOM_STRING_ASCII |
+			DOM_STRING_LENGTH;
+	istr->length = istr->data.cdata.len;
+}
+
+/**
+ * Test whether a string is known to be ASCII
+ *
+ * \param str  The string to test
+ * \return true if ::str is ASCII, false if it is not or is not scanned.
+ */
+static inline bool _dom_string_is_ascii(const dom_string *str)
+{
+	return (((const dom_string_internal *) (const void *) str)->flags &
+			DOM_STRING_ASCII) != 0;
+}
+
+/**
+ * Find the positions of characters in part of a string
+ *
+ * \param s        The string's data
+ * \param slen     The string's byte length
+ * \param from     The position to start from
+ * \param until    Index of the character to stop before
+ * \param entries  Array to receive the positions, which must have room
+ *                 for one per DOM_STRING_OFFSET_STRIDE characters
+ * \return the number of positions found.
+ *
+ * Positions are recorded every DOM_STRING_OFFSET_STRIDE characters after
+ * ::from, until the end of the string or the character ::until.
+ */
+static uint32_t _dom_string_find_offsets(const uint8_t *s, size_t slen,
+		dom_string_offset from, uint32_t until,
+		dom_string_offset *entries)
+{
+	uint32_t index = from.index, n = 0;
+	size_t i;
+
+	for (i = from.byte + 1; i < slen; i++) {
+		if (_dom_string_is_continuation(s[i]))
+			continue;
+
+		if (++index >= until)
+			break;
+
+		if ((index - from.index) % DOM_STRING_OFFSET_STRIDE == 0) {
+			entries[n].index = index;
+			entries[n].byte = i;
+			n++;
+		}
+	}
+
+	return n;
+}
+
+/**
+ * Build the offset table of a string which is not ASCII
+ *
+ * \param istr  The string
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ */
+static dom_exception _dom_string_build_offsets(dom_string_internal *istr)
+{
+	static const dom_string_offset start = { 0, 0 };
+	const uint8_t *s;
+	size_t slen;
+	dom_string_offsets *offsets;
+
+	s = (const uint8_t *) dom_string_data((dom_string *) istr);
+	slen = dom_string_byte_length((dom_string *) istr);
+
+	/* Every character takes at least one byte */
+	offsets = malloc(sizeof(*offsets) + (slen / DOM_STRING_OFFSET_STRIDE) *
+			sizeof(offsets->entries[0]));
+	if (offsets == NULL)
+		return DOM_NO_MEM_ERR;
+
+	offsets->count = _dom_string_find_offsets(s, slen, start, UINT32_MAX,
+			offsets->entries);
+
+	istr->offsets = offsets;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Give the result of replacing part of a string an offset table, taken
+ * from that of the original string
+ *
+ * \param res     The new string
+ * \param target  The original string, which has an offset table
+ * \param i1      Index of the first character replaced
+ * \param i2      Index of the character after those replaced
+ * \param b1      Byte offset of the first character replaced
+ * \param b2      Byte offset of the character after those replaced
+ * \param chars   The number of characters replacing them
+ * \param bytes   The number of bytes replacing them
+ *
+ * The positions before the replaced characters are kept and those after
+ * them are moved; only where the gap between them grows too big are new
+ * positions found.  This keeps editing a long string from having to step
+ * through it all each time.  If there is no memory, ::res is left for
+ * its table to be built when needed.
+ */
+static void _dom_string_move_offsets(dom_string_internal *res,
+		const dom_string_internal *target, uint32_t i1, uint32_t i2,
+		uint32_t b1, uint32_t b2, uint32_t chars, uint32_t bytes)
+{
+	const dom_string_offsets *old = target->offsets;
+	dom_string_offsets *offsets;
+	dom_string_offset prev = { 0, 0 };
+	uint32_t keep, skip, next, n, i;
+	size_t gap = 0;
+
+	/* Positions up to the first replaced character are unchanged */
+	for (keep = 0; keep < old->count; keep++) {
+		if (old->entries[keep].index > i1)
+			break;
+	}
+
+	/* Those of replaced characters are dropped */
+	for (skip = keep; skip < old->count; skip++) {
+		if (old->entries[skip].index >= i2)
+			break;
+	}
+
+	if (keep > 0)
+		prev = old->entries[keep - 1];
+
+	if (skip < old->count)
+		next = old->entries[skip].index - i2 + i1 + chars;
+	else
+		next = res->length;
+
+	if (next - prev.index > 2 * DOM_STRING_OFFSET_STRIDE)
+		gap = (next - prev.index) / DOM_STRING_OFFSET_STRIDE;
+
+	offsets = malloc(sizeof(*offsets) + (keep + gap + old->count - skip) *
+			sizeof(offsets->entries[0]));
+	if (offsets == NULL)
+		return;
+
+	memcpy(offsets->entries, old->entries,
+			keep * sizeof(offsets->entries[0]));
+	n = keep;
+
+	if (gap > 0) {
+		n += _dom_string_find_offsets(res->data.cdata.ptr,
+				res->data.cdata.len, prev, next,
+				offsets->entries + n);
+	}
+
+	for (i = skip; i < old->count; i++) {
+		offsets->entries[n].index =
+				old->entries[i].index - i2 + i1 + chars;
+		offsets->entries[n].byte =
+				old->entries[i].byte - b2 + b1 + bytes;
+		n++;
+	}
+
+	offsets->count = n;
+	res->offsets = offsets;
+}
+
+/**
+ * Find the byte offset of a character in a string
+ *
+ * \param str     The string
+ * \param index   The character index, which may be the string's length
+ * \param offset  Pointer to location to receive the byte offset
+ * \return DOM_NO_ERR on success, DOM_INDEX_SIZE_ERR if ::index is beyond
+ *         the end of the string.
+ *
+ * Strings which are not ASCII have their offset table built when a
+ * character past the first DOM_STRING_OFFSET_STRIDE is wanted.  If there
+ * is no memory for it, the string is stepped through from the start.
+ */
+static dom_exception _dom_string_char_offset(dom_string *str,
+		uint32_t index, uint32_t *offset)
+{
+	dom_string_internal *istr = (void *) str;
+	const dom_string_offsets *offsets;
+	const uint8_t *s;
+	size_t slen;
+	uint32_t b = 0, lo, hi, mid;
+	parserutils_error err;
+
+	s = (const uint8_t *) dom_string_data(str);
+	slen = dom_string_byte_length(str);
+
+	_dom_string_scan(istr);
+
+	if (istr->flags & DOM_STRING_ASCII) {
+		if (index > slen)
+			return DOM_INDEX_SIZE_ERR;
+
+		*offset = index;
+		return DOM_NO_ERR;
+	}
+
+	if (index >= DOM_STRING_OFFSET_STRIDE && (istr->offsets != NULL ||
+			_dom_string_build_offsets(istr) == DOM_NO_ERR)) {
+		offsets = istr->offsets;
+
+		/* Find the last position at or before the character */
+		lo = 0;
+		hi = offsets->count;
+		while (lo < hi) {
+			mid = lo + (hi - lo) / 2;
+			if (offsets->entries[mid].index <= index)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+
+		if (lo > 0) {
+			b = offsets->entries[lo - 1].byte;
+			index -= offsets->entries[lo - 1].index;
+		}
+	}
+
+	while (index > 0) {
+		err = parserutils_charset_utf8_next(s, slen, b, &b);
+		if (err != PARSERUTILS_OK)
+			return DOM_INDEX_SIZE_ERR;
+
+		index--;
+	}
+
+	*offset = b;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Work out what is known of the result of replacing part of a string
+ *
+ * \param res     The new string
+ * \param target  The original string
+ * \param source  The string replacing part of it
+ * \param i1      Index of the first character replaced
+ * \param i2      Index of the character after those replaced
+ * \param b1      Byte offset of the first character replaced
+ * \param b2      Byte offset of the character after those replaced
+ *
+ * Unless either string starts with a continuation byte, which would stop
+ * being counted as a character, the characters of the new string are
+ * simply those kept and those added.
+ */
+static void _dom_string_replaced(dom_string_internal *res,
+		dom_string *target, dom_string *source,
+		uint32_t i1, uint32_t i2, uint32_t b1, uint32_t b2)
+{
+	dom_string_internal *itarget = (void *) target;
+	const uint8_t *t, *s;
+	size_t slen;
+	uint32_t chars;
+
+	_dom_string_scan((dom_string_internal *) (void *) source);
 
-		d1++;
-		d2++;
-		len--;
+	if (_dom_string_is_ascii(target) && _dom_string_is_ascii(source)) {
+		_dom_string_set_ascii(res);
+		return;
 	}
 
-	return true;
+	t = (const uint8_t *) dom_string_data(target);
+	s = (const uint8_t *) dom_string_data(source);
+	slen = dom_string_byte_length(source);
+
+	if ((dom_string_byte_length(target) > 0 &&
+			_dom_string_is_continuation(t[0])) ||
+			(slen > 0 && _dom_string_is_continuation(s[0])))
+		return;
+
+	chars = dom_string_length(source);
+
+	res->flags |= DOM_STRING_LENGTH;
+	res->length = dom_string_length(target) - (i2 - i1) + chars;
+
+	if (itarget->offsets != NULL) {
+		_dom_string_move_offsets(res, itarget, i1, i2, b1, b2,
+				chars, slen);
+	}
 }
 
 
@@ -467,21 +957,36 @@ uint32_t dom_string_rindex(dom_string *str, uint32_t chr)
  *
  * \param str  The string to measure the length of
  * \return The length of the string, in characters
+ *
+ * The length is counted once and then kept with the string.
  */
 uint32_t dom_string_length(dom_string *str)
 {
+	dom_string_internal *istr = (void *) str;
 	const uint8_t *s;
-	size_t slen, clen;
-	parserutils_error err;
+	size_t slen, i;
+	uint32_t clen;
+
+	if (istr->flags & DOM_STRING_LENGTH)
+		return istr->length;
+
+	_dom_string_scan(istr);
+	if (istr->flags & DOM_STRING_LENGTH)
+		return istr->length;
 
 	s = (const uint8_t *) dom_string_data(str);
 	slen = dom_string_byte_length(str);
 
-	err = parserutils_charset_utf8_length(s, slen, &clen);
-	if (err != PARSERUTILS_OK) {
-		return 0;
+	/* The first byte always starts a character */
+	clen = slen > 0 ? 1 : 0;
+	for (i = 1; i < slen; i++) {
+		if (_dom_string_is_continuation(s[i]) == false)
+			clen++;
 	}
 
+	istr->length = clen;
+	istr->flags |= DOM_STRING_LENGTH;
+
 	return clen;
 }
 
@@ -497,39 +1002,23 @@ dom_exception dom_string_at(dom_string *str, uint32_t index,
 {
 	const uint8_t *s;
 	size_t clen, slen;
-	uint32_t c, i;
+	uint32_t c, b;
 	parserutils_error err;
 
 	s = (const uint8_t *) dom_string_data(str);
 	slen = dom_string_byte_length(str);
 
-	i = 0;
-
-	while (slen > 0) {
-		err = parserutils_charset_utf8_char_byte_length(s, &clen);
-		if (err != PARSERUTILS_OK) {
-			return (uint32_t) -1;
-		}
-
-		i++;
-		if (i == index + 1)
-			break;
+	if (_dom_string_char_offset(str, index, &b) != DOM_NO_ERR ||
+			b >= slen)
+		return DOM_DOMSTRING_SIZE_ERR;
 
-		s += clen;
-		slen -= clen;
+	err = parserutils_charset_utf8_to_ucs4(s + b, slen - b, &c, &clen);
+	if (err != PARSERUTILS_OK) {
+		return (uint32_t) -1;
 	}
 
-	if (i == index + 1) {
-		err = parserutils_charset_utf8_to_ucs4(s, slen, &c, &clen);
-		if (err != PARSERUTILS_OK) {
-			return (uint32_t) -1;
-		}
-
-		*ch = c;
-		return DOM_NO_ERR;
-	} else {
-		return DOM_DOMSTRING_SIZE_ERR;
-	}
+	*ch = c;
+	return DOM_NO_ERR;
 }
 
 /** 
@@ -558,29 +1047,17 @@ dom_exception dom_string_concat(dom_string *s1, dom_string *s2,
 	s1len = dom_string_byte_length(s1);
 	s2len = dom_string_byte_length(s2);
 
-	concat = malloc(sizeof(*concat));
+	concat = _dom_string_alloc(NULL, s1len + s2len);
 	if (concat == NULL) {
 		return DOM_NO_MEM_ERR;
 	}
 
-	concat->data.cdata.ptr = malloc(s1len + s2len + 1);
-	if (concat->data.cdata.ptr == NULL) {
-		free(concat);
-
-		return DOM_NO_MEM_ERR;
-	}
-
 	memcpy(concat->data.cdata.ptr, s1ptr, s1len);
 
 	memcpy(concat->data.cdata.ptr + s1len, s2ptr, s2len);
 
-	concat->data.cdata.ptr[s1len + s2len] = '\0';
-
-	concat->data.cdata.len = s1len + s2len;
-
-	concat->base.refcnt = 1;
-
-	concat->type = DOM_STRING_CDATA;
+	if (_dom_string_is_ascii(s1) && _dom_string_is_ascii(s2))
+		_dom_string_set_ascii(concat);
 
 	*result = (dom_string *)concat;
 
@@ -603,47 +1080,26 @@ dom_exception dom_string_substr(dom_string *str,
 		uint32_t i1, uint32_t i2, dom_string **result)
 {
 	const uint8_t *s;
-	size_t slen;
 	uint32_t b1, b2;
-	parserutils_error err;
+	dom_exception err;
 
 	/* target string is NULL equivalent to empty. */
 	if (str == NULL)
 		str = (dom_string *)&empty_string;
 
 	s = (const uint8_t *) dom_string_data(str);
-	slen = dom_string_byte_length(str);
-
-	/* Initialise the byte index of the start to 0 */
-	b1 = 0;
-	/* Make the end a character offset from the start */
-	i2 -= i1;
-
-	/* Calculate the byte index of the start */
-	while (i1 > 0) {
-		err = parserutils_charset_utf8_next(s, slen, b1, &b1);
-		if (err != PARSERUTILS_OK) {
-			return DOM_NO_MEM_ERR;
-		}
-
-		i1--;
-	}
-
-	/* Initialise the byte index of the end to that of the start */
-	b2 = b1;
-
-	/* Calculate the byte index of the end */
-	while (i2 > 0) {
-		err = parserutils_charset_utf8_next(s, slen, b2, &b2);
-		if (err != PARSERUTILS_OK) {
-			return DOM_NO_MEM_ERR;
-		}
 
-		i2--;
-	}
+	/* Calculate the byte indices of the start and the end */
+	if (i2 < i1 || _dom_string_char_offset(str, i1, &b1) != DOM_NO_ERR ||
+			_dom_string_char_offset(str, i2, &b2) != DOM_NO_ERR)
+		return DOM_NO_MEM_ERR;
 
 	/* Create a string from the specified byte range */
-	return dom_string_create(s + b1, b2 - b1, result);
+	err = dom_string_create(s + b1, b2 - b1, result);
+	if (err == DOM_NO_ERR && _dom_string_is_ascii(str))
+		_dom_string_set_ascii((dom_string_internal *) (void *) *result);
+
+	return err;
 }
 
 /**
@@ -668,7 +1124,6 @@ dom_exception dom_string_insert(dom_string *target,
 	const uint8_t *t, *s;
 	uint32_t tlen, slen, clen;
 	uint32_t ins = 0;
-	parserutils_error err;
 
 	/* target string is NULL equivalent to empty. */
 	if (target == NULL)
@@ -688,32 +1143,17 @@ dom_exception dom_string_insert(dom_string *target,
 	if (offset == clen) {
 		/* Optimisation for append */
 		ins = tlen;
-	} else {
-		while (offset > 0) {
-			err = parserutils_charset_utf8_next(t, tlen, 
-					ins, &ins);
-
-			if (err != PARSERUTILS_OK) {
-				return DOM_NO_MEM_ERR;
-			}
-
-			offset--;
-		}
+	} else if (_dom_string_char_offset(target, offset, &ins) !=
+			DOM_NO_ERR) {
+		return DOM_NO_MEM_ERR;
 	}
 
 	/* Allocate result string */
-	res = malloc(sizeof(*res));
+	res = _dom_string_alloc(NULL, tlen + slen);
 	if (res == NULL) {
 		return DOM_NO_MEM_ERR;
 	}
 
-	/* Allocate data buffer for result contents */
-	res->data.cdata.ptr = malloc(tlen + slen + 1);
-	if (res->data.cdata.ptr == NULL) {
-		free(res);
-		return DOM_NO_MEM_ERR;
-	}
-
 	/* Copy initial portion of target, if any, into result */
 	if (ins > 0) {
 		memcpy(res->data.cdata.ptr, t, ins);
@@ -727,13 +1167,7 @@ dom_exception dom_string_insert(dom_string *target,
 		memcpy(res->data.cdata.ptr + ins + slen, t + ins, tlen - ins);
 	}
 
-	res->data.cdata.ptr[tlen + slen] = '\0';
-
-	res->data.cdata.len = tlen + slen;
-
-	res->base.refcnt = 1;
-
-	res->type = DOM_STRING_CDATA;
+	_dom_string_replaced(res, target, source, offset, offset, ins, ins);
 
 	*result = (dom_string *)res;
 
@@ -761,7 +1195,6 @@ dom_exception dom_string_replace(dom_string *target,
 	const uint8_t *t, *s;
 	uint32_t tlen, slen;
 	uint32_t b1, b2;
-	parserutils_error err;
 
 	/* target string is NULL equivalent to empty. */
 	if (target == NULL)
@@ -772,49 +1205,18 @@ dom_exception dom_string_replace(dom_string *target,
 	s = (const uint8_t *) dom_string_data(source);
 	slen = dom_string_byte_length(source);
 
-	/* Initialise the byte index of the start to 0 */
-	b1 = 0;
-	/* Make the end a character offset from the start */
-	i2 -= i1;
-
-	/* Calculate the byte index of the start */
-	while (i1 > 0) {
-		err = parserutils_charset_utf8_next(t, tlen, b1, &b1);
-
-		if (err != PARSERUTILS_OK) {
-			return DOM_NO_MEM_ERR;
-		}
-
-		i1--;
-	}
-
-	/* Initialise the byte index of the end to that of the start */
-	b2 = b1;
-
-	/* Calculate the byte index of the end */
-	while (i2 > 0) {
-		err = parserutils_charset_utf8_next(t, tlen, b2, &b2);
-
-		if (err != PARSERUTILS_OK) {
-			return DOM_NO_MEM_ERR;
-		}
-
-		i2--;
-	}
+	/* Calculate the byte indices of the start and the end */
+	if (i2 < i1 ||
+			_dom_string_char_offset(target, i1, &b1) != DOM_NO_ERR ||
+			_dom_string_char_offset(target, i2, &b2) != DOM_NO_ERR)
+		return DOM_NO_MEM_ERR;
 
 	/* Allocate result string */
-	res = malloc(sizeof(*res));
+	res = _dom_string_alloc(NULL, tlen + slen - (b2 - b1));
 	if (res == NULL) {
 		return DOM_NO_MEM_ERR;
 	}
 
-	/* Allocate data buffer for result contents */
-	res->data.cdata.ptr = malloc(tlen + slen - (b2 - b1) + 1);
-	if (res->data.cdata.ptr == NULL) {
-		free(res);
-		return DOM_NO_MEM_ERR;
-	}
-
 	/* Copy initial portion of target, if any, into result */
 	if (b1 > 0) {
 		memcpy(res->data.cdata.ptr, t, b1);
@@ -830,13 +1232,7 @@ dom_exception dom_string_replace(dom_string *target,
 		memcpy(res->data.cdata.ptr + b1 + slen, t + b2, tlen - b2);
 	}
 
-	res->data.cdata.ptr[tlen + slen - (b2 - b1)] = '\0';
-
-	res->data.cdata.len = tlen + slen - (b2 - b1);
-
-	res->base.refcnt = 1;
-
-	res->type = DOM_STRING_CDATA;
+	_dom_string_replaced(res, target, source, i1, i2, b1, b2);
 
 	*result = (dom_string *)res;
 
@@ -919,6 +1315,66 @@ size_t dom_string_byte_length(const dom_string *str)
 	}
 }
 
+/**
+ * Make a copy of a string with the case of its ASCII letters changed
+ *
+ * \param source   The string to copy
+ * \param first    Offset of the first byte which changes
+ * \param convert  Function to change the case of the rest of the string
+ * \param result   Pointer to location to receive result
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ *
+ * The copy is interned if the source is.  A CDATA copy is written in
+ * place, and keeps what is known of the source, which the case of ASCII
+ * letters does not affect.
+ */
+static dom_exception _dom_string_recase(dom_string *source, size_t first,
+		void (*convert)(uint8_t *dst, const uint8_t *src, size_t len),
+		dom_string **result)
+{
+	dom_string_internal *isource = (void *) source;
+	const uint8_t *src = (const uint8_t *) dom_string_data(source);
+	const size_t len = dom_string_byte_length(source);
+	uint8_t stack[DOM_STRING_STACK_BUFFER];
+	dom_string_internal *res;
+	dom_exception exc;
+	uint8_t *buf;
+
+	if (isource->type == DOM_STRING_CDATA) {
+		res = _dom_string_alloc(NULL, len);
+		if (res == NULL)
+			return DOM_NO_MEM_ERR;
+
+		memcpy(res->data.cdata.ptr, src, first);
+		convert(res->data.cdata.ptr + first, src + first, len - first);
+
+		res->flags = isource->flags;
+		res->length = isource->length;
+
+		*result = (dom_string *) res;
+
+		return DOM_NO_ERR;
+	}
+
+	if (len <= sizeof(stack)) {
+		buf = stack;
+	} else {
+		buf = malloc(len);
+		if (buf == NULL)
+			return DOM_NO_MEM_ERR;
+	}
+
+	memcpy(buf, src, first);
+	convert(buf + first, src + first, len - first);
+
+	exc = dom_string_create_interned(buf, len, result);
+
+	if (buf != stack)
+		free(buf);
+
+	return exc;
+}
+
 /** Convert the given string to uppercase
  *
  * \param source 
@@ -934,35 +1390,19 @@ dom_string_toupper(dom_string *source, bool ascii_only, dom_string **upper)
 {
 	const uint8_t *orig_s = (const uint8_t *) dom_string_data(source);
 	const size_t nbytes = dom_string_byte_length(source);
-	uint8_t *copy_s;
-	size_t index = 0;
-	dom_exception exc;
+	size_t first;
 	
 	if (ascii_only == false)
 		return DOM_NOT_SUPPORTED_ERR;
-	
-	copy_s = malloc(nbytes);
-	if (copy_s == NULL)
-		return DOM_NO_MEM_ERR;
-	memcpy(copy_s, orig_s, nbytes);
-	
-	while (index < nbytes) {
-		if (orig_s[index] >= 'a' && orig_s[index] <= 'z') {
-			copy_s[index] -= 'a' - 'A';
-		}
-		
-		index++;
-	}
-	
-	if (((dom_string_internal *) ((void *) source))->type == DOM_STRING_CDATA) {
-		exc = dom_string_create(copy_s, nbytes, upper);
-	} else {
-		exc = dom_string_create_interned(copy_s, nbytes, upper);
+
+	first = _dom_ascii_find_lower(orig_s, nbytes);
+	if (first == nbytes) {
+		/* String is already upper case. */
+		*upper = dom_string_ref(source);
+		return DOM_NO_ERR;
 	}
-	
-	free(copy_s);
-	
-	return exc;
+
+	return _dom_string_recase(source, first, _dom_ascii_toupper, upper);
 }
 
 /** Convert the given string to lowercase
@@ -988,24 +1428,17 @@ dom_string_tolower(dom_string *source, bool ascii_only, dom_string **lower)
 		const uint8_t *orig_s = (const uint8_t *)
 				dom_string_data(source);
 		const size_t nbytes = dom_string_byte_length(source);
-		size_t index = 0;
-		uint8_t *copy_s;
-
-		copy_s = malloc(nbytes);
-		if (copy_s == NULL)
-			return DOM_NO_MEM_ERR;
-		memcpy(copy_s, orig_s, nbytes);
+		size_t first;
 
-		while (index < nbytes) {
-			if (orig_s[index] >= 'A' && orig_s[index] <= 'Z') {
-				copy_s[index] += 'a' - 'A';
-			}
-
-			index++;
+		first = _dom_ascii_find_upper(orig_s, nbytes);
+		if (first == nbytes) {
+			/* String is already lower case. */
+			*lower = dom_string_ref(source);
+			return DOM_NO_ERR;
 		}
-		exc = dom_string_create(copy_s, nbytes, lower);
 
-		free(copy_s);
+		exc = _dom_string_recase(source, first, _dom_ascii_tolower,
+				lower);
 	} else {
 		bool equal;
 		lwc_error err;
@@ -1039,19 +1472,35 @@ dom_exception dom_string_whitespace_op(dom_string *s,
 {
 	const uint8_t *src_text = (const uint8_t *) dom_string_data(s);
 	size_t len = dom_string_byte_length(s);
+	uint8_t stack[DOM_STRING_STACK_BUFFER];
+	dom_string_internal *res = NULL;
 	const uint8_t *src_pos;
 	const uint8_t *src_end;
 	dom_exception exc;
 	uint8_t *temp_pos;
 	uint8_t *temp;
+	size_t run;
 
 	if (len == 0) {
 		*ret = dom_string_ref(s);
+		return DOM_NO_ERR;
 	}
 
-	temp = malloc(len);
-	if (temp == NULL) {
-		return DOM_NO_MEM_ERR;
+	/* The result is never longer than the source, so a CDATA result is
+	 * written in place, and an interned one on the stack if it fits */
+	if (((dom_string_internal *) ((void *) s))->type == DOM_STRING_CDATA) {
+		res = _dom_string_alloc(NULL, len);
+		if (res == NULL) {
+			return DOM_NO_MEM_ERR;
+		}
+		temp = res->data.cdata.ptr;
+	} else if (len <= sizeof(stack)) {
+		temp = stack;
+	} else {
+		temp = malloc(len);
+		if (temp == NULL) {
+			return DOM_NO_MEM_ERR;
+		}
 	}
 
 	src_pos = src_text;
@@ -1059,61 +1508,258 @@ dom_exception dom_string_whitespace_op(dom_string *s,
 	temp_pos = temp;
 
 	if (op & DOM_WHITESPACE_STRIP_LEADING) {
+		while (src_pos < src_end && _dom_ascii_is_space(*src_pos))
+			src_pos++;
+	}
+
+	if (op & DOM_WHITESPACE_COLLAPSE) {
 		while (src_pos < src_end) {
-			if (*src_pos == ' '  || *src_pos == '\t' ||
-			    *src_pos == '\n' || *src_pos == '\r' ||
-			    *src_pos == '\f')
-				src_pos++;
-			else
+			/* Copy everything up to the next whitespace */
+			run = _dom_ascii_find_space(src_pos,
+					src_end - src_pos);
+			memcpy(temp_pos, src_pos, run);
+			temp_pos += run;
+			src_pos += run;
+
+			if (src_pos == src_end)
 				break;
-		}
-	}
 
-	while (src_pos < src_end) {
-		if ((op & DOM_WHITESPACE_COLLAPSE) &&
-				(*src_pos == ' ' || *src_pos == '\t' ||
-				*src_pos == '\n' || *src_pos == '\r' ||
-				*src_pos == '\f')) {
-			/* Got a whitespace character */
+			/* Skip all adjacent whitespace */
 			do {
-				/* Skip all adjacent whitespace */
 				src_pos++;
 			} while (src_pos < src_end &&
-					(*src_pos == ' ' || *src_pos == '\t' ||
-					*src_pos == '\n' || *src_pos == '\r' ||
-					*src_pos == '\f'));
+					_dom_ascii_is_space(*src_pos));
+
 			/* Gets replaced with single space in output */
 			*temp_pos++ = ' ';
-		} else {
-			/* Otherwise, copy to output */
-			*temp_pos++ = *src_pos++;
 		}
+	} else {
+		memcpy(temp_pos, src_pos, src_end - src_pos);
+		temp_pos += src_end - src_pos;
 	}
 
 	if (op & DOM_WHITESPACE_STRIP_TRAILING) {
-		while (temp_pos > temp) {
+		while (temp_pos > temp && _dom_ascii_is_space(temp_pos[-1]))
 			temp_pos--;
-			if (*temp_pos != ' '  && *temp_pos != '\t' &&
-			    *temp_pos != '\n' && *temp_pos != '\r' &&
-			    *temp_pos != '\f') {
-				temp_pos++;
-				break;
-			}
-		}
 	}
 
 	/* New length */
 	len = temp_pos - temp;
 
 	/* Make new string */
-	if (((dom_string_internal *) ((void *) s))->type == DOM_STRING_CDATA) {
-		exc = dom_string_create(temp, len, ret);
-	} else {
-		exc = dom_string_create_interned(temp, len, ret);
+	if (res != NULL) {
+		res->data.cdata.len = len;
+		res->data.cdata.ptr[len] = '\0';
+
+		if (_dom_string_is_ascii(s))
+			_dom_string_set_ascii(res);
+
+		*ret = (dom_string *) res;
+		return DOM_NO_ERR;
 	}
 
-	free(temp);
+	exc = dom_string_create_interned(temp, len, ret);
+
+	if (temp != stack)
+		free(temp);
 
 	return exc;
 }
 
+
+/**
+ * Initialise a string builder
+ *
+ * \param sb  The builder to initialise
+ */
+void _dom_string_builder_init(dom_string_builder *sb)
+{
+	sb->single = NULL;
+	sb->buf = NULL;
+	sb->start = 0;
+	sb->end = 0;
+	sb->alloc = 0;
+}
+
+/**
+ * Finalise a string builder, discarding any text it holds
+ *
+ * \param sb  The builder to finalise
+ */
+void _dom_string_builder_finalise(dom_string_builder *sb)
+{
+	if (sb->single != NULL)
+		dom_string_unref(sb->single);
+	free(sb->buf);
+
+	_dom_string_builder_init(sb);
+}
+
+/**
+ * Make room for more text in a string builder
+ *
+ * \param sb       The builder
+ * \param len      Number of bytes about to be added
+ * \param at_head  Whether the bytes will be added before the existing text
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion
+ *
+ * The buffer is grown geometrically, with the new space placed on the side
+ * being added to, so a sequence of appends or prepends runs in linear time.
+ */
+static dom_exception _dom_string_builder_reserve(dom_string_builder *sb,
+		size_t len, bool at_head)
+{
+	size_t used = sb->end - sb->start;
+	size_t alloc, start;
+	uint8_t *buf;
+
+	if (at_head ? (sb->start >= len) : (sb->alloc - sb->end >= len))
+		return DOM_NO_ERR;
+
+	alloc = (used + len) * 2;
+	if (alloc < 64)
+		alloc = 64;
+
+	buf = malloc(alloc);
+	if (buf == NULL)
+		return DOM_NO_MEM_ERR;
+
+	start = at_head ? alloc - used : 0;
+	if (used > 0)
+		memcpy(buf + start, sb->buf + sb->start, used);
+
+	free(sb->buf);
+	sb->buf = buf;
+	sb->start = start;
+	sb->end = start + used;
+	sb->alloc = alloc;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Copy text into the reserved space at one end of a string builder
+ *
+ * \param sb       The builder
+ * \param ptr      The text to copy
+ * \param len      Length, in bytes, of the text
+ * \param at_head  Whether to copy the text before the existing text
+ */
+static void _dom_string_builder_copy(dom_string_builder *sb,
+		const char *ptr, size_t len, bool at_head)
+{
+	if (at_head) {
+		sb->start -= len;
+		memcpy(sb->buf + sb->start, ptr, len);
+	} else {
+		memcpy(sb->buf + sb->end, ptr, len);
+		sb->end += len;
+	}
+}
+
+/**
+ * Add a string to one end of a string builder
+ *
+ * \param sb       The builder
+ * \param str      The string to add
+ * \param at_head  Whether to add the string before the existing text
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion
+ */
+static dom_exception _dom_string_builder_add(dom_string_builder *sb,
+		dom_string *str, bool at_head)
+{
+	dom_string *single = sb->single;
+	size_t len = dom_string_byte_length(str);
+	dom_exception err;
+
+	if (len == 0)
+		return DOM_NO_ERR;
+
+	/* Defer copying while we only have one piece */
+	if (single == NULL && sb->end == sb->start) {
+		sb->single = dom_string_ref(str);
+		return DOM_NO_ERR;
+	}
+
+	if (single != NULL) {
+		size_t slen = dom_string_byte_length(single);
+
+		err = _dom_string_builder_reserve(sb, slen + len, at_head);
+		if (err != DOM_NO_ERR)
+			return err;
+
+		_dom_string_builder_copy(sb, dom_string_data(single), slen,
+				at_head);
+		dom_string_unref(single);
+		sb->single = NULL;
+	} else {
+		err = _dom_string_builder_reserve(sb, len, at_head);
+		if (err != DOM_NO_ERR)
+			return err;
+	}
+
+	_dom_string_builder_copy(sb, dom_string_data(str), len, at_head);
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Append a string to the text in a string builder
+ *
+ * \param sb   The builder
+ * \param str  The string to append
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion
+ */
+dom_exception _dom_string_builder_append(dom_string_builder *sb,
+		dom_string *str)
+{
+	return _dom_string_builder_add(sb, str, false);
+}
+
+/**
+ * Prepend a string to the text in a string builder
+ *
+ * \param sb   The builder
+ * \param str  The string to prepend
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion
+ */
+dom_exception _dom_string_builder_prepend(dom_string_builder *sb,
+		dom_string *str)
+{
+	return _dom_string_builder_add(sb, str, true);
+}
+
+/**
+ * Create a DOM string from the text in a string builder
+ *
+ * \param sb      The builder
+ * \param result  Pointer to location to receive result
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion
+ *
+ * The builder is finalised on success.  The returned string will be
+ * referenced.  The client should dereference it once it has finished
+ * with it.
+ */
+dom_exception _dom_string_builder_finish(dom_string_builder *sb,
+		dom_string **result)
+{
+	dom_exception err;
+
+	if (sb->single != NULL) {
+		err = _dom_string_unpool(&sb->single);
+		if (err != DOM_NO_ERR)
+			return err;
+
+		*result = sb->single;
+		sb->single = NULL;
+	} else {
+		err = dom_string_create(sb->buf + sb->start,
+				sb->end - sb->start, result);
+		if (err != DOM_NO_ERR)
+			return err;
+	}
+
+	_dom_string_builder_finalise(sb);
+
+	return DOM_NO_ERR;
+}
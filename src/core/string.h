@@ -11,6 +11,41 @@
 
 #include <dom/core/string.h>
 
+struct dom_document;
+
+/* Create a DOM string using the memory of a document */
+dom_exception _dom_string_create_in_document(struct dom_document *doc,
+		const uint8_t *ptr, size_t len, dom_string **str);
+
+/* Move a string out of a document's pool before handing it out */
+dom_exception _dom_string_unpool(dom_string **str);
+
+/* Get the interned string behind a DOM string, without interning it */
+lwc_string *_dom_string_get_intern(const dom_string *str);
+
+/**
+ * A growable buffer for building a DOM string from many pieces
+ *
+ * Text may be added to either end; the result is created with a single
+ * allocation once all the pieces have been added.
+ */
+typedef struct dom_string_builder {
+	dom_string *single;	/**< The only piece added so far, or NULL */
+	uint8_t *buf;		/**< Buffer holding the text */
+	size_t start;		/**< Offset of the first byte of the text */
+	size_t end;		/**< Offset just past the last byte of the text */
+	size_t alloc;		/**< Allocated size of the buffer */
+} dom_string_builder;
+
+void _dom_string_builder_init(dom_string_builder *sb);
+void _dom_string_builder_finalise(dom_string_builder *sb);
+dom_exception _dom_string_builder_append(dom_string_builder *sb,
+		dom_string *str);
+dom_exception _dom_string_builder_prepend(dom_string_builder *sb,
+		dom_string *str);
+dom_exception _dom_string_builder_finish(dom_string_builder *sb,
+		dom_string **result);
+
 /* Map the lwc_error to dom_exception */
 dom_exception _dom_exception_from_lwc_error(lwc_error err);
 
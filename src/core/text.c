@@ -16,6 +16,7 @@
 
 #include "core/characterdata.h"
 #include "core/document.h"
+#include "core/string.h"
 #include "core/text.h"
 #include "utils/utils.h"
 
@@ -50,7 +51,7 @@ typedef enum walk_order {
 /* Walk the logic-adjacent text in document order */
 static dom_exception walk_logic_adjacent_text_in_order(
 		dom_node_internal *node, walk_operation opt,
-		walk_order order, dom_string **ret, bool *cont);
+		walk_order order, dom_string_builder *sb, bool *cont);
 /* Walk the logic-adjacent text */
 static dom_exception walk_logic_adjacent_text(dom_text *text, 
 		walk_operation opt, dom_string **ret);
@@ -80,14 +81,14 @@ dom_exception _dom_text_create(dom_document *doc,
 	dom_exception err;
 
 	/* Allocate the text node */
-	t = malloc(sizeof(dom_text));
+	t = _dom_node_alloc(doc, sizeof(dom_text));
 	if (t == NULL)
 		return DOM_NO_MEM_ERR;
 
 	/* And initialise the node */
 	err = _dom_text_initialise(t, doc, DOM_TEXT_NODE, name, value);
 	if (err != DOM_NO_ERR) {
-		free(t);
+		_dom_node_free(t);
 		return err;
 	}
 
@@ -114,7 +115,7 @@ void _dom_text_destroy(dom_text *text)
 	_dom_text_finalise(text);
 
 	/* Free node */
-	free(text);
+	_dom_node_free(text);
 }
 
 /**
@@ -300,18 +301,19 @@ void __dom_text_destroy(dom_node_internal *node)
 }
 
 /* The copy constructor of this class */
-dom_exception _dom_text_copy(dom_node_internal *old, dom_node_internal **copy)
+dom_exception _dom_text_copy(dom_node_internal *old,
+		struct dom_document *doc, dom_node_internal **copy)
 {
 	dom_text *new_text;
 	dom_exception err;
 
-	new_text = malloc(sizeof(dom_text));
+	new_text = _dom_node_alloc(doc, sizeof(dom_text));
 	if (new_text == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_text_copy_internal(old, new_text);
 	if (err != DOM_NO_ERR) {
-		free(new_text);
+		_dom_node_free(new_text);
 		return err;
 	}
 
@@ -342,16 +344,16 @@ dom_exception _dom_text_copy_internal(dom_text *old, dom_text *new)
  * \param node   The start Text node
  * \param opt    The operation on each Text Node
  * \param order  The order
- * \param ret    The string of the logic adjacent text 
+ * \param sb     The builder collecting the logic adjacent text, if the opt
+ *               is COLLECT
  * \param cont   Whether the logic adjacent text is interrupt here
  * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
  */
 dom_exception walk_logic_adjacent_text_in_order(
 		dom_node_internal *node, walk_operation opt,
-		walk_order order, dom_string **ret, bool *cont)
+		walk_order order, dom_string_builder *sb, bool *cont)
 {
 	dom_exception err;
-	dom_string *data, *tmp;
 	dom_node_internal *parent;
 
 	/* If we reach the leaf of the DOM tree, just return to continue
@@ -364,7 +366,7 @@ dom_exception walk_logic_adjacent_text_in_order(
 	parent = dom_node_get_parent(node);
 
 	while (node != NULL) {
-		dom_node_internal *p;
+		dom_node_internal *p, *next;
 
 		/* If we reach the boundary of logical-adjacent text, we stop */
 		if (node->type == DOM_ELEMENT_NODE || 
@@ -375,42 +377,51 @@ dom_exception walk_logic_adjacent_text_in_order(
 			return DOM_NO_ERR;
 		}
 
+		/* Find the next node before we may remove this one */
+		p = dom_node_get_parent(node);
+		if (order == LEFT) {
+			if (node->last_child != NULL) {
+				next = node->last_child;
+			} else if (node->previous != NULL) {
+				next = node->previous;
+			} else {
+				next = node;
+				while (p != parent && next == p->first_child) {
+					next = p;
+					p = dom_node_get_parent(p);
+				}
+
+				next = next->previous;
+			}
+		} else {
+			if (node->first_child != NULL) {
+				next = node->first_child;
+			} else if (node->next != NULL) {
+				next = node->next;
+			} else {
+				next = node;
+				while (p != parent && next == p->last_child) {
+					next = p;
+					p = dom_node_get_parent(p);
+				}
+
+				next = next->next;
+			}
+		}
+
 		if (node->type == DOM_TEXT_NODE) {
 			/* According the DOM spec, text node never have child */
 			assert(node->first_child == NULL);
 			assert(node->last_child == NULL);
-			if (opt == COLLECT) {
-				err = dom_characterdata_get_data(node, &data);
+			if (opt == COLLECT && node->value != NULL) {
+				if (order == LEFT)
+					err = _dom_string_builder_prepend(sb,
+							node->value);
+				else
+					err = _dom_string_builder_append(sb,
+							node->value);
 				if (err != DOM_NO_ERR)
 					return err;
-
-				tmp = *ret;
-				if (order == LEFT) {
-					if (tmp != NULL) {
-						err = dom_string_concat(data, tmp, ret);
-						if (err != DOM_NO_ERR)
-							return err;
-					} else {
-						dom_string_ref(data);
-						*ret = data;
-					}
-				} else if (order == RIGHT) {
-					if (tmp != NULL) {
-						err = dom_string_concat(tmp, data, ret);
-						if (err != DOM_NO_ERR)
-							return err;
-					} else {
-						dom_string_ref(data);
-						*ret = data;
-					}
-				}
-
-				if (tmp != NULL)
-					dom_string_unref(tmp);
-				dom_string_unref(data);
-
-				*cont = true;
-				return DOM_NO_ERR;
 			}
 
 			if (opt == DELETE) {
@@ -420,42 +431,14 @@ dom_exception walk_logic_adjacent_text_in_order(
 				if (err != DOM_NO_ERR)
 					return err;
 
-				*cont = true;
 				dom_node_unref(tn);
-				return DOM_NO_ERR;
 			}
 		}
 
-		p = dom_node_get_parent(node);
-		if (order == LEFT) {
-			if (node->last_child != NULL) {
-				node = node->last_child;
-			} else if (node->previous != NULL) {
-				node = node->previous;
-			} else {
-				while (p != parent && node == p->last_child) {
-					node = p;
-					p = dom_node_get_parent(p);
-				}
-
-				node = node->previous;
-			}
-		} else {
-			if (node->first_child != NULL) {
-				node = node->first_child;
-			} else if (node->next != NULL) {
-				node = node->next;
-			} else {
-				while (p != parent && node == p->first_child) {
-					node = p;
-					p = dom_node_get_parent(p);
-				}
-
-				node = node->next;
-			}
-		}
+		node = next;
 	}
 
+	*cont = true;
 	return DOM_NO_ERR;
 }
 
@@ -474,6 +457,7 @@ dom_exception walk_logic_adjacent_text(dom_text *text,
 	dom_node_internal *parent = node->parent;
 	dom_node_internal *left = node->previous;
 	dom_node_internal *right = node->next;
+	dom_string_builder sb;
 	dom_exception err;
 	bool cont;
 	
@@ -483,56 +467,38 @@ dom_exception walk_logic_adjacent_text(dom_text *text,
 
 	*ret = NULL;
 
+	_dom_string_builder_init(&sb);
+
 	/* Firstly, we look our left */
-	err = walk_logic_adjacent_text_in_order(left, opt, LEFT, ret, &cont);
-	if (err != DOM_NO_ERR) {
-		if (opt == COLLECT) {
-			dom_string_unref(*ret);
-			*ret = NULL;
-		}
-		return err;
-	}
+	err = walk_logic_adjacent_text_in_order(left, opt, LEFT, &sb, &cont);
+	if (err != DOM_NO_ERR)
+		goto cleanup;
 
 	/* Ourself */
 	if (opt == COLLECT) {
-		dom_string *data = NULL, *tmp = NULL;
-		err = dom_characterdata_get_data(text, &data);
-		if (err != DOM_NO_ERR) {
-			dom_string_unref(*ret);
-			return err;
-		}
-
-		if (*ret != NULL) {
-			err = dom_string_concat(*ret, data, &tmp);
-			dom_string_unref(data);
-			dom_string_unref(*ret);
-			if (err != DOM_NO_ERR) {
-				return err;
-			}
-
-			*ret = tmp;
-		} else {
-			*ret = data;
+		if (node->value != NULL) {
+			err = _dom_string_builder_append(&sb, node->value);
+			if (err != DOM_NO_ERR)
+				goto cleanup;
 		}
 	} else {
 			dom_node_internal *tn;
 			err = dom_node_remove_child(node->parent, node,
 					(void *) &tn);
 			if (err != DOM_NO_ERR)
-				return err;
+				goto cleanup;
 			dom_node_unref(tn);
 	}
 
 	/* Now, look right */
-	err = walk_logic_adjacent_text_in_order(right, opt, RIGHT, ret, &cont);
-	if (err != DOM_NO_ERR) {
-		if (opt == COLLECT) {
-			dom_string_unref(*ret);
-			*ret = NULL;
-		}
-		return err;
-	}
+	err = walk_logic_adjacent_text_in_order(right, opt, RIGHT, &sb, &cont);
+	if (err != DOM_NO_ERR)
+		goto cleanup;
 
-	return DOM_NO_ERR;
-}
+	if (opt == COLLECT)
+		return _dom_string_builder_finish(&sb, ret);
 
+cleanup:
+	_dom_string_builder_finalise(&sb);
+	return err;
+}
@@ -60,7 +60,8 @@ dom_exception _dom_text_replace_whole_text(dom_text *text,
 
 /* Following comes the protected vtable  */
 void __dom_text_destroy(struct dom_node_internal *node);
-dom_exception _dom_text_copy(dom_node_internal *old, dom_node_internal **copy);
+dom_exception _dom_text_copy(dom_node_internal *old,
+		struct dom_document *doc, dom_node_internal **copy);
 
 #define DOM_TEXT_PROTECT_VTABLE \
 	__dom_text_destroy, \
@@ -0,0 +1,496 @@
+/*
+ * This file is part of libdom.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libwapcaplet/libwapcaplet.h>
+
+#include <dom/core/node.h>
+#include <dom/core/string.h>
+#include <dom/core/walk.h>
+
+#include "core/document.h"
+#include "core/element.h"
+#include "core/node.h"
+
+#include "utils/utils.h"
+
+/** Log2 of the number of counters in an ancestor filter */
+#define DOM_WALK_FILTER_BITS 12
+
+/** The number of counters in an ancestor filter */
+#define DOM_WALK_FILTER_SIZE (1 << DOM_WALK_FILTER_BITS)
+
+/** The value at which a filter counter sticks */
+#define DOM_WALK_FILTER_MAX UINT8_MAX
+
+/** The number of kinds of key */
+#define DOM_WALK_KEYS (DOM_WALK_KEY_CLASS + 1)
+
+/**
+ * An ancestor of the element a walk is at
+ */
+typedef struct dom_walk_level {
+	dom_node_internal *node;		/**< The ancestor */
+	uint32_t n_hashes[DOM_WALK_KEYS];	/**< Number of its keys of each
+						 * kind in the filter */
+} dom_walk_level;
+
+/**
+ * The keys of one kind in a walk's ancestor filter
+ */
+typedef struct dom_walk_keys {
+	uint32_t *hashes;		/**< Hashes added, outermost level
+					 * first */
+	uint32_t n_hashes;		/**< Number of hashes */
+	uint32_t alloc_hashes;		/**< Allocated size of hashes */
+	uint32_t n_filtered;		/**< Number of levels whose keys are
+					 * in the filter */
+} dom_walk_keys;
+
+/**
+ * A depth-first walk of the elements below a node
+ *
+ * Each key is counted in the filter at two positions, taken from the low
+ * and high bits of its hash.  The hashes added for each ancestor are kept,
+ * so that they are removed exactly even if the ancestor's attributes are
+ * changed.  A counter which overflows sticks at its maximum, which at
+ * worst gives false positives.
+ *
+ * Ancestors' keys of a kind are only added to the filter when a key of
+ * that kind is next tested, so a walk does not read the attributes of
+ * every ancestor when only names are tested, or when the filter is unused.
+ */
+struct dom_walk {
+	struct dom_document *doc;	/**< The document walked */
+	dom_node_internal *root;	/**< The node walked below */
+	dom_node_internal *current;	/**< The element walked to, or NULL */
+	bool started;			/**< Whether the walk has started */
+	bool skip;			/**< Whether to skip the children of
+					 * current */
+	uint64_t generation;		/**< Tree generation of the walk */
+
+	dom_walk_level *levels;		/**< The ancestors of current,
+					 * outermost first */
+	uint32_t n_levels;		/**< Number of levels */
+	uint32_t alloc_levels;		/**< Allocated size of levels */
+
+	dom_walk_keys keys[DOM_WALK_KEYS];	/**< Keys of each kind */
+
+	uint8_t filter[DOM_WALK_FILTER_SIZE];	/**< The ancestor filter */
+};
+
+static dom_exception _dom_walk_push(dom_walk *walk, dom_node_internal *node);
+static void _dom_walk_pop(dom_walk *walk);
+static dom_exception _dom_walk_filter(dom_walk *walk, dom_walk_key key);
+
+/**
+ * Create a walk of the elements below a node
+ *
+ * \param root    The node to walk below
+ * \param result  Pointer to location to receive the walk
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ *
+ * The walk holds a reference on ::root.  The tree below ::root must not be
+ * changed while it is walked.  The walk must be destroyed by the caller.
+ */
+dom_exception dom_walk_create(struct dom_node *root, dom_walk **result)
+{
+	dom_node_internal *node = (dom_node_internal *) root;
+	dom_node_internal *ancestor;
+	dom_exception err;
+	dom_walk *walk;
+	uint32_t i;
+
+	walk = malloc(sizeof(*walk));
+	if (walk == NULL)
+		return DOM_NO_MEM_ERR;
+
+	walk->doc = node->type == DOM_DOCUMENT_NODE ?
+			(struct dom_document *) node : node->owner;
+	walk->root = node;
+	walk->current = NULL;
+	walk->started = false;
+	walk->skip = false;
+	walk->generation = walk->doc->tree_generation;
+	walk->levels = NULL;
+	walk->n_levels = 0;
+	walk->alloc_levels = 0;
+	memset(walk->keys, 0, sizeof(walk->keys));
+	memset(walk->filter, 0, sizeof(walk->filter));
+
+	dom_node_ref(node);
+
+	/* Root and its ancestors are ancestors of every element walked */
+	for (ancestor = node; ancestor != NULL; ancestor = ancestor->parent) {
+		if (ancestor->type != DOM_ELEMENT_NODE)
+			continue;
+
+		err = _dom_walk_push(walk, ancestor);
+		if (err != DOM_NO_ERR) {
+			dom_walk_destroy(walk);
+			return err;
+		}
+	}
+
+	/* They were found innermost first */
+	for (i = 0; i < walk->n_levels / 2; i++) {
+		dom_walk_level level = walk->levels[i];
+
+		walk->levels[i] = walk->levels[walk->n_levels - 1 - i];
+		walk->levels[walk->n_levels - 1 - i] = level;
+	}
+
+	*result = walk;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Destroy a walk
+ *
+ * \param walk  The walk to destroy
+ */
+void dom_walk_destroy(dom_walk *walk)
+{
+	uint32_t k;
+
+	if (walk == NULL)
+		return;
+
+	dom_node_unref(walk->root);
+
+	for (k = 0; k < DOM_WALK_KEYS; k++)
+		free(walk->keys[k].hashes);
+	free(walk->levels);
+	free(walk);
+}
+
+/**
+ * Get an element's first child element
+ *
+ * \param node  The element
+ * \return the first child element, or NULL if there is none
+ */
+static inline dom_node_internal *_dom_walk_first_child(dom_node_internal *node)
+{
+	for (node = node->first_child; node != NULL; node = node->next) {
+		if (node->type == DOM_ELEMENT_NODE)
+			break;
+	}
+
+	return node;
+}
+
+/**
+ * Get an element's next sibling element
+ *
+ * \param node  The element
+ * \return the next sibling element, or NULL if there is none
+ */
+static inline dom_node_internal *_dom_walk_next_sibling(
+		dom_node_internal *node)
+{
+	for (node = node->next; node != NULL; node = node->next) {
+		if (node->type == DOM_ELEMENT_NODE)
+			break;
+	}
+
+	return node;
+}
+
+/**
+ * Move a walk to the next element, in document order
+ *
+ * \param walk     The walk
+ * \param element  Pointer to location to receive the element, or NULL if
+ *                 the walk is complete
+ * \return DOM_NO_ERR                on success,
+ *         DOM_INVALID_STATE_ERR     if the tree has changed since the walk
+ *                                   was created,
+ *         DOM_NO_MEM_ERR            on memory exhaustion.
+ *
+ * On success, the ancestor filter describes the ancestors of the element
+ * returned.  The element is not referenced, and is only valid until the
+ * tree next changes.
+ */
+dom_exception dom_walk_next(dom_walk *walk, struct dom_element **element)
+{
+	dom_node_internal *node = walk->current, *next;
+	dom_exception err;
+
+	if (walk->generation != walk->doc->tree_generation)
+		return DOM_INVALID_STATE_ERR;
+
+	if (node == NULL) {
+		next = walk->started ? NULL : _dom_walk_first_child(walk->root);
+	} else if (walk->skip == false &&
+			(next = _dom_walk_first_child(node)) != NULL) {
+		err = _dom_walk_push(walk, node);
+		if (err != DOM_NO_ERR)
+			return err;
+	} else {
+		/* Leave finished elements until one has a next sibling */
+		while ((next = _dom_walk_next_sibling(node)) == NULL &&
+				node->parent != walk->root) {
+			node = node->parent;
+			_dom_walk_pop(walk);
+		}
+	}
+
+	walk->started = true;
+	walk->skip = false;
+	walk->current = next;
+
+	*element = (struct dom_element *) next;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Have a walk skip the children of the element it is at
+ *
+ * \param walk  The walk
+ */
+void dom_walk_skip_children(dom_walk *walk)
+{
+	walk->skip = true;
+}
+
+/**
+ * Hash a key for a walk's ancestor filter
+ *
+ * \param key   The kind of key
+ * \param data  The key's text
+ * \param len   The length of ::data
+ * \return the hash of the key
+ *
+ * Keys of different kinds hash differently, so that a class does not
+ * match an element name.
+ */
+uint32_t dom_walk_hash(dom_walk_key key, const uint8_t *data, size_t len)
+{
+	uint32_t hash = 0x811c9dc5 ^ ((uint32_t) key * 0x9e3779b9);
+
+	/* FNV-1a, folding ASCII case */
+	while (len-- > 0) {
+		uint8_t c = *data++;
+
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+
+		hash = (hash ^ c) * 0x01000193;
+	}
+
+	/* Spread the bits, as the filter uses both halves */
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6b;
+	hash ^= hash >> 13;
+
+	return hash;
+}
+
+/**
+ * Test whether the ancestors of a walk's element may have a key
+ *
+ * \param walk  The walk
+ * \param key   The kind of key
+ * \param hash  The key's hash, from dom_walk_hash()
+ * \return false if no ancestor has the key, true if one may have it
+ */
+bool dom_walk_ancestors_may_have(dom_walk *walk, dom_walk_key key,
+		uint32_t hash)
+{
+	uint32_t mask = DOM_WALK_FILTER_SIZE - 1;
+	uint32_t high = hash >> DOM_WALK_FILTER_BITS;
+
+	/* Without a complete filter, any ancestor may have the key */
+	if (walk->keys[key].n_filtered != walk->n_levels &&
+			_dom_walk_filter(walk, key) != DOM_NO_ERR)
+		return true;
+
+	return walk->filter[hash & mask] != 0 &&
+			walk->filter[high & mask] != 0;
+}
+
+/**
+ * Make an element the innermost ancestor of a walk's element
+ *
+ * \param walk  The walk
+ * \param node  The element
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ *
+ * On failure, the walk is unchanged.
+ */
+dom_exception _dom_walk_push(dom_walk *walk, dom_node_internal *node)
+{
+	dom_walk_level *level;
+
+	if (walk->n_levels == walk->alloc_levels) {
+		uint32_t alloc = walk->alloc_levels == 0 ?
+				16 : walk->alloc_levels * 2;
+		dom_walk_level *levels;
+
+		levels = realloc(walk->levels, alloc * sizeof(*levels));
+		if (levels == NULL)
+			return DOM_NO_MEM_ERR;
+
+		walk->levels = levels;
+		walk->alloc_levels = alloc;
+	}
+
+	level = &walk->levels[walk->n_levels++];
+	level->node = node;
+	memset(level->n_hashes, 0, sizeof(level->n_hashes));
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Remove some keys of one kind from a walk's ancestor filter
+ *
+ * \param walk  The walk
+ * \param key   The kind of key
+ * \param n     The number of keys to remove, most recently added first
+ */
+static void _dom_walk_remove(dom_walk *walk, dom_walk_key key, uint32_t n)
+{
+	dom_walk_keys *keys = &walk->keys[key];
+	uint32_t mask = DOM_WALK_FILTER_SIZE - 1;
+
+	while (n-- > 0) {
+		uint32_t hash = keys->hashes[--keys->n_hashes];
+		uint8_t *c1 = &walk->filter[hash & mask];
+		uint8_t *c2 = &walk->filter[(hash >> DOM_WALK_FILTER_BITS) &
+				mask];
+
+		if (*c1 != DOM_WALK_FILTER_MAX)
+			(*c1)--;
+		if (*c2 != DOM_WALK_FILTER_MAX)
+			(*c2)--;
+	}
+}
+
+/**
+ * Remove the innermost ancestor of a walk's element
+ *
+ * \param walk  The walk
+ */
+void _dom_walk_pop(dom_walk *walk)
+{
+	dom_walk_level *level = &walk->levels[--walk->n_levels];
+	uint32_t k;
+
+	for (k = 0; k < DOM_WALK_KEYS; k++) {
+		if (walk->keys[k].n_filtered > walk->n_levels) {
+			_dom_walk_remove(walk, k, level->n_hashes[k]);
+			walk->keys[k].n_filtered--;
+		}
+	}
+}
+
+/**
+ * Add a key to a walk's ancestor filter
+ *
+ * \param walk  The walk
+ * \param key   The kind of key
+ * \param data  The key's text
+ * \param len   The length of ::data
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ */
+static dom_exception _dom_walk_add(dom_walk *walk, dom_walk_key key,
+		const char *data, size_t len)
+{
+	dom_walk_keys *keys = &walk->keys[key];
+	uint32_t mask = DOM_WALK_FILTER_SIZE - 1;
+	uint32_t hash = dom_walk_hash(key, (const uint8_t *) data, len);
+	uint8_t *c1 = &walk->filter[hash & mask];
+	uint8_t *c2 = &walk->filter[(hash >> DOM_WALK_FILTER_BITS) & mask];
+
+	if (keys->n_hashes == keys->alloc_hashes) {
+		uint32_t alloc = keys->alloc_hashes == 0 ?
+				64 : keys->alloc_hashes * 2;
+		uint32_t *hashes;
+
+		hashes = realloc(keys->hashes, alloc * sizeof(*hashes));
+		if (hashes == NULL)
+			return DOM_NO_MEM_ERR;
+
+		keys->hashes = hashes;
+		keys->alloc_hashes = alloc;
+	}
+
+	keys->hashes[keys->n_hashes++] = hash;
+
+	if (*c1 != DOM_WALK_FILTER_MAX)
+		(*c1)++;
+	if (*c2 != DOM_WALK_FILTER_MAX)
+		(*c2)++;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Add the keys of one kind of all a walk's ancestors to its filter
+ *
+ * \param walk  The walk
+ * \param key   The kind of key
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ *
+ * On failure, the filter holds the keys of some outermost ancestors.
+ */
+dom_exception _dom_walk_filter(dom_walk *walk, dom_walk_key key)
+{
+	dom_walk_keys *keys = &walk->keys[key];
+
+	while (keys->n_filtered < walk->n_levels) {
+		dom_walk_level *level = &walk->levels[keys->n_filtered];
+		dom_node_internal *node = level->node;
+		struct dom_element *element = (struct dom_element *) node;
+		uint32_t n_hashes = keys->n_hashes;
+		dom_exception err = DOM_NO_ERR;
+		dom_string *id;
+		uint32_t i;
+
+		switch (key) {
+		case DOM_WALK_KEY_NAME:
+			err = _dom_walk_add(walk, key,
+					dom_string_data(node->name),
+					dom_string_byte_length(node->name));
+			break;
+		case DOM_WALK_KEY_ID:
+			err = _dom_element_get_id(element, &id);
+			if (err == DOM_NO_ERR && id != NULL) {
+				err = _dom_walk_add(walk, key,
+						dom_string_data(id),
+						dom_string_byte_length(id));
+				dom_string_unref(id);
+			}
+			break;
+		case DOM_WALK_KEY_CLASS:
+			for (i = 0; i < element->n_classes &&
+					err == DOM_NO_ERR; i++) {
+				lwc_string *class = element->classes[i];
+
+				err = _dom_walk_add(walk, key,
+						lwc_string_data(class),
+						lwc_string_length(class));
+			}
+			break;
+		}
+
+		if (err != DOM_NO_ERR) {
+			_dom_walk_remove(walk, key, keys->n_hashes - n_hashes);
+			return err;
+		}
+
+		level->n_hashes[key] = keys->n_hashes - n_hashes;
+		keys->n_filtered++;
+	}
+
+	return DOM_NO_ERR;
+}
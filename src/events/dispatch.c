@@ -13,6 +13,20 @@
 
 #include "utils/utils.h"
 
+/**
+ * Determine whether a mutation event needs to be dispatched at all
+ *
+ * \param doc   The document
+ * \param type  The event type
+ * \return true if the event may be observed, false otherwise
+ */
+static inline bool _dom_dispatch_is_wanted(dom_document *doc,
+		dom_string *type)
+{
+	return doc->mutation_events &&
+		_dom_document_event_internal_is_handled(&doc->dei, type);
+}
+
 /**
  * Dispatch a DOMNodeInserted/DOMNodeRemoved event
  *
@@ -31,6 +45,13 @@ dom_exception __dom_dispatch_node_change_event(dom_document *doc,
 	dom_string *type = NULL;
 	dom_exception err;
 
+	if (_dom_dispatch_is_wanted(doc, change == DOM_MUTATION_ADDITION ?
+			doc->_memo_domnodeinserted :
+			doc->_memo_domnoderemoved) == false) {
+		*success = true;
+		return DOM_NO_ERR;
+	}
+
 	err = _dom_mutation_event_create(&evt);
 	if (err != DOM_NO_ERR)
 		return err;
@@ -77,6 +98,13 @@ dom_exception __dom_dispatch_node_change_document_event(dom_document *doc,
 	dom_string *type = NULL;
 	dom_exception err;
 
+	if (_dom_dispatch_is_wanted(doc, change == DOM_MUTATION_ADDITION ?
+			doc->_memo_domnodeinsertedintodocument :
+			doc->_memo_domnoderemovedfromdocument) == false) {
+		*success = true;
+		return DOM_NO_ERR;
+	}
+
 	err = _dom_mutation_event_create(&evt);
 	if (err != DOM_NO_ERR)
 		return err;
@@ -128,6 +156,11 @@ dom_exception __dom_dispatch_attr_modified_event(dom_document *doc,
 	dom_string *type = NULL;
 	dom_exception err;
 
+	if (_dom_dispatch_is_wanted(doc, doc->_memo_domattrmodified) == false) {
+		*success = true;
+		return DOM_NO_ERR;
+	}
+
 	err = _dom_mutation_event_create(&evt);
 	if (err != DOM_NO_ERR)
 		return err;
@@ -172,6 +205,11 @@ dom_exception __dom_dispatch_characterdata_modified_event(
 	dom_string *type = NULL;
 	dom_exception err;
 
+	if (_dom_dispatch_is_wanted(doc, doc->_memo_domcharacterdatamodified) == false) {
+		*success = true;
+		return DOM_NO_ERR;
+	}
+
 	err = _dom_mutation_event_create(&evt);
 	if (err != DOM_NO_ERR)
 		return err;
@@ -208,6 +246,11 @@ dom_exception __dom_dispatch_subtree_modified_event(dom_document *doc,
 	dom_string *type = NULL;
 	dom_exception err;
 
+	if (_dom_dispatch_is_wanted(doc, doc->_memo_domsubtreemodified) == false) {
+		*success = true;
+		return DOM_NO_ERR;
+	}
+
 	err = _dom_mutation_event_create(&evt);
 	if (err != DOM_NO_ERR)
 		return err;
@@ -6,6 +6,7 @@
  */
 
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <libwapcaplet/libwapcaplet.h>
@@ -56,6 +57,10 @@ dom_exception _dom_document_event_internal_initialise(
 	lwc_error err;
 	int i;
 
+	dei->listener_counts = NULL;
+	dei->n_listener_types = 0;
+	dei->n_listeners = 0;
+
 	for (i = 0; i < DOM_EVENT_COUNT; i++) {
 		err = lwc_intern_string(__event_types[i],
 				strlen(__event_types[i]), &dei->event_types[i]);
@@ -74,14 +79,130 @@ void _dom_document_event_internal_finalise(dom_document_event_internal *dei)
 {
 	int i;
 
+	uint32_t t;
+
 	for (i = 0; i < DOM_EVENT_COUNT; i++) {
 		if (dei->event_types[i] != NULL)
 			lwc_string_unref(dei->event_types[i]);
 	}
 
+	for (t = 0; t < dei->n_listener_types; t++)
+		dom_string_unref(dei->listener_counts[t].type);
+	free(dei->listener_counts);
+	dei->listener_counts = NULL;
+	dei->n_listener_types = 0;
+
 	return;
 }
 
+/**
+ * Find the listener count for an event type
+ *
+ * \param dei   The DocumentEvent internal object
+ * \param type  The event type
+ * \return the count entry, or NULL if no listener was ever registered for
+ *         the type
+ */
+static struct dom_listener_count *_dom_document_event_internal_find_count(
+		dom_document_event_internal *dei, dom_string *type)
+{
+	uint32_t t;
+
+	for (t = 0; t < dei->n_listener_types; t++) {
+		if (dom_string_isequal(dei->listener_counts[t].type, type))
+			return &dei->listener_counts[t];
+	}
+
+	return NULL;
+}
+
+/**
+ * Record that a listener has been registered in the document
+ *
+ * \param dei   The DocumentEvent internal object
+ * \param type  The type of event the listener was registered for
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ */
+dom_exception _dom_document_event_internal_listener_added(
+		dom_document_event_internal *dei, dom_string *type)
+{
+	struct dom_listener_count *lc;
+
+	lc = _dom_document_event_internal_find_count(dei, type);
+	if (lc == NULL) {
+		lc = realloc(dei->listener_counts,
+				(dei->n_listener_types + 1) * sizeof(*lc));
+		if (lc == NULL)
+			return DOM_NO_MEM_ERR;
+
+		dei->listener_counts = lc;
+		lc += dei->n_listener_types++;
+		lc->type = dom_string_ref(type);
+		lc->count = 0;
+	}
+
+	lc->count++;
+	dei->n_listeners++;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Record that a listener has been removed from the document
+ *
+ * \param dei   The DocumentEvent internal object
+ * \param type  The type of event the listener was registered for
+ */
+void _dom_document_event_internal_listener_removed(
+		dom_document_event_internal *dei, dom_string *type)
+{
+	struct dom_listener_count *lc;
+
+	lc = _dom_document_event_internal_find_count(dei, type);
+	if (lc != NULL && lc->count > 0) {
+		lc->count--;
+		dei->n_listeners--;
+	}
+}
+
+/**
+ * Test whether dispatching an event of some type can have any effect
+ *
+ * \param dei   The DocumentEvent internal object
+ * \param type  The event type
+ * \return true if a listener is registered for the type anywhere in the
+ *         document, or the default action fetcher has an action for it,
+ *         false otherwise.
+ *
+ * When this returns false, the event need not be created or dispatched.
+ */
+bool _dom_document_event_internal_is_handled(
+		dom_document_event_internal *dei, dom_string *type)
+{
+	struct dom_listener_count *lc;
+	void *pw;
+
+	if (dei->n_listeners > 0) {
+		lc = _dom_document_event_internal_find_count(dei, type);
+		if (lc != NULL && lc->count > 0)
+			return true;
+	}
+
+	if (dei->actions != NULL) {
+		pw = dei->actions_ctx;
+		if (dei->actions(type, DOM_DEFAULT_ACTION_STARTED, &pw) != NULL)
+			return true;
+		pw = dei->actions_ctx;
+		if (dei->actions(type, DOM_DEFAULT_ACTION_END, &pw) != NULL)
+			return true;
+		pw = dei->actions_ctx;
+		if (dei->actions(type, DOM_DEFAULT_ACTION_FINISHED, &pw) != NULL)
+			return true;
+	}
+
+	return false;
+}
+
 /*-------------------------------------------------------------------------*/
 /* Public API */
 
@@ -8,6 +8,9 @@
 #ifndef dom_internal_events_document_event_h_
 #define dom_internal_events_document_event_h_
 
+#include <stdbool.h>
+
+#include <dom/core/string.h>
 #include <dom/events/document_event.h>
 
 struct dom_event_listener;
@@ -32,6 +35,14 @@ typedef enum {
 	DOM_EVENT_COUNT
 } dom_event_type;
 
+/**
+ * The number of listeners registered for an event type
+ */
+struct dom_listener_count {
+	dom_string *type;	/**< The event type */
+	uint32_t count;		/**< Listeners registered for the type */
+};
+
 /**
  * The DocumentEvent internal class
  */
@@ -41,6 +52,11 @@ struct dom_document_event_internal {
 	void *actions_ctx; /**< The default action fetcher context */
 	struct lwc_string_s *event_types[DOM_EVENT_COUNT];
 			/**< Events type names */
+
+	struct dom_listener_count *listener_counts;
+			/**< Listeners registered in the document, by type */
+	uint32_t n_listener_types;	/**< Entries in listener_counts */
+	uint32_t n_listeners;		/**< Total listeners registered */
 };
 
 typedef struct dom_document_event_internal dom_document_event_internal;
@@ -61,4 +77,16 @@ dom_exception _dom_document_event_internal_initialise(
 void _dom_document_event_internal_finalise(
 		dom_document_event_internal *dei);
 
+/* Record that a listener has been registered in the document */
+dom_exception _dom_document_event_internal_listener_added(
+		dom_document_event_internal *dei, dom_string *type);
+
+/* Record that a listener has been removed from the document */
+void _dom_document_event_internal_listener_removed(
+		dom_document_event_internal *dei, dom_string *type);
+
+/* Test whether dispatching an event of some type can have any effect */
+bool _dom_document_event_internal_is_handled(
+		dom_document_event_internal *dei, dom_string *type);
+
 #endif
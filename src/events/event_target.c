@@ -19,24 +19,30 @@
 #include "utils/utils.h"
 #include "utils/validate.h"
 
-static void event_target_destroy_listener(struct listener_entry *e)
+static void event_target_destroy_listener(dom_document *doc,
+		struct listener_entry *e)
 {
+	if (doc != NULL)
+		_dom_document_event_internal_listener_removed(&doc->dei,
+				e->type);
+
 	list_del(&e->list);
 	dom_event_listener_unref(e->listener);
 	dom_string_unref(e->type);
 	free(e);
 }
-static void event_target_destroy_listeners(struct listener_entry *list)
+static void event_target_destroy_listeners(dom_document *doc,
+		struct listener_entry *list)
 {
 	struct listener_entry *next;
 
 	while (list != (struct listener_entry *) list->list.next) {
 		next = (struct listener_entry *) list->list.next;
-		event_target_destroy_listener(list);
+		event_target_destroy_listener(doc, list);
 		list = next;
 	}
 
-	event_target_destroy_listener(list);
+	event_target_destroy_listener(doc, list);
 }
 
 /* Initialise this EventTarget */
@@ -49,36 +55,79 @@ dom_exception _dom_event_target_internal_initialise(
 }
 
 /* Finalise this EventTarget */
-void _dom_event_target_internal_finalise(dom_event_target_internal *eti)
+void _dom_event_target_internal_finalise(dom_document *doc,
+		dom_event_target_internal *eti)
 {
 	if (eti->listeners != NULL) {
-		event_target_destroy_listeners(eti->listeners);
+		event_target_destroy_listeners(doc, eti->listeners);
 		eti->listeners = NULL;
 	}
 }
 
+/**
+ * Record the listeners of an EventTarget in the document which now owns it
+ *
+ * \param doc  The new owner document
+ * \param eti  The EventTarget
+ * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
+ *
+ * This is needed for nodes, such as DocumentTypes, which may have
+ * listeners registered before they have an owner document.
+ */
+dom_exception _dom_event_target_internal_adopt(dom_document *doc,
+		dom_event_target_internal *eti)
+{
+	struct listener_entry *le = eti->listeners;
+	dom_exception err;
+
+	if (le == NULL)
+		return DOM_NO_ERR;
+
+	do {
+		err = _dom_document_event_internal_listener_added(&doc->dei,
+				le->type);
+		if (err != DOM_NO_ERR)
+			return err;
+
+		le = (struct listener_entry *) le->list.next;
+	} while (le != eti->listeners);
+
+	return DOM_NO_ERR;
+}
+
 /*-------------------------------------------------------------------------*/
 /* The public API */
 
 /**
  * Add an EventListener to the EventTarget
  *
+ * \param doc       The EventTarget's owner document, or NULL
  * \param et        The EventTarget object
  * \param type      The event type which this event listener listens for
  * \param listener  The event listener object
  * \param capture   Whether add this listener in the capturing phase
  * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
  */
-dom_exception _dom_event_target_add_event_listener(
+dom_exception _dom_event_target_add_event_listener(dom_document *doc,
 		dom_event_target_internal *eti,
 		dom_string *type, struct dom_event_listener *listener, 
 		bool capture)
 {
 	struct listener_entry *le = NULL;
+	dom_exception err;
 
 	le = malloc(sizeof(struct listener_entry));
 	if (le == NULL)
 		return DOM_NO_MEM_ERR;
+
+	if (doc != NULL) {
+		err = _dom_document_event_internal_listener_added(&doc->dei,
+				type);
+		if (err != DOM_NO_ERR) {
+			free(le);
+			return err;
+		}
+	}
 	
 	/* Initialise the listener_entry */
 	list_init(&le->list);
@@ -102,13 +151,14 @@ dom_exception _dom_event_target_add_event_listener(
  * (LibDOM extension: If type is NULL, remove all listener registrations
  * regardless of type and cature)
  *
+ * \param doc       The EventTarget's owner document, or NULL
  * \param et        The EventTarget object
  * \param type      The event type this listener is registered for 
  * \param listener  The listener object
  * \param capture   Whether the listener is registered at the capturing phase
  * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
  */
-dom_exception _dom_event_target_remove_event_listener(
+dom_exception _dom_event_target_remove_event_listener(dom_document *doc,
 		dom_event_target_internal *eti,
 		dom_string *type, struct dom_event_listener *listener, 
 		bool capture)
@@ -133,10 +183,7 @@ dom_exception _dom_event_target_remove_event_listener(
 						(struct listener_entry *)
 						le->list.next;
 				}
-				list_del(&le->list);
-				dom_event_listener_unref(le->listener);
-				dom_string_unref(le->type);
-				free(le);
+				event_target_destroy_listener(doc, le);
 				break;
 			}
 
@@ -57,14 +57,19 @@ dom_exception _dom_event_target_internal_initialise(
 		dom_event_target_internal *eti);
 
 /* Finalise this EventTarget */
-void _dom_event_target_internal_finalise(dom_event_target_internal *eti);
+void _dom_event_target_internal_finalise(dom_document *doc,
+		dom_event_target_internal *eti);
+
+/* Register this EventTarget's listeners with a new owner document */
+dom_exception _dom_event_target_internal_adopt(dom_document *doc,
+		dom_event_target_internal *eti);
 
-dom_exception _dom_event_target_add_event_listener(
+dom_exception _dom_event_target_add_event_listener(dom_document *doc,
 		dom_event_target_internal *eti,
 		dom_string *type, struct dom_event_listener *listener, 
 		bool capture);
 
-dom_exception _dom_event_target_remove_event_listener(
+dom_exception _dom_event_target_remove_event_listener(dom_document *doc,
 		dom_event_target_internal *eti,
 		dom_string *type, struct dom_event_listener *listener, 
 		bool capture);
@@ -8,6 +8,7 @@
 #include <stdlib.h>
 
 #include "events/mutation_event.h"
+#include "core/string.h"
 
 static void _virtual_dom_mutation_event_destroy(struct dom_event *evt);
 
@@ -92,11 +93,17 @@ dom_exception _dom_mutation_event_get_related_node(dom_mutation_event *evt,
  *
  * \param evt  The Event object
  * \param ret  The old value
- * \return DOM_NO_ERR.
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
  */
 dom_exception _dom_mutation_event_get_prev_value(dom_mutation_event *evt,
 		dom_string **ret)
 {
+	dom_exception err;
+
+	err = _dom_string_unpool(&evt->prev_value);
+	if (err != DOM_NO_ERR)
+		return err;
+
 	*ret = evt->prev_value;
 	dom_string_ref(*ret);
 
@@ -108,11 +115,17 @@ dom_exception _dom_mutation_event_get_prev_value(dom_mutation_event *evt,
  *
  * \param evt  The Event object
  * \param ret  The new value
- * \return DOM_NO_ERR.
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
  */
 dom_exception _dom_mutation_event_get_new_value(dom_mutation_event *evt,
 		dom_string **ret)
 {
+	dom_exception err;
+
+	err = _dom_string_unpool(&evt->new_value);
+	if (err != DOM_NO_ERR)
+		return err;
+
 	*ret = evt->new_value;
 	dom_string_ref(*ret);
 
@@ -43,6 +43,40 @@ dom_exception _dom_html_collection_create(struct dom_html_document *doc,
 	return _dom_html_collection_initialise(doc, *col, root, ic, ctx);
 }
 
+/**
+ * Create a dom_html_collection whose members are listed by a callback
+ *
+ * \param doc   The document
+ * \param root  The root element of the collection
+ * \param list  The callback function used to list the collection's members
+ * \param ctx   Context for the callback
+ * \param col   The result collection object
+ * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
+ *
+ * This is for collections which can find their members more cheaply than
+ * by walking the tree below ::root.  The members are still only relisted
+ * when the document has changed.
+ */
+dom_exception _dom_html_collection_create_listed(
+		struct dom_html_document *doc,
+		struct dom_node_internal *root,
+		dom_callback_list_collection list,
+		void *ctx,
+		struct dom_html_collection **col)
+{
+	dom_exception err;
+
+	assert(list != NULL);
+
+	err = _dom_html_collection_create(doc, root, NULL, ctx, col);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	(*col)->list = list;
+
+	return DOM_NO_ERR;
+}
+
 /**
  * Intialiase a dom_html_collection
  *
@@ -59,7 +93,6 @@ dom_exception _dom_html_collection_initialise(struct dom_html_document *doc,
 		dom_callback_is_in_collection ic, void *ctx)
 {
 	assert(doc != NULL);
-	assert(ic != NULL);
 	assert(root != NULL);
 
 	col->doc = doc;
@@ -69,7 +102,16 @@ dom_exception _dom_html_collection_initialise(struct dom_html_document *doc,
 	dom_node_ref(root);
 
 	col->ic = ic;
+	col->list = NULL;
 	col->ctx = ctx;
+
+	col->items = NULL;
+	col->n_items = 0;
+	col->alloc_items = 0;
+	col->valid = false;
+	col->tree_generation = 0;
+	col->attr_generation = 0;
+
 	col->refcnt = 1;
 
 	return DOM_NO_ERR;
@@ -89,6 +131,9 @@ void _dom_html_collection_finalise(struct dom_html_collection *col)
 	col->root = NULL;
 
 	col->ic = NULL;
+
+	free(col->items);
+	col->items = NULL;
 }
 
 /**
@@ -104,25 +149,59 @@ void _dom_html_collection_destroy(struct dom_html_collection *col)
 
 
 /*-----------------------------------------------------------------------*/
-/* Public API */
+/* Helper functions */
 
 /**
- * Get the length of this dom_html_collection
+ * Add a member to the end of a collection's list of members
  *
- * \param col  The dom_html_collection object
- * \param len  The returned length of this collection
- * \return DOM_NO_ERR on success.
+ * \param col   The collection
+ * \param node  The member to add
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ *
+ * This is used while the list is being refilled, including by the
+ * callbacks of listed collections.
  */
-dom_exception dom_html_collection_get_length(dom_html_collection *col,
-		uint32_t *len)
+dom_exception _dom_html_collection_append(dom_html_collection *col,
+		struct dom_node_internal *node)
+{
+	if (col->n_items == col->alloc_items) {
+		struct dom_node_internal **items;
+		uint32_t alloc = col->alloc_items == 0 ?
+				8 : col->alloc_items * 2;
+
+		items = realloc(col->items, alloc * sizeof(*items));
+		if (items == NULL)
+			return DOM_NO_MEM_ERR;
+
+		col->items = items;
+		col->alloc_items = alloc;
+	}
+
+	col->items[col->n_items++] = node;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Find a collection's members by a depth first walk of its root
+ *
+ * \param col  The collection, whose list of members is empty
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ */
+static dom_exception _dom_html_collection_walk(dom_html_collection *col)
 {
 	struct dom_node_internal *node = col->root;
-	*len = 0;
+	dom_exception err;
+
+	assert(col->ic != NULL);
 
 	while (node != NULL) {
 		if (node->type == DOM_ELEMENT_NODE && 
-		    col->ic(node, col->ctx) == true)
-			(*len)++;
+		    col->ic(node, col->ctx) == true) {
+			err = _dom_html_collection_append(col, node);
+			if (err != DOM_NO_ERR)
+				return err;
+		}
 
 		/* Depth first iterating */
 		if (node->first_child != NULL) {
@@ -149,55 +228,91 @@ dom_exception dom_html_collection_get_length(dom_html_collection *col,
 	return DOM_NO_ERR;
 }
 
+/**
+ * Ensure a collection's list of members is up to date
+ *
+ * \param col  The collection
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ *
+ * The members are found by the collection's list callback, if it has one,
+ * or else by a depth first walk of the collection's root.  This is only
+ * repeated if the tree or any attribute has changed since it was last done.
+ */
+static dom_exception _dom_html_collection_update(dom_html_collection *col)
+{
+	struct dom_document *doc = col->root->owner;
+	dom_exception err;
+
+	if (col->valid && col->tree_generation == doc->tree_generation &&
+			col->attr_generation == doc->attr_generation)
+		return DOM_NO_ERR;
+
+	col->valid = false;
+	col->n_items = 0;
+
+	if (col->list != NULL)
+		err = col->list(col, col->ctx);
+	else
+		err = _dom_html_collection_walk(col);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	col->valid = true;
+	col->tree_generation = doc->tree_generation;
+	col->attr_generation = doc->attr_generation;
+
+	return DOM_NO_ERR;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Public API */
+
+/**
+ * Get the length of this dom_html_collection
+ *
+ * \param col  The dom_html_collection object
+ * \param len  The returned length of this collection
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ */
+dom_exception dom_html_collection_get_length(dom_html_collection *col,
+		uint32_t *len)
+{
+	dom_exception err;
+
+	err = _dom_html_collection_update(col);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	*len = col->n_items;
+
+	return DOM_NO_ERR;
+}
+
 /**
  * Get the node with certain index
  *
  * \param col  The dom_html_collection object
  * \param index  The index number based on zero
  * \param node   The returned node object
- * \return DOM_NO_ERR on success.
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
  */
 dom_exception dom_html_collection_item(dom_html_collection *col,
 		uint32_t index, struct dom_node **node)
 {
-	struct dom_node_internal *n = col->root;
-	uint32_t len = 0;
-
-	while (n != NULL) {
-		if (n->type == DOM_ELEMENT_NODE && 
-		    col->ic(n, col->ctx) == true)
-			len++;
-
-		if (len == index + 1) {
-			dom_node_ref(n);
-			*node = (struct dom_node *) n;
-			return DOM_NO_ERR;
-		}
+	dom_exception err;
 
-		/* Depth first iterating */
-		if (n->first_child != NULL) {
-			n = n->first_child;
-		} else if (n->next != NULL) {
-			n = n->next;
-		} else {
-			/* No children and siblings */
-			struct dom_node_internal *parent = n->parent;
+	err = _dom_html_collection_update(col);
+	if (err != DOM_NO_ERR)
+		return err;
 
-			while (n != col->root &&
-					n == parent->last_child) {
-				n = parent;
-				parent = parent->parent;
-			}
-			
-			if (n == col->root)
-				n = NULL;
-			else
-				n = n->next;
-		}
+	if (index >= col->n_items) {
+		/* Not find the node */
+		*node = NULL;
+		return DOM_NO_ERR;
 	}
 
-	/* Not find the node */
-	*node = NULL;
+	*node = (struct dom_node *) dom_node_ref(col->items[index]);
+
 	return DOM_NO_ERR;
 }
 
@@ -212,69 +327,52 @@ dom_exception dom_html_collection_item(dom_html_collection *col,
 dom_exception dom_html_collection_named_item(dom_html_collection *col,
 		dom_string *name, struct dom_node **node)
 {
-	struct dom_node_internal *n = col->root;
-	dom_html_document *doc = (dom_html_document *)dom_node_get_owner(n);
+	dom_html_document *doc =
+			(dom_html_document *) dom_node_get_owner(col->root);
+	struct dom_node_internal *n;
 	dom_exception err;
+	uint32_t i;
 
-	while (n != NULL) {
-		if (n->type == DOM_ELEMENT_NODE &&
-		    col->ic(n, col->ctx) == true) {
-			dom_string *id = NULL;
-			dom_string *id_name = NULL;
+	err = _dom_html_collection_update(col);
+	if (err != DOM_NO_ERR)
+		return err;
 
-			err = _dom_element_get_id((struct dom_element *) n,
-					&id);
-			if (err != DOM_NO_ERR) {
-				return err;
-			}
+	for (i = 0; i < col->n_items; i++) {
+		dom_string *id = NULL;
+		dom_string *id_name = NULL;
+
+		n = col->items[i];
 
-			if (id != NULL) {
-				if (dom_string_isequal(name, id)) {
-					*node = dom_node_ref(n);
-					dom_string_unref(id);
+		err = _dom_element_get_id((struct dom_element *) n, &id);
+		if (err != DOM_NO_ERR) {
+			return err;
+		}
 
-					return DOM_NO_ERR;
-				}
+		if (id != NULL) {
+			if (dom_string_isequal(name, id)) {
+				*node = dom_node_ref(n);
 				dom_string_unref(id);
-			}
 
-			/* Check for Name attr if id not matched/found */
-			err = _dom_element_get_attribute((dom_element *)n,
-					doc->memoised[hds_name], &id_name);
-			if(err != DOM_NO_ERR) {
-				return err;
+				return DOM_NO_ERR;
 			}
+			dom_string_unref(id);
+		}
 
-			if (id_name != NULL) {
-				if (dom_string_isequal(name, id_name)) {
-					*node = dom_node_ref(n);
-					dom_string_unref(id_name);
-
-					return DOM_NO_ERR;
-				}
-				dom_string_unref(id_name);
-			}
+		/* Check for Name attr if id not matched/found */
+		err = _dom_element_get_attribute((dom_element *)n,
+				doc->memoised[hds_name], &id_name);
+		if(err != DOM_NO_ERR) {
+			return err;
 		}
 
-		/* Depth first iterating */
-		if (n->first_child != NULL) {
-			n = n->first_child;
-		} else if (n->next != NULL) {
-			n = n->next;
-		} else {
-			/* No children and siblings */
-			struct dom_node_internal *parent = n->parent;
+		if (id_name != NULL) {
+			if (dom_string_isequal(name, id_name)) {
+				*node = dom_node_ref(n);
+				dom_string_unref(id_name);
 
-			while (n != col->root &&
-					n == parent->last_child) {
-				n = parent;
-				parent = parent->parent;
+				return DOM_NO_ERR;
 			}
-			
-			if (n == col->root)
-				n = NULL;
-			else
-				n = n->next;
+			dom_string_unref(id_name);
 		}
 	}
 
@@ -15,6 +15,14 @@ struct dom_node_internal;
 typedef bool (*dom_callback_is_in_collection)(
 	struct dom_node_internal *node, void *ctx);
 
+struct dom_html_collection;
+
+/* Callback which lists a collection's members in document order, with
+ * _dom_html_collection_append, instead of them being found by walking the
+ * collection's root */
+typedef dom_exception (*dom_callback_list_collection)(
+	struct dom_html_collection *col, void *ctx);
+
 /**
  * The html_collection structure
  */
@@ -24,12 +32,27 @@ struct dom_html_collection {
 			 * whether some node is an element of
 			 * this collection
 			 */
+	dom_callback_list_collection list;
+			/**< If not NULL, the function used to list the
+			 * members, in place of a walk of the root */
 	void *ctx; /**< Context for the callback */
 	struct dom_html_document *doc;	/**< The document created this
 					 * collection
 					 */
 	struct dom_node_internal *root;
 			/**< The root node of this collection */
+	struct dom_node_internal **items;
+			/**< The members, valid if the generations below
+			 * match the document's */
+	uint32_t n_items;
+			/**< The number of members */
+	uint32_t alloc_items;
+			/**< The allocated size of items */
+	bool valid;	/**< Whether items has been filled */
+	uint64_t tree_generation;
+			/**< The document's tree generation when filled */
+	uint64_t attr_generation;
+			/**< The document's attribute generation when filled */
 	uint32_t refcnt;
 			/**< Reference counting */
 };
@@ -45,9 +68,19 @@ dom_exception _dom_html_collection_initialise(struct dom_html_document *doc,
 		struct dom_node_internal *root,
 		dom_callback_is_in_collection ic, void *ctx);
 
+dom_exception _dom_html_collection_create_listed(
+		struct dom_html_document *doc,
+		struct dom_node_internal *root,
+		dom_callback_list_collection list,
+		void *ctx,
+		struct dom_html_collection **col);
+
 void _dom_html_collection_finalise(struct dom_html_collection *col);
 
 void _dom_html_collection_destroy(struct dom_html_collection *col);
 
+dom_exception _dom_html_collection_append(struct dom_html_collection *col,
+		struct dom_node_internal *node);
+
 #endif
 
@@ -6,7 +6,9 @@
  */
 
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <dom/html/html_elements.h>
 
@@ -72,7 +74,7 @@
 #include "utils/namespace.h"
 #include "utils/utils.h"
 
-static const struct dom_html_document_vtable html_document_vtable = {
+const struct dom_html_document_vtable _dom_html_document_vtable = {
 	{
 		{
 			{
@@ -89,6 +91,33 @@ static const struct dom_node_protect_vtable html_document_protect_vtable = {
 	DOM_HTML_DOCUMENT_PROTECT_VTABLE
 };
 
+/**
+ * Table of strings shared by every HTML document
+ *
+ * The table is created with the first HTML document, and is then kept
+ * until dom_namespace_finalise() is called.  Each HTML document
+ * also holds a reference to the table, so that it outlives the documents
+ * that use it.
+ */
+struct dom_html_document_strings {
+	uint32_t refcnt;			/**< Reference count */
+	dom_string *memoised[hds_COUNT];	/**< Memoised strings */
+	dom_string *elements[DOM_HTML_ELEMENT_TYPE__COUNT];
+					/**< HTML element names, upper case */
+	uint8_t element_types[DOM_HTML_DOCUMENT_ELEMENT_TYPES_SIZE];
+					/**< Element types, by name hash */
+};
+
+/** The table for new HTML documents to use, or NULL if it is not created */
+static struct dom_html_document_strings *shared_strings;
+
+static dom_exception _dom_html_document_strings_get(
+		struct dom_html_document_strings **result);
+static void _dom_html_document_strings_release(
+		struct dom_html_document_strings *strings);
+static void _dom_html_document_hash_element_types(
+		struct dom_html_document_strings *strings);
+
 /* Create a HTMLDocument */
 dom_exception _dom_html_document_create(
 		dom_events_default_action_fetcher daf,
@@ -102,7 +131,7 @@ dom_exception _dom_html_document_create(
 	if (result == NULL)
 		return DOM_NO_MEM_ERR;
 
-	result->base.base.base.vtable = &html_document_vtable;
+	result->base.base.base.vtable = &_dom_html_document_vtable;
 	result->base.base.vtable = &html_document_protect_vtable;
 	
 	error = _dom_html_document_initialise(result, daf, daf_ctx);
@@ -121,7 +150,6 @@ dom_exception _dom_html_document_initialise(dom_html_document *doc,
 		void *daf_ctx)
 {
 	dom_exception error;
-	int sidx;
 
 	error = _dom_document_initialise(&doc->base, daf, daf_ctx);
 	if (error != DOM_NO_ERR)
@@ -134,69 +162,23 @@ dom_exception _dom_html_document_initialise(dom_html_document *doc,
 	doc->cookie = NULL;
 	doc->body = NULL;
 
-	doc->memoised = calloc(sizeof(dom_string *), hds_COUNT);
-	if (doc->memoised == NULL) {
-		error = DOM_NO_MEM_ERR;
-		goto out;
-	}
-	doc->elements = calloc(sizeof(dom_string *),
-			DOM_HTML_ELEMENT_TYPE__COUNT);
-	if (doc->elements == NULL) {
-		error = DOM_NO_MEM_ERR;
-		goto out;
-	}
-
-#define HTML_DOCUMENT_STRINGS_ACTION(attr,str)				\
-	error = dom_string_create_interned((const uint8_t *) #str,	\
-			SLEN(#str), &doc->memoised[hds_##attr]);	\
-	if (error != DOM_NO_ERR) {					\
-		goto out;						\
-	}
-
-#include "html_document_strings.h"
-#undef HTML_DOCUMENT_STRINGS_ACTION
-
-#define DOM_HTML_ELEMENT_STRINGS_ENTRY(tag)				\
-	error = dom_string_create_interned((const uint8_t *) #tag,	\
-			SLEN(#tag),					\
-			&doc->elements[DOM_HTML_ELEMENT_TYPE_##tag]);	\
-	if (error != DOM_NO_ERR) {					\
-		goto out;						\
+	error = _dom_html_document_strings_get(&doc->strings);
+	if (error != DOM_NO_ERR) {
+		doc->strings = NULL;
+		doc->memoised = NULL;
+		doc->elements = NULL;
+		return error;
 	}
 
-#include <dom/html/html_elements.h>
-#undef DOM_HTML_ELEMENT_STRINGS_ENTRY
+	doc->memoised = doc->strings->memoised;
+	doc->elements = doc->strings->elements;
 
-out:
-	if (error != DOM_NO_ERR) {
-		if (doc->memoised != NULL) {
-			for(sidx = 0; sidx < hds_COUNT; ++sidx) {
-				if (doc->memoised[sidx] != NULL) {
-					dom_string_unref(doc->memoised[sidx]);
-				}
-			}
-			free(doc->memoised);
-			doc->memoised = NULL;
-		}
-		if (doc->elements != NULL) {
-			for(sidx = 0; sidx < DOM_HTML_ELEMENT_TYPE__COUNT;
-					++sidx) {
-				if (doc->elements[sidx] != NULL) {
-					dom_string_unref(doc->elements[sidx]);
-				}
-			}
-			free(doc->elements);
-			doc->elements = NULL;
-		}
-	}
-	return error;
+	return DOM_NO_ERR;
 }
 
 /* Finalise a HTMLDocument */
 bool _dom_html_document_finalise(dom_html_document *doc)
 {
-	int sidx;
-	
 	if (doc->cookie != NULL)
 		dom_string_unref(doc->cookie);
 	if (doc->url != NULL)
@@ -208,23 +190,10 @@ bool _dom_html_document_finalise(dom_html_document *doc)
 	if (doc->title != NULL)
 		dom_string_unref(doc->title);
 	
-	if (doc->memoised != NULL) {
-		for(sidx = 0; sidx < hds_COUNT; ++sidx) {
-			if (doc->memoised[sidx] != NULL) {
-				dom_string_unref(doc->memoised[sidx]);
-			}
-		}
-		free(doc->memoised);
+	if (doc->strings != NULL) {
+		_dom_html_document_strings_release(doc->strings);
+		doc->strings = NULL;
 		doc->memoised = NULL;
-	}
-	
-	if (doc->elements != NULL) {
-		for(sidx = 0; sidx < DOM_HTML_ELEMENT_TYPE__COUNT; ++sidx) {
-			if (doc->elements[sidx] != NULL) {
-				dom_string_unref(doc->elements[sidx]);
-			}
-		}
-		free(doc->elements);
 		doc->elements = NULL;
 	}
 
@@ -241,287 +210,241 @@ void _dom_html_document_destroy(dom_node_internal *node)
 }
 
 dom_exception _dom_html_document_copy(dom_node_internal *old,
-		dom_node_internal **copy)
+		struct dom_document *doc, dom_node_internal **copy)
 {
 	UNUSED(old);
+	UNUSED(doc);
 	UNUSED(copy);
 
 	return DOM_NOT_SUPPORTED_ERR;
 }
 
-#define RETURN_IF_MATCH(_x, _y) \
-	if (dom_string_isequal(_x, html->elements[_y])) { return _y; }
+/**
+ * Hash an HTML element name, ignoring the case of ASCII letters
+ *
+ * \param name  The name
+ * \param len   The length of the name, in bytes
+ * \return the slot in the HTML documents' table of element types at which
+ *         to start looking for the name.
+ */
+static inline uint32_t _dom_html_document_hash_element_name(
+		const uint8_t *name, size_t len)
+{
+	uint32_t hash = 2166136261u;
+	size_t i;
+
+	/* FNV-1a, with bit 5 cleared to fold ASCII letters to upper case.
+	 * Other bytes are folded too, but only to choose a slot: names
+	 * are compared properly when found. */
+	for (i = 0; i < len; i++) {
+		hash ^= name[i] & ~0x20u;
+		hash *= 16777619u;
+	}
+
+	return (hash ^ (hash >> 16)) &
+			(DOM_HTML_DOCUMENT_ELEMENT_TYPES_SIZE - 1);
+}
+
+/**
+ * Create the table of strings shared by every HTML document
+ *
+ * \param result  Pointer to location to receive the table
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ *
+ * The table is returned with one reference, which is held until
+ * dom_namespace_finalise() is called.
+ */
+static dom_exception _dom_html_document_strings_create(
+		struct dom_html_document_strings **result)
+{
+	struct dom_html_document_strings *strings;
+	dom_exception error;
+
+	strings = calloc(1, sizeof(*strings));
+	if (strings == NULL)
+		return DOM_NO_MEM_ERR;
+
+	strings->refcnt = 1;
+
+#define HTML_DOCUMENT_STRINGS_ACTION(attr,str)				\
+	error = dom_string_create_interned((const uint8_t *) #str,	\
+			SLEN(#str), &strings->memoised[hds_##attr]);	\
+	if (error != DOM_NO_ERR) {					\
+		goto out;						\
+	}
+
+#include "html_document_strings.h"
+#undef HTML_DOCUMENT_STRINGS_ACTION
+
+#define DOM_HTML_ELEMENT_STRINGS_ENTRY(tag)				\
+	error = dom_string_create_interned((const uint8_t *) #tag,	\
+			SLEN(#tag),					\
+			&strings->elements[DOM_HTML_ELEMENT_TYPE_##tag]); \
+	if (error != DOM_NO_ERR) {					\
+		goto out;						\
+	}
+
+#include <dom/html/html_elements.h>
+#undef DOM_HTML_ELEMENT_STRINGS_ENTRY
+
+	_dom_html_document_hash_element_types(strings);
+
+out:
+	if (error != DOM_NO_ERR) {
+		_dom_html_document_strings_release(strings);
+		return error;
+	}
+
+	*result = strings;
+	return DOM_NO_ERR;
+}
+
+/**
+ * Get the table of strings shared by every HTML document
+ *
+ * \param result  Pointer to location to receive the table
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ *
+ * The table is created if there is none.  The caller must release its
+ * reference to the table with _dom_html_document_strings_release().
+ */
+dom_exception _dom_html_document_strings_get(
+		struct dom_html_document_strings **result)
+{
+	dom_exception error;
+
+	if (shared_strings == NULL) {
+		error = _dom_html_document_strings_create(&shared_strings);
+		if (error != DOM_NO_ERR)
+			return error;
+	}
+
+	shared_strings->refcnt++;
+	*result = shared_strings;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Release a reference to a table of strings shared by HTML documents
+ *
+ * \param strings  The table, which is destroyed with its last reference
+ */
+void _dom_html_document_strings_release(
+		struct dom_html_document_strings *strings)
+{
+	int sidx;
+
+	if (--strings->refcnt > 0)
+		return;
+
+	for (sidx = 0; sidx < hds_COUNT; ++sidx) {
+		if (strings->memoised[sidx] != NULL)
+			dom_string_unref(strings->memoised[sidx]);
+	}
+
+	for (sidx = 0; sidx < DOM_HTML_ELEMENT_TYPE__COUNT; ++sidx) {
+		if (strings->elements[sidx] != NULL)
+			dom_string_unref(strings->elements[sidx]);
+	}
+
+	free(strings);
+}
+
+/**
+ * Finalise the strings shared by HTML documents
+ *
+ * The shared strings are destroyed once every existing HTML document has
+ * been destroyed.  Documents created afterwards make a new set.
+ */
+void _dom_html_document_strings_finalise(void)
+{
+	if (shared_strings != NULL) {
+		_dom_html_document_strings_release(shared_strings);
+		shared_strings = NULL;
+	}
+}
 
 /**
- * Get html element type from an uppercased tag name string
+ * Fill the HTML documents' table of element types
  *
- * \param html            The html document that the html element belongs to
- * \param upper  Upper cased string containing tag name
+ * \param strings  The shared strings, whose element names have been created
+ */
+void _dom_html_document_hash_element_types(
+		struct dom_html_document_strings *strings)
+{
+	uint32_t type, slot;
+
+	assert(DOM_HTML_ELEMENT_TYPE__COUNT <= UINT8_MAX + 1);
+	assert(DOM_HTML_ELEMENT_TYPE__COUNT <
+			DOM_HTML_DOCUMENT_ELEMENT_TYPES_SIZE);
+
+	memset(strings->element_types, DOM_HTML_ELEMENT_TYPE__UNKNOWN,
+			sizeof(strings->element_types));
+
+	for (type = DOM_HTML_ELEMENT_TYPE__UNKNOWN + 1;
+			type < DOM_HTML_ELEMENT_TYPE__COUNT; type++) {
+		slot = _dom_html_document_hash_element_name(
+				(const uint8_t *) dom_string_data(
+						strings->elements[type]),
+				dom_string_byte_length(strings->elements[type]));
+
+		while (strings->element_types[slot] !=
+				DOM_HTML_ELEMENT_TYPE__UNKNOWN)
+			slot = (slot + 1) &
+				(DOM_HTML_DOCUMENT_ELEMENT_TYPES_SIZE - 1);
+
+		strings->element_types[slot] = type;
+	}
+}
+
+/**
+ * Get html element type from a tag name string
+ *
+ * \param html  The html document that the html element belongs to
+ * \param name  String containing tag name, in any case
+ * \return the element type, or DOM_HTML_ELEMENT_TYPE__UNKNOWN.
+ *
+ * The name is looked up in the shared table of element types, so no
+ * upper cased copy of it needs to be made.
  */
 static inline dom_html_element_type _dom_html_document_get_element_type(
-		dom_html_document *html, dom_string *upper)
+		dom_html_document *html, dom_string *name)
 {
-	size_t len = dom_string_byte_length(upper);
-
-	switch (len) {
-	case 1:
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_P)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_A)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_B)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_I)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_S)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_U)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_Q)
-		break;
-	case 2:
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_EM)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_LI)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_H1)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_H2)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_H3)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_H4)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_H5)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_H6)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_HR)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_DD)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_DT)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_DL)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_UL)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_OL)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_TD)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_TH)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_TR)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_BR)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_RP)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_RT)
-		break;
-	case 3:
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_DIV)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_IMG)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_PRE)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_DEL)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_INS)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_COL)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_MAP)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_DIR)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_SUB)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_SUP)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_DFN)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_KBD)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_NAV)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_VAR)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_BDI)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_BDO)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_WBR)
-		break;
-	case 4:
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_META)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_CODE)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_SPAN)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_FORM)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_LINK)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_MENU)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_FONT)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_ABBR)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_CITE)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_DATA)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_HTML)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_BODY)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_HEAD)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_AREA)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_MAIN)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_MARK)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_RUBY)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_SAMP)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_BASE)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_TIME)
-		break;
-	case 5:
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_INPUT)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_TABLE)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_STYLE)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_THEAD)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_TBODY)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_TFOOT)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_LABEL)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_PARAM)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_TITLE)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_FRAME)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_AUDIO)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_ASIDE)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_EMBED)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_METER)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_SMALL)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_TRACK)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_VIDEO)
-		break;
-	case 6:
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_BUTTON)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_OPTION)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_SCRIPT)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_IFRAME)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_LEGEND)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_SELECT)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_OBJECT)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_APPLET)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_CANVAS)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_DIALOG)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_CENTER)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_FIGURE)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_FOOTER)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_HEADER)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_HGROUP)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_KEYGEN)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_OUTPUT)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_SOURCE)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_STRONG)
-		break;
-	case 7:
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_CAPTION)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_ISINDEX)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_ADDRESS)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_ARTICLE)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_DETAILS)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_PICTURE)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_SECTION)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_SUMMARY)
-		break;
-	case 8:
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_TEXTAREA)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_OPTGROUP)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_BASEFONT)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_FIELDSET)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_COLGROUP)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_FRAMESET)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_DATALIST)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_MENUITEM)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_NOSCRIPT)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_PROGRESS)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_TEMPLATE)
-		break;
-	case 10:
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_BLOCKQUOTE)
-		else
-		RETURN_IF_MATCH(upper, DOM_HTML_ELEMENT_TYPE_FIGCAPTION)
-		break;
+	const uint8_t *data = (const uint8_t *) dom_string_data(name);
+	size_t len = dom_string_byte_length(name);
+	uint32_t slot = _dom_html_document_hash_element_name(data, len);
+	dom_html_element_type type;
+
+	while ((type = html->strings->element_types[slot]) !=
+			DOM_HTML_ELEMENT_TYPE__UNKNOWN) {
+		dom_string *upper = html->elements[type];
+
+		if (dom_string_byte_length(upper) == len) {
+			const uint8_t *u = (const uint8_t *)
+					dom_string_data(upper);
+			size_t i;
+
+			for (i = 0; i < len; i++) {
+				uint8_t c = data[i];
+
+				if (c >= 'a' && c <= 'z')
+					c -= 'a' - 'A';
+
+				if (c != u[i])
+					break;
+			}
+
+			if (i == len)
+				return type;
+		}
+
+		slot = (slot + 1) & (DOM_HTML_DOCUMENT_ELEMENT_TYPES_SIZE - 1);
 	}
 
 	return DOM_HTML_ELEMENT_TYPE__UNKNOWN;
 }
 
-#undef RETURN_IF_MATCH
-
 /* Overloaded methods inherited from super class */
 
 /** Internal method to support both kinds of create method */
@@ -540,11 +463,16 @@ _dom_html_document_create_element_internal(
 	if (dom_string_length(in_tag_name) == 0)
 		return DOM_INVALID_CHARACTER_ERR;
 
-	exc = dom_string_toupper(in_tag_name, true, &params.name);
-	if (exc != DOM_NO_ERR)
-		return exc;
+	params.type = _dom_html_document_get_element_type(html, in_tag_name);
 
-	params.type = _dom_html_document_get_element_type(html, params.name);
+	/* Known elements share the document's name for their type */
+	if (params.type != DOM_HTML_ELEMENT_TYPE__UNKNOWN) {
+		params.name = dom_string_ref(html->elements[params.type]);
+	} else {
+		exc = dom_string_toupper(in_tag_name, true, &params.name);
+		if (exc != DOM_NO_ERR)
+			return exc;
+	}
 	params.doc = html;
 	params.namespace = namespace;
 	params.prefix = prefix;
@@ -1173,13 +1101,10 @@ dom_exception _dom_html_document_set_body(dom_html_document *doc,
  */
 bool images_callback(struct dom_node_internal *node, void *ctx)
 {
-	dom_html_document *doc = ctx;
-	if(node->type == DOM_ELEMENT_NODE &&
-			dom_string_caseless_isequal(node->name,
-				doc->elements[DOM_HTML_ELEMENT_TYPE_IMG])) {
-		return true;
-	}
-	return false;
+	UNUSED(ctx);
+
+	return _dom_html_node_get_element_type(node) ==
+			DOM_HTML_ELEMENT_TYPE_IMG;
 }
 
 dom_exception _dom_html_document_get_images(dom_html_document *doc,
@@ -1199,13 +1124,10 @@ dom_exception _dom_html_document_get_images(dom_html_document *doc,
 
 bool applet_callback(struct dom_node_internal * node, void *ctx)
 {
-	dom_html_document *doc = ctx;
-	if(node->type == DOM_ELEMENT_NODE &&
-			dom_string_caseless_isequal(node->name,
-				doc->elements[DOM_HTML_ELEMENT_TYPE_APPLET])) {
-		return true;
-	}
-	return false;
+	UNUSED(ctx);
+
+	return _dom_html_node_get_element_type(node) ==
+			DOM_HTML_ELEMENT_TYPE_APPLET;
 }
 /**
  * Callback for creating the applets collection
@@ -1216,10 +1138,8 @@ bool applet_callback(struct dom_node_internal * node, void *ctx)
  */
 bool applets_callback(struct dom_node_internal *node, void *ctx)
 {
-	dom_html_document *doc = ctx;
-	if(node->type == DOM_ELEMENT_NODE &&
-			dom_string_caseless_isequal(node->name,
-				doc->elements[DOM_HTML_ELEMENT_TYPE_OBJECT])) {
+	if(_dom_html_node_get_element_type(node) ==
+			DOM_HTML_ELEMENT_TYPE_OBJECT) {
 		uint32_t len = 0;
 		dom_html_collection *applets;
 		if (_dom_html_collection_create(ctx, node,
@@ -1258,12 +1178,10 @@ dom_exception _dom_html_document_get_applets(dom_html_document *doc,
 bool links_callback(struct dom_node_internal *node, void *ctx)
 {
 	dom_html_document *doc = ctx;
-	if(node->type == DOM_ELEMENT_NODE &&
-			(dom_string_caseless_isequal(node->name,
-				doc->elements[DOM_HTML_ELEMENT_TYPE_A]) ||
-			dom_string_caseless_isequal(node->name,
-				doc->elements[DOM_HTML_ELEMENT_TYPE_AREA]))
-			 ) {
+	dom_html_element_type type = _dom_html_node_get_element_type(node);
+
+	if(type == DOM_HTML_ELEMENT_TYPE_A ||
+			type == DOM_HTML_ELEMENT_TYPE_AREA) {
 		bool has_value = false;
 		dom_exception err;
 
@@ -1296,12 +1214,10 @@ dom_exception _dom_html_document_get_links(dom_html_document *doc,
 static bool __dom_html_document_node_is_form(dom_node_internal *node,
 		void *ctx)
 {
-	dom_html_document *doc = (dom_html_document *)node->owner;
-
 	UNUSED(ctx);
 
-	return dom_string_caseless_isequal(node->name,
-			doc->elements[DOM_HTML_ELEMENT_TYPE_FORM]);
+	return _dom_html_node_get_element_type(node) ==
+			DOM_HTML_ELEMENT_TYPE_FORM;
 }
 
 dom_exception _dom_html_document_get_forms(dom_html_document *doc,
@@ -1339,9 +1255,8 @@ dom_exception _dom_html_document_get_forms(dom_html_document *doc,
 bool anchors_callback(struct dom_node_internal *node, void *ctx)
 {
 	dom_html_document *doc = ctx;
-	if(node->type == DOM_ELEMENT_NODE &&
-			dom_string_caseless_isequal(node->name,
-				doc->elements[DOM_HTML_ELEMENT_TYPE_A])) {
+	if(_dom_html_node_get_element_type(node) ==
+			DOM_HTML_ELEMENT_TYPE_A) {
 		bool has_value = false;
 		dom_exception err;
 
@@ -13,6 +13,13 @@
 
 #include "core/document.h"
 
+/**
+ * The number of slots in the HTML documents' table of element types.  This
+ * is a power of two, and about twice the number of element types, so that
+ * chains of colliding names stay short.
+ */
+#define DOM_HTML_DOCUMENT_ELEMENT_TYPES_SIZE 256
+
 /**
  * The dom_html_document class
  */
@@ -26,9 +33,11 @@ struct dom_html_document {
 	dom_string *cookie;	/**< HTML document cookie */
 	dom_html_element *body;	/**< HTML BodyElement */
 	
-	/** Cached strings for html objects to use */
+	/** Strings shared with other HTML documents */
+	struct dom_html_document_strings *strings;
+	/** Cached strings for html objects to use, from the shared strings */
 	dom_string **memoised;
-	/** Cached strings for HTML element names */
+	/** Cached strings for HTML element names, from the shared strings */
 	dom_string **elements;
 };
 
@@ -47,9 +56,26 @@ dom_exception _dom_html_document_initialise(
 /* Finalise a HTMLDocument */
 bool _dom_html_document_finalise(dom_html_document *doc);
 
+/* Finalise the strings shared by HTML documents */
+void _dom_html_document_strings_finalise(void);
+
+extern const struct dom_html_document_vtable _dom_html_document_vtable;
+
+/**
+ * Test whether a document is an HTML document
+ *
+ * \param doc  The document
+ * \return true if ::doc was created as an HTML document, false otherwise
+ */
+static inline bool _dom_document_is_html(const struct dom_document *doc)
+{
+	return ((const struct dom_node *) doc)->vtable ==
+			&_dom_html_document_vtable;
+}
+
 void _dom_html_document_destroy(dom_node_internal *node);
-dom_exception _dom_html_document_copy(dom_node_internal *old, 
-		dom_node_internal **copy);
+dom_exception _dom_html_document_copy(dom_node_internal *old,
+		struct dom_document *doc, dom_node_internal **copy);
 
 #define DOM_HTML_DOCUMENT_PROTECT_VTABLE \
 	_dom_html_document_destroy, \
@@ -45,7 +45,8 @@ dom_exception _dom_html_element_create(
 	dom_exception error;
 	dom_html_element *el;
 
-	el = malloc(sizeof(struct dom_html_element));
+	el = _dom_node_alloc(&params->doc->base,
+			sizeof(struct dom_html_element));
 	if (el == NULL)
 		return DOM_NO_MEM_ERR;
 
@@ -54,7 +55,7 @@ dom_exception _dom_html_element_create(
 
 	error = _dom_html_element_initialise(params, el);
 	if (error != DOM_NO_ERR) {
-		free(el);
+		_dom_node_free(el);
 		return error;
 	}
 
@@ -94,23 +95,23 @@ void _dom_html_element_destroy(dom_node_internal *node)
 
 	_dom_html_element_finalise(html);
 
-	free(html);
+	_dom_node_free(html);
 }
 
 /* The virtual copy function, see src/core/node.c for detail */
 dom_exception _dom_html_element_copy(dom_node_internal *old,
-		dom_node_internal **copy)
+		struct dom_document *doc, dom_node_internal **copy)
 {
 	dom_html_element *new_node;
 	dom_exception err;
 
-	new_node = malloc(sizeof(dom_html_element));
+	new_node = _dom_node_alloc(doc, sizeof(dom_html_element));
 	if (new_node == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_html_element_copy_internal(old, new_node);
 	if (err != DOM_NO_ERR) {
-		free(new_node);
+		_dom_node_free(new_node);
 		return err;
 	}
 
@@ -72,7 +72,7 @@ dom_exception _dom_html_element_get_elements_by_tag_name_ns(
 /* The protected virtual functions */
 void _dom_html_element_destroy(dom_node_internal *node);
 dom_exception _dom_html_element_copy(dom_node_internal *old,
-		dom_node_internal **copy);
+		struct dom_document *doc, dom_node_internal **copy);
 
 #define DOM_ELEMENT_VTABLE_HTML_ELEMENT \
 	_dom_element_get_tag_name, \
@@ -164,5 +164,40 @@ dom_exception _dom_html_element_copy_internal(dom_html_element *old,
 
 extern const struct dom_html_element_vtable _dom_html_element_vtable;
 
+/**
+ * Test whether a node is an HTML element
+ *
+ * \param node  The node
+ * \return true if ::node was created as an element of an HTML document,
+ *         false otherwise.
+ */
+static inline bool _dom_html_node_is_element(
+		const struct dom_node_internal *node)
+{
+	return node->type == DOM_ELEMENT_NODE &&
+			node->base.vtable == &_dom_html_element_vtable;
+}
+
+/**
+ * Get the type of an HTML element, from any node
+ *
+ * \param node  The node
+ * \return the element's type, or DOM_HTML_ELEMENT_TYPE__UNKNOWN if the
+ *         node is not an HTML element.
+ *
+ * This reads the type stored when the element was created, in place of
+ * comparing the node's name with each name it might have.  Elements of
+ * other document types, which may have been adopted into an HTML
+ * document, are never of a known type.
+ */
+static inline dom_html_element_type _dom_html_node_get_element_type(
+		const struct dom_node_internal *node)
+{
+	if (_dom_html_node_is_element(node) == false)
+		return DOM_HTML_ELEMENT_TYPE__UNKNOWN;
+
+	return ((const struct dom_html_element *) node)->type;
+}
+
 #endif
 
@@ -7,6 +7,7 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <dom/html/html_form_element.h>
 
@@ -19,6 +20,7 @@
 #include "html/html_collection.h"
 #include "html/html_document.h"
 
+#include "core/document.h"
 #include "core/node.h"
 #include "utils/utils.h"
 
@@ -29,7 +31,10 @@ static const struct dom_element_protected_vtable _protect_vtable = {
 	DOM_HTML_FORM_ELEMENT_PROTECT_VTABLE
 };
 
-static bool _dom_is_form_control(struct dom_node_internal *node, void *ctx);
+static dom_exception _dom_html_form_element_list_controls(
+		struct dom_html_collection *col, void *ctx);
+static void _dom_html_form_element_clear_control(
+		struct dom_html_element *control);
 
 /**
  * Create a dom_html_form_element object
@@ -44,7 +49,8 @@ dom_exception _dom_html_form_element_create(
 {
 	struct dom_node_internal *node;
 
-	*ele = malloc(sizeof(dom_html_form_element));
+	*ele = _dom_node_alloc(&params->doc->base,
+			sizeof(dom_html_form_element));
 	if (*ele == NULL)
 		return DOM_NO_MEM_ERR;
 	
@@ -69,6 +75,10 @@ dom_exception _dom_html_form_element_initialise(
 {
 	dom_exception err;
 
+	ele->controls = NULL;
+	ele->n_controls = 0;
+	ele->alloc_controls = 0;
+
 	err = _dom_html_element_initialise(params, &ele->base);
 	
 	return err;
@@ -81,6 +91,16 @@ dom_exception _dom_html_form_element_initialise(
  */
 void _dom_html_form_element_finalise(struct dom_html_form_element *ele)
 {
+	uint32_t i;
+
+	/* The controls may outlive the form, so disassociate them */
+	for (i = 0; i < ele->n_controls; i++)
+		_dom_html_form_element_clear_control(ele->controls[i]);
+
+	free(ele->controls);
+	ele->controls = NULL;
+	ele->n_controls = 0;
+	ele->alloc_controls = 0;
 
 	_dom_html_element_finalise(&ele->base);
 }
@@ -93,7 +113,7 @@ void _dom_html_form_element_finalise(struct dom_html_form_element *ele)
 void _dom_html_form_element_destroy(struct dom_html_form_element *ele)
 {
 	_dom_html_form_element_finalise(ele);
-	free(ele);
+	_dom_node_free(ele);
 }
 
 /*------------------------------------------------------------------------*/
@@ -122,18 +142,19 @@ void _dom_virtual_html_form_element_destroy(dom_node_internal *node)
 
 /* The virtual copy function, see src/core/node.c for detail */
 dom_exception _dom_html_form_element_copy(
-		dom_node_internal *old, dom_node_internal **copy)
+		dom_node_internal *old, struct dom_document *doc,
+		dom_node_internal **copy)
 {
 	dom_html_form_element *new_node;
 	dom_exception err;
 
-	new_node = malloc(sizeof(dom_html_form_element));
+	new_node = _dom_node_alloc(doc, sizeof(dom_html_form_element));
 	if (new_node == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_html_form_element_copy_internal(old, new_node);
 	if (err != DOM_NO_ERR) {
-		free(new_node);
+		_dom_node_free(new_node);
 		return err;
 	}
 
@@ -153,9 +174,75 @@ dom_exception _dom_html_form_element_copy_internal(
 		return err;
 	}
 
+	/* The copy's descendants are not associated with it */
+	new->controls = NULL;
+	new->n_controls = 0;
+	new->alloc_controls = 0;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Associate a form control with a form
+ *
+ * \param form     The form
+ * \param control  The form control, which is not already associated
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ *
+ * This is called by the form controls when their form is set, and
+ * doesn't update the control itself.
+ */
+dom_exception _dom_html_form_element_add_control(
+		struct dom_html_form_element *form,
+		struct dom_html_element *control)
+{
+	if (form->n_controls == form->alloc_controls) {
+		struct dom_html_element **controls;
+		uint32_t alloc = form->alloc_controls == 0 ?
+				8 : form->alloc_controls * 2;
+
+		controls = realloc(form->controls,
+				alloc * sizeof(*controls));
+		if (controls == NULL)
+			return DOM_NO_MEM_ERR;
+
+		form->controls = controls;
+		form->alloc_controls = alloc;
+	}
+
+	form->controls[form->n_controls++] = control;
+
 	return DOM_NO_ERR;
 }
 
+/**
+ * Disassociate a form control from a form
+ *
+ * \param form     The form
+ * \param control  The form control
+ *
+ * This is called by the form controls when their form is changed or they
+ * are destroyed, and doesn't update the control itself.
+ */
+void _dom_html_form_element_remove_control(
+		struct dom_html_form_element *form,
+		struct dom_html_element *control)
+{
+	uint32_t i;
+
+	/* Controls tend to be removed in the reverse of the order in which
+	 * they were added, so search from the end */
+	for (i = form->n_controls; i > 0; i--) {
+		if (form->controls[i - 1] == control) {
+			memmove(&form->controls[i - 1], &form->controls[i],
+					(form->n_controls - i) *
+					sizeof(*form->controls));
+			form->n_controls--;
+			return;
+		}
+	}
+}
+
 /*-----------------------------------------------------------------------*/
 /* Public APIs */
 
@@ -173,9 +260,9 @@ dom_exception dom_html_form_element_get_elements(dom_html_form_element *ele,
 	dom_html_document *doc = (dom_html_document *) dom_node_get_owner(ele);
 	
 	assert(doc != NULL);
-	err = _dom_html_collection_create(doc,
-					  (dom_node_internal *) doc,
-					  _dom_is_form_control, ele, col);
+	err = _dom_html_collection_create_listed(doc,
+			(dom_node_internal *) ele,
+			_dom_html_form_element_list_controls, ele, col);
 	return err;
 }
 
@@ -189,23 +276,20 @@ dom_exception dom_html_form_element_get_elements(dom_html_form_element *ele,
 dom_exception dom_html_form_element_get_length(dom_html_form_element *ele,
 		uint32_t *len)
 {
-	dom_exception err;
-	dom_html_document *doc = (dom_html_document *) dom_node_get_owner(ele);
-	dom_html_collection *col;
-	
+	dom_document *doc = dom_node_get_owner(ele);
+	uint32_t i, n = 0;
+
 	assert(doc != NULL);
-	err = _dom_html_collection_create(doc,
-					  (dom_node_internal *) doc,
-					  _dom_is_form_control, ele, &col);
-	if (err != DOM_NO_ERR)
-		return err;
 
+	for (i = 0; i < ele->n_controls; i++) {
+		if (_dom_document_contains(doc,
+				(dom_node_internal *) ele->controls[i]))
+			n++;
+	}
 
-	err = dom_html_collection_get_length(col, len);
-	
-	dom_html_collection_unref(col);
-	
-	return err;
+	*len = n;
+
+	return DOM_NO_ERR;
 }
 
 #define SIMPLE_GET_SET(attr)						\
@@ -297,32 +381,84 @@ dom_exception dom_html_form_element_reset(dom_html_form_element *ele)
 /*-----------------------------------------------------------------------*/
 /* Internal functions */
 
-/* Callback function to test whether certain node is a form control, see 
- * src/html/html_collection.h for detail. */
-static bool _dom_is_form_control(struct dom_node_internal *node, void *ctx)
+/* Callback for qsort, to put form controls in document order */
+static int _dom_html_form_element_compare_controls(const void *a,
+		const void *b)
+{
+	dom_node_internal *na = *(dom_node_internal * const *) a;
+	dom_node_internal *nb = *(dom_node_internal * const *) b;
+
+	if (na == nb)
+		return 0;
+
+	return _dom_document_precedes(na, nb) ? -1 : 1;
+}
+
+/* Callback function to list a form's controls, see
+ * src/html/html_collection.h for detail.
+ *
+ * Only the controls in the document are listed.  They are put in document
+ * order, which rarely changes once they've been sorted, so the list is
+ * checked before it is sorted again. */
+static dom_exception _dom_html_form_element_list_controls(
+		struct dom_html_collection *col, void *ctx)
 {
-	struct dom_html_document *doc =
-		(struct dom_html_document *)(node->owner);
 	struct dom_html_form_element *form = ctx;
+	dom_document *doc = dom_node_get_owner(form);
+	dom_node_internal **controls = (dom_node_internal **) form->controls;
+	uint32_t i, n = 0;
+	dom_exception err;
 
-	
-	assert(node->type == DOM_ELEMENT_NODE);
-	
-        /* Form controls are INPUT TEXTAREA SELECT and BUTTON*/
-        if (dom_string_caseless_isequal(node->name,
-					doc->elements[DOM_HTML_ELEMENT_TYPE_INPUT]))
-		return ((dom_html_input_element *)node)->form == form;
-	if (dom_string_caseless_isequal(node->name,
-					doc->elements[DOM_HTML_ELEMENT_TYPE_TEXTAREA]))
-		return ((dom_html_text_area_element *)node)->form == form;
-	if (dom_string_caseless_isequal(node->name,
-					doc->elements[DOM_HTML_ELEMENT_TYPE_SELECT]))
-		return ((dom_html_select_element *)node)->form == form;
-	if (dom_string_caseless_isequal(node->name,
-					doc->elements[DOM_HTML_ELEMENT_TYPE_BUTTON])) {
-		return ((dom_html_button_element *)node)->form == form;
+	/* Move the controls in the document to the front */
+	for (i = 0; i < form->n_controls; i++) {
+		dom_node_internal *control = controls[i];
+
+		if (_dom_document_contains(doc, control)) {
+			controls[i] = controls[n];
+			controls[n++] = control;
+		}
+	}
+
+	for (i = 1; i < n; i++) {
+		if (_dom_document_precedes(controls[i], controls[i - 1])) {
+			qsort(controls, n, sizeof(*controls),
+					_dom_html_form_element_compare_controls);
+			break;
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		err = _dom_html_collection_append(col, controls[i]);
+		if (err != DOM_NO_ERR)
+			return err;
 	}
 
-	return false;
+	return DOM_NO_ERR;
 }
 
+/**
+ * Clear a form control's form, when the form is destroyed
+ *
+ * \param control  The form control
+ */
+static void _dom_html_form_element_clear_control(
+		struct dom_html_element *control)
+{
+	switch (control->type) {
+	case DOM_HTML_ELEMENT_TYPE_INPUT:
+		((dom_html_input_element *) control)->form = NULL;
+		break;
+	case DOM_HTML_ELEMENT_TYPE_TEXTAREA:
+		((dom_html_text_area_element *) control)->form = NULL;
+		break;
+	case DOM_HTML_ELEMENT_TYPE_SELECT:
+		((dom_html_select_element *) control)->form = NULL;
+		break;
+	case DOM_HTML_ELEMENT_TYPE_BUTTON:
+		((dom_html_button_element *) control)->form = NULL;
+		break;
+	default:
+		assert("Not a form control" == NULL);
+		break;
+	}
+}
@@ -17,6 +17,12 @@ struct dom_html_collection;
 struct dom_html_form_element {
 	struct dom_html_element base;
 			/**< The base class */
+
+	struct dom_html_element **controls;
+			/**< The form controls associated with the form,
+			 * in no particular order */
+	uint32_t n_controls;	/**< The number of associated controls */
+	uint32_t alloc_controls;	/**< The allocated size of controls */
 };
 
 /* Create a dom_html_form_element object */
@@ -35,13 +41,21 @@ void _dom_html_form_element_finalise(struct dom_html_form_element *ele);
 /* Destroy a dom_html_form_element object */
 void _dom_html_form_element_destroy(struct dom_html_form_element *ele);
 
+/* Maintain the form's list of associated form controls */
+dom_exception _dom_html_form_element_add_control(
+		struct dom_html_form_element *form,
+		struct dom_html_element *control);
+void _dom_html_form_element_remove_control(
+		struct dom_html_form_element *form,
+		struct dom_html_element *control);
+
 /* The protected virtual functions */
 dom_exception _dom_html_form_element_parse_attribute(dom_element *ele,
 		dom_string *name, dom_string *value,
 		dom_string **parsed);
 void _dom_virtual_html_form_element_destroy(dom_node_internal *node);
 dom_exception _dom_html_form_element_copy(dom_node_internal *old,
-		dom_node_internal **copy);
+		struct dom_document *doc, dom_node_internal **copy);
 
 #define DOM_HTML_FORM_ELEMENT_PROTECT_VTABLE \
 	_dom_html_form_element_parse_attribute
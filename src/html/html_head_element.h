@@ -39,7 +39,7 @@ dom_exception _dom_html_head_element_parse_attribute(dom_element *ele,
 		dom_string **parsed);
 void _dom_virtual_html_head_element_destroy(dom_node_internal *node);
 dom_exception _dom_html_head_element_copy(dom_node_internal *old,
-		dom_node_internal **copy);
+		struct dom_document *doc, dom_node_internal **copy);
 
 #define DOM_HTML_HEAD_ELEMENT_PROTECT_VTABLE \
 	_dom_html_head_element_parse_attribute
@@ -11,6 +11,7 @@
 #include <dom/html/html_input_element.h>
 
 #include "html/html_document.h"
+#include "html/html_form_element.h"
 #include "html/html_input_element.h"
 
 #include "core/node.h"
@@ -37,7 +38,8 @@ dom_exception _dom_html_input_element_create(
 {
 	struct dom_node_internal *node;
 
-	*ele = malloc(sizeof(dom_html_input_element));
+	*ele = _dom_node_alloc(&params->doc->base,
+			sizeof(dom_html_input_element));
 	if (*ele == NULL)
 		return DOM_NO_MEM_ERR;
 
@@ -78,6 +80,12 @@ dom_exception _dom_html_input_element_initialise(
  */
 void _dom_html_input_element_finalise(struct dom_html_input_element *ele)
 {
+	if (ele->form != NULL) {
+		_dom_html_form_element_remove_control(ele->form,
+				(struct dom_html_element *) ele);
+		ele->form = NULL;
+	}
+
 	if (ele->default_value != NULL) {
 		dom_string_unref(ele->default_value);
 		ele->default_value = NULL;
@@ -94,7 +102,7 @@ void _dom_html_input_element_finalise(struct dom_html_input_element *ele)
 void _dom_html_input_element_destroy(struct dom_html_input_element *ele)
 {
 	_dom_html_input_element_finalise(ele);
-	free(ele);
+	_dom_node_free(ele);
 }
 
 /*-----------------------------------------------------------------------*/
@@ -304,18 +312,19 @@ void _dom_virtual_html_input_element_destroy(dom_node_internal *node)
 
 /* The virtual copy function, see src/core/node.c for detail */
 dom_exception _dom_html_input_element_copy(
-		dom_node_internal *old, dom_node_internal **copy)
+		dom_node_internal *old, struct dom_document *doc,
+		dom_node_internal **copy)
 {
 	dom_html_input_element *new_node;
 	dom_exception err;
 
-	new_node = malloc(sizeof(dom_html_input_element));
+	new_node = _dom_node_alloc(doc, sizeof(dom_html_input_element));
 	if (new_node == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_html_input_element_copy_internal(old, new_node);
 	if (err != DOM_NO_ERR) {
-		free(new_node);
+		_dom_node_free(new_node);
 		return err;
 	}
 
@@ -335,9 +344,16 @@ dom_exception _dom_html_input_element_copy_internal(
 		return err;
 	}
 
-	/* TODO: We don't seem to keep a ref to form element, so just
-	 *       copy the pointer for now. */
-	new->form = old->form;
+	/* The copy belongs to the same form.
+	 * TODO: We don't seem to keep a ref to form element. */
+	new->form = NULL;
+	if (old->form != NULL) {
+		err = _dom_html_form_element_add_control(old->form,
+				(struct dom_html_element *) new);
+		if (err != DOM_NO_ERR)
+			return err;
+		new->form = old->form;
+	}
 
 	new->default_checked = old->default_checked;
 	new->default_checked_set = old->default_checked_set;
@@ -455,8 +471,28 @@ dom_exception dom_html_input_element_get_form(
 dom_exception _dom_html_input_element_set_form(
 	dom_html_input_element *input, dom_html_form_element *form)
 {
+	dom_exception err;
+
+	if (input->form == form)
+		return DOM_NO_ERR;
+
+	if (form != NULL) {
+		err = _dom_html_form_element_add_control(form,
+				(struct dom_html_element *) input);
+		if (err != DOM_NO_ERR)
+			return err;
+	}
+
+	if (input->form != NULL)
+		_dom_html_form_element_remove_control(input->form,
+				(struct dom_html_element *) input);
+
 	input->form = form;
 
+	/* This changes which form's elements collection we belong to */
+	_dom_document_element_changed(dom_node_get_owner(input),
+			(struct dom_element *) input);
+
 	return DOM_NO_ERR;
 }
 
@@ -35,7 +35,8 @@ dom_exception _dom_html_isindex_element_create(
 		struct dom_html_isindex_element **ele)
 {
 	struct dom_node_internal *node;
-	*ele = malloc(sizeof(dom_html_isindex_element));
+	*ele = _dom_node_alloc(&params->doc->base,
+			sizeof(dom_html_isindex_element));
 	if (*ele == NULL)
 		return DOM_NO_MEM_ERR;
 
@@ -79,7 +80,7 @@ void _dom_html_isindex_element_finalise(struct dom_html_isindex_element *ele)
 void _dom_html_isindex_element_destroy(struct dom_html_isindex_element *ele)
 {
 	_dom_html_isindex_element_finalise(ele);
-	free(ele);
+	_dom_node_free(ele);
 }
 
 /*------------------------------------------------------------------------*/
@@ -108,18 +109,20 @@ void _dom_virtual_html_isindex_element_destroy(dom_node_internal *node)
 
 /* The virtual copy function, see src/core/node.c for detail */
 dom_exception _dom_html_isindex_element_copy(
-		dom_node_internal *old, dom_node_internal **copy)
+		dom_node_internal *old, struct dom_document *doc,
+		dom_node_internal **copy)
 {
 	dom_html_isindex_element *new_node;
 	dom_exception err;
 
-	new_node = malloc(sizeof(dom_html_isindex_element));
+	new_node = _dom_node_alloc(doc,
+			sizeof(dom_html_isindex_element));
 	if (new_node == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_html_isindex_element_copy_internal(old, new_node);
 	if (err != DOM_NO_ERR) {
-		free(new_node);
+		_dom_node_free(new_node);
 		return err;
 	}
 
@@ -35,7 +35,8 @@ dom_exception _dom_html_label_element_create(
 {
 	struct dom_node_internal *node;
 
-	*ele = malloc(sizeof(dom_html_label_element));
+	*ele = _dom_node_alloc(&params->doc->base,
+			sizeof(dom_html_label_element));
 	if (*ele == NULL)
 		return DOM_NO_MEM_ERR;
 
@@ -79,7 +80,7 @@ void _dom_html_label_element_finalise(struct dom_html_label_element *ele)
 void _dom_html_label_element_destroy(struct dom_html_label_element *ele)
 {
 	_dom_html_label_element_finalise(ele);
-	free(ele);
+	_dom_node_free(ele);
 }
 
 /*------------------------------------------------------------------------*/
@@ -108,18 +109,19 @@ void _dom_virtual_html_label_element_destroy(dom_node_internal *node)
 
 /* The virtual copy function, see src/core/node.c for detail */
 dom_exception _dom_html_label_element_copy(
-		dom_node_internal *old, dom_node_internal **copy)
+		dom_node_internal *old, struct dom_document *doc,
+		dom_node_internal **copy)
 {
 	dom_html_label_element *new_node;
 	dom_exception err;
 
-	new_node = malloc(sizeof(dom_html_label_element));
+	new_node = _dom_node_alloc(doc, sizeof(dom_html_label_element));
 	if (new_node == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_html_label_element_copy_internal(old, new_node);
 	if (err != DOM_NO_ERR) {
-		free(new_node);
+		_dom_node_free(new_node);
 		return err;
 	}
 
@@ -152,15 +154,12 @@ dom_exception _dom_html_label_element_copy_internal(
 dom_exception dom_html_label_element_get_form(
 		dom_html_label_element *label, dom_html_form_element **form)
 {
-	dom_html_document *doc
-		= (dom_html_document *) ((dom_node_internal *) label)->owner;
 	dom_node_internal *form_tmp = ((dom_node_internal *) label)->parent;
 
 	/* Search ancestor chain for FIELDSET element */
 	while (form_tmp != NULL) {
-		if (form_tmp->type == DOM_ELEMENT_NODE &&
-				dom_string_caseless_isequal(form_tmp->name,
-					doc->elements[DOM_HTML_ELEMENT_TYPE_FORM]))
+		if (_dom_html_node_get_element_type(form_tmp) ==
+				DOM_HTML_ELEMENT_TYPE_FORM)
 			break;
 
 		form_tmp = form_tmp->parent;
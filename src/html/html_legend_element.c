@@ -39,7 +39,8 @@ dom_exception _dom_html_legend_element_create(
 {
 	struct dom_node_internal *node;
 
-	*ele = malloc(sizeof(dom_html_legend_element));
+	*ele = _dom_node_alloc(&params->doc->base,
+			sizeof(dom_html_legend_element));
 	if (*ele == NULL)
 		return DOM_NO_MEM_ERR;
 
@@ -83,7 +84,7 @@ void _dom_html_legend_element_finalise(struct dom_html_legend_element *ele)
 void _dom_html_legend_element_destroy(struct dom_html_legend_element *ele)
 {
 	_dom_html_legend_element_finalise(ele);
-	free(ele);
+	_dom_node_free(ele);
 }
 
 /**
@@ -96,15 +97,12 @@ void _dom_html_legend_element_destroy(struct dom_html_legend_element *ele)
 dom_exception dom_html_legend_element_get_form(
 	dom_html_legend_element *legend, dom_html_form_element **form)
 {
-	dom_html_document *doc
-		= (dom_html_document *) ((dom_node_internal *) legend)->owner;
 	dom_node_internal *field_set = ((dom_node_internal *) legend)->parent;
 
 	/* Search ancestor chain for FIELDSET element */
 	while (field_set != NULL) {
-		if (field_set->type == DOM_ELEMENT_NODE &&
-				dom_string_caseless_isequal(field_set->name,
-						doc->elements[DOM_HTML_ELEMENT_TYPE_FIELDSET]))
+		if (_dom_html_node_get_element_type(field_set) ==
+				DOM_HTML_ELEMENT_TYPE_FIELDSET)
 			break;
 
 		field_set = field_set->parent;
@@ -145,18 +143,19 @@ void _dom_virtual_html_legend_element_destroy(dom_node_internal *node)
 
 /* The virtual copy function, see src/core/node.c for detail */
 dom_exception _dom_html_legend_element_copy(
-		dom_node_internal *old, dom_node_internal **copy)
+		dom_node_internal *old, struct dom_document *doc,
+		dom_node_internal **copy)
 {
 	dom_html_legend_element *new_node;
 	dom_exception err;
 
-	new_node = malloc(sizeof(dom_html_legend_element));
+	new_node = _dom_node_alloc(doc, sizeof(dom_html_legend_element));
 	if (new_node == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_html_legend_element_copy_internal(old, new_node);
 	if (err != DOM_NO_ERR) {
-		free(new_node);
+		_dom_node_free(new_node);
 		return err;
 	}
 
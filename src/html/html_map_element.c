@@ -39,7 +39,8 @@ dom_exception _dom_html_map_element_create(
 {
 	struct dom_node_internal *node;
 
-	*ele = malloc(sizeof(dom_html_map_element));
+	*ele = _dom_node_alloc(&params->doc->base,
+			sizeof(dom_html_map_element));
 	if (*ele == NULL)
 		return DOM_NO_MEM_ERR;
 
@@ -83,7 +84,7 @@ void _dom_html_map_element_finalise(struct dom_html_map_element *ele)
 void _dom_html_map_element_destroy(struct dom_html_map_element *ele)
 {
 	_dom_html_map_element_finalise(ele);
-	free(ele);
+	_dom_node_free(ele);
 }
 
 
@@ -113,18 +114,19 @@ void _dom_virtual_html_map_element_destroy(dom_node_internal *node)
 
 /* The virtual copy function, see src/core/node.c for detail */
 dom_exception _dom_html_map_element_copy(
-		dom_node_internal *old, dom_node_internal **copy)
+		dom_node_internal *old, struct dom_document *doc,
+		dom_node_internal **copy)
 {
 	dom_html_map_element *new_node;
 	dom_exception err;
 
-	new_node = malloc(sizeof(dom_html_map_element));
+	new_node = _dom_node_alloc(doc, sizeof(dom_html_map_element));
 	if (new_node == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_html_map_element_copy_internal(old, new_node);
 	if (err != DOM_NO_ERR) {
-		free(new_node);
+		_dom_node_free(new_node);
 		return err;
 	}
 
@@ -192,14 +194,10 @@ SIMPLE_GET_SET(name);
 /* The callback function for  _dom_html_collection_create*/
 static bool callback(struct dom_node_internal *node, void *ctx)
 {
-	if(node->type == DOM_ELEMENT_NODE &&
-			dom_string_caseless_isequal(node->name,
-				((dom_html_document *)ctx)->elements[DOM_HTML_ELEMENT_TYPE_AREA]))
-	{
-		return true;
-	}
+	UNUSED(ctx);
 
-	return false;
+	return _dom_html_node_get_element_type(node) ==
+			DOM_HTML_ELEMENT_TYPE_AREA;
 }
 
 /**
@@ -215,8 +213,7 @@ dom_exception dom_html_map_element_get_areas(
 {
 	dom_html_document *doc
 		= (dom_html_document *) ((dom_node_internal *) ele)->owner;
-	
-	/*doc is passed as a parameter to callback to avoid repeated calculations */
+
 	return _dom_html_collection_create(doc, (dom_node_internal *) ele,
-			callback, (void *) doc, areas);
+			callback, NULL, areas);
 }
@@ -40,7 +40,8 @@ dom_exception _dom_html_object_element_create(
 {
 	struct dom_node_internal *node;
 
-	*ele = malloc(sizeof(dom_html_object_element));
+	*ele = _dom_node_alloc(&params->doc->base,
+			sizeof(dom_html_object_element));
 	if (*ele == NULL)
 		return DOM_NO_MEM_ERR;
 
@@ -84,7 +85,7 @@ void _dom_html_object_element_finalise(struct dom_html_object_element *ele)
 void _dom_html_object_element_destroy(struct dom_html_object_element *ele)
 {
 	_dom_html_object_element_finalise(ele);
-	free(ele);
+	_dom_node_free(ele);
 }
 
 /*------------------------------------------------------------------------*/
@@ -113,18 +114,19 @@ void _dom_virtual_html_object_element_destroy(dom_node_internal *node)
 
 /* The virtual copy function, see src/core/node.c for detail */
 dom_exception _dom_html_object_element_copy(
-		dom_node_internal *old, dom_node_internal **copy)
+		dom_node_internal *old, struct dom_document *doc,
+		dom_node_internal **copy)
 {
 	dom_html_object_element *new_node;
 	dom_exception err;
 
-	new_node = malloc(sizeof(dom_html_object_element));
+	new_node = _dom_node_alloc(doc, sizeof(dom_html_object_element));
 	if (new_node == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_html_object_element_copy_internal(old, new_node);
 	if (err != DOM_NO_ERR) {
-		free(new_node);
+		_dom_node_free(new_node);
 		return err;
 	}
 
@@ -260,14 +262,11 @@ dom_exception dom_html_object_element_set_declare(dom_html_object_element *ele,
 dom_exception dom_html_object_element_get_form(
 		dom_html_object_element *object, dom_html_form_element **form)
 {
-	dom_html_document *doc
-		= (dom_html_document *) ((dom_node_internal *) object)->owner;
 	dom_node_internal *form_tmp = ((dom_node_internal *) object)->parent;
 
 	while (form_tmp != NULL) {
-		if (form_tmp->type == DOM_ELEMENT_NODE &&
-				dom_string_caseless_isequal(form_tmp->name,
-					doc->elements[DOM_HTML_ELEMENT_TYPE_FORM]))
+		if (_dom_html_node_get_element_type(form_tmp) ==
+				DOM_HTML_ELEMENT_TYPE_FORM)
 			break;
 
 		form_tmp = form_tmp->parent;
@@ -14,6 +14,7 @@
 
 #include "html/html_document.h"
 #include "html/html_option_element.h"
+#include "html/html_select_element.h"
 
 #include "core/node.h"
 #include "core/attr.h"
@@ -39,7 +40,8 @@ dom_exception _dom_html_option_element_create(
 {
 	struct dom_node_internal *node;
 
-	*ele = malloc(sizeof(dom_html_option_element));
+	*ele = _dom_node_alloc(&params->doc->base,
+			sizeof(dom_html_option_element));
 	if (*ele == NULL)
 		return DOM_NO_MEM_ERR;
 
@@ -64,6 +66,9 @@ dom_exception _dom_html_option_element_initialise(
 {
 	ele->default_selected = false;
 	ele->default_selected_set = false;
+	ele->select = NULL;
+	ele->index = 0;
+	ele->index_generation = 0;
 
 	return _dom_html_element_initialise(params, &ele->base);
 }
@@ -86,7 +91,7 @@ void _dom_html_option_element_finalise(struct dom_html_option_element *ele)
 void _dom_html_option_element_destroy(struct dom_html_option_element *ele)
 {
 	_dom_html_option_element_finalise(ele);
-	free(ele);
+	_dom_node_free(ele);
 }
 
 /*-----------------------------------------------------------------------*/
@@ -95,16 +100,12 @@ void _dom_html_option_element_destroy(struct dom_html_option_element *ele)
 dom_exception dom_html_option_element_get_form(
 	dom_html_option_element *option, dom_html_form_element **form)
 {
-	dom_html_document *doc;
 	dom_node_internal *select = ((dom_node_internal *) option)->parent;
 
-	doc = (dom_html_document *) ((dom_node_internal *) option)->owner;
-
 	/* Search ancestor chain for SELECT element */
 	while (select != NULL) {
-		if (select->type == DOM_ELEMENT_NODE &&
-				dom_string_caseless_isequal(select->name,
-						doc->elements[DOM_HTML_ELEMENT_TYPE_SELECT]))
+		if (_dom_html_node_get_element_type(select) ==
+				DOM_HTML_ELEMENT_TYPE_SELECT)
 			break;
 
 		select = select->parent;
@@ -246,24 +247,42 @@ dom_exception dom_html_option_element_get_text(
 }
 
 /**
- * Obtain the index of this option in its parent
+ * Obtain the index of this option in its select element's list of options
  * 
  * \param option  The dom_html_option_element object
  * \param index   Pointer to receive zero-based index
  * \return DOM_NO_ERR on success, appropriate error otherwise.
+ *
+ * An option which isn't in a select, directly or through an optgroup, is
+ * numbered among the options which are its siblings.
  */
 dom_exception dom_html_option_element_get_index(
 	dom_html_option_element *option, int32_t *index)
 {
-	dom_html_document *doc = (dom_html_document *) dom_node_get_owner(option);
 	int32_t idx = 0;
-	dom_node_internal *n = ((dom_node_internal *)option)->parent;
+	dom_node_internal *parent = ((dom_node_internal *)option)->parent;
+	dom_node_internal *n = parent;
+
+	if (n != NULL && _dom_html_node_get_element_type(n) ==
+			DOM_HTML_ELEMENT_TYPE_OPTGROUP)
+		n = n->parent;
+
+	if (n != NULL && _dom_html_node_get_element_type(n) ==
+			DOM_HTML_ELEMENT_TYPE_SELECT)
+		return _dom_html_select_element_get_option_index(
+				(dom_html_select_element *) n, option, index);
+
+	*index = 0;
+
+	if (parent == NULL)
+		return DOM_NO_ERR;
 
-	for(n = n->first_child;n != NULL; n = n->next) {
+	for(n = parent->first_child;n != NULL; n = n->next) {
 		if((dom_node_internal *)option == n) {
 			*index = idx;
 			break;
-		} else if(dom_string_caseless_isequal(n->name,doc->elements[DOM_HTML_ELEMENT_TYPE_OPTION])) {
+		} else if(_dom_html_node_get_element_type(n) ==
+				DOM_HTML_ELEMENT_TYPE_OPTION) {
 			idx += 1;
 		}
 	}
@@ -446,18 +465,19 @@ void _dom_virtual_html_option_element_destroy(dom_node_internal *node)
 
 /* The virtual copy function, see src/core/node.c for detail */
 dom_exception _dom_html_option_element_copy(
-		dom_node_internal *old, dom_node_internal **copy)
+		dom_node_internal *old, struct dom_document *doc,
+		dom_node_internal **copy)
 {
 	dom_html_option_element *new_node;
 	dom_exception err;
 
-	new_node = malloc(sizeof(dom_html_option_element));
+	new_node = _dom_node_alloc(doc, sizeof(dom_html_option_element));
 	if (new_node == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_html_option_element_copy_internal(old, new_node);
 	if (err != DOM_NO_ERR) {
-		free(new_node);
+		_dom_node_free(new_node);
 		return err;
 	}
 
@@ -479,6 +499,9 @@ dom_exception _dom_html_option_element_copy_internal(
 
 	new->default_selected = old->default_selected;
 	new->default_selected_set = old->default_selected_set;
+	new->select = NULL;
+	new->index = 0;
+	new->index_generation = 0;
 
 	return DOM_NO_ERR;
 }
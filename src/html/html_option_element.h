@@ -17,6 +17,14 @@ struct dom_html_option_element {
 			/**< The base class */
 	bool default_selected; /**< Initial selected value */
 	bool default_selected_set; /**< Whether default_selected has been set */
+
+	struct dom_html_select_element *select;
+			/**< The select whose options last included this
+			 * option, or NULL */
+	uint32_t index;	/**< The option's index in select's options, valid
+			 * if index_generation matches select's options */
+	uint64_t index_generation;
+			/**< The document's tree generation when indexed */
 };
 
 /* Create a dom_html_option_element object */
@@ -41,7 +49,7 @@ dom_exception _dom_html_option_element_parse_attribute(dom_element *ele,
 		dom_string **parsed);
 void _dom_virtual_html_option_element_destroy(dom_node_internal *node);
 dom_exception _dom_html_option_element_copy(dom_node_internal *old,
-		dom_node_internal **copy);
+		struct dom_document *doc, dom_node_internal **copy);
 
 #define DOM_HTML_OPTION_ELEMENT_PROTECT_VTABLE \
 	_dom_html_option_element_parse_attribute
@@ -12,6 +12,8 @@
 #include <dom/html/html_options_collection.h>
 
 #include "html/html_document.h"
+#include "html/html_form_element.h"
+#include "html/html_option_element.h"
 #include "html/html_select_element.h"
 
 #include "core/node.h"
@@ -25,6 +27,10 @@ static const struct dom_element_protected_vtable _protect_vtable = {
 };
 
 static bool is_option(struct dom_node_internal *node, void *ctx);
+static dom_exception _dom_html_select_element_update_options(
+		dom_html_select_element *ele);
+static dom_exception _dom_html_select_element_update_selected(
+		dom_html_select_element *ele);
 
 /**
  * Create a dom_html_select_element object
@@ -39,7 +45,8 @@ dom_exception _dom_html_select_element_create(
 {
 	struct dom_node_internal *node;
 
-	*ele = malloc(sizeof(dom_html_select_element));
+	*ele = _dom_node_alloc(&params->doc->base,
+			sizeof(dom_html_select_element));
 	if (*ele == NULL)
 		return DOM_NO_MEM_ERR;
 	
@@ -64,6 +71,16 @@ dom_exception _dom_html_select_element_initialise(
 {
 	ele->form = NULL;
 
+	ele->options = NULL;
+	ele->n_options = 0;
+	ele->alloc_options = 0;
+	ele->options_valid = false;
+	ele->options_generation = 0;
+
+	ele->selected = -1;
+	ele->selected_valid = false;
+	ele->selected_generation = 0;
+
 	return _dom_html_element_initialise(params, &ele->base);
 }
 
@@ -74,6 +91,15 @@ dom_exception _dom_html_select_element_initialise(
  */
 void _dom_html_select_element_finalise(struct dom_html_select_element *ele)
 {
+	if (ele->form != NULL) {
+		_dom_html_form_element_remove_control(ele->form,
+				(struct dom_html_element *) ele);
+		ele->form = NULL;
+	}
+
+	free(ele->options);
+	ele->options = NULL;
+
 	_dom_html_element_finalise(&ele->base);
 }
 
@@ -85,7 +111,7 @@ void _dom_html_select_element_finalise(struct dom_html_select_element *ele)
 void _dom_html_select_element_destroy(struct dom_html_select_element *ele)
 {
 	_dom_html_select_element_finalise(ele);
-	free(ele);
+	_dom_node_free(ele);
 }
 
 /*------------------------------------------------------------------------*/
@@ -114,18 +140,19 @@ void _dom_virtual_html_select_element_destroy(dom_node_internal *node)
 
 /* The virtual copy function, see src/core/node.c for detail */
 dom_exception _dom_html_select_element_copy(
-		dom_node_internal *old, dom_node_internal **copy)
+		dom_node_internal *old, struct dom_document *doc,
+		dom_node_internal **copy)
 {
 	dom_html_select_element *new_node;
 	dom_exception err;
 
-	new_node = malloc(sizeof(dom_html_select_element));
+	new_node = _dom_node_alloc(doc, sizeof(dom_html_select_element));
 	if (new_node == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_html_select_element_copy_internal(old, new_node);
 	if (err != DOM_NO_ERR) {
-		free(new_node);
+		_dom_node_free(new_node);
 		return err;
 	}
 
@@ -145,11 +172,27 @@ dom_exception _dom_html_select_element_copy_internal(
 		return err;
 	}
 
-	/* TODO: We don't seem to keep a ref to form element, so just
-	 *       copy the pointer for now. */
-	new->form = old->form;
+	/* The copy belongs to the same form.
+	 * TODO: We don't seem to keep a ref to form element. */
+	new->form = NULL;
+	if (old->form != NULL) {
+		err = _dom_html_form_element_add_control(old->form,
+				(struct dom_html_element *) new);
+		if (err != DOM_NO_ERR)
+			return err;
+		new->form = old->form;
+	}
+
+	/* The copy's options are found when they are first needed */
+	new->options = NULL;
+	new->n_options = 0;
+	new->alloc_options = 0;
+	new->options_valid = false;
+	new->options_generation = 0;
 
-	new->selected = old->selected;
+	new->selected = -1;
+	new->selected_valid = false;
+	new->selected_generation = 0;
 
 	return DOM_NO_ERR;
 }
@@ -207,50 +250,13 @@ dom_exception dom_html_select_element_get_selected_index(
 		dom_html_select_element *ele, int32_t *index)
 {
 	dom_exception err;
-	uint32_t idx,len;
-	dom_node *option;
-	bool selected;
-	dom_html_options_collection *col;
 
-	err = _dom_html_select_element_make_collection(ele, &col);
-	if (err != DOM_NO_ERR) {
-		return err;
-	}
-
-	err = dom_html_options_collection_get_length(col, &len);
-	if (err != DOM_NO_ERR) {
-		dom_html_options_collection_unref(col);
+	err = _dom_html_select_element_update_selected(ele);
+	if (err != DOM_NO_ERR)
 		return err;
-	}
-
-	for (idx = 0; idx < len; idx++) {
-		err = dom_html_options_collection_item(col,
-				idx, &option);
-		if (err != DOM_NO_ERR) {
-			dom_html_options_collection_unref(col);
-			return err;
-		}
-
-		err = dom_html_option_element_get_selected(
-				(dom_html_option_element *) option, &selected);
-
-		dom_node_unref(option);
-
-		if (err != DOM_NO_ERR) {
-			dom_html_options_collection_unref(col);
-			return err;
-		}
-
-		if (selected) {
-			*index = idx;
-			dom_html_options_collection_unref(col);
-			return DOM_NO_ERR;
-		}
-	}
 
-	*index = -1;
+	*index = ele->selected;
 
-	dom_html_options_collection_unref(col);
 	return DOM_NO_ERR;
 }
 
@@ -265,32 +271,15 @@ dom_exception dom_html_select_element_set_selected_index(
 		dom_html_select_element *ele, int32_t index)
 {
 	dom_exception err;
-	dom_node *option;
-	dom_html_options_collection *col;
 
-	err = _dom_html_select_element_make_collection(ele, &col);
-	if (err != DOM_NO_ERR) {
-		return err;
-	}
-
-	err = dom_html_options_collection_item(col,
-			index, &option);
-	if (err != DOM_NO_ERR) {
-		dom_html_options_collection_unref(col);
+	err = _dom_html_select_element_update_options(ele);
+	if (err != DOM_NO_ERR)
 		return err;
-	}
-
-	err = dom_html_option_element_set_selected(
-			(dom_html_option_element *) option, true);
-
-	dom_node_unref(option);
 
-	dom_html_options_collection_unref(col);
-	if (err != DOM_NO_ERR) {
-		return err;
-	}
+	if (index < 0 || (uint32_t) index >= ele->n_options)
+		return DOM_NO_ERR;
 
-	return DOM_NO_ERR;
+	return dom_html_option_element_set_selected(ele->options[index], true);
 }
 
 /**
@@ -304,53 +293,18 @@ dom_exception dom_html_select_element_get_value(
 		dom_html_select_element *ele, dom_string **value)
 {
 	dom_exception err;
-	uint32_t idx, len;
-	dom_node *option;
-	bool selected;
-	dom_html_options_collection *col;
 
-	err = _dom_html_select_element_make_collection(ele, &col);
+	err = _dom_html_select_element_update_selected(ele);
 	if (err != DOM_NO_ERR)
 		return err;
 
-	err = dom_html_select_element_get_length(ele, &len);
-	if (err != DOM_NO_ERR) {
-		dom_html_options_collection_unref(col);
-		return err;
-	}
-
-	for (idx = 0; idx < len; idx++) {
-		err = dom_html_options_collection_item(col,
-				idx, &option);
-		if (err != DOM_NO_ERR) {
-			dom_html_options_collection_unref(col);
-			return err;
-		}
-
-		err = dom_html_option_element_get_selected(
-				(dom_html_option_element *) option, &selected);
-		if (err != DOM_NO_ERR) {
-			dom_html_options_collection_unref(col);
-			dom_node_unref(option);
-			return err;
-		}
-
-		if (selected) {
-			err = dom_html_option_element_get_value(
-					(dom_html_option_element *) option,
-					value);
-
-			dom_html_options_collection_unref(col);
-			dom_node_unref(option);
-
-			return err;
-		}
+	if (ele->selected < 0) {
+		*value = NULL;
+		return DOM_NO_ERR;
 	}
 
-	*value = NULL;
-	dom_html_options_collection_unref(col);
-
-	return DOM_NO_ERR;
+	return dom_html_option_element_get_value(ele->options[ele->selected],
+			value);
 }
 
 /**
@@ -364,53 +318,16 @@ dom_exception dom_html_select_element_set_value(
 		dom_html_select_element *ele, dom_string *value)
 {
 	dom_exception err;
-	uint32_t idx, len;
-	dom_node *option;
-	bool selected;
-	dom_html_options_collection *col;
 
-	err = _dom_html_select_element_make_collection(ele, &col);
+	err = _dom_html_select_element_update_selected(ele);
 	if (err != DOM_NO_ERR)
 		return err;
 
-	err = dom_html_select_element_get_length(ele, &len);
-	if (err != DOM_NO_ERR) {
-		dom_html_options_collection_unref(col);
-		return err;
-	}
-
-	for (idx = 0; idx < len; idx++) {
-		err = dom_html_options_collection_item(col,
-				idx, &option);
-		if (err != DOM_NO_ERR) {
-			dom_html_options_collection_unref(col);
-			return err;
-		}
-
-		err = dom_html_option_element_get_selected(
-				(dom_html_option_element *) option, &selected);
-		if (err != DOM_NO_ERR) {
-			dom_html_options_collection_unref(col);
-			dom_node_unref(option);
-			return err;
-		}
-
-		if (selected) {
-			err = dom_html_option_element_set_value(
-					(dom_html_option_element *) option,
-					value);
-
-			dom_html_options_collection_unref(col);
-			dom_node_unref(option);
-
-			return err;
-		}
-	}
-
-	dom_html_options_collection_unref(col);
-
-	return DOM_NO_ERR;
+	if (ele->selected < 0)
+		return DOM_NO_ERR;
 
+	return dom_html_option_element_set_value(ele->options[ele->selected],
+			value);
 }
 
 /**
@@ -424,17 +341,14 @@ dom_exception dom_html_select_element_get_length(
 		dom_html_select_element *ele, uint32_t *len)
 {
 	dom_exception err;
-	dom_html_options_collection *col;
-	
-	err = _dom_html_select_element_make_collection(ele, &col);
+
+	err = _dom_html_select_element_update_options(ele);
 	if (err != DOM_NO_ERR)
 		return err;
 
-	err = dom_html_options_collection_get_length(col, len);
-	
-	dom_html_options_collection_unref(col);
-	
-	return err;
+	*len = ele->n_options;
+
+	return DOM_NO_ERR;
 }
 
 /**
@@ -651,36 +565,23 @@ dom_exception dom_html_select_element_remove(dom_html_select_element *ele,
 		int32_t index)
 {
 	dom_exception err;
-	uint32_t len;
 	dom_node *option, *old_option;
-	dom_html_options_collection *col;
 
-	err = dom_html_select_element_get_length(ele, &len);
+	err = _dom_html_select_element_update_options(ele);
 	if (err != DOM_NO_ERR)
 		return err;
 
 	/* Ensure index is in range */
-	if (index < 0 || index >= (int32_t)len)
+	if (index < 0 || (uint32_t) index >= ele->n_options)
 		return DOM_NO_ERR;
 
-        err = _dom_html_select_element_make_collection(ele, &col);
-        if (err != DOM_NO_ERR)
-		return err;
-	
-	err = dom_html_options_collection_item(col, index, &option);
-	if (err != DOM_NO_ERR) {
-		dom_html_options_collection_unref(col);
-		return err;
-	}
+	option = (dom_node *) ele->options[index];
 
 	err = dom_node_remove_child(dom_node_get_parent(option),
 			option, &old_option);
 	if (err == DOM_NO_ERR)
 		dom_node_unref(old_option);
 
-	dom_node_unref(option);
-	dom_html_options_collection_unref(col);
-
 	return err;
 }
 
@@ -731,21 +632,190 @@ dom_exception dom_html_select_element_focus(struct dom_html_select_element *ele)
 /* Test whether certain node is an option node */
 bool is_option(struct dom_node_internal *node, void *ctx)
 {
-	dom_html_select_element *ele = ctx;
-	dom_html_document *doc = (dom_html_document *) dom_node_get_owner(ele);
+	UNUSED(ctx);
+
+	return _dom_html_node_get_element_type(node) ==
+			DOM_HTML_ELEMENT_TYPE_OPTION;
+}
+
+/**
+ * Ensure a select element's list of options is up to date
+ *
+ * \param ele  The select element
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ *
+ * The options are found by a depth first walk of the select, which is only
+ * repeated if the document's tree has changed since the last walk.  Each
+ * option found records its index, for
+ * _dom_html_select_element_get_option_index().
+ */
+dom_exception _dom_html_select_element_update_options(
+		dom_html_select_element *ele)
+{
+	struct dom_node_internal *root = (struct dom_node_internal *) ele;
+	struct dom_node_internal *node = root->first_child;
+	struct dom_document *doc = root->owner;
+	struct dom_html_option_element *option;
+
+	if (ele->options_valid &&
+			ele->options_generation == doc->tree_generation)
+		return DOM_NO_ERR;
+
+	ele->options_valid = false;
+	ele->selected_valid = false;
+	ele->n_options = 0;
+
+	while (node != NULL) {
+		if (node->type == DOM_ELEMENT_NODE && is_option(node, ele)) {
+			if (ele->n_options == ele->alloc_options) {
+				struct dom_html_option_element **options;
+				uint32_t alloc = ele->alloc_options == 0 ?
+						8 : ele->alloc_options * 2;
+
+				options = realloc(ele->options,
+						alloc * sizeof(*options));
+				if (options == NULL)
+					return DOM_NO_MEM_ERR;
+
+				ele->options = options;
+				ele->alloc_options = alloc;
+			}
+
+			option = (struct dom_html_option_element *) node;
+			option->select = ele;
+			option->index = ele->n_options;
+			option->index_generation = doc->tree_generation;
+
+			ele->options[ele->n_options++] = option;
+		}
+
+		/* Depth first iterating */
+		if (node->first_child != NULL) {
+			node = node->first_child;
+		} else {
+			while (node != root && node->next == NULL)
+				node = node->parent;
+
+			node = node == root ? NULL : node->next;
+		}
+	}
+
+	ele->options_valid = true;
+	ele->options_generation = doc->tree_generation;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Ensure a select element's selected option is up to date
+ *
+ * \param ele  The select element
+ * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
+ *
+ * The selected option is only looked for again if the options or any
+ * attribute have changed since it was last found.
+ */
+dom_exception _dom_html_select_element_update_selected(
+		dom_html_select_element *ele)
+{
+	struct dom_document *doc = dom_node_get_owner(ele);
+	dom_exception err;
+	uint32_t idx;
+	bool selected;
 
-	if (dom_string_isequal(node->name,
-			doc->elements[DOM_HTML_ELEMENT_TYPE_OPTION]))
-		return true;
+	err = _dom_html_select_element_update_options(ele);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	if (ele->selected_valid &&
+			ele->selected_generation == doc->attr_generation)
+		return DOM_NO_ERR;
+
+	ele->selected = -1;
+
+	for (idx = 0; idx < ele->n_options; idx++) {
+		err = dom_html_option_element_get_selected(
+				ele->options[idx], &selected);
+		if (err != DOM_NO_ERR)
+			return err;
+
+		if (selected) {
+			ele->selected = idx;
+			break;
+		}
+	}
 
-	return false;
+	ele->selected_valid = true;
+	ele->selected_generation = doc->attr_generation;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Get the index of an option among a select element's options
+ *
+ * \param select  The select element
+ * \param option  The option
+ * \param index   Pointer to location to receive the index, or -1 if
+ *                ::option is not one of ::select's options
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ */
+dom_exception _dom_html_select_element_get_option_index(
+		dom_html_select_element *select,
+		struct dom_html_option_element *option, int32_t *index)
+{
+	dom_exception err;
+	uint32_t idx;
+
+	err = _dom_html_select_element_update_options(select);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	/* The index recorded when the options were last found */
+	if (option->select == select &&
+			option->index_generation == select->options_generation) {
+		*index = option->index;
+		return DOM_NO_ERR;
+	}
+
+	/* Otherwise a select nested in or around this one found it last */
+	for (idx = 0; idx < select->n_options; idx++) {
+		if (select->options[idx] == option) {
+			*index = idx;
+			return DOM_NO_ERR;
+		}
+	}
+
+	*index = -1;
+
+	return DOM_NO_ERR;
 }
 
 dom_exception _dom_html_select_element_set_form(
 		dom_html_select_element *select, dom_html_form_element *form)
 {
+	dom_exception err;
+
+	if (select->form == form)
+		return DOM_NO_ERR;
+
+	if (form != NULL) {
+		err = _dom_html_form_element_add_control(form,
+				(struct dom_html_element *) select);
+		if (err != DOM_NO_ERR)
+			return err;
+	}
+
+	if (select->form != NULL)
+		_dom_html_form_element_remove_control(select->form,
+				(struct dom_html_element *) select);
+
 	select->form = form;
 
+	/* This changes which form's elements collection we belong to */
+	_dom_document_element_changed(dom_node_get_owner(select),
+			(struct dom_element *) select);
+
 	return DOM_NO_ERR;
 }
 
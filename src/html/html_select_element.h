@@ -16,10 +16,26 @@
 struct dom_html_select_element {
 	struct dom_html_element base;
 			/**< The base class */
-	int32_t selected;
-			/**< The selected element's index */
 	dom_html_form_element *form;
 			/**< The form associated with select */
+
+	struct dom_html_option_element **options;
+			/**< The options, in document order, valid if
+			 * options_generation matches the document's tree
+			 * generation */
+	uint32_t n_options;	/**< The number of options */
+	uint32_t alloc_options;	/**< The allocated size of options */
+	bool options_valid;	/**< Whether options has been filled */
+	uint64_t options_generation;
+			/**< The document's tree generation when filled */
+
+	int32_t selected;
+			/**< The selected option's index, or -1, valid if
+			 * options is and selected_generation matches the
+			 * document's attribute generation */
+	bool selected_valid;	/**< Whether selected has been found */
+	uint64_t selected_generation;
+			/**< The document's attribute generation when found */
 };
 
 /* Create a dom_html_select_element object */
@@ -44,7 +60,7 @@ dom_exception _dom_html_select_element_parse_attribute(dom_element *ele,
 		dom_string **parsed);
 void _dom_virtual_html_select_element_destroy(dom_node_internal *node);
 dom_exception _dom_html_select_element_copy(dom_node_internal *old,
-		dom_node_internal **copy);
+		struct dom_document *doc, dom_node_internal **copy);
 
 #define DOM_HTML_SELECT_ELEMENT_PROTECT_VTABLE \
 	_dom_html_select_element_parse_attribute
@@ -58,6 +74,10 @@ dom_exception _dom_html_select_element_copy(dom_node_internal *old,
 dom_exception _dom_html_select_element_set_form(
 	dom_html_select_element *select, dom_html_form_element *form);
 
+dom_exception _dom_html_select_element_get_option_index(
+		dom_html_select_element *select,
+		struct dom_html_option_element *option, int32_t *index);
+
 /* Helper functions*/
 dom_exception _dom_html_select_element_copy_internal(
 		dom_html_select_element *old,
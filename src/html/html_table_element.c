@@ -28,6 +28,12 @@ static const struct dom_element_protected_vtable _protect_vtable = {
 	DOM_HTML_TABLE_ELEMENT_PROTECT_VTABLE
 };
 
+static dom_exception _dom_html_table_element_add_section(
+		dom_html_table_element *table, dom_node_internal *section,
+		uint32_t length);
+static uint32_t _dom_html_table_element_number_rows(
+		dom_node_internal *section, uint32_t base);
+
 /**
  * Create a dom_html_table_element object
  *
@@ -41,7 +47,8 @@ dom_exception _dom_html_table_element_create(
 {
 	struct dom_node_internal *node;
 
-	*ele = malloc(sizeof(dom_html_table_element));
+	*ele = _dom_node_alloc(&params->doc->base,
+			sizeof(dom_html_table_element));
 	if (*ele == NULL)
 		return DOM_NO_MEM_ERR;
 
@@ -64,6 +71,15 @@ dom_exception _dom_html_table_element_initialise(
 		struct dom_html_element_create_params *params,
 		struct dom_html_table_element *ele)
 {
+	ele->rows = NULL;
+	ele->n_rows = 0;
+	ele->alloc_rows = 0;
+	ele->sections = NULL;
+	ele->n_sections = 0;
+	ele->alloc_sections = 0;
+	ele->index_valid = false;
+	ele->index_generation = 0;
+
 	return _dom_html_element_initialise(params, &ele->base);
 }
 
@@ -74,6 +90,11 @@ dom_exception _dom_html_table_element_initialise(
  */
 void _dom_html_table_element_finalise(struct dom_html_table_element *ele)
 {
+	free(ele->rows);
+	ele->rows = NULL;
+	free(ele->sections);
+	ele->sections = NULL;
+
 	_dom_html_element_finalise(&ele->base);
 }
 
@@ -85,7 +106,7 @@ void _dom_html_table_element_finalise(struct dom_html_table_element *ele)
 void _dom_html_table_element_destroy(struct dom_html_table_element *ele)
 {
 	_dom_html_table_element_finalise(ele);
-	free(ele);
+	_dom_node_free(ele);
 }
 
 /*------------------------------------------------------------------------*/
@@ -114,18 +135,19 @@ void _dom_virtual_html_table_element_destroy(dom_node_internal *node)
 
 /* The virtual copy function, see src/core/node.c for detail */
 dom_exception _dom_html_table_element_copy(
-		dom_node_internal *old, dom_node_internal **copy)
+		dom_node_internal *old, struct dom_document *doc,
+		dom_node_internal **copy)
 {
 	dom_html_table_element *new_node;
 	dom_exception err;
 
-	new_node = malloc(sizeof(dom_html_table_element));
+	new_node = _dom_node_alloc(doc, sizeof(dom_html_table_element));
 	if (new_node == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_html_table_element_copy_internal(old, new_node);
 	if (err != DOM_NO_ERR) {
-		free(new_node);
+		_dom_node_free(new_node);
 		return err;
 	}
 
@@ -145,6 +167,16 @@ dom_exception _dom_html_table_element_copy_internal(
 		return err;
 	}
 
+	/* The copy's index is built when it is first needed */
+	new->rows = NULL;
+	new->n_rows = 0;
+	new->alloc_rows = 0;
+	new->sections = NULL;
+	new->n_sections = 0;
+	new->alloc_sections = 0;
+	new->index_valid = false;
+	new->index_generation = 0;
+
 	return DOM_NO_ERR;
 }
 
@@ -206,13 +238,10 @@ dom_exception dom_html_table_element_get_caption(
 		dom_html_table_element *table, dom_html_table_caption_element **caption)
 {
 	dom_node_internal *node_tmp = ((dom_node_internal *)table);
-	dom_html_document *doc = (dom_html_document *)(node_tmp->owner);
 
 	for (node_tmp = node_tmp->first_child; node_tmp != NULL; node_tmp = node_tmp->next) {
-		if((node_tmp->type == DOM_ELEMENT_NODE) &&
-				dom_string_caseless_isequal(
-				doc->elements[DOM_HTML_ELEMENT_TYPE_CAPTION],
-				node_tmp->name)) {
+		if(_dom_html_node_get_element_type(node_tmp) ==
+				DOM_HTML_ELEMENT_TYPE_CAPTION) {
 			break;
 		}
 	}
@@ -234,16 +263,14 @@ dom_exception dom_html_table_element_set_caption(
 		dom_html_table_element *table, dom_html_table_caption_element *caption)
 {
 	dom_node_internal *check_node = ((dom_node_internal *)caption);
-	dom_html_document *doc = (dom_html_document *)(((dom_node_internal *)table)->owner);
 	dom_exception exp;
 	dom_node *new_caption;
 
 	if (check_node == NULL) {
 		return DOM_HIERARCHY_REQUEST_ERR;
 	}
-	if (!dom_string_caseless_isequal(
-			doc->elements[DOM_HTML_ELEMENT_TYPE_CAPTION],
-			check_node->name)) {
+	if (_dom_html_node_get_element_type(check_node) !=
+			DOM_HTML_ELEMENT_TYPE_CAPTION) {
 		return DOM_HIERARCHY_REQUEST_ERR;
 	}
 
@@ -265,13 +292,10 @@ dom_exception dom_html_table_element_get_t_head(
 		dom_html_table_element *table, dom_html_table_section_element **t_head)
 {
 	dom_node_internal *node_tmp = ((dom_node_internal *)table);
-	dom_html_document *doc = (dom_html_document *)(node_tmp->owner);
 
 	for (node_tmp = node_tmp->first_child; node_tmp != NULL; node_tmp = node_tmp->next) {
-		if((node_tmp->type == DOM_ELEMENT_NODE) &&
-				dom_string_caseless_isequal(
-				doc->elements[DOM_HTML_ELEMENT_TYPE_THEAD],
-				node_tmp->name)) {
+		if(_dom_html_node_get_element_type(node_tmp) ==
+				DOM_HTML_ELEMENT_TYPE_THEAD) {
 			break;
 		}
 	}
@@ -292,16 +316,14 @@ dom_exception dom_html_table_element_set_t_head(
 		dom_html_table_element *table, dom_html_table_section_element *t_head)
 {
 	dom_node_internal *check_node = ((dom_node_internal *)t_head);
-	dom_html_document *doc = (dom_html_document *)(((dom_node_internal *)table)->owner);
 	dom_exception exp;
 	dom_node *new_t_head;
 
 	if (check_node == NULL) {
 		return DOM_HIERARCHY_REQUEST_ERR;
 	}
-	if (!dom_string_caseless_isequal(
-			doc->elements[DOM_HTML_ELEMENT_TYPE_CAPTION],
-			check_node->name)) {
+	if (_dom_html_node_get_element_type(check_node) !=
+			DOM_HTML_ELEMENT_TYPE_THEAD) {
 		return DOM_HIERARCHY_REQUEST_ERR;
 	}
 
@@ -323,13 +345,10 @@ dom_exception dom_html_table_element_get_t_foot(
 		dom_html_table_element *table, dom_html_table_section_element **t_foot)
 {
 	dom_node_internal *node_tmp = ((dom_node_internal *)table);
-	dom_html_document *doc = (dom_html_document *)(node_tmp->owner);
 
 	for (node_tmp = node_tmp->first_child; node_tmp != NULL; node_tmp = node_tmp->next) {
-		if ((node_tmp->type == DOM_ELEMENT_NODE) &&
-				dom_string_caseless_isequal(
-				doc->elements[DOM_HTML_ELEMENT_TYPE_TFOOT],
-				node_tmp->name)) {
+		if (_dom_html_node_get_element_type(node_tmp) ==
+				DOM_HTML_ELEMENT_TYPE_TFOOT) {
 			break;
 		}
 	}
@@ -350,7 +369,6 @@ dom_exception dom_html_table_element_set_t_foot(
 		dom_html_table_element *table, dom_html_table_section_element *t_foot)
 {
 	dom_node_internal *check_node = ((dom_node_internal *)t_foot); /*< temporary node to check for raised exceptions */
-	dom_html_document *doc = (dom_html_document *)(((dom_node_internal *)table)->owner);
 	dom_exception exp;
 	dom_node *new_t_foot;
 
@@ -358,9 +376,8 @@ dom_exception dom_html_table_element_set_t_foot(
 		return DOM_HIERARCHY_REQUEST_ERR;
 	}
 
-	if(!dom_string_caseless_isequal(
-			doc->elements[DOM_HTML_ELEMENT_TYPE_TFOOT],
-			check_node->name)) {
+	if(_dom_html_node_get_element_type(check_node) !=
+			DOM_HTML_ELEMENT_TYPE_TFOOT) {
 		return DOM_HIERARCHY_REQUEST_ERR;
 	}
 
@@ -374,21 +391,30 @@ dom_exception dom_html_table_element_set_t_foot(
 }
 
 /**
- * Callback for creating the rows collection
+ * Callback for listing the rows collection
  *
- * \param node		The dom_html_table_element object
- * \param ctx		The dom_html_document object (void *)
+ * \param col		The collection
+ * \param ctx		The dom_html_table_element object (void *)
  * \return DOM_NO_ERR on success, appropriate dom_exception on failure.
  */
-static bool table_rows_callback(struct dom_node_internal *node, void *ctx)
+static dom_exception table_rows_list(struct dom_html_collection *col,
+		void *ctx)
 {
-	dom_html_document *doc = ctx;
-	if(node->type == DOM_ELEMENT_NODE &&
-			dom_string_caseless_isequal(node->name,
-				doc->elements[DOM_HTML_ELEMENT_TYPE_TR])) {
-		return true;
+	dom_html_table_element *table = ctx;
+	dom_exception err;
+	uint32_t i;
+
+	err = _dom_html_table_element_update_index(table);
+	if (err != DOM_NO_ERR)
+		return err;
+
+	for (i = 0; i < table->n_rows; i++) {
+		err = _dom_html_collection_append(col, table->rows[i]);
+		if (err != DOM_NO_ERR)
+			return err;
 	}
-	return false;
+
+	return DOM_NO_ERR;
 }
 
 /**
@@ -403,8 +429,9 @@ dom_exception dom_html_table_element_get_rows(
 		dom_html_collection **rows)
 {
 	dom_html_document *doc = (dom_html_document *) ((dom_node_internal *) element)->owner;
-	return _dom_html_collection_create(doc, (dom_node_internal *)element, 
-			table_rows_callback, (void *)doc, rows);
+	return _dom_html_collection_create_listed(doc,
+			(dom_node_internal *) element, table_rows_list,
+			element, rows);
 }
 
 /**
@@ -416,13 +443,10 @@ dom_exception dom_html_table_element_get_rows(
  */
 static bool table_t_bodies_callback(struct dom_node_internal *node, void *ctx)
 {
-	dom_html_document *doc = ctx;
-	if(node->type == DOM_ELEMENT_NODE && 
-			dom_string_caseless_isequal(node->name,
-				doc->elements[DOM_HTML_ELEMENT_TYPE_TBODY])) {
-		return true;
-	}
-	return false;
+	UNUSED(ctx);
+
+	return _dom_html_node_get_element_type(node) ==
+			DOM_HTML_ELEMENT_TYPE_TBODY;
 }
 
 /**
@@ -740,20 +764,15 @@ dom_exception dom_html_table_element_insert_row(
 		dom_html_element **row_out)
 {
 	dom_exception exp;
-	dom_html_collection* rows;
 	uint32_t len;
 	dom_html_document *doc = (dom_html_document *)
 		((dom_node_internal *) element)->owner;
 
-	exp = dom_html_table_element_get_rows(element, &rows);
-	if(exp != DOM_NO_ERR) {
-		return exp;
-	}
-	exp = dom_html_collection_get_length(rows, &len);
-	dom_html_collection_unref(rows);
+	exp = _dom_html_table_element_update_index(element);
 	if(exp != DOM_NO_ERR) {
 		return exp;
 	}
+	len = element->n_rows;
 
 	if(index > (int32_t)len || index < -1) {
 		exp = DOM_INDEX_SIZE_ERR;
@@ -789,112 +808,33 @@ dom_exception dom_html_table_element_insert_row(
 			*row_out = (dom_html_element *)new_row;
 		}
 	} else {
-		uint32_t window_len = 0, section_len;
-		dom_html_table_section_element *t_head;
-		dom_html_table_section_element *t_foot;
-		dom_html_element *row;
-		dom_node_internal *n;
+		uint32_t window_len = 0, i;
 
 		if(index ==-1) {
 			index = (int32_t)len;
 		}
 
-		exp = dom_html_table_element_get_t_head(element, &t_head);
-		if (exp != DOM_NO_ERR) {
-			return exp;
-		}
+		/* Find the section holding the row before which to insert,
+		 * or the first section which ends with the last row */
+		for (i = 0; i < element->n_sections; i++) {
+			struct dom_html_table_section_span *span =
+					&element->sections[i];
 
-		exp = dom_html_table_section_element_get_rows(t_head, &rows);
-		if(exp != DOM_NO_ERR) {
-			dom_node_unref(t_head);
-			return exp;
-		}
-
-		exp = dom_html_collection_get_length(rows, &section_len);
-		dom_html_collection_unref(rows);
-		if(exp != DOM_NO_ERR) {
-			dom_node_unref(t_head);
-			return exp;
-		}
-
-		if(window_len + section_len > (uint32_t)index ||
-				window_len + section_len == len) {
-			exp = dom_html_table_section_element_insert_row(t_head,
-					index-window_len, &row);
-			dom_node_unref(t_head);
-			if (exp == DOM_NO_ERR) {
-				*row_out = row;
-			}
-			return exp;
-		}
-		dom_node_unref(t_head);
-
-		window_len += section_len;
-
-		n = (dom_node_internal *)element;
-
-		for (n = n->first_child; n != NULL; n = n->next) {
-			if((n->type == DOM_ELEMENT_NODE) &&
-					dom_string_caseless_isequal(
-					doc->elements[DOM_HTML_ELEMENT_TYPE_TBODY],
-					n->name)) {
-
-				exp = dom_html_table_section_element_get_rows(
-						(dom_html_table_section_element *)n,
-						&rows);
-				if (exp != DOM_NO_ERR) {
-					return exp;
-				}
-				exp = dom_html_collection_get_length(rows, &section_len);
-				dom_html_collection_unref(rows);
-				if (exp != DOM_NO_ERR) {
-					return exp;
-				}
-
-				if(window_len + section_len > (uint32_t)index ||
-						window_len + section_len == len) {
-					exp = dom_html_table_section_element_insert_row(
-							(dom_html_table_section_element *)n,
-							index-window_len, &row);
-					if (exp == DOM_NO_ERR) {
-						*row_out = row;
-					}
-					return exp;
-				}
-
-				window_len += section_len;
+			if(window_len + span->length > (uint32_t)index ||
+					window_len + span->length == len) {
+				break;
 			}
-		}
-		exp = dom_html_table_element_get_t_foot(element, &t_foot);
-		if(exp != DOM_NO_ERR) {
-			return exp;
-		}
 
-		exp = dom_html_table_section_element_get_rows(t_foot, &rows);
-		if(exp != DOM_NO_ERR) {
-			dom_node_unref(t_foot);
-			return exp;
+			window_len += span->length;
 		}
 
-		exp = dom_html_collection_get_length(rows, &section_len);
-		dom_html_collection_unref(rows);
-		if(exp != DOM_NO_ERR) {
-			dom_node_unref(t_foot);
-			return exp;
+		if(i == element->n_sections) {
+			return DOM_INDEX_SIZE_ERR;
 		}
 
-		if(window_len + section_len > (uint32_t)index ||
-				window_len +section_len == len) {
-			exp = dom_html_table_section_element_insert_row(t_foot,
-					index-window_len, &row);
-			dom_node_unref(t_foot);
-			if (exp == DOM_NO_ERR) {
-				*row_out = row;
-			}
-			return exp;
-		}
-		dom_node_unref(t_foot);
-		exp = DOM_INDEX_SIZE_ERR;
+		exp = dom_html_table_section_element_insert_row(
+				element->sections[i].section,
+				index - window_len, row_out);
 	}
 
 	return exp;
@@ -911,110 +851,228 @@ dom_exception dom_html_table_element_delete_row(
 		int32_t index)
 {
 	dom_exception exp;
-	dom_html_collection* rows;
 	uint32_t len;
-	dom_html_document *doc = (dom_html_document *) 
-		((dom_node_internal *) element)->owner;
+	uint32_t window_len = 0, i;
 
-	exp = dom_html_table_element_get_rows(element, &rows);
-	if(exp != DOM_NO_ERR) {
-		return exp;
-	}
-	exp = dom_html_collection_get_length(rows, &len);
-	dom_html_collection_unref(rows);
+	exp = _dom_html_table_element_update_index(element);
 	if(exp != DOM_NO_ERR) {
 		return exp;
 	}
+	len = element->n_rows;
 
 	if(index >= (int32_t)len || index < -1 || len ==0) {
 		return DOM_INDEX_SIZE_ERR;
-	} else {
-		uint32_t window_len = 0, section_len;
-		dom_html_table_section_element *t_head;
-		dom_html_table_section_element *t_foot;
-		dom_node_internal *n;
+	}
 
-		if(index ==-1) {
-			index = (int32_t)len-1;
-		}
+	if(index ==-1) {
+		index = (int32_t)len-1;
+	}
 
-		exp = dom_html_table_element_get_t_head(element, &t_head);
-		if(exp != DOM_NO_ERR)
-			return exp;
+	for (i = 0; i < element->n_sections; i++) {
+		struct dom_html_table_section_span *span =
+				&element->sections[i];
 
-		exp = dom_html_table_section_element_get_rows(t_head, &rows);
-		if (exp != DOM_NO_ERR) {
-			dom_node_unref(t_head);
-			return DOM_NO_ERR;
+		if(window_len + span->length > (uint32_t)index) {
+			return dom_html_table_section_element_delete_row(
+					span->section, index - window_len);
 		}
 
-		exp = dom_html_collection_get_length(rows, &section_len);
-		dom_html_collection_unref(rows);
-		if(exp != DOM_NO_ERR) {
-			dom_node_unref(t_head);
-			return exp;
-		}
+		window_len += span->length;
+	}
 
-		if(window_len + section_len > (uint32_t)index) {
-			exp = dom_html_table_section_element_delete_row(t_head,
-					index-window_len);
-			dom_node_unref(t_head);
-			return exp;
+	return DOM_INDEX_SIZE_ERR;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Internal functions */
+
+/**
+ * Append a section to a table's index
+ *
+ * \param table    The dom_html_table_element object
+ * \param section  The THEAD, TBODY or TFOOT element
+ * \param length   The number of rows in the section
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ */
+dom_exception _dom_html_table_element_add_section(
+		dom_html_table_element *table, dom_node_internal *section,
+		uint32_t length)
+{
+	if (table->n_sections == table->alloc_sections) {
+		struct dom_html_table_section_span *sections;
+		uint32_t alloc = table->alloc_sections == 0 ?
+				4 : table->alloc_sections * 2;
+
+		sections = realloc(table->sections, alloc * sizeof(*sections));
+		if (sections == NULL)
+			return DOM_NO_MEM_ERR;
+
+		table->sections = sections;
+		table->alloc_sections = alloc;
+	}
+
+	table->sections[table->n_sections].section =
+			(dom_html_table_section_element *) section;
+	table->sections[table->n_sections].length = length;
+	table->n_sections++;
+
+	return DOM_NO_ERR;
+}
+
+/**
+ * Number the rows which are children of a table section
+ *
+ * \param section  The THEAD, TBODY or TFOOT element
+ * \param base     The table row index of the section's first row
+ * \return the number of rows in the section.
+ */
+uint32_t _dom_html_table_element_number_rows(
+		dom_node_internal *section, uint32_t base)
+{
+	dom_node_internal *n;
+	uint32_t count = 0;
+
+	for (n = section->first_child; n != NULL; n = n->next) {
+		if (_dom_html_node_get_element_type(n) ==
+				DOM_HTML_ELEMENT_TYPE_TR) {
+			dom_html_table_row_element *row =
+					(dom_html_table_row_element *) n;
+
+			row->row_index = base + count;
+			row->section_row_index = count;
+			count++;
 		}
-		dom_node_unref(t_head);
-
-		window_len += section_len;
-		n = (dom_node_internal *)element;
-
-		for (n = n->first_child; n != NULL; n = n->next) {
-			if((n->type == DOM_ELEMENT_NODE) &&
-					dom_string_caseless_isequal(
-					doc->elements[DOM_HTML_ELEMENT_TYPE_TBODY],
-					n->name)) {
-				exp = dom_html_table_section_element_get_rows(
-						(dom_html_table_section_element *)n,
-						&rows);
-				if(exp != DOM_NO_ERR) {
-					return exp;
-				}
-
-				dom_html_collection_get_length(rows, &section_len);
-				dom_html_collection_unref(rows);
-				if(exp != DOM_NO_ERR)
-					return exp;
-
-				if(window_len + section_len > (uint32_t)index) {
-					return dom_html_table_section_element_delete_row(
-							(dom_html_table_section_element *)n,
-							index-window_len);
-				}
-				window_len += section_len;
+	}
+
+	return count;
+}
+
+/**
+ * Bring a table's row index up to date
+ *
+ * \param table  The dom_html_table_element object
+ * \return DOM_NO_ERR on success, DOM_NO_MEM_ERR on memory exhaustion.
+ *
+ * The index lists the table's rows, and the sections rows are inserted
+ * and deleted by, and numbers the rows of each section.  It is rebuilt
+ * only when the document's tree has changed since it was last built.
+ */
+dom_exception _dom_html_table_element_update_index(
+		dom_html_table_element *table)
+{
+	dom_node_internal *root = (dom_node_internal *) table;
+	dom_node_internal *node = root->first_child;
+	dom_html_document *doc = (dom_html_document *) root->owner;
+	dom_node_internal *head = NULL, *foot = NULL;
+	uint32_t head_len = 0, foot_len = 0, before;
+	dom_exception err;
+
+	if (table->index_valid &&
+			table->index_generation == doc->base.tree_generation)
+		return DOM_NO_ERR;
+
+	table->index_valid = false;
+	table->n_rows = 0;
+	table->n_sections = 0;
+
+	while (node != NULL) {
+		if (_dom_html_node_get_element_type(node) ==
+				DOM_HTML_ELEMENT_TYPE_TR) {
+			if (table->n_rows == table->alloc_rows) {
+				dom_node_internal **rows;
+				uint32_t alloc = table->alloc_rows == 0 ?
+						16 : table->alloc_rows * 2;
+
+				rows = realloc(table->rows,
+						alloc * sizeof(*rows));
+				if (rows == NULL)
+					return DOM_NO_MEM_ERR;
+
+				table->rows = rows;
+				table->alloc_rows = alloc;
 			}
+
+			table->rows[table->n_rows++] = node;
 		}
-		exp = dom_html_table_element_get_t_foot(element, &t_foot);
-		if(exp != DOM_NO_ERR)
-			return exp;
 
-		exp = dom_html_table_section_element_get_rows(t_foot, &rows);
-		if(exp != DOM_NO_ERR) {
-			dom_node_unref(t_foot);
-			return exp;
+		/* Depth first iterating */
+		if (node->first_child != NULL) {
+			node = node->first_child;
+		} else {
+			while (node != root && node->next == NULL)
+				node = node->parent;
+
+			node = node == root ? NULL : node->next;
 		}
-		exp = dom_html_collection_get_length(rows, &section_len);
-		dom_html_collection_unref(rows);
-		if (exp != DOM_NO_ERR) {
-			dom_node_unref(t_foot);
-			return exp;
+	}
+
+	for (node = root->first_child; node != NULL; node = node->next) {
+		switch (_dom_html_node_get_element_type(node)) {
+		case DOM_HTML_ELEMENT_TYPE_THEAD:
+			if (head == NULL)
+				head = node;
+			break;
+		case DOM_HTML_ELEMENT_TYPE_TFOOT:
+			if (foot == NULL)
+				foot = node;
+			break;
+		default:
+			break;
 		}
+	}
 
-		if(window_len + section_len > (uint32_t)index) {
-			exp = dom_html_table_section_element_delete_row(t_foot,
-					index-window_len);
-			dom_node_unref(t_foot);
-			return exp;
+	/* Rows of the head come first, wherever it is in the table */
+	if (head != NULL) {
+		head_len = _dom_html_table_element_number_rows(head, 0);
+
+		err = _dom_html_table_element_add_section(table, head,
+				head_len);
+		if (err != DOM_NO_ERR)
+			return err;
+	}
+
+	/* Other rows follow the head and the bodies before them */
+	before = head_len;
+
+	for (node = root->first_child; node != NULL; node = node->next) {
+		uint32_t len;
+
+		if (node == head)
+			continue;
+
+		switch (_dom_html_node_get_element_type(node)) {
+		case DOM_HTML_ELEMENT_TYPE_THEAD:
+			_dom_html_table_element_number_rows(node, 0);
+			break;
+		case DOM_HTML_ELEMENT_TYPE_TBODY:
+			len = _dom_html_table_element_number_rows(node, before);
+
+			err = _dom_html_table_element_add_section(table, node,
+					len);
+			if (err != DOM_NO_ERR)
+				return err;
+
+			before += len;
+			break;
+		case DOM_HTML_ELEMENT_TYPE_TFOOT:
+			len = _dom_html_table_element_number_rows(node, before);
+			if (node == foot)
+				foot_len = len;
+			break;
+		default:
+			break;
 		}
-		return DOM_INDEX_SIZE_ERR;
 	}
 
-}
+	if (foot != NULL) {
+		err = _dom_html_table_element_add_section(table, foot,
+				foot_len);
+		if (err != DOM_NO_ERR)
+			return err;
+	}
 
+	table->index_valid = true;
+	table->index_generation = doc->base.tree_generation;
+
+	return DOM_NO_ERR;
+}
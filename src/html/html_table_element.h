@@ -12,9 +12,35 @@
 #include <dom/html/html_table_element.h>
 #include "html/html_element.h"
 
+struct dom_html_table_section_element;
+
+/**
+ * A section of a table, and the number of rows it holds
+ */
+struct dom_html_table_section_span {
+	struct dom_html_table_section_element *section;
+			/**< The THEAD, TBODY or TFOOT element */
+	uint32_t length;	/**< The number of rows in the section */
+};
+
 struct dom_html_table_element {
 	struct dom_html_element base;
 			/**< The base class */
+
+	struct dom_node_internal **rows;
+			/**< The rows, in document order, valid if
+			 * index_generation matches the document's tree
+			 * generation */
+	uint32_t n_rows;	/**< The number of rows */
+	uint32_t alloc_rows;	/**< The allocated size of rows */
+	struct dom_html_table_section_span *sections;
+			/**< The head, the bodies and the foot, in that
+			 * order, which rows are inserted and deleted by */
+	uint32_t n_sections;	/**< The number of sections */
+	uint32_t alloc_sections;	/**< The allocated size of sections */
+	bool index_valid;	/**< Whether the index has been built */
+	uint64_t index_generation;
+			/**< The document's tree generation when built */
 };
 
 /* Create a dom_html_table_element object */
@@ -39,7 +65,7 @@ dom_exception _dom_html_table_element_parse_attribute(dom_element *ele,
 		dom_string **parsed);
 void _dom_virtual_html_table_element_destroy(dom_node_internal *node);
 dom_exception _dom_html_table_element_copy(dom_node_internal *old,
-		                dom_node_internal **copy);
+		struct dom_document *doc, dom_node_internal **copy);
 
 #define DOM_HTML_TABLE_ELEMENT_PROTECT_VTABLE \
 	_dom_html_table_element_parse_attribute
@@ -48,6 +74,10 @@ dom_exception _dom_html_table_element_copy(dom_node_internal *old,
 	_dom_virtual_html_table_element_destroy, \
 	_dom_html_table_element_copy
 
+/* Bring the table's row index up to date */
+dom_exception _dom_html_table_element_update_index(
+		dom_html_table_element *table);
+
 /* Helper functions*/
 dom_exception _dom_html_table_element_copy_internal(
 		dom_html_table_element *old,
@@ -13,6 +13,7 @@
 
 #include "html/html_document.h"
 #include "html/html_tablecell_element.h"
+#include "html/html_tablerow_element.h"
 
 #include "core/node.h"
 #include "core/attr.h"
@@ -38,7 +39,8 @@ dom_exception _dom_html_table_cell_element_create(
 {
 	struct dom_node_internal *node;
 
-	*ele = malloc(sizeof(dom_html_table_cell_element));
+	*ele = _dom_node_alloc(&params->doc->base,
+			sizeof(dom_html_table_cell_element));
 	if (*ele == NULL)
 		return DOM_NO_MEM_ERR;
 
@@ -61,6 +63,8 @@ dom_exception _dom_html_table_cell_element_initialise(
 		struct dom_html_element_create_params *params,
 		struct dom_html_table_cell_element *ele)
 {
+	ele->cell_index = 0;
+
 	return _dom_html_element_initialise(params, &ele->base);
 }
 
@@ -82,7 +86,7 @@ void _dom_html_table_cell_element_finalise(struct dom_html_table_cell_element *e
 void _dom_html_table_cell_element_destroy(struct dom_html_table_cell_element *ele)
 {
 	_dom_html_table_cell_element_finalise(ele);
-	free(ele);
+	_dom_node_free(ele);
 }
 
 /*------------------------------------------------------------------------*/
@@ -111,18 +115,20 @@ void _dom_virtual_html_table_cell_element_destroy(dom_node_internal *node)
 
 /* The virtual copy function, see src/core/node.c for detail */
 dom_exception _dom_html_table_cell_element_copy(
-		dom_node_internal *old, dom_node_internal **copy)
+		dom_node_internal *old, struct dom_document *doc,
+		dom_node_internal **copy)
 {
 	dom_html_table_cell_element *new_node;
 	dom_exception err;
 
-	new_node = malloc(sizeof(dom_html_table_cell_element));
+	new_node = _dom_node_alloc(doc,
+			sizeof(dom_html_table_cell_element));
 	if (new_node == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_html_table_cell_element_copy_internal(old, new_node);
 	if (err != DOM_NO_ERR) {
-		free(new_node);
+		_dom_node_free(new_node);
 		return err;
 	}
 
@@ -142,6 +148,8 @@ dom_exception _dom_html_table_cell_element_copy_internal(
 		return err;
 	}
 
+	new->cell_index = 0;
+
 	return DOM_NO_ERR;
 }
 
@@ -208,13 +216,21 @@ dom_exception dom_html_table_cell_element_get_cell_index(
 		dom_html_table_cell_element *table_cell, dom_long *cell_index)
 {
 	dom_node_internal *n = ((dom_node_internal *)table_cell)->parent;
-	dom_html_document *doc = (dom_html_document *)(n->owner);
 	int32_t cnt = 0;
 	dom_node_internal *root;
+
+	/* A cell in a row is numbered among the row's cells */
+	if(n != NULL && _dom_html_node_get_element_type(n) ==
+			DOM_HTML_ELEMENT_TYPE_TR) {
+		_dom_html_table_row_element_update_cells(
+				(dom_html_table_row_element *) n);
+		*cell_index = table_cell->cell_index;
+		return DOM_NO_ERR;
+	}
+
 	while(n != NULL) {
-		if(dom_string_caseless_isequal(
-				doc->elements[DOM_HTML_ELEMENT_TYPE_TR],
-				n->name)) {
+		if(_dom_html_node_get_element_type(n) ==
+				DOM_HTML_ELEMENT_TYPE_TR) {
 			break;
 		}
 		n = n->parent;
@@ -223,13 +239,10 @@ dom_exception dom_html_table_cell_element_get_cell_index(
 	while(n != NULL) {
 		if(n == (dom_node_internal *)table_cell) {
 			break;
-		} else if((n->type == DOM_ELEMENT_NODE) &&
-				(dom_string_caseless_isequal(
-				doc->elements[DOM_HTML_ELEMENT_TYPE_TD],
-				n->name) ||
-				dom_string_caseless_isequal(
-				doc->elements[DOM_HTML_ELEMENT_TYPE_TH],
-				n->name))) {
+		} else if(_dom_html_node_get_element_type(n) ==
+				DOM_HTML_ELEMENT_TYPE_TD ||
+				_dom_html_node_get_element_type(n) ==
+				DOM_HTML_ELEMENT_TYPE_TH) {
 			cnt += 1;
 		}
 		if(n->first_child != NULL) {
@@ -16,6 +16,9 @@
 struct dom_html_table_cell_element {
 	struct dom_html_element base;
 			/**< The base class */
+	int32_t cell_index;
+			/**< The cell's index in its row, valid if the row's
+			 * cells have been numbered */
 };
 
 /* Create a dom_html_table_cell_element object */
@@ -40,7 +43,7 @@ dom_exception _dom_html_table_cell_element_parse_attribute(dom_element *ele,
 		dom_string **parsed);
 void _dom_virtual_html_table_cell_element_destroy(dom_node_internal *node);
 dom_exception _dom_html_table_cell_element_copy(dom_node_internal *old,
-		                dom_node_internal **copy);
+		struct dom_document *doc, dom_node_internal **copy);
 
 #define DOM_HTML_TABLE_CELL_ELEMENT_PROTECT_VTABLE \
 	_dom_html_table_cell_element_parse_attribute
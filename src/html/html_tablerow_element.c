@@ -13,7 +13,9 @@
 #include <dom/html/html_table_element.h>
 
 #include "html/html_document.h"
+#include "html/html_table_element.h"
 #include "html/html_tablerow_element.h"
+#include "html/html_tablecell_element.h"
 #include "html/html_collection.h"
 
 #include "core/node.h"
@@ -27,6 +29,9 @@ static const struct dom_element_protected_vtable _protect_vtable = {
 	DOM_HTML_TABLE_ROW_ELEMENT_PROTECT_VTABLE
 };
 
+static dom_html_table_element *_dom_html_table_row_element_get_table(
+		dom_html_table_row_element *row);
+
 /**
  * Create a dom_html_table_row_element table_row
  *
@@ -40,7 +45,8 @@ dom_exception _dom_html_table_row_element_create(
 {
 	struct dom_node_internal *node;
 
-	*ele = malloc(sizeof(dom_html_table_row_element));
+	*ele = _dom_node_alloc(&params->doc->base,
+			sizeof(dom_html_table_row_element));
 	if (*ele == NULL)
 		return DOM_NO_MEM_ERR;
 
@@ -63,6 +69,11 @@ dom_exception _dom_html_table_row_element_initialise(
 		struct dom_html_element_create_params *params,
 		struct dom_html_table_row_element *ele)
 {
+	ele->row_index = 0;
+	ele->section_row_index = 0;
+	ele->cells_valid = false;
+	ele->cells_generation = 0;
+
 	return _dom_html_element_initialise(params, &ele->base);
 }
 
@@ -84,7 +95,7 @@ void _dom_html_table_row_element_finalise(struct dom_html_table_row_element *ele
 void _dom_html_table_row_element_destroy(struct dom_html_table_row_element *ele)
 {
 	_dom_html_table_row_element_finalise(ele);
-	free(ele);
+	_dom_node_free(ele);
 }
 
 /*------------------------------------------------------------------------*/
@@ -113,18 +124,20 @@ void _dom_virtual_html_table_row_element_destroy(dom_node_internal *node)
 
 /* The virtual copy function, see src/core/node.c for detail */
 dom_exception _dom_html_table_row_element_copy(
-		dom_node_internal *old, dom_node_internal **copy)
+		dom_node_internal *old, struct dom_document *doc,
+		dom_node_internal **copy)
 {
 	dom_html_table_row_element *new_node;
 	dom_exception err;
 
-	new_node = malloc(sizeof(dom_html_table_row_element));
+	new_node = _dom_node_alloc(doc,
+			sizeof(dom_html_table_row_element));
 	if (new_node == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_html_table_row_element_copy_internal(old, new_node);
 	if (err != DOM_NO_ERR) {
-		free(new_node);
+		_dom_node_free(new_node);
 		return err;
 	}
 
@@ -144,6 +157,11 @@ dom_exception _dom_html_table_row_element_copy_internal(
 		return err;
 	}
 
+	new->row_index = 0;
+	new->section_row_index = 0;
+	new->cells_valid = false;
+	new->cells_generation = 0;
+
 	return DOM_NO_ERR;
 }
 
@@ -203,84 +221,20 @@ SIMPLE_GET_SET(v_align);
 dom_exception dom_html_table_row_element_get_row_index(
 		dom_html_table_row_element *table_row, int32_t *row_index)
 {
+	dom_html_table_element *table;
 	dom_exception exp;
-	dom_node_internal *n =
-		((dom_node_internal *)table_row)->parent;
-	dom_node_internal *parent = n; 
-	dom_html_document *doc =
-		(dom_html_document *) ((dom_node_internal *) table_row)->owner;
 
-	uint32_t count = 0;
-
-	for (n = n->first_child; n != (dom_node_internal *)table_row;
-			n = n->next) {
-		if(n->type == DOM_ELEMENT_NODE &&
-				dom_string_caseless_isequal(n->name,
-				doc->elements[DOM_HTML_ELEMENT_TYPE_TR])) {
-			count += 1;
-		}
+	table = _dom_html_table_row_element_get_table(table_row);
+	if (table == NULL) {
+		return DOM_HIERARCHY_REQUEST_ERR;
 	}
 
-	if (dom_string_caseless_isequal((parent->parent)->name,
-			doc->elements[DOM_HTML_ELEMENT_TYPE_TABLE]) &&
-			dom_string_caseless_isequal(parent->name,
-			doc->elements[DOM_HTML_ELEMENT_TYPE_THEAD])) {
-		*row_index = count;
-	} else if (dom_string_caseless_isequal((parent->parent)->name,
-				doc->elements[DOM_HTML_ELEMENT_TYPE_TABLE]) &&
-				(dom_string_caseless_isequal(parent->name,
-				doc->elements[DOM_HTML_ELEMENT_TYPE_TBODY]) ||
-				dom_string_caseless_isequal(parent->name,
-				doc->elements[DOM_HTML_ELEMENT_TYPE_TFOOT]))) {
-		uint32_t len;
-		dom_html_table_section_element *t_head;
-		dom_html_collection *rows;
-
-		n = parent->parent;
-		exp = dom_html_table_element_get_t_head(
-				(dom_html_table_element *)(parent->parent),
-				&t_head);
-		if (exp != DOM_NO_ERR) {
-			return exp;
-		}
-
-		if (t_head != NULL) {
-			exp = dom_html_table_section_element_get_rows(t_head, &rows);
-			dom_node_unref(t_head);
-			if (exp != DOM_NO_ERR) {
-				return exp;
-			}
-
-			dom_html_collection_get_length(rows, &len);
-			dom_html_collection_unref(rows);
-			count += len;
-		}
-
-		for (n = n->first_child;n != parent && n != NULL;
-			n = n->next) {
-			if (dom_string_caseless_isequal(n->name,
-					doc->elements[DOM_HTML_ELEMENT_TYPE_TBODY])) {
-				exp = dom_html_table_section_element_get_rows(
-						(dom_html_table_section_element *)n,
-						&rows);
-				if (exp != DOM_NO_ERR) {
-					return exp;
-				}
-
-				exp = dom_html_collection_get_length(rows, &len);
-				dom_html_collection_unref(rows);
-				if (exp != DOM_NO_ERR) {
-					return exp;
-				}
-
-				count += len;
-			}
-		}
-		*row_index = (int32_t)count;
-
-	} else {
-		return DOM_HIERARCHY_REQUEST_ERR;
+	exp = _dom_html_table_element_update_index(table);
+	if (exp != DOM_NO_ERR) {
+		return exp;
 	}
+
+	*row_index = table_row->row_index;
 	return DOM_NO_ERR;
 }
 
@@ -295,13 +249,29 @@ dom_exception dom_html_table_row_element_get_section_row_index(
 		dom_html_table_row_element *table_row, int32_t *section_row_index)
 {
 	dom_node_internal *n = ((dom_node_internal *)table_row)->parent;
-	dom_html_document *doc = (dom_html_document *) ((dom_node_internal *) table_row)->owner;
+	dom_html_table_element *table;
 	int32_t count = 0;
+
+	table = _dom_html_table_row_element_get_table(table_row);
+	if (table != NULL) {
+		dom_exception exp = _dom_html_table_element_update_index(table);
+		if (exp != DOM_NO_ERR) {
+			return exp;
+		}
+
+		*section_row_index = table_row->section_row_index;
+		return DOM_NO_ERR;
+	}
+
+	if (n == NULL) {
+		*section_row_index = -1;
+		return DOM_NO_ERR;
+	}
+
 	for (n = n->first_child; n != (dom_node_internal *)table_row;
 			n = n->next) {
-		if (n->type == DOM_ELEMENT_NODE &&
-				dom_string_caseless_isequal(n->name,
-				doc->elements[DOM_HTML_ELEMENT_TYPE_TR])) {
+		if (_dom_html_node_get_element_type(n) ==
+				DOM_HTML_ELEMENT_TYPE_TR) {
 			count += 1;
 		}
 	}
@@ -318,13 +288,10 @@ dom_exception dom_html_table_row_element_get_section_row_index(
  */
 static bool table_cells_callback(struct dom_node_internal *node, void *ctx)
 {
-	dom_html_document *doc = ctx;
-	if (node->type == DOM_ELEMENT_NODE &&
-			dom_string_caseless_isequal(node->name,
-				doc->elements[DOM_HTML_ELEMENT_TYPE_TD])) {
-		return true;
-	}
-	return false;
+	UNUSED(ctx);
+
+	return _dom_html_node_get_element_type(node) ==
+			DOM_HTML_ELEMENT_TYPE_TD;
 }
 
 /**
@@ -461,3 +428,69 @@ dom_exception dom_html_table_row_element_delete_cell(
 	return exp;
 }
 
+/*-----------------------------------------------------------------------*/
+/* Internal functions */
+
+/**
+ * Find the table which a row is in a section of
+ *
+ * \param row  The dom_html_table_row_element object
+ * \return the table, or NULL if the row is not in a THEAD, TBODY or TFOOT
+ *         which is a child of a TABLE.
+ */
+dom_html_table_element *_dom_html_table_row_element_get_table(
+		dom_html_table_row_element *row)
+{
+	dom_node_internal *section = ((dom_node_internal *) row)->parent;
+
+	if (section == NULL || section->parent == NULL)
+		return NULL;
+
+	if (_dom_html_node_get_element_type(section->parent) !=
+			DOM_HTML_ELEMENT_TYPE_TABLE)
+		return NULL;
+
+	switch (_dom_html_node_get_element_type(section)) {
+	case DOM_HTML_ELEMENT_TYPE_THEAD:
+	case DOM_HTML_ELEMENT_TYPE_TBODY:
+	case DOM_HTML_ELEMENT_TYPE_TFOOT:
+		return (dom_html_table_element *) section->parent;
+	default:
+		return NULL;
+	}
+}
+
+/**
+ * Number the cells of a row, if they have changed since last numbered
+ *
+ * \param row  The dom_html_table_row_element object
+ *
+ * Each TD or TH child of the row is given its index among them.
+ */
+void _dom_html_table_row_element_update_cells(
+		dom_html_table_row_element *row)
+{
+	dom_node_internal *n = ((dom_node_internal *) row)->first_child;
+	dom_html_document *doc =
+		(dom_html_document *) ((dom_node_internal *) row)->owner;
+	int32_t count = 0;
+
+	if (row->cells_valid &&
+			row->cells_generation == doc->base.tree_generation)
+		return;
+
+	for (; n != NULL; n = n->next) {
+		switch (_dom_html_node_get_element_type(n)) {
+		case DOM_HTML_ELEMENT_TYPE_TD:
+		case DOM_HTML_ELEMENT_TYPE_TH:
+			((dom_html_table_cell_element *) n)->cell_index =
+					count++;
+			break;
+		default:
+			break;
+		}
+	}
+
+	row->cells_valid = true;
+	row->cells_generation = doc->base.tree_generation;
+}
@@ -15,6 +15,17 @@
 struct dom_html_table_row_element {
 	struct dom_html_element base;
 			/**< The base class */
+
+	int32_t row_index;
+			/**< The row's index in its table, valid if the
+			 * table's index is */
+	int32_t section_row_index;
+			/**< The row's index in its section, valid if the
+			 * table's index is */
+
+	bool cells_valid;	/**< Whether the cells have been numbered */
+	uint64_t cells_generation;
+			/**< The document's tree generation when numbered */
 };
 
 /* Create a dom_html_table_row_element object */
@@ -39,7 +50,7 @@ dom_exception _dom_html_table_row_element_parse_attribute(dom_element *ele,
 		dom_string **parsed);
 void _dom_virtual_html_table_row_element_destroy(dom_node_internal *node);
 dom_exception _dom_html_table_row_element_copy(dom_node_internal *old,
-		                dom_node_internal **copy);
+		struct dom_document *doc, dom_node_internal **copy);
 
 #define DOM_HTML_TABLE_ROW_ELEMENT_PROTECT_VTABLE \
 	_dom_html_table_row_element_parse_attribute
@@ -48,6 +59,10 @@ dom_exception _dom_html_table_row_element_copy(dom_node_internal *old,
 	_dom_virtual_html_table_row_element_destroy, \
 	_dom_html_table_row_element_copy
 
+/* Number the cells of a row, if they have changed since last numbered */
+void _dom_html_table_row_element_update_cells(
+		dom_html_table_row_element *row);
+
 /* Helper functions*/
 dom_exception _dom_html_table_row_element_copy_internal(
 		dom_html_table_row_element *old,
@@ -41,7 +41,8 @@ dom_exception _dom_html_table_section_element_create(
 {
 	struct dom_node_internal *node;
 
-	*ele = malloc(sizeof(dom_html_table_section_element));
+	*ele = _dom_node_alloc(&params->doc->base,
+			sizeof(dom_html_table_section_element));
 	if (*ele == NULL)
 		return DOM_NO_MEM_ERR;
 
@@ -85,7 +86,7 @@ void _dom_html_table_section_element_finalise(struct dom_html_table_section_elem
 void _dom_html_table_section_element_destroy(struct dom_html_table_section_element *ele)
 {
 	_dom_html_table_section_element_finalise(ele);
-	free(ele);
+	_dom_node_free(ele);
 }
 
 /*------------------------------------------------------------------------*/
@@ -114,18 +115,20 @@ void _dom_virtual_html_table_section_element_destroy(dom_node_internal *node)
 
 /* The virtual copy function, see src/core/node.c for detail */
 dom_exception _dom_html_table_section_element_copy(
-		dom_node_internal *old, dom_node_internal **copy)
+		dom_node_internal *old, struct dom_document *doc,
+		dom_node_internal **copy)
 {
 	dom_html_table_section_element *new_node;
 	dom_exception err;
 
-	new_node = malloc(sizeof(dom_html_table_section_element));
+	new_node = _dom_node_alloc(doc,
+			sizeof(dom_html_table_section_element));
 	if (new_node == NULL)
 		return DOM_NO_MEM_ERR;
 
 	err = dom_html_table_section_element_copy_internal(old, new_node);
 	if (err != DOM_NO_ERR) {
-		free(new_node);
+		_dom_node_free(new_node);
 		return err;
 	}
 
@@ -195,13 +198,10 @@ SIMPLE_GET_SET(v_align);
 /* The callback function for  _dom_html_collection_create*/
 static bool table_section_callback(struct dom_node_internal *node, void *ctx)
 {
-	dom_html_document *doc = ctx;
-	if(node->type == DOM_ELEMENT_NODE &&
-			dom_string_caseless_isequal(node->name,
-				doc->elements[DOM_HTML_ELEMENT_TYPE_TR])) {
-		return true;
-	}
-	return false;
+	UNUSED(ctx);
+
+	return _dom_html_node_get_element_type(node) ==
+			DOM_HTML_ELEMENT_TYPE_TR;
 }
 
 /**
@@ -0,0 +1,451 @@
+/*
+ * This file is part of libdom.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "utils/ascii.h"
+
+/* The kernels work on blocks of 16 bytes with SSE2 or AArch64 NEON, when
+ * the compiler targets them, and then on 8 byte words, leaving only the
+ * last few bytes to be handled one at a time.  Both instruction sets are
+ * part of their architecture's baseline, so there is nothing to detect
+ * at runtime.  Defining DOM_ASCII_SCALAR leaves out the vector code. */
+#if !defined(DOM_ASCII_SCALAR) && defined(__SSE2__)
+#include <emmintrin.h>
+#define DOM_ASCII_SSE2
+#elif !defined(DOM_ASCII_SCALAR) && defined(__ARM_NEON) && \
+		defined(__aarch64__)
+#include <arm_neon.h>
+#define DOM_ASCII_NEON
+#endif
+
+/** A word with every byte 0x01 */
+#define ONES UINT64_C(0x0101010101010101)
+
+/** A word with every byte 0x80 */
+#define HIGHS UINT64_C(0x8080808080808080)
+
+static inline uint64_t load_word(const uint8_t *s);
+static inline void store_word(uint8_t *d, uint64_t w);
+static inline uint64_t word_range(uint64_t w, uint8_t lo, uint8_t hi);
+static inline uint64_t word_byte(uint64_t w, uint8_t c);
+static inline bool in_range(uint8_t c, uint8_t lo, uint8_t hi);
+static size_t find_range(const uint8_t *s, size_t len, uint8_t lo,
+		uint8_t hi);
+static void flip_range(uint8_t *dst, const uint8_t *src, size_t len,
+		uint8_t lo, uint8_t hi);
+
+#ifdef DOM_ASCII_SSE2
+/**
+ * Find the lowest set bit of a mask
+ *
+ * \param m  The mask, which must not be 0
+ * \return the index of the lowest set bit
+ */
+static inline unsigned int lowest_bit(unsigned int m)
+{
+#ifdef __GNUC__
+	return __builtin_ctz(m);
+#else
+	unsigned int n = 0;
+
+	while ((m & 1) == 0) {
+		m >>= 1;
+		n++;
+	}
+
+	return n;
+#endif
+}
+
+/**
+ * Make a mask of the bytes of a block within a range
+ *
+ * \param v   The block
+ * \param lo  The lowest byte in the range
+ * \param k   The size of the range, less one, in every byte
+ * \return a block with bytes in the range 0xff and the rest 0.
+ */
+static inline __m128i block_range(__m128i v, __m128i lo, __m128i k)
+{
+	__m128i t = _mm_sub_epi8(v, lo);
+
+	/* There is no unsigned comparison, but t <= k if min(t, k) == t */
+	return _mm_cmpeq_epi8(_mm_min_epu8(t, k), t);
+}
+#endif
+
+/**
+ * Load a word from a byte array, which need not be aligned
+ *
+ * \param s  Pointer to the bytes
+ * \return the word
+ */
+uint64_t load_word(const uint8_t *s)
+{
+	uint64_t w;
+
+	memcpy(&w, s, sizeof(w));
+
+	return w;
+}
+
+/**
+ * Store a word to a byte array, which need not be aligned
+ *
+ * \param d  Pointer to the bytes
+ * \param w  The word
+ */
+void store_word(uint8_t *d, uint64_t w)
+{
+	memcpy(d, &w, sizeof(w));
+}
+
+/**
+ * Find the bytes of a word within a range of ASCII
+ *
+ * \param w   The word
+ * \param lo  The lowest byte in the range, which must not be 0
+ * \param hi  The highest byte in the range, which must be ASCII
+ * \return a word with 0x80 in each byte in the range and 0 elsewhere.
+ *
+ * The low seven bits of each byte are offset so that they carry into
+ * the high bit when at least lo or more than hi; neither sum can carry
+ * into the next byte.
+ */
+uint64_t word_range(uint64_t w, uint8_t lo, uint8_t hi)
+{
+	uint64_t low = w & ~HIGHS;
+	uint64_t ge = low + ONES * (uint8_t) (0x80 - lo);
+	uint64_t gt = low + ONES * (uint8_t) (0x7f - hi);
+
+	return ge & ~gt & ~w & HIGHS;
+}
+
+/**
+ * Test whether a word may contain a byte
+ *
+ * \param w  The word
+ * \param c  The byte to look for
+ * \return non-zero if ::w contains ::c, 0 if it does not.
+ *
+ * A borrow may give false positives in bytes above one which matches,
+ * so the result only tells whether there is a match at all.
+ */
+uint64_t word_byte(uint64_t w, uint8_t c)
+{
+	uint64_t x = w ^ (ONES * c);
+
+	return (x - ONES) & ~x & HIGHS;
+}
+
+/**
+ * Test whether a byte is within a range
+ *
+ * \param c   The byte
+ * \param lo  The lowest byte in the range
+ * \param hi  The highest byte in the range
+ * \return true if ::c is in the range, false otherwise.
+ */
+bool in_range(uint8_t c, uint8_t lo, uint8_t hi)
+{
+	return (uint8_t) (c - lo) <= (uint8_t) (hi - lo);
+}
+
+/**
+ * Find the first byte of a string within a range of ASCII
+ *
+ * \param s    The string
+ * \param len  The length of the string, in bytes
+ * \param lo   The lowest byte in the range, which must not be 0
+ * \param hi   The highest byte in the range, which must be ASCII
+ * \return the offset of the byte, or ::len if there is none.
+ */
+size_t find_range(const uint8_t *s, size_t len, uint8_t lo, uint8_t hi)
+{
+	size_t i = 0;
+
+#if defined(DOM_ASCII_SSE2)
+	const __m128i vlo = _mm_set1_epi8((char) lo);
+	const __m128i vk = _mm_set1_epi8((char) (hi - lo));
+
+	for (; i + 16 <= len; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *) (s + i));
+		int m = _mm_movemask_epi8(block_range(v, vlo, vk));
+
+		if (m != 0)
+			return i + lowest_bit(m);
+	}
+#elif defined(DOM_ASCII_NEON)
+	const uint8x16_t vlo = vdupq_n_u8(lo);
+	const uint8x16_t vk = vdupq_n_u8(hi - lo);
+
+	for (; i + 16 <= len; i += 16) {
+		uint8x16_t t = vsubq_u8(vld1q_u8(s + i), vlo);
+
+		if (vmaxvq_u8(vcleq_u8(t, vk)) != 0)
+			break;
+	}
+#endif
+
+	for (; i + 8 <= len; i += 8) {
+		if (word_range(load_word(s + i), lo, hi) != 0)
+			break;
+	}
+
+	for (; i < len; i++) {
+		if (in_range(s[i], lo, hi))
+			return i;
+	}
+
+	return len;
+}
+
+/**
+ * Copy a string, changing the case of letters within a range
+ *
+ * \param dst  Location to receive the result, which may be ::src
+ * \param src  The string
+ * \param len  The length of the string, in bytes
+ * \param lo   The lowest byte in the range, which must not be 0
+ * \param hi   The highest byte in the range, which must be ASCII
+ *
+ * The case of an ASCII letter is its 0x20 bit.
+ */
+void flip_range(uint8_t *dst, const uint8_t *src, size_t len,
+		uint8_t lo, uint8_t hi)
+{
+	size_t i = 0;
+
+#if defined(DOM_ASCII_SSE2)
+	const __m128i vlo = _mm_set1_epi8((char) lo);
+	const __m128i vk = _mm_set1_epi8((char) (hi - lo));
+	const __m128i bit = _mm_set1_epi8(0x20);
+
+	for (; i + 16 <= len; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+		__m128i m = block_range(v, vlo, vk);
+
+		v = _mm_xor_si128(v, _mm_and_si128(m, bit));
+		_mm_storeu_si128((__m128i *) (dst + i), v);
+	}
+#elif defined(DOM_ASCII_NEON)
+	const uint8x16_t vlo = vdupq_n_u8(lo);
+	const uint8x16_t vk = vdupq_n_u8(hi - lo);
+	const uint8x16_t bit = vdupq_n_u8(0x20);
+
+	for (; i + 16 <= len; i += 16) {
+		uint8x16_t v = vld1q_u8(src + i);
+		uint8x16_t m = vcleq_u8(vsubq_u8(v, vlo), vk);
+
+		vst1q_u8(dst + i, veorq_u8(v, vandq_u8(m, bit)));
+	}
+#endif
+
+	for (; i + 8 <= len; i += 8) {
+		uint64_t w = load_word(src + i);
+
+		store_word(dst + i, w ^ (word_range(w, lo, hi) >> 2));
+	}
+
+	for (; i < len; i++)
+		dst[i] = src[i] ^ (in_range(src[i], lo, hi) ? 0x20 : 0);
+}
+
+/**
+ * Find the first upper case ASCII letter in a string
+ *
+ * \param s    The string
+ * \param len  The length of the string, in bytes
+ * \return the offset of the letter, or ::len if there is none.
+ */
+size_t _dom_ascii_find_upper(const uint8_t *s, size_t len)
+{
+	return find_range(s, len, 'A', 'Z');
+}
+
+/**
+ * Find the first lower case ASCII letter in a string
+ *
+ * \param s    The string
+ * \param len  The length of the string, in bytes
+ * \return the offset of the letter, or ::len if there is none.
+ */
+size_t _dom_ascii_find_lower(const uint8_t *s, size_t len)
+{
+	return find_range(s, len, 'a', 'z');
+}
+
+/**
+ * Find the first whitespace character in a string
+ *
+ * \param s    The string
+ * \param len  The length of the string, in bytes
+ * \return the offset of the whitespace, or ::len if there is none.
+ */
+size_t _dom_ascii_find_space(const uint8_t *s, size_t len)
+{
+	size_t i = 0;
+
+#if defined(DOM_ASCII_SSE2)
+	const __m128i space = _mm_set1_epi8(' ');
+	const __m128i tab = _mm_set1_epi8('\t');
+	const __m128i lf = _mm_set1_epi8('\n');
+	const __m128i cr = _mm_set1_epi8('\r');
+	const __m128i ff = _mm_set1_epi8('\f');
+
+	for (; i + 16 <= len; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *) (s + i));
+		__m128i m = _mm_cmpeq_epi8(v, space);
+		int bits;
+
+		m = _mm_or_si128(m, _mm_cmpeq_epi8(v, tab));
+		m = _mm_or_si128(m, _mm_cmpeq_epi8(v, lf));
+		m = _mm_or_si128(m, _mm_cmpeq_epi8(v, cr));
+		m = _mm_or_si128(m, _mm_cmpeq_epi8(v, ff));
+
+		bits = _mm_movemask_epi8(m);
+
+		if (bits != 0)
+			return i + lowest_bit(bits);
+	}
+#elif defined(DOM_ASCII_NEON)
+	const uint8x16_t space = vdupq_n_u8(' ');
+	const uint8x16_t tab = vdupq_n_u8('\t');
+	const uint8x16_t lf = vdupq_n_u8('\n');
+	const uint8x16_t cr = vdupq_n_u8('\r');
+	const uint8x16_t ff = vdupq_n_u8('\f');
+
+	for (; i + 16 <= len; i += 16) {
+		uint8x16_t v = vld1q_u8(s + i);
+		uint8x16_t m = vceqq_u8(v, space);
+
+		m = vorrq_u8(m, vceqq_u8(v, tab));
+		m = vorrq_u8(m, vceqq_u8(v, lf));
+		m = vorrq_u8(m, vceqq_u8(v, cr));
+		m = vorrq_u8(m, vceqq_u8(v, ff));
+
+		if (vmaxvq_u8(m) != 0)
+			break;
+	}
+#endif
+
+	for (; i + 8 <= len; i += 8) {
+		uint64_t w = load_word(s + i);
+
+		if ((word_byte(w, ' ') | word_byte(w, '\t') |
+				word_byte(w, '\n') | word_byte(w, '\r') |
+				word_byte(w, '\f')) != 0)
+			break;
+	}
+
+	for (; i < len; i++) {
+		if (_dom_ascii_is_space(s[i]))
+			return i;
+	}
+
+	return len;
+}
+
+/**
+ * Copy a string, making its ASCII letters lower case
+ *
+ * \param dst  Location to receive the result, which may be ::src
+ * \param src  The string
+ * \param len  The length of the string, in bytes
+ */
+void _dom_ascii_tolower(uint8_t *dst, const uint8_t *src, size_t len)
+{
+	flip_range(dst, src, len, 'A', 'Z');
+}
+
+/**
+ * Copy a string, making its ASCII letters upper case
+ *
+ * \param dst  Location to receive the result, which may be ::src
+ * \param src  The string
+ * \param len  The length of the string, in bytes
+ */
+void _dom_ascii_toupper(uint8_t *dst, const uint8_t *src, size_t len)
+{
+	flip_range(dst, src, len, 'a', 'z');
+}
+
+/**
+ * Compare two strings, ignoring the case of ASCII letters
+ *
+ * \param s1   The first string
+ * \param s2   The second string
+ * \param len  The length of both strings, in bytes
+ * \return true if the strings match, false otherwise.
+ */
+bool _dom_ascii_caseless_isequal(const uint8_t *s1, const uint8_t *s2,
+		size_t len)
+{
+	size_t i = 0;
+
+#if defined(DOM_ASCII_SSE2)
+	const __m128i vlo = _mm_set1_epi8('A');
+	const __m128i vk = _mm_set1_epi8('Z' - 'A');
+	const __m128i bit = _mm_set1_epi8(0x20);
+
+	for (; i + 16 <= len; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i *) (s1 + i));
+		__m128i b = _mm_loadu_si128((const __m128i *) (s2 + i));
+
+		/* Set the 0x20 bit of upper case letters */
+		a = _mm_or_si128(a,
+				_mm_and_si128(block_range(a, vlo, vk), bit));
+		b = _mm_or_si128(b,
+				_mm_and_si128(block_range(b, vlo, vk), bit));
+
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xffff)
+			return false;
+	}
+#elif defined(DOM_ASCII_NEON)
+	const uint8x16_t vlo = vdupq_n_u8('A');
+	const uint8x16_t vk = vdupq_n_u8('Z' - 'A');
+	const uint8x16_t bit = vdupq_n_u8(0x20);
+
+	for (; i + 16 <= len; i += 16) {
+		uint8x16_t a = vld1q_u8(s1 + i);
+		uint8x16_t b = vld1q_u8(s2 + i);
+
+		a = vorrq_u8(a, vandq_u8(vcleq_u8(vsubq_u8(a, vlo), vk), bit));
+		b = vorrq_u8(b, vandq_u8(vcleq_u8(vsubq_u8(b, vlo), vk), bit));
+
+		if (vminvq_u8(vceqq_u8(a, b)) == 0)
+			return false;
+	}
+#endif
+
+	for (; i + 8 <= len; i += 8) {
+		uint64_t a = load_word(s1 + i);
+		uint64_t b = load_word(s2 + i);
+
+		a |= word_range(a, 'A', 'Z') >> 2;
+		b |= word_range(b, 'A', 'Z') >> 2;
+
+		if (a != b)
+			return false;
+	}
+
+	for (; i < len; i++) {
+		uint8_t a = s1[i], b = s2[i];
+
+		if (in_range(a, 'A', 'Z'))
+			a |= 0x20;
+		if (in_range(b, 'A', 'Z'))
+			b |= 0x20;
+
+		if (a != b)
+			return false;
+	}
+
+	return true;
+}
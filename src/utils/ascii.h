@@ -0,0 +1,35 @@
+/*
+ * This file is part of libdom.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#ifndef dom_utils_ascii_h_
+#define dom_utils_ascii_h_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+size_t _dom_ascii_find_upper(const uint8_t *s, size_t len);
+size_t _dom_ascii_find_lower(const uint8_t *s, size_t len);
+size_t _dom_ascii_find_space(const uint8_t *s, size_t len);
+
+void _dom_ascii_tolower(uint8_t *dst, const uint8_t *src, size_t len);
+void _dom_ascii_toupper(uint8_t *dst, const uint8_t *src, size_t len);
+
+bool _dom_ascii_caseless_isequal(const uint8_t *s1, const uint8_t *s2,
+		size_t len);
+
+/**
+ * Test whether a byte is HTML whitespace
+ *
+ * \param c  The byte to test
+ * \return true if ::c is space, tab, line feed, form feed or carriage return
+ */
+static inline bool _dom_ascii_is_space(uint8_t c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+#endif
@@ -10,6 +10,8 @@
 
 #include <dom/dom.h>
 
+#include "core/document.h"
+#include "core/node.h"
 #include "utils/namespace.h"
 #include "utils/validate.h"
 #include "utils/utils.h"
@@ -81,11 +83,19 @@ static dom_exception _dom_namespace_initialise(void)
  * Finalise the namespace component
  *
  * \return DOM_NO_ERR on success.
+ *
+ * This also releases the strings shared by documents, the registered user
+ * data keys and the remembered validity of names, so it may only be called
+ * once every document has been destroyed.
  */
 dom_exception dom_namespace_finalise(void)
 {
 	int i;
 
+	_dom_document_strings_finalise();
+	_dom_node_user_data_finalise();
+	_dom_validate_finalise();
+
 	if (xmlns != NULL) {
 		dom_string_unref(xmlns);
 		xmlns = NULL;
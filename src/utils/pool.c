@@ -0,0 +1,240 @@
+/*
+ * This file is part of libdom.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "utils/pool.h"
+
+/* Memory checkers such as AddressSanitizer cannot see use-after-free of
+ * memory which is recycled by the pool, so every allocation is passed
+ * straight through to malloc when building with one, or when
+ * DOM_POOL_DISABLE is defined. */
+#if !defined(DOM_POOL_DISABLE) && defined(__SANITIZE_ADDRESS__)
+#define DOM_POOL_DISABLE
+#endif
+#if !defined(DOM_POOL_DISABLE) && defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define DOM_POOL_DISABLE
+#endif
+#endif
+
+/** Size class granularity, in bytes */
+#define DOM_POOL_GRANULE 16
+
+/** Number of size classes; larger allocations are passed to malloc */
+#define DOM_POOL_CLASSES 32
+
+/** Size of each slab, in bytes */
+#define DOM_POOL_SLAB_SIZE 32768
+
+struct dom_pool;
+
+/**
+ * A size class, and its list of free chunks
+ */
+struct dom_pool_class {
+	union dom_pool_header *free;	/**< First free chunk */
+	struct dom_pool *pool;		/**< The pool we belong to */
+};
+
+/**
+ * The header preceding every allocation
+ */
+typedef union dom_pool_header {
+	struct dom_pool_class *cls;	/**< Size class, or NULL if the
+					 * allocation came from malloc */
+	union dom_pool_header *next;	/**< Next free chunk, when free */
+	double align;			/**< Force suitable alignment */
+} dom_pool_header;
+
+/**
+ * A slab, from which chunks of all size classes are carved
+ */
+typedef struct dom_pool_slab {
+	struct dom_pool_slab *next;	/**< Next slab in the pool */
+	dom_pool_header data[];		/**< The chunks */
+} dom_pool_slab;
+
+/**
+ * A pool of memory
+ *
+ * Freed chunks are kept on a list per size class for reuse, and slabs are
+ * only returned to the system when the pool is destroyed.  The pool is
+ * destroyed once its owner has released it and every chunk allocated
+ * from it has been freed.
+ */
+struct dom_pool {
+	struct dom_pool_class classes[DOM_POOL_CLASSES];
+					/**< The size classes */
+
+	dom_pool_slab *slabs;		/**< All slabs in the pool */
+	char *next;			/**< Unused space in the newest slab */
+	size_t avail;			/**< Bytes available at next */
+
+	uint32_t live;			/**< Number of chunks in use */
+	bool released;			/**< Whether the owner has finished */
+};
+
+/**
+ * Create a pool
+ *
+ * \return the new pool, or NULL on memory exhaustion
+ */
+dom_pool *_dom_pool_create(void)
+{
+	dom_pool *pool;
+	int i;
+
+	pool = malloc(sizeof(*pool));
+	if (pool == NULL)
+		return NULL;
+
+	for (i = 0; i < DOM_POOL_CLASSES; i++) {
+		pool->classes[i].free = NULL;
+		pool->classes[i].pool = pool;
+	}
+
+	pool->slabs = NULL;
+	pool->next = NULL;
+	pool->avail = 0;
+	pool->live = 0;
+	pool->released = false;
+
+	return pool;
+}
+
+/**
+ * Destroy a pool, and all its slabs
+ *
+ * \param pool  The pool to destroy
+ */
+static void _dom_pool_destroy(dom_pool *pool)
+{
+	dom_pool_slab *slab, *next;
+
+	for (slab = pool->slabs; slab != NULL; slab = next) {
+		next = slab->next;
+		free(slab);
+	}
+
+	free(pool);
+}
+
+/**
+ * Release the owner's interest in a pool
+ *
+ * \param pool  The pool to release, or NULL
+ *
+ * The pool is destroyed immediately if no chunks remain in use; otherwise
+ * it is destroyed when the last of them is freed.
+ */
+void _dom_pool_release(dom_pool *pool)
+{
+	if (pool == NULL)
+		return;
+
+	pool->released = true;
+
+	if (pool->live == 0)
+		_dom_pool_destroy(pool);
+}
+
+/**
+ * Allocate memory from a pool
+ *
+ * \param pool  The pool to allocate from, or NULL to use malloc
+ * \param size  The number of bytes required
+ * \return the allocated memory, or NULL on memory exhaustion
+ *
+ * The returned memory must be freed with _dom_pool_free.
+ */
+void *_dom_pool_alloc(dom_pool *pool, size_t size)
+{
+	struct dom_pool_class *cls;
+	dom_pool_header *chunk;
+	size_t c;
+
+#ifndef DOM_POOL_DISABLE
+	c = (size + DOM_POOL_GRANULE - 1) / DOM_POOL_GRANULE;
+#else
+	c = DOM_POOL_CLASSES + 1;
+#endif
+
+	if (pool == NULL || size == 0 || c > DOM_POOL_CLASSES) {
+		chunk = malloc(sizeof(dom_pool_header) + size);
+		if (chunk == NULL)
+			return NULL;
+
+		chunk->cls = NULL;
+
+		return chunk + 1;
+	}
+
+	cls = &pool->classes[c - 1];
+
+	if (cls->free != NULL) {
+		chunk = cls->free;
+		cls->free = chunk->next;
+	} else {
+		size_t need = sizeof(dom_pool_header) + c * DOM_POOL_GRANULE;
+
+		if (pool->avail < need) {
+			/* Start a new slab; the tail of the old one is
+			 * wasted, which is at most one chunk's worth */
+			dom_pool_slab *slab = malloc(sizeof(dom_pool_slab) +
+					DOM_POOL_SLAB_SIZE);
+			if (slab == NULL)
+				return NULL;
+
+			slab->next = pool->slabs;
+			pool->slabs = slab;
+			pool->next = (char *) slab->data;
+			pool->avail = DOM_POOL_SLAB_SIZE;
+		}
+
+		chunk = (dom_pool_header *) (void *) pool->next;
+		pool->next += need;
+		pool->avail -= need;
+	}
+
+	chunk->cls = cls;
+	pool->live++;
+
+	return chunk + 1;
+}
+
+/**
+ * Free memory allocated by _dom_pool_alloc
+ *
+ * \param ptr  The memory to free, or NULL
+ */
+void _dom_pool_free(void *ptr)
+{
+	dom_pool_header *chunk;
+	struct dom_pool_class *cls;
+	dom_pool *pool;
+
+	if (ptr == NULL)
+		return;
+
+	chunk = (dom_pool_header *) ptr - 1;
+	cls = chunk->cls;
+
+	if (cls == NULL) {
+		free(chunk);
+		return;
+	}
+
+	pool = cls->pool;
+
+	chunk->next = cls->free;
+	cls->free = chunk;
+
+	if (--pool->live == 0 && pool->released)
+		_dom_pool_destroy(pool);
+}
@@ -0,0 +1,20 @@
+/*
+ * This file is part of libdom.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#ifndef dom_utils_pool_h_
+#define dom_utils_pool_h_
+
+#include <stddef.h>
+
+typedef struct dom_pool dom_pool;
+
+dom_pool *_dom_pool_create(void);
+void _dom_pool_release(dom_pool *pool);
+
+void *_dom_pool_alloc(dom_pool *pool, size_t size);
+void _dom_pool_free(void *ptr);
+
+#endif
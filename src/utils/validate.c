@@ -10,7 +10,9 @@
 
 #include "utils/validate.h"
 
-#include <dom/core/string.h>
+#include <dom/dom.h>
+
+#include "core/string.h"
 
 #include "utils/character_valid.h"
 #include "utils/namespace.h"
@@ -21,6 +23,57 @@
 /* An combination of various tests */
 static bool is_first_char(uint32_t ch);
 static bool is_name_char(uint32_t ch);
+static bool validate_chars(const uint8_t *s, size_t slen, bool ncname);
+static bool validate_name(dom_string *name, bool ncname);
+
+/* Classes of ASCII characters in names */
+#define NAME_START	(1 << 0)	/**< May start a Name */
+#define NAME_CHAR	(1 << 1)	/**< May be part of a Name */
+#define NCNAME_START	(1 << 2)	/**< May start an NCName */
+#define NCNAME_CHAR	(1 << 3)	/**< May be part of an NCName */
+
+#define L (NAME_START | NAME_CHAR | NCNAME_START | NCNAME_CHAR)
+#define C (NAME_START | NAME_CHAR)
+#define D (NAME_CHAR | NCNAME_CHAR)
+
+/**
+ * Classes of each byte, with letters and '_' as L, ':' as C, and digits,
+ * '-' and '.' as D.  Every byte of a multibyte character is in no class,
+ * so that the table alone tells whether a name needs decoding.
+ */
+static const uint8_t name_class[256] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, D, D, 0,
+	D, D, D, D, D, D, D, D, D, D, C, 0, 0, 0, 0, 0,
+	0, L, L, L, L, L, L, L, L, L, L, L, L, L, L, L,
+	L, L, L, L, L, L, L, L, L, L, L, 0, 0, 0, 0, L,
+	0, L, L, L, L, L, L, L, L, L, L, L, L, L, L, L,
+	L, L, L, L, L, L, L, L, L, L, L, 0, 0, 0, 0, 0,
+};
+
+#undef L
+#undef C
+#undef D
+
+/* Flags recording what is known of an interned name */
+#define NAME_CHECKED	(1 << 0)	/**< Tested as a Name */
+#define NAME_VALID	(1 << 1)	/**< Is a valid Name */
+#define NCNAME_CHECKED	(1 << 2)	/**< Tested as an NCName */
+#define NCNAME_VALID	(1 << 3)	/**< Is a valid NCName */
+
+/** Number of interned names whose validity is remembered */
+#define VALIDATE_CACHE_SIZE	256
+
+/**
+ * The validity of interned names tested so far, indexed by their hash.
+ * Each entry holds a reference to its name, so no other string can take
+ * its address while it is in the cache.
+ */
+static struct validate_cache_entry {
+	lwc_string *name;	/**< The name, or NULL if the entry is empty */
+	uint8_t flags;		/**< What is known of the name */
+} validate_cache[VALIDATE_CACHE_SIZE];
 
 /* Test whether the character can be the first character of
  * a NCName. */
@@ -89,51 +142,69 @@ static bool is_name_char(uint32_t ch)
 }
 
 /**
- * Test whether the name is a valid one according XML 1.0 standard.
- * For the standard please refer:
+ * Test whether a string of UTF-8 is a Name or an NCName
  *
- * http://www.w3.org/TR/2004/REC-xml-20040204/
+ * \param s       The string to test
+ * \param slen    The length of the string, in bytes
+ * \param ncname  Whether to test for an NCName, rather than a Name
+ * \return true if ::s is valid, false otherwise.
  *
- * \param name  The name need to be tested
- * \return true if ::name is valid, false otherwise.
+ * Names are almost always ASCII, so their characters are looked up in
+ * name_class, and only decoded from the first byte which is not ASCII.
  */
-bool _dom_validate_name(dom_string *name)
+bool validate_chars(const uint8_t *s, size_t slen, bool ncname)
 {
-	uint32_t ch;
-	size_t clen, slen;
+	const uint8_t start = ncname ? NCNAME_START : NAME_START;
+	const uint8_t rest = ncname ? NCNAME_CHAR : NAME_CHAR;
 	parserutils_error err;
-	const uint8_t *s;
-
-	if (name == NULL)
-		return false;
+	uint32_t ch;
+	size_t clen, i;
 
-	slen = dom_string_length(name);
 	if (slen == 0)
 		return false;
 
-	s = (const uint8_t *) dom_string_data(name);
-	slen = dom_string_byte_length(name);
-	
-	err = parserutils_charset_utf8_to_ucs4(s, slen, &ch, &clen);
-	if (err != PARSERUTILS_OK) {
-		return false;
+	if (s[0] < 0x80) {
+		if ((name_class[s[0]] & start) == 0)
+			return false;
+
+		for (i = 1; i < slen && (name_class[s[i]] & rest) != 0; i++)
+			;
+
+		if (i == slen)
+			return true;
+
+		/* Any other ASCII character is invalid */
+		if (s[i] < 0x80)
+			return false;
+	} else {
+		err = parserutils_charset_utf8_to_ucs4(s, slen, &ch, &clen);
+		if (err != PARSERUTILS_OK)
+			return false;
+
+		if (ncname) {
+			if (is_letter(ch) == false && ch != (uint32_t) '_')
+				return false;
+		} else if (is_first_char(ch) == false) {
+			return false;
+		}
+
+		i = clen;
 	}
-	
-	if (is_first_char(ch) == false)
-		return false;
-	
-	s += clen;
-	slen -= clen;
-	
+
+	s += i;
+	slen -= i;
+
 	while (slen > 0) {
 		err = parserutils_charset_utf8_to_ucs4(s, slen, &ch, &clen);
-		if (err != PARSERUTILS_OK) {
+		if (err != PARSERUTILS_OK)
 			return false;
-		}
 
 		if (is_name_char(ch) == false)
 			return false;
 
+		if (ncname && ch == (uint32_t) ':')
+			return false;
+
 		s += clen;
 		slen -= clen;
 	}
@@ -141,6 +212,70 @@ bool _dom_validate_name(dom_string *name)
 	return true;
 }
 
+/**
+ * Test whether a name is a Name or an NCName, remembering the result if
+ * it is interned
+ *
+ * \param name    The name to test
+ * \param ncname  Whether to test for an NCName, rather than a Name
+ * \return true if ::name is valid, false otherwise.
+ *
+ * The parsers and the documents' memoised strings intern the names they
+ * use over and over, so most names are only tested once.
+ */
+bool validate_name(dom_string *name, bool ncname)
+{
+	const uint8_t checked = ncname ? NCNAME_CHECKED : NAME_CHECKED;
+	const uint8_t valid = ncname ? NCNAME_VALID : NAME_VALID;
+	struct validate_cache_entry *entry;
+	lwc_string *intern;
+	bool result;
+
+	intern = _dom_string_get_intern(name);
+	if (intern == NULL) {
+		return validate_chars((const uint8_t *) dom_string_data(name),
+				dom_string_byte_length(name), ncname);
+	}
+
+	entry = &validate_cache[lwc_string_hash_value(intern) &
+			(VALIDATE_CACHE_SIZE - 1)];
+
+	if (entry->name == intern && (entry->flags & checked) != 0)
+		return (entry->flags & valid) != 0;
+
+	result = validate_chars((const uint8_t *) lwc_string_data(intern),
+			lwc_string_length(intern), ncname);
+
+	if (entry->name != intern) {
+		if (entry->name != NULL)
+			lwc_string_unref(entry->name);
+
+		entry->name = lwc_string_ref(intern);
+		entry->flags = 0;
+	}
+
+	entry->flags |= checked | (result ? valid : 0);
+
+	return result;
+}
+
+/**
+ * Test whether the name is a valid one according XML 1.0 standard.
+ * For the standard please refer:
+ *
+ * http://www.w3.org/TR/2004/REC-xml-20040204/
+ *
+ * \param name  The name need to be tested
+ * \return true if ::name is valid, false otherwise.
+ */
+bool _dom_validate_name(dom_string *name)
+{
+	if (name == NULL)
+		return false;
+
+	return validate_name(name, false);
+}
+
 /**
  * Validate whether the string is a legal NCName.
  * Refer http://www.w3.org/TR/REC-xml-names/ for detail.
@@ -150,48 +285,24 @@ bool _dom_validate_name(dom_string *name)
  */
 bool _dom_validate_ncname(dom_string *name)
 {
-	uint32_t ch;
-	size_t clen, slen;
-	parserutils_error err;
-	const uint8_t *s;
-
 	if (name == NULL)
 		return false;
 
-	slen = dom_string_length(name);
-	if (slen == 0)
-		return false;
-
-	s = (const uint8_t *) dom_string_data(name);
-	slen = dom_string_byte_length(name);
-	
-	err = parserutils_charset_utf8_to_ucs4(s, slen, &ch, &clen);
-	if (err != PARSERUTILS_OK) {
-		return false;
-	}
-	
-	if (is_letter(ch) == false && ch != (uint32_t) '_')
-		return false;
-	
-	s += clen;
-	slen -= clen;
-	
-	while (slen > 0) {
-		err = parserutils_charset_utf8_to_ucs4(s, slen, &ch, &clen);
-		if (err != PARSERUTILS_OK) {
-			return false;
-		}
+	return validate_name(name, true);
+}
 
-		if (is_name_char(ch) == false)
-			return false;
+/**
+ * Release the interned names whose validity is remembered
+ */
+void _dom_validate_finalise(void)
+{
+	int i;
 
-		if (ch == (uint32_t) ':')
-			return false;
+	for (i = 0; i < VALIDATE_CACHE_SIZE; i++) {
+		if (validate_cache[i].name != NULL)
+			lwc_string_unref(validate_cache[i].name);
 
-		s += clen;
-		slen -= clen;
+		validate_cache[i].name = NULL;
+		validate_cache[i].flags = 0;
 	}
-
-	return true;
 }
-
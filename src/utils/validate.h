@@ -21,5 +21,7 @@
 bool _dom_validate_name(dom_string *name);
 bool _dom_validate_ncname(dom_string *name);
 
+void _dom_validate_finalise(void);
+
 #endif
 
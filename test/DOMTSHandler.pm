@@ -452,6 +452,9 @@ sub generate_var {
 	} else {
 		if ($type =~ m/\*/) {
 			print " = NULL;\n";
+		} elsif ($ats->{"type"} eq "int") {
+			# Methods may set fewer bytes than an int holds
+			print " = 0;\n";
 		} else {
 			print ";\n";
 		}
@@ -1018,6 +1021,13 @@ sub generate_condition {
 			$ig = adjust_ignore($ig);
 
 			my $func = $self->find_override("is_equals", $actual, $expected);
+
+			# Compare only the bits the bitmask selects
+			if (defined $ats->{bitmask}) {
+				$actual = "($actual & $ats->{bitmask})";
+				$expected = "($expected & $ats->{bitmask})";
+			}
+
 			if ($name =~ /not/i){
 				print "(false == $func($expected, $actual, $ig))";
 			} else {
@@ -1168,6 +1178,7 @@ sub generate_assertion {
 						expected => $ats->{expected},
 						ignoreCase => $ats->{ignoreCase},
 						type => $ats->{type},
+						bitmask => $ats->{bitmask},
 					 };
 				$self->generate_condition($n,$ta);
 			}
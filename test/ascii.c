@@ -0,0 +1,323 @@
+/*
+ * This file is part of libdom test suite.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <dom/dom.h>
+
+/* The string kernels, which work on blocks of 16 bytes, then on words of
+ * 8, then on single bytes */
+#include "utils/ascii.h"
+
+#include <domts.h>
+
+/* Lengths up to five blocks, so every mix of blocks, words and bytes */
+#define MAX_LEN 80
+
+/* Starts at every misalignment of a block */
+#define MAX_ALIGN 16
+
+/* Bytes next to the ranges the kernels look for, and bytes which are
+ * the same as those but for the high bit */
+static const uint8_t near[] = {
+	'@', '[', '`', '{', 'A' | 0x80, 'Z' | 0x80, 'a' | 0x80, 'z' | 0x80,
+	0x00, 0x08, 0x0B, 0x0E, 0x1F, 0x21, ' ' | 0x80, '\t' | 0x80,
+	0x7F, 0x80, 0xFF, '0'
+};
+
+#define N_NEAR (sizeof(near) / sizeof(near[0]))
+
+/* The bytes each search looks for */
+static const char uppers[] = "AMZ";
+static const char lowers[] = "amz";
+static const char spaces[] = " \t\n\r\f";
+
+static uint32_t seed = 1;
+
+static uint8_t random_byte(void)
+{
+	seed = seed * 1103515245 + 12345;
+
+	return seed >> 16;
+}
+
+/* Fill a buffer with bytes next to, but outside, the ranges looked for */
+static void fill_near(uint8_t *s, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		s[i] = near[random_byte() % N_NEAR];
+}
+
+static void fill_random(uint8_t *s, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		s[i] = random_byte();
+}
+
+static bool scalar_is_upper(uint8_t c)
+{
+	return c >= 'A' && c <= 'Z';
+}
+
+static bool scalar_is_lower(uint8_t c)
+{
+	return c >= 'a' && c <= 'z';
+}
+
+static bool scalar_is_space(uint8_t c)
+{
+	return c != '\0' && strchr(spaces, c) != NULL;
+}
+
+static size_t scalar_find(const uint8_t *s, size_t len, bool (*is)(uint8_t))
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		if (is(s[i]))
+			break;
+	}
+
+	return i;
+}
+
+static bool scalar_caseless_isequal(const uint8_t *s1, const uint8_t *s2,
+		size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		uint8_t a = scalar_is_upper(s1[i]) ? s1[i] + 32 : s1[i];
+		uint8_t b = scalar_is_upper(s2[i]) ? s2[i] + 32 : s2[i];
+
+		if (a != b)
+			return false;
+	}
+
+	return true;
+}
+
+/* The searches, each with the bytes it looks for */
+static const struct {
+	const char *name;
+	size_t (*find)(const uint8_t *s, size_t len);
+	bool (*is)(uint8_t c);
+	const char *targets;
+} searches[] = {
+	{ "find_upper", _dom_ascii_find_upper, scalar_is_upper, uppers },
+	{ "find_lower", _dom_ascii_find_lower, scalar_is_lower, lowers },
+	{ "find_space", _dom_ascii_find_space, scalar_is_space, spaces }
+};
+
+#define N_SEARCHES (sizeof(searches) / sizeof(searches[0]))
+
+static void check_find(size_t n, const uint8_t *s, size_t len)
+{
+	size_t found = searches[n].find(s, len);
+	size_t expected = scalar_find(s, len, searches[n].is);
+
+	if (found != expected)
+		printf("%s of %u bytes found %u, not %u\n", searches[n].name,
+				(unsigned) len, (unsigned) found,
+				(unsigned) expected);
+	assert(found == expected);
+}
+
+/* A byte looked for at every position, alone and followed by another,
+ * among bytes next to those looked for */
+static void test_find(void)
+{
+	static uint8_t buf[MAX_ALIGN + MAX_LEN];
+	size_t n, align, len, at, t;
+
+	for (n = 0; n < N_SEARCHES; n++) {
+		const char *targets = searches[n].targets;
+
+		for (align = 0; align < MAX_ALIGN; align++) {
+			uint8_t *s = buf + align;
+
+			for (len = 0; len <= MAX_LEN; len++) {
+				fill_near(s, len);
+				check_find(n, s, len);
+
+				for (at = 0; at < len; at++) {
+					t = (at + len) % strlen(targets);
+
+					fill_near(s, len);
+					s[at] = targets[t];
+					check_find(n, s, len);
+
+					/* A second one after it */
+					if (at + 1 < len) {
+						s[len - 1] = targets[0];
+						check_find(n, s, len);
+					}
+				}
+
+				/* Random bytes, which often hold some */
+				fill_random(s, len);
+				check_find(n, s, len);
+			}
+		}
+	}
+}
+
+/* Case changes of every byte value, copied and in place */
+static void test_recase(void)
+{
+	static uint8_t src[MAX_ALIGN + MAX_LEN];
+	static uint8_t dst[MAX_ALIGN + MAX_LEN + 1];
+	static uint8_t copy[MAX_LEN];
+	size_t align, len, i;
+	int upper;
+
+	for (upper = 0; upper < 2; upper++) {
+		void (*recase)(uint8_t *, const uint8_t *, size_t) = upper ?
+				_dom_ascii_toupper : _dom_ascii_tolower;
+		bool (*is)(uint8_t) = upper ?
+				scalar_is_lower : scalar_is_upper;
+
+		for (align = 0; align < MAX_ALIGN; align++) {
+			for (len = 0; len <= MAX_LEN; len++) {
+				uint8_t *s = src + align;
+				uint8_t *d = dst + MAX_ALIGN - 1 - align;
+
+				if (len % 2 == 0)
+					fill_random(s, len);
+				else
+					fill_near(s, len);
+				for (i = 0; i < len; i += 3)
+					s[i] = 'A' + (i + len) % 26 +
+							(i % 2) * 32;
+
+				/* Bytes past the end are left alone */
+				d[len] = 0xAA;
+				recase(d, s, len);
+				assert(d[len] == 0xAA);
+
+				for (i = 0; i < len; i++) {
+					uint8_t c = is(s[i]) ? s[i] ^ 0x20 :
+							s[i];
+
+					if (d[i] != c)
+						printf("byte %u of %u is %x, "
+								"not %x\n",
+								(unsigned) i,
+								(unsigned) len,
+								d[i], c);
+					assert(d[i] == c);
+				}
+
+				memcpy(copy, s, len);
+				recase(s, s, len);
+				assert(memcmp(s, d, len) == 0);
+				memcpy(s, copy, len);
+			}
+		}
+	}
+
+	/* Every byte value, in each position of a block */
+	for (i = 0; i < 256 + MAX_ALIGN; i++) {
+		uint8_t c = i % 256;
+
+		memset(src, 'x', MAX_LEN);
+		src[i % MAX_ALIGN + MAX_ALIGN] = c;
+		_dom_ascii_tolower(dst, src, MAX_LEN);
+		assert(dst[i % MAX_ALIGN + MAX_ALIGN] ==
+				(scalar_is_upper(c) ? c + 32 : c));
+		_dom_ascii_toupper(dst, src, MAX_LEN);
+		assert(dst[i % MAX_ALIGN + MAX_ALIGN] ==
+				(scalar_is_lower(c) ? c - 32 : c));
+	}
+}
+
+static void check_isequal(const uint8_t *s1, const uint8_t *s2, size_t len)
+{
+	bool equal = _dom_ascii_caseless_isequal(s1, s2, len);
+	bool expected = scalar_caseless_isequal(s1, s2, len);
+
+	if (equal != expected)
+		printf("caseless_isequal of %u bytes is %d, not %d\n",
+				(unsigned) len, equal, expected);
+	assert(equal == expected);
+	assert(_dom_ascii_caseless_isequal(s2, s1, len) == expected);
+}
+
+/* Pairs of bytes put at the same place in two strings, equal ignoring
+ * case or not, including bytes which differ only by the case bit but are
+ * not letters */
+static const uint8_t pairs[][2] = {
+	{ 'a', 'A' }, { 'z', 'Z' }, { 'm', 'N' }, { '@', '`' },
+	{ '[', '{' }, { 'A' | 0x80, 'a' | 0x80 }, { 'A', 'a' | 0x80 },
+	{ 0x00, ' ' }, { 'Z' | 0x80, 'z' }, { '^', '~' }
+};
+
+#define N_PAIRS (sizeof(pairs) / sizeof(pairs[0]))
+
+/* Strings differing only by case, and by one pair of bytes at each
+ * position */
+static void test_caseless(void)
+{
+	static uint8_t buf1[MAX_ALIGN + MAX_LEN];
+	static uint8_t buf2[MAX_ALIGN + MAX_LEN];
+	size_t align, len, at, i, p;
+
+	for (align = 0; align < MAX_ALIGN; align++) {
+		uint8_t *s1 = buf1 + align;
+		uint8_t *s2 = buf2 + (MAX_ALIGN - 1 - align);
+
+		for (len = 0; len <= MAX_LEN; len++) {
+			fill_near(s1, len);
+			for (i = 0; i < len; i += 2)
+				s1[i] = 'a' + (i + len) % 26;
+			for (i = 0; i < len; i++) {
+				s2[i] = scalar_is_lower(s1[i]) && i % 3 == 0 ?
+						s1[i] - 32 : s1[i];
+			}
+
+			check_isequal(s1, s2, len);
+
+			for (at = 0; at < len; at++) {
+				uint8_t c1 = s1[at], c2 = s2[at];
+
+				for (p = 0; p < N_PAIRS; p++) {
+					s1[at] = pairs[p][0];
+					s2[at] = pairs[p][1];
+					check_isequal(s1, s2, len);
+				}
+
+				s1[at] = c1;
+				s2[at] = c2;
+			}
+
+			/* Random strings, against themselves case changed */
+			fill_random(s1, len);
+			_dom_ascii_toupper(s2, s1, len);
+			check_isequal(s1, s2, len);
+			fill_random(s2, len);
+			check_isequal(s1, s2, len);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	UNUSED(argc);
+	UNUSED(argv);
+
+	test_find();
+	test_recase();
+	test_caseless();
+
+	printf("PASS\n");
+
+	return 0;
+}
@@ -0,0 +1,370 @@
+/*
+ * This file is part of libdom test suite.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <dom/dom.h>
+
+#include <domts.h>
+
+/* Attribute lists longer than 8 are indexed by a hash of the name */
+#define MAX_ATTRS 12
+
+#define NS1 "http://example.org/1"
+#define NS2 "http://example.org/2"
+
+static dom_document *doc;
+
+static dom_string *string(const char *s)
+{
+	dom_string *str;
+
+	if (s == NULL)
+		return NULL;
+
+	assert(dom_string_create((const uint8_t *) s, strlen(s), &str) ==
+			DOM_NO_ERR);
+
+	return str;
+}
+
+static dom_element *element(void)
+{
+	dom_string *str = string("e");
+	dom_element *e;
+
+	assert(dom_document_create_element(doc, str, &e) == DOM_NO_ERR);
+	dom_string_unref(str);
+
+	return e;
+}
+
+/* Set attribute a<i> to v<i> */
+static void set(dom_element *e, int i)
+{
+	char name[8], value[8];
+	dom_string *n, *v;
+
+	sprintf(name, "a%d", i);
+	sprintf(value, "v%d", i);
+	n = string(name);
+	v = string(value);
+	assert(dom_element_set_attribute(e, n, v) == DOM_NO_ERR);
+	dom_string_unref(n);
+	dom_string_unref(v);
+}
+
+static void remove_attr(dom_element *e, int i)
+{
+	char name[8];
+	dom_string *n;
+
+	sprintf(name, "a%d", i);
+	n = string(name);
+	assert(dom_element_remove_attribute(e, n) == DOM_NO_ERR);
+	dom_string_unref(n);
+}
+
+/* Check attribute a<i> is v<i>, or absent */
+static void check_one(dom_element *e, int i, bool present)
+{
+	char name[8], value[8];
+	dom_string *n, *v;
+	bool has;
+
+	sprintf(name, "a%d", i);
+	sprintf(value, "v%d", i);
+	n = string(name);
+
+	assert(dom_element_get_attribute(e, n, &v) == DOM_NO_ERR);
+	assert(dom_element_has_attribute(e, n, &has) == DOM_NO_ERR);
+	assert(has == present);
+	if (present) {
+		assert(v != NULL);
+		assert(strcmp(dom_string_data(v), value) == 0);
+		dom_string_unref(v);
+	} else {
+		assert(v == NULL);
+	}
+
+	dom_string_unref(n);
+}
+
+/* Check an element has exactly the attributes a<order[i]>, in order */
+static void check(dom_element *e, const int *order, int n)
+{
+	dom_namednodemap *map;
+	bool present[MAX_ATTRS + 1];
+	uint32_t len;
+	int i;
+
+	assert(dom_node_get_attributes(e, &map) == DOM_NO_ERR);
+	assert(dom_namednodemap_get_length(map, &len) == DOM_NO_ERR);
+	assert(len == (uint32_t) n);
+
+	memset(present, 0, sizeof(present));
+
+	for (i = 0; i < n; i++) {
+		dom_node *attr;
+		dom_string *name;
+		char expected[8];
+
+		assert(dom_namednodemap_item(map, i, &attr) == DOM_NO_ERR);
+		assert(dom_node_get_node_name(attr, &name) == DOM_NO_ERR);
+		sprintf(expected, "a%d", order[i]);
+		assert(strcmp(dom_string_data(name), expected) == 0);
+		dom_string_unref(name);
+		dom_node_unref(attr);
+
+		present[order[i]] = true;
+	}
+
+	dom_namednodemap_unref(map);
+
+	for (i = 0; i <= MAX_ATTRS; i++)
+		check_one(e, i, present[i]);
+}
+
+/* Grow a list one attribute at a time, across the indexing threshold */
+static void test_growth(void)
+{
+	dom_element *e = element();
+	dom_node *clone;
+	int order[MAX_ATTRS];
+	int i;
+
+	for (i = 0; i < MAX_ATTRS; i++) {
+		set(e, i);
+		order[i] = i;
+		check(e, order, i + 1);
+
+		/* Setting an existing attribute does not add another */
+		set(e, i / 2);
+		check(e, order, i + 1);
+	}
+
+	/* A clone has its own copy of the index */
+	assert(dom_node_clone_node(e, false, &clone) == DOM_NO_ERR);
+	remove_attr(e, 3);
+	check((dom_element *) clone, order, MAX_ATTRS);
+	dom_node_unref(clone);
+
+	dom_node_unref(e);
+}
+
+/* Remove each attribute in turn from lists either side of the indexing
+ * threshold, then add it back */
+static void test_removal(void)
+{
+	int order[MAX_ATTRS];
+	int n, r, i, j;
+
+	for (n = 7; n <= 10; n++) {
+		for (r = 0; r < n; r++) {
+			dom_element *e = element();
+
+			for (i = 0; i < n; i++)
+				set(e, i);
+
+			remove_attr(e, r);
+			for (i = 0, j = 0; i < n; i++) {
+				if (i != r)
+					order[j++] = i;
+			}
+			check(e, order, n - 1);
+
+			/* Removing one which is absent changes nothing */
+			remove_attr(e, r);
+			check(e, order, n - 1);
+
+			set(e, r);
+			order[n - 1] = r;
+			check(e, order, n);
+
+			dom_node_unref(e);
+		}
+	}
+
+	/* Shrinking a list from above the threshold to empty */
+	{
+		dom_element *e = element();
+
+		for (i = 0; i < MAX_ATTRS; i++)
+			set(e, i);
+		for (i = 0; i < MAX_ATTRS; i++) {
+			remove_attr(e, MAX_ATTRS - 1 - i);
+			for (j = 0; j < MAX_ATTRS - 1 - i; j++)
+				order[j] = j;
+			check(e, order, MAX_ATTRS - 1 - i);
+		}
+
+		dom_node_unref(e);
+	}
+}
+
+static void set_ns(dom_element *e, const char *ns, const char *qname,
+		const char *value)
+{
+	dom_string *n = string(ns), *q = string(qname), *v = string(value);
+
+	assert(dom_element_set_attribute_ns(e, n, q, v) == DOM_NO_ERR);
+	if (n != NULL)
+		dom_string_unref(n);
+	dom_string_unref(q);
+	dom_string_unref(v);
+}
+
+/* Check the value of an attribute by namespace and local name */
+static void check_ns(dom_element *e, const char *ns, const char *local,
+		const char *expected)
+{
+	dom_string *n = string(ns), *l = string(local), *v;
+
+	assert(dom_element_get_attribute_ns(e, n, l, &v) == DOM_NO_ERR);
+	if (expected == NULL) {
+		assert(v == NULL);
+	} else {
+		assert(v != NULL);
+		assert(strcmp(dom_string_data(v), expected) == 0);
+		dom_string_unref(v);
+	}
+
+	if (n != NULL)
+		dom_string_unref(n);
+	dom_string_unref(l);
+}
+
+/* Attributes with the same local name in different namespaces share a
+ * hash slot's probe sequence, but are distinct */
+static void test_namespaces(void)
+{
+	dom_string *n, *l;
+	int fill, i;
+
+	/* 3 attributes named x, plus enough others to make 7 to 11 */
+	for (fill = 4; fill <= 8; fill++) {
+		dom_element *e = element();
+
+		for (i = 0; i < fill / 2; i++)
+			set(e, i);
+		set_ns(e, NS1, "p:x", "1");
+		set_ns(e, NULL, "x", "0");
+		for (; i < fill; i++)
+			set(e, i);
+		set_ns(e, NS2, "q:x", "2");
+
+		check_ns(e, NS1, "x", "1");
+		check_ns(e, NS2, "x", "2");
+		check_ns(e, NULL, "x", "0");
+		check_one(e, fill - 1, true);
+
+		/* Setting one namespace's x leaves the others alone */
+		set_ns(e, NS2, "r:x", "3");
+		check_ns(e, NS1, "x", "1");
+		check_ns(e, NS2, "x", "3");
+		check_ns(e, NULL, "x", "0");
+
+		/* Removing one namespace's x leaves the others */
+		n = string(NS1);
+		l = string("x");
+		assert(dom_element_remove_attribute_ns(e, n, l) ==
+				DOM_NO_ERR);
+		dom_string_unref(n);
+		check_ns(e, NS1, "x", NULL);
+		check_ns(e, NS2, "x", "3");
+		check_ns(e, NULL, "x", "0");
+
+		/* And removing the one with no namespace */
+		assert(dom_element_remove_attribute_ns(e, NULL, l) ==
+				DOM_NO_ERR);
+		dom_string_unref(l);
+		check_ns(e, NULL, "x", NULL);
+		check_ns(e, NS2, "x", "3");
+
+		for (i = 0; i < fill; i++)
+			check_one(e, i, true);
+
+		dom_node_unref(e);
+	}
+}
+
+/* Attributes given all at once, as a parser gives them, are added even
+ * if some of the others have invalid names */
+static void test_init(void)
+{
+	static const struct {
+		const char *ns, *name, *value;
+	} attrs[] = {
+		{ NULL, "a0", "v0" },
+		{ NULL, "1bad", "x" },
+		{ NULL, "a1", "v1" },
+		{ NS1, "p:x", "1" },
+		{ NULL, "bad name", "x" },
+		{ NS2, "1q:x", "2" },
+		{ NULL, "a2", "v2" }
+	};
+	static const int order[] = { 0, 1, 2, 3 };
+	dom_string *names[7], *values[7], *namespaces[7], *n, *v;
+	dom_element *e = element();
+	int i;
+
+	for (i = 0; i < 7; i++) {
+		names[i] = string(attrs[i].name);
+		values[i] = string(attrs[i].value);
+		namespaces[i] = string(attrs[i].ns);
+	}
+
+	assert(dom_element_init_attributes(e, 7, names, values,
+			namespaces) == DOM_INVALID_CHARACTER_ERR);
+
+	for (i = 0; i < 7; i++) {
+		dom_string_unref(names[i]);
+		dom_string_unref(values[i]);
+		if (namespaces[i] != NULL)
+			dom_string_unref(namespaces[i]);
+	}
+
+	n = string("1bad");
+	assert(dom_element_get_attribute(e, n, &v) == DOM_NO_ERR);
+	assert(v == NULL);
+	dom_string_unref(n);
+	check_ns(e, NS1, "x", "1");
+	check_ns(e, NS2, "x", NULL);
+
+	n = string(NS1);
+	v = string("x");
+	assert(dom_element_remove_attribute_ns(e, n, v) == DOM_NO_ERR);
+	dom_string_unref(n);
+	dom_string_unref(v);
+	check(e, order, 3);
+
+	/* The element is usable as normal */
+	set(e, 3);
+	check(e, order, 4);
+
+	dom_node_unref(e);
+}
+
+int main(int argc, char **argv)
+{
+	UNUSED(argc);
+	UNUSED(argv);
+
+	assert(dom_implementation_create_document(DOM_IMPLEMENTATION_XML,
+			NULL, "root", NULL, NULL, NULL, &doc) == DOM_NO_ERR);
+
+	test_growth();
+	test_removal();
+	test_namespaces();
+	test_init();
+
+	dom_node_unref(doc);
+
+	printf("PASS\n");
+
+	return 0;
+}
@@ -0,0 +1,294 @@
+/*
+ * This file is part of libdom test suite.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <dom/dom.h>
+
+#include <domts.h>
+
+#define INSERTS 2000
+
+#define PRECEDING DOM_DOCUMENT_POSITION_PRECEDING
+#define FOLLOWING DOM_DOCUMENT_POSITION_FOLLOWING
+#define CONTAINS DOM_DOCUMENT_POSITION_CONTAINS
+#define CONTAINED_BY DOM_DOCUMENT_POSITION_CONTAINED_BY
+#define DISCONNECTED DOM_DOCUMENT_POSITION_DISCONNECTED
+#define IMPLEMENTATION_SPECIFIC DOM_DOCUMENT_POSITION_IMPLEMENTATION_SPECIFIC
+
+static uint16_t position(void *node, void *other)
+{
+	uint16_t result = 0xffff;
+
+	assert(dom_node_compare_document_position(node, other, &result) ==
+			DOM_NO_ERR);
+
+	return result;
+}
+
+static dom_string *string(const char *s)
+{
+	dom_string *str;
+
+	assert(dom_string_create((const uint8_t *) s, strlen(s), &str) ==
+			DOM_NO_ERR);
+
+	return str;
+}
+
+static dom_element *element(dom_document *doc, const char *name)
+{
+	dom_string *str = string(name);
+	dom_element *e;
+
+	assert(dom_document_create_element(doc, str, &e) == DOM_NO_ERR);
+	dom_string_unref(str);
+
+	return e;
+}
+
+static dom_text *text(dom_document *doc, const char *data)
+{
+	dom_string *str = string(data);
+	dom_text *t;
+
+	assert(dom_document_create_text_node(doc, str, &t) == DOM_NO_ERR);
+	dom_string_unref(str);
+
+	return t;
+}
+
+static void append(void *parent, void *child)
+{
+	dom_node *result;
+
+	assert(dom_node_append_child(parent, child, &result) == DOM_NO_ERR);
+	dom_node_unref(result);
+}
+
+static void insert_before(void *parent, void *child, void *ref)
+{
+	dom_node *result;
+
+	assert(dom_node_insert_before(parent, child, ref, &result) ==
+			DOM_NO_ERR);
+	dom_node_unref(result);
+}
+
+static dom_attr *attribute(dom_element *e, const char *name)
+{
+	dom_string *n = string(name), *v = string("v");
+	dom_attr *a;
+
+	assert(dom_element_set_attribute(e, n, v) == DOM_NO_ERR);
+	assert(dom_element_get_attribute_node(e, n, &a) == DOM_NO_ERR);
+	assert(a != NULL);
+	dom_string_unref(n);
+	dom_string_unref(v);
+
+	return a;
+}
+
+/* Check both directions of a pair of connected nodes */
+static void check(void *node, void *other, uint16_t expected)
+{
+	uint16_t reverse = 0;
+
+	if (expected & PRECEDING)
+		reverse |= FOLLOWING;
+	if (expected & FOLLOWING)
+		reverse |= PRECEDING;
+	if (expected & CONTAINS)
+		reverse |= CONTAINED_BY;
+	if (expected & CONTAINED_BY)
+		reverse |= CONTAINS;
+
+	assert(position(node, other) == expected);
+	assert(position(other, node) == reverse);
+}
+
+/* Check two nodes are disconnected, and consistently ordered */
+static void check_disconnected(void *node, void *other)
+{
+	uint16_t p = position(node, other), r = position(other, node);
+
+	assert((p & ~(PRECEDING | FOLLOWING)) ==
+			(DISCONNECTED | IMPLEMENTATION_SPECIFIC));
+	assert((r & ~(PRECEDING | FOLLOWING)) ==
+			(DISCONNECTED | IMPLEMENTATION_SPECIFIC));
+	assert((p & (PRECEDING | FOLLOWING)) != 0);
+	assert((p & (PRECEDING | FOLLOWING)) !=
+			(r & (PRECEDING | FOLLOWING)));
+	assert(position(node, other) == p);
+}
+
+/* Each of the nodes must follow the one before it, and contain none */
+static void check_sequence(dom_element **nodes, int n)
+{
+	int i;
+
+	for (i = 1; i < n; i++)
+		check(nodes[i - 1], nodes[i], FOLLOWING);
+}
+
+static void test_tree(dom_document *doc, dom_document *other_doc)
+{
+	dom_element *root, *p, *q, *r, *detached;
+	dom_attr *a1, *a2;
+	dom_text *t, *at;
+
+	assert(dom_document_get_document_element(doc, &root) == DOM_NO_ERR);
+
+	/* <root><p><q/>t</p><r/></root>, p has attrs a1 and a2, and a1
+	 * holds the text at */
+	p = element(doc, "p");
+	q = element(doc, "q");
+	r = element(doc, "r");
+	t = text(doc, "t");
+	append(root, p);
+	append(p, q);
+	append(p, t);
+	append(root, r);
+	a1 = attribute(p, "a1");
+	a2 = attribute(p, "a2");
+	at = text(doc, "at");
+	append(a1, at);
+
+	assert(position(doc, doc) == 0);
+	assert(position(a1, a1) == 0);
+
+	check(doc, root, CONTAINED_BY | FOLLOWING);
+	check(doc, t, CONTAINED_BY | FOLLOWING);
+	check(p, q, CONTAINED_BY | FOLLOWING);
+	check(q, t, FOLLOWING);
+	check(q, r, FOLLOWING);
+	check(t, r, FOLLOWING);
+
+	/* An Attr lies after its element, before the element's children */
+	check(doc, a1, CONTAINED_BY | FOLLOWING);
+	check(root, a1, CONTAINED_BY | FOLLOWING);
+	check(p, a1, CONTAINED_BY | FOLLOWING);
+	check(a1, q, FOLLOWING);
+	check(a1, t, FOLLOWING);
+	check(a1, r, FOLLOWING);
+
+	/* An Attr contains its own children only */
+	check(a1, at, CONTAINED_BY | FOLLOWING);
+	check(p, at, CONTAINED_BY | FOLLOWING);
+	check(at, q, FOLLOWING);
+	check(at, r, FOLLOWING);
+
+	/* The order of an element's Attrs is implementation specific */
+	assert((position(a1, a2) & ~(PRECEDING | FOLLOWING)) ==
+			IMPLEMENTATION_SPECIFIC);
+	assert((position(a1, a2) & (PRECEDING | FOLLOWING)) != 0);
+	assert((position(a1, a2) & (PRECEDING | FOLLOWING)) !=
+			(position(a2, a1) & (PRECEDING | FOLLOWING)));
+
+	/* Nodes outside the document's tree are disconnected from it */
+	detached = element(doc, "detached");
+	check_disconnected(detached, root);
+	check_disconnected(detached, a1);
+	check_disconnected(doc, other_doc);
+	check_disconnected(q, other_doc);
+
+	dom_node_unref(at);
+	dom_node_unref(a2);
+	dom_node_unref(a1);
+	dom_node_unref(detached);
+	dom_node_unref(t);
+	dom_node_unref(r);
+	dom_node_unref(q);
+	dom_node_unref(p);
+	dom_node_unref(root);
+}
+
+/* Insert many nodes between the same pair of siblings, so the order index
+ * is repeatedly invalidated and rebuilt */
+static void test_inserts(dom_document *doc)
+{
+	static dom_element *nodes[INSERTS + 2];
+	dom_element *root, *first, *last, *child;
+	int n = 2, i, j;
+
+	assert(dom_document_get_document_element(doc, &root) == DOM_NO_ERR);
+
+	first = element(doc, "first");
+	last = element(doc, "last");
+	append(root, first);
+	append(root, last);
+	nodes[0] = first;
+	nodes[1] = last;
+
+	for (i = 0; i < INSERTS; i++) {
+		dom_element *e = element(doc, "e");
+
+		/* Alternate between just after first and just before last */
+		if (i % 2 == 0) {
+			insert_before(root, e, nodes[1]);
+			memmove(&nodes[2], &nodes[1],
+					(n - 1) * sizeof(nodes[0]));
+			nodes[1] = e;
+		} else {
+			insert_before(root, e, last);
+			nodes[n] = last;
+			nodes[n - 1] = e;
+		}
+		n++;
+
+		check(first, e, FOLLOWING);
+		check(e, last, FOLLOWING);
+
+		/* Enough queries to rebuild the index before the next
+		 * insert, which are then answered from it */
+		if (i % 97 == 0) {
+			for (j = 0; j < 4; j++)
+				check_sequence(nodes, n);
+		}
+	}
+
+	check_sequence(nodes, n);
+	check_sequence(nodes, n);
+
+	/* A node moved into one of its following siblings */
+	child = nodes[n / 2];
+	dom_node_ref(child);
+	append(nodes[n / 2 + 1], child);
+	check(nodes[n / 2 + 1], child, CONTAINED_BY | FOLLOWING);
+	check(nodes[n / 2 - 1], child, FOLLOWING);
+	check(child, nodes[n / 2 + 2], FOLLOWING);
+	check(child, last, FOLLOWING);
+	dom_node_unref(child);
+
+	for (i = 0; i < n; i++)
+		dom_node_unref(nodes[i]);
+	dom_node_unref(root);
+}
+
+int main(int argc, char **argv)
+{
+	dom_document *doc, *other_doc;
+
+	UNUSED(argc);
+	UNUSED(argv);
+
+	assert(dom_implementation_create_document(DOM_IMPLEMENTATION_XML,
+			NULL, "root", NULL, NULL, NULL, &doc) == DOM_NO_ERR);
+	assert(dom_implementation_create_document(DOM_IMPLEMENTATION_XML,
+			NULL, "root", NULL, NULL, NULL, &other_doc) ==
+			DOM_NO_ERR);
+
+	test_tree(doc, other_doc);
+	test_inserts(other_doc);
+
+	dom_node_unref(other_doc);
+	dom_node_unref(doc);
+
+	printf("PASS\n");
+
+	return 0;
+}
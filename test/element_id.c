@@ -0,0 +1,239 @@
+/*
+ * This file is part of libdom test suite.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <dom/dom.h>
+
+#include <domts.h>
+
+static dom_string *string(const char *s)
+{
+	dom_string *str;
+
+	assert(dom_string_create((const uint8_t *) s, strlen(s), &str) ==
+			DOM_NO_ERR);
+
+	return str;
+}
+
+static void set_attribute(dom_element *e, const char *name, const char *value)
+{
+	dom_string *n = string(name), *v = string(value);
+
+	assert(dom_element_set_attribute(e, n, v) == DOM_NO_ERR);
+	dom_string_unref(n);
+	dom_string_unref(v);
+}
+
+static void remove_attribute(dom_element *e, const char *name)
+{
+	dom_string *n = string(name);
+
+	assert(dom_element_remove_attribute(e, n) == DOM_NO_ERR);
+	dom_string_unref(n);
+}
+
+/* Create an element with an id, or none if id is NULL */
+static dom_element *element(dom_document *doc, const char *name,
+		const char *id)
+{
+	dom_string *str = string(name);
+	dom_element *e;
+
+	assert(dom_document_create_element(doc, str, &e) == DOM_NO_ERR);
+	dom_string_unref(str);
+
+	if (id != NULL)
+		set_attribute(e, "id", id);
+
+	return e;
+}
+
+static void append(void *parent, void *child)
+{
+	dom_node *result;
+
+	assert(dom_node_append_child(parent, child, &result) == DOM_NO_ERR);
+	dom_node_unref(result);
+}
+
+static void insert_before(void *parent, void *child, void *ref)
+{
+	dom_node *result;
+
+	assert(dom_node_insert_before(parent, child, ref, &result) ==
+			DOM_NO_ERR);
+	dom_node_unref(result);
+}
+
+static void remove_child(void *parent, void *child)
+{
+	dom_node *result;
+
+	assert(dom_node_remove_child(parent, child, &result) == DOM_NO_ERR);
+	dom_node_unref(result);
+}
+
+/* Check which element, if any, getElementById finds for an id */
+static void check(dom_document *doc, const char *id, dom_element *expected)
+{
+	dom_string *str = string(id);
+	dom_element *e;
+
+	assert(dom_document_get_element_by_id(doc, str, &e) == DOM_NO_ERR);
+	if (e != expected)
+		printf("'%s' found %p, not %p\n", id, (void *) e,
+				(void *) expected);
+	assert(e == expected);
+
+	if (e != NULL)
+		dom_node_unref(e);
+	dom_string_unref(str);
+}
+
+int main(int argc, char **argv)
+{
+	dom_document *doc;
+	dom_element *root, *a, *b, *c, *d, *sub, *inner;
+	dom_node *old;
+	dom_attr *attr, *prev;
+	dom_string *str;
+
+	UNUSED(argc);
+	UNUSED(argv);
+
+	assert(dom_implementation_create_document(DOM_IMPLEMENTATION_XML,
+			NULL, "root", NULL, NULL, NULL, &doc) == DOM_NO_ERR);
+	assert(dom_document_get_document_element(doc, &root) == DOM_NO_ERR);
+
+	a = element(doc, "a", "x");
+	b = element(doc, "b", "y");
+	append(root, a);
+	append(root, b);
+
+	/* Build the index, then change it */
+	check(doc, "x", a);
+	check(doc, "y", b);
+	check(doc, "z", NULL);
+
+	/* Changing an id refiles the element */
+	set_attribute(a, "id", "z");
+	check(doc, "x", NULL);
+	check(doc, "z", a);
+
+	/* As does changing the value of the id Attr itself */
+	str = string("id");
+	assert(dom_element_get_attribute_node(a, str, &attr) == DOM_NO_ERR);
+	dom_string_unref(str);
+	str = string("w");
+	assert(dom_attr_set_value(attr, str) == DOM_NO_ERR);
+	dom_string_unref(str);
+	check(doc, "z", NULL);
+	check(doc, "w", a);
+
+	/* Removing the id Attr node, and setting it again */
+	assert(dom_element_remove_attribute_node(a, attr, &prev) ==
+			DOM_NO_ERR);
+	assert(prev == attr);
+	dom_node_unref(prev);
+	check(doc, "w", NULL);
+	assert(dom_element_set_attribute_node(a, attr, &prev) == DOM_NO_ERR);
+	assert(prev == NULL);
+	check(doc, "w", a);
+
+	/* Removing the id attribute */
+	remove_attribute(a, "id");
+	check(doc, "w", NULL);
+	set_attribute(a, "id", "x");
+	check(doc, "x", a);
+
+	/* Duplicate ids are found in document order, wherever they were
+	 * inserted */
+	c = element(doc, "c", "x");
+	append(root, c);
+	check(doc, "x", a);
+	insert_before(root, c, a);
+	check(doc, "x", c);
+	set_attribute(b, "id", "x");
+	check(doc, "x", c);
+	check(doc, "y", NULL);
+	remove_attribute(c, "id");
+	check(doc, "x", a);
+	remove_child(root, a);
+	check(doc, "x", b);
+	insert_before(root, a, c);
+	check(doc, "x", a);
+	set_attribute(c, "id", "x");
+	check(doc, "x", a);
+	remove_attribute(a, "id");
+	check(doc, "x", c);
+	set_attribute(a, "id", "x");
+	check(doc, "x", a);
+	remove_attribute(c, "id");
+
+	/* Elements outside the tree are never found */
+	d = element(doc, "d", "v");
+	check(doc, "v", NULL);
+
+	/* A subtree is filed when it is inserted, and unfiled when it is
+	 * removed, along with its descendants */
+	sub = element(doc, "sub", "s");
+	inner = element(doc, "inner", "i");
+	append(sub, inner);
+	append(inner, d);
+	check(doc, "s", NULL);
+	check(doc, "i", NULL);
+	append(root, sub);
+	check(doc, "s", sub);
+	check(doc, "i", inner);
+	check(doc, "v", d);
+
+	remove_child(root, sub);
+	check(doc, "s", NULL);
+	check(doc, "i", NULL);
+	check(doc, "v", NULL);
+
+	/* Changes made while the subtree is outside the tree are seen when
+	 * it is inserted again */
+	set_attribute(inner, "id", "j");
+	set_attribute(d, "id", "x");
+	insert_before(root, sub, a);
+	check(doc, "s", sub);
+	check(doc, "i", NULL);
+	check(doc, "j", inner);
+	check(doc, "x", d);
+
+	/* Replacing a subtree */
+	assert(dom_node_replace_child(root, c, sub, &old) == DOM_NO_ERR);
+	dom_node_unref(old);
+	check(doc, "s", NULL);
+	check(doc, "j", NULL);
+	check(doc, "x", a);
+
+	/* Removing a subtree's descendant */
+	append(root, sub);
+	check(doc, "j", inner);
+	remove_child(sub, inner);
+	check(doc, "j", NULL);
+	check(doc, "x", a);
+	check(doc, "s", sub);
+
+	dom_node_unref(attr);
+	dom_node_unref(inner);
+	dom_node_unref(sub);
+	dom_node_unref(d);
+	dom_node_unref(c);
+	dom_node_unref(b);
+	dom_node_unref(a);
+	dom_node_unref(root);
+	dom_node_unref(doc);
+
+	printf("PASS\n");
+
+	return 0;
+}
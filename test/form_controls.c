@@ -0,0 +1,338 @@
+/*
+ * This file is part of libdom test suite.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <dom/dom.h>
+
+/* Controls are associated with forms by the parser bindings, through
+ * these internal calls */
+#include "html/html_button_element.h"
+#include "html/html_input_element.h"
+#include "html/html_select_element.h"
+#include "html/html_text_area_element.h"
+
+#include <domts.h>
+
+/* The kinds of form control, in the order of the tags below */
+enum control { INPUT, SELECT, TEXTAREA, BUTTON };
+
+static const char *tags[] = { "input", "select", "textarea", "button" };
+
+static dom_string *string(const char *s)
+{
+	dom_string *str;
+
+	assert(dom_string_create((const uint8_t *) s, strlen(s), &str) ==
+			DOM_NO_ERR);
+
+	return str;
+}
+
+static dom_element *element(dom_document *doc, const char *name)
+{
+	dom_string *str = string(name);
+	dom_element *e;
+
+	assert(dom_document_create_element(doc, str, &e) == DOM_NO_ERR);
+	dom_string_unref(str);
+
+	return e;
+}
+
+static void append(void *parent, void *child)
+{
+	dom_node *result;
+
+	assert(dom_node_append_child(parent, child, &result) == DOM_NO_ERR);
+	dom_node_unref(result);
+}
+
+static void insert_before(void *parent, void *child, void *ref)
+{
+	dom_node *result;
+
+	assert(dom_node_insert_before(parent, child, ref, &result) ==
+			DOM_NO_ERR);
+	dom_node_unref(result);
+}
+
+static void remove_child(void *parent, void *child)
+{
+	dom_node *result;
+
+	assert(dom_node_remove_child(parent, child, &result) == DOM_NO_ERR);
+	dom_node_unref(result);
+}
+
+static void set_form(enum control type, dom_element *e,
+		dom_html_form_element *form)
+{
+	dom_exception err = DOM_NO_ERR;
+
+	switch (type) {
+	case INPUT:
+		err = _dom_html_input_element_set_form(
+				(dom_html_input_element *) e, form);
+		break;
+	case SELECT:
+		err = _dom_html_select_element_set_form(
+				(dom_html_select_element *) e, form);
+		break;
+	case TEXTAREA:
+		err = _dom_html_text_area_element_set_form(
+				(dom_html_text_area_element *) e, form);
+		break;
+	case BUTTON:
+		err = _dom_html_button_element_set_form(
+				(dom_html_button_element *) e, form);
+		break;
+	}
+
+	assert(err == DOM_NO_ERR);
+}
+
+/* Check which form, if any, a control belongs to */
+static void check_form(enum control type, dom_element *e,
+		dom_html_form_element *expected)
+{
+	dom_html_form_element *form = NULL;
+	dom_exception err = DOM_NO_ERR;
+
+	switch (type) {
+	case INPUT:
+		err = dom_html_input_element_get_form(
+				(dom_html_input_element *) e, &form);
+		break;
+	case SELECT:
+		err = dom_html_select_element_get_form(
+				(dom_html_select_element *) e, &form);
+		break;
+	case TEXTAREA:
+		err = dom_html_text_area_element_get_form(
+				(dom_html_text_area_element *) e, &form);
+		break;
+	case BUTTON:
+		err = dom_html_button_element_get_form(
+				(dom_html_button_element *) e, &form);
+		break;
+	}
+
+	assert(err == DOM_NO_ERR);
+	assert(form == expected);
+	if (form != NULL)
+		dom_node_unref(form);
+}
+
+/* Check a form's elements and length, and that item i is nodes[i] */
+static void check(dom_html_form_element *form, dom_element **nodes,
+		uint32_t n)
+{
+	dom_html_collection *col;
+	dom_node *item;
+	uint32_t len, i;
+
+	assert(dom_html_form_element_get_length(form, &len) == DOM_NO_ERR);
+	if (len != n)
+		printf("length %u, not %u\n", len, n);
+	assert(len == n);
+
+	assert(dom_html_form_element_get_elements(form, &col) == DOM_NO_ERR);
+	assert(dom_html_collection_get_length(col, &len) == DOM_NO_ERR);
+	assert(len == n);
+
+	for (i = 0; i < n; i++) {
+		assert(dom_html_collection_item(col, i, &item) == DOM_NO_ERR);
+		assert(item == (dom_node *) nodes[i]);
+		dom_node_unref(item);
+	}
+
+	assert(dom_html_collection_item(col, n, &item) == DOM_NO_ERR);
+	assert(item == NULL);
+
+	dom_html_collection_unref(col);
+}
+
+/* Controls moved between forms, and out of any form */
+static void test_move(dom_document *doc, dom_element *body)
+{
+	dom_html_form_element *f1, *f2;
+	dom_element *c[4];
+	int i;
+
+	f1 = (dom_html_form_element *) element(doc, "form");
+	f2 = (dom_html_form_element *) element(doc, "form");
+	append(body, f1);
+	append(body, f2);
+
+	for (i = 0; i < 4; i++) {
+		c[i] = element(doc, tags[i]);
+		append(f1, c[i]);
+	}
+
+	/* Associated out of document order */
+	set_form(BUTTON, c[3], f1);
+	set_form(SELECT, c[1], f1);
+	set_form(INPUT, c[0], f1);
+	set_form(TEXTAREA, c[2], f1);
+	check(f1, c, 4);
+	check(f2, NULL, 0);
+
+	/* Moving a control to another form */
+	set_form(SELECT, c[1], f2);
+	check_form(SELECT, c[1], f2);
+	check(f1, (dom_element *[]) { c[0], c[2], c[3] }, 3);
+	check(f2, c + 1, 1);
+
+	/* And back again */
+	set_form(SELECT, c[1], f1);
+	check(f1, c, 4);
+	check(f2, NULL, 0);
+
+	/* Setting the same form again changes nothing */
+	set_form(INPUT, c[0], f1);
+	check(f1, c, 4);
+
+	/* Out of any form */
+	set_form(TEXTAREA, c[2], NULL);
+	check_form(TEXTAREA, c[2], NULL);
+	check(f1, (dom_element *[]) { c[0], c[1], c[3] }, 3);
+
+	for (i = 0; i < 4; i++)
+		dom_node_unref(c[i]);
+	dom_node_unref(f2);
+	dom_node_unref(f1);
+}
+
+/* Controls removed from the document, and put back */
+static void test_removed(dom_document *doc, dom_element *body)
+{
+	dom_html_form_element *form;
+	dom_element *c[3], *div;
+	dom_node *clone;
+	int i;
+
+	form = (dom_html_form_element *) element(doc, "form");
+	div = element(doc, "div");
+	append(body, form);
+	append(body, div);
+
+	for (i = 0; i < 3; i++) {
+		c[i] = element(doc, "input");
+		append(div, c[i]);
+		set_form(INPUT, c[i], form);
+	}
+	check(form, c, 3);
+
+	/* A removed control stays in the form, but is not listed */
+	remove_child(div, c[1]);
+	check_form(INPUT, c[1], form);
+	check(form, (dom_element *[]) { c[0], c[2] }, 2);
+
+	/* Until it is put back, at its new place in the document */
+	insert_before(div, c[1], c[0]);
+	check(form, (dom_element *[]) { c[1], c[0], c[2] }, 3);
+
+	/* Nor is any control in a subtree which is removed */
+	remove_child(body, div);
+	check(form, NULL, 0);
+	append(body, div);
+	check(form, (dom_element *[]) { c[1], c[0], c[2] }, 3);
+
+	/* A copy of a control is in the same form */
+	assert(dom_node_clone_node(c[2], false, &clone) == DOM_NO_ERR);
+	check_form(INPUT, (dom_element *) clone, form);
+	check(form, (dom_element *[]) { c[1], c[0], c[2] }, 3);
+	append(div, clone);
+	check(form, (dom_element *[]) { c[1], c[0], c[2],
+			(dom_element *) clone }, 4);
+
+	/* Destroying a control removes it from the form */
+	remove_child(div, clone);
+	dom_node_unref(clone);
+	remove_child(div, c[0]);
+	dom_node_unref(c[0]);
+	check(form, (dom_element *[]) { c[1], c[2] }, 2);
+
+	dom_node_unref(c[2]);
+	dom_node_unref(c[1]);
+	dom_node_unref(div);
+	dom_node_unref(form);
+}
+
+/* A form destroyed while its controls live on */
+static void test_form_destroyed(dom_document *doc, dom_element *body)
+{
+	dom_html_form_element *form, *other;
+	dom_element *c[4];
+	int i;
+
+	form = (dom_html_form_element *) element(doc, "form");
+	other = (dom_html_form_element *) element(doc, "form");
+	append(body, form);
+	append(body, other);
+
+	/* Two controls in the tree, and two out of it */
+	for (i = 0; i < 4; i++) {
+		c[i] = element(doc, tags[i]);
+		if (i < 2)
+			append(body, c[i]);
+		set_form(i, c[i], form);
+	}
+	check(form, c, 2);
+
+	remove_child(body, form);
+	dom_node_unref(form);
+
+	/* The controls no longer refer to the form */
+	for (i = 0; i < 4; i++)
+		check_form(i, c[i], NULL);
+
+	/* And can join another, or none */
+	set_form(INPUT, c[0], other);
+	set_form(SELECT, c[1], NULL);
+	set_form(TEXTAREA, c[2], other);
+	check_form(INPUT, c[0], other);
+	check(other, c, 1);
+
+	/* Destroying them leaves the other form empty */
+	remove_child(body, c[0]);
+	remove_child(body, c[1]);
+	for (i = 0; i < 4; i++)
+		dom_node_unref(c[i]);
+	check(other, NULL, 0);
+
+	dom_node_unref(other);
+}
+
+int main(int argc, char **argv)
+{
+	dom_document *doc;
+	dom_element *html, *body;
+
+	UNUSED(argc);
+	UNUSED(argv);
+
+	assert(dom_implementation_create_document(DOM_IMPLEMENTATION_HTML,
+			NULL, "html", NULL, NULL, NULL, &doc) == DOM_NO_ERR);
+	assert(dom_document_get_document_element(doc, &html) == DOM_NO_ERR);
+
+	body = element(doc, "body");
+	append(html, body);
+
+	test_move(doc, body);
+	test_removed(doc, body);
+	test_form_destroyed(doc, body);
+
+	dom_node_unref(body);
+	dom_node_unref(html);
+	dom_node_unref(doc);
+
+	printf("PASS\n");
+
+	return 0;
+}
@@ -0,0 +1,251 @@
+/*
+ * This file is part of libdom test suite.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <dom/dom.h>
+
+#include <domts.h>
+
+static dom_string *string(const char *s)
+{
+	dom_string *str;
+
+	assert(dom_string_create((const uint8_t *) s, strlen(s), &str) ==
+			DOM_NO_ERR);
+
+	return str;
+}
+
+static void set_attribute(dom_element *e, const char *name, const char *value)
+{
+	dom_string *n = string(name), *v = string(value);
+
+	assert(dom_element_set_attribute(e, n, v) == DOM_NO_ERR);
+	dom_string_unref(n);
+	dom_string_unref(v);
+}
+
+static void remove_attribute(dom_element *e, const char *name)
+{
+	dom_string *n = string(name);
+
+	assert(dom_element_remove_attribute(e, n) == DOM_NO_ERR);
+	dom_string_unref(n);
+}
+
+static dom_element *element(dom_document *doc, const char *name)
+{
+	dom_string *str = string(name);
+	dom_element *e;
+
+	assert(dom_document_create_element(doc, str, &e) == DOM_NO_ERR);
+	dom_string_unref(str);
+
+	return e;
+}
+
+static void append(void *parent, void *child)
+{
+	dom_node *result;
+
+	assert(dom_node_append_child(parent, child, &result) == DOM_NO_ERR);
+	dom_node_unref(result);
+}
+
+static void remove_child(void *parent, void *child)
+{
+	dom_node *result;
+
+	assert(dom_node_remove_child(parent, child, &result) == DOM_NO_ERR);
+	dom_node_unref(result);
+}
+
+/* Check a collection's length, and that item i is nodes[i] for each */
+static void check(dom_html_collection *col, dom_element **nodes, uint32_t n)
+{
+	dom_node *item;
+	uint32_t len, i;
+
+	assert(dom_html_collection_get_length(col, &len) == DOM_NO_ERR);
+	if (len != n)
+		printf("length %u, not %u\n", len, n);
+	assert(len == n);
+
+	for (i = 0; i < n; i++) {
+		assert(dom_html_collection_item(col, i, &item) == DOM_NO_ERR);
+		assert(item == (dom_node *) nodes[i]);
+		dom_node_unref(item);
+	}
+
+	assert(dom_html_collection_item(col, n, &item) == DOM_NO_ERR);
+	assert(item == NULL);
+}
+
+/* Check which member, if any, namedItem finds for a name */
+static void check_named(dom_html_collection *col, const char *name,
+		dom_element *expected)
+{
+	dom_string *str = string(name);
+	dom_node *item;
+
+	assert(dom_html_collection_named_item(col, str, &item) == DOM_NO_ERR);
+	assert(item == (dom_node *) expected);
+	if (item != NULL)
+		dom_node_unref(item);
+	dom_string_unref(str);
+}
+
+/* The anchors collection holds the a elements with a name attribute */
+static void test_anchors(dom_document *doc, dom_element *body)
+{
+	dom_html_collection *col;
+	dom_element *a[3], *div;
+	dom_attr *attr;
+	dom_string *str;
+
+	a[0] = element(doc, "a");
+	a[1] = element(doc, "a");
+	a[2] = element(doc, "a");
+	div = element(doc, "div");
+	append(body, a[0]);
+	append(body, div);
+	append(div, a[1]);
+	append(body, a[2]);
+
+	assert(dom_html_document_get_anchors(doc, &col) == DOM_NO_ERR);
+	check(col, a, 0);
+
+	/* Setting a name adds an element, in document order */
+	set_attribute(a[1], "name", "n1");
+	check(col, a + 1, 1);
+	set_attribute(a[0], "name", "n0");
+	check(col, a, 2);
+	check_named(col, "n1", a[1]);
+
+	/* Changing the name keeps it, under its new name */
+	set_attribute(a[1], "name", "m1");
+	check(col, a, 2);
+	check_named(col, "n1", NULL);
+	check_named(col, "m1", a[1]);
+
+	/* As does changing the value of the name Attr itself */
+	str = string("name");
+	assert(dom_element_get_attribute_node(a[1], str, &attr) ==
+			DOM_NO_ERR);
+	dom_string_unref(str);
+	str = string("k1");
+	assert(dom_attr_set_value(attr, str) == DOM_NO_ERR);
+	dom_string_unref(str);
+	dom_node_unref(attr);
+	check_named(col, "m1", NULL);
+	check_named(col, "k1", a[1]);
+
+	/* Other attributes of a non-member do not make it one */
+	set_attribute(a[2], "href", "x");
+	set_attribute(div, "name", "d");
+	check(col, a, 2);
+	check_named(col, "d", NULL);
+
+	/* An id is looked up by namedItem, but does not add an element */
+	set_attribute(a[2], "id", "i2");
+	check_named(col, "i2", NULL);
+	set_attribute(a[0], "id", "i0");
+	check_named(col, "i0", a[0]);
+	check_named(col, "n0", a[0]);
+
+	/* Removing the name removes the element */
+	remove_attribute(a[0], "name");
+	check(col, a + 1, 1);
+	check_named(col, "i0", NULL);
+	set_attribute(a[2], "name", "n2");
+	check(col, a + 1, 2);
+
+	/* As does removing it from the tree */
+	remove_child(body, div);
+	check(col, a + 2, 1);
+	remove_child(body, a[2]);
+	remove_child(body, a[0]);
+	check(col, a, 0);
+
+	dom_html_collection_unref(col);
+
+	dom_node_unref(div);
+	dom_node_unref(a[2]);
+	dom_node_unref(a[1]);
+	dom_node_unref(a[0]);
+}
+
+/* The links collection holds the a and area elements with an href */
+static void test_links(dom_document *doc, dom_element *body)
+{
+	dom_html_collection *col;
+	dom_element *l[2], *p;
+
+	l[0] = element(doc, "area");
+	l[1] = element(doc, "a");
+	p = element(doc, "p");
+	append(body, l[0]);
+	append(body, p);
+	append(p, l[1]);
+
+	assert(dom_html_document_get_links(doc, &col) == DOM_NO_ERR);
+	check(col, NULL, 0);
+
+	/* The collection is filled, then changed between calls */
+	set_attribute(l[1], "href", "b");
+	check(col, l + 1, 1);
+	set_attribute(l[0], "href", "a");
+	set_attribute(p, "href", "p");
+	check(col, l, 2);
+	remove_attribute(l[1], "href");
+	check(col, l, 1);
+	set_attribute(l[1], "href", "c");
+	check(col, l, 2);
+
+	/* namedItem sees a name set after the collection was filled */
+	check_named(col, "x", NULL);
+	set_attribute(l[1], "name", "x");
+	check_named(col, "x", l[1]);
+	set_attribute(l[0], "id", "x");
+	check_named(col, "x", l[0]);
+	remove_attribute(l[0], "id");
+	check_named(col, "x", l[1]);
+
+	dom_html_collection_unref(col);
+
+	dom_node_unref(p);
+	dom_node_unref(l[1]);
+	dom_node_unref(l[0]);
+}
+
+int main(int argc, char **argv)
+{
+	dom_document *doc;
+	dom_element *html, *body;
+
+	UNUSED(argc);
+	UNUSED(argv);
+
+	assert(dom_implementation_create_document(DOM_IMPLEMENTATION_HTML,
+			NULL, "html", NULL, NULL, NULL, &doc) == DOM_NO_ERR);
+	assert(dom_document_get_document_element(doc, &html) == DOM_NO_ERR);
+
+	body = element(doc, "body");
+	append(html, body);
+
+	test_anchors(doc, body);
+	test_links(doc, body);
+
+	dom_node_unref(body);
+	dom_node_unref(html);
+	dom_node_unref(doc);
+
+	printf("PASS\n");
+
+	return 0;
+}
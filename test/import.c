@@ -0,0 +1,294 @@
+/*
+ * This file is part of libdom test suite.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <dom/dom.h>
+
+#include <domts.h>
+
+static dom_string *string(const char *s)
+{
+	dom_string *str;
+
+	assert(dom_string_create((const uint8_t *) s, strlen(s), &str) ==
+			DOM_NO_ERR);
+
+	return str;
+}
+
+static dom_document *document(dom_implementation_type type)
+{
+	dom_document *doc;
+
+	assert(dom_implementation_create_document(type, NULL, "root", NULL,
+			NULL, NULL, &doc) == DOM_NO_ERR);
+
+	return doc;
+}
+
+static dom_element *element(dom_document *doc, const char *name)
+{
+	dom_string *str = string(name);
+	dom_element *e;
+
+	assert(dom_document_create_element(doc, str, &e) == DOM_NO_ERR);
+	dom_string_unref(str);
+
+	return e;
+}
+
+static void set_attribute(dom_element *e, const char *name, const char *value)
+{
+	dom_string *n = string(name), *v = string(value);
+
+	assert(dom_element_set_attribute(e, n, v) == DOM_NO_ERR);
+	dom_string_unref(n);
+	dom_string_unref(v);
+}
+
+static void append(void *parent, void *child)
+{
+	dom_node *result;
+
+	assert(dom_node_append_child(parent, child, &result) == DOM_NO_ERR);
+	dom_node_unref(result);
+}
+
+static void append_text(dom_document *doc, void *parent, const char *data)
+{
+	dom_string *str = string(data);
+	dom_text *t;
+
+	assert(dom_document_create_text_node(doc, str, &t) == DOM_NO_ERR);
+	dom_string_unref(str);
+
+	append(parent, t);
+	dom_node_unref(t);
+}
+
+/* Check a node's owner document */
+static void check_owner(void *node, dom_document *expected)
+{
+	dom_document *owner;
+
+	assert(dom_node_get_owner_document(node, &owner) == DOM_NO_ERR);
+	assert(owner == expected);
+	dom_node_unref(owner);
+}
+
+/* Check an attribute's value, and the owner of its Attr node */
+static void check_attribute(dom_element *e, const char *name,
+		const char *expected, dom_document *owner)
+{
+	dom_string *n = string(name), *v;
+	dom_attr *attr;
+
+	assert(dom_element_get_attribute(e, n, &v) == DOM_NO_ERR);
+	assert(v != NULL);
+	assert(strcmp(dom_string_data(v), expected) == 0);
+	dom_string_unref(v);
+
+	assert(dom_element_get_attribute_node(e, n, &attr) == DOM_NO_ERR);
+	assert(attr != NULL);
+	check_owner(attr, owner);
+	dom_node_unref(attr);
+
+	dom_string_unref(n);
+}
+
+static void check_text_content(void *node, const char *expected)
+{
+	dom_string *text;
+
+	assert(dom_node_get_text_content(node, &text) == DOM_NO_ERR);
+	if (text == NULL) {
+		assert(expected[0] == '\0');
+		return;
+	}
+	assert(strcmp(dom_string_data(text), expected) == 0);
+	dom_string_unref(text);
+}
+
+/* Build <e a=1 id=x>t<f b=2>u</f></e> in a document */
+static dom_element *subtree(dom_document *doc)
+{
+	dom_element *e = element(doc, "e"), *f = element(doc, "f");
+
+	set_attribute(e, "a", "1");
+	set_attribute(e, "id", "x");
+	append_text(doc, e, "t");
+	set_attribute(f, "b", "2");
+	append_text(doc, f, "u");
+	append(e, f);
+	dom_node_unref(f);
+
+	return e;
+}
+
+/* Check a copy of subtree() made for a document, and use it there */
+static void check_subtree(dom_document *doc, dom_element *e)
+{
+	dom_element *root, *f, *found;
+	dom_string *id = string("x");
+
+	check_owner(e, doc);
+	check_attribute(e, "a", "1", doc);
+	check_attribute(e, "id", "x", doc);
+	check_text_content(e, "tu");
+
+	assert(dom_node_get_last_child(e, &f) == DOM_NO_ERR);
+	check_owner(f, doc);
+	check_attribute(f, "b", "2", doc);
+
+	/* The copy can be put into its document's tree */
+	assert(dom_document_get_document_element(doc, &root) == DOM_NO_ERR);
+	append(root, e);
+	assert(dom_document_get_element_by_id(doc, id, &found) ==
+			DOM_NO_ERR);
+	assert(found == e);
+	dom_node_unref(found);
+
+	set_attribute(f, "b", "3");
+	check_attribute(f, "b", "3", doc);
+
+	dom_node_unref(f);
+	dom_node_unref(root);
+	dom_string_unref(id);
+}
+
+/* Import a subtree, then destroy the document it was imported from */
+static void test_import(void)
+{
+	dom_document *src = document(DOM_IMPLEMENTATION_XML);
+	dom_document *dst = document(DOM_IMPLEMENTATION_XML);
+	dom_element *e = subtree(src);
+	dom_node *copy, *shallow;
+
+	assert(dom_document_import_node(dst, e, true, &copy) == DOM_NO_ERR);
+	assert(dom_document_import_node(dst, e, false, &shallow) ==
+			DOM_NO_ERR);
+	check_owner(e, src);
+
+	dom_node_unref(e);
+	dom_node_unref(src);
+
+	check_subtree(dst, (dom_element *) copy);
+
+	/* A shallow copy has the attributes, but not the children */
+	check_owner(shallow, dst);
+	check_attribute((dom_element *) shallow, "a", "1", dst);
+	check_text_content(shallow, "");
+
+	dom_node_unref(shallow);
+	dom_node_unref(copy);
+	dom_node_unref(dst);
+}
+
+/* Adopt a subtree, then destroy the document it was adopted from */
+static void test_adopt(void)
+{
+	dom_document *src = document(DOM_IMPLEMENTATION_XML);
+	dom_document *dst = document(DOM_IMPLEMENTATION_XML);
+	dom_element *root, *e = subtree(src);
+	dom_node *adopted, *parent;
+
+	assert(dom_document_get_document_element(src, &root) == DOM_NO_ERR);
+	append(root, e);
+	dom_node_unref(root);
+
+	assert(dom_document_adopt_node(dst, e, &adopted) == DOM_NO_ERR);
+
+	/* The node was removed from its old tree */
+	assert(dom_node_get_parent_node(e, &parent) == DOM_NO_ERR);
+	assert(parent == NULL);
+
+	dom_node_unref(e);
+	dom_node_unref(src);
+
+	check_subtree(dst, (dom_element *) adopted);
+
+	dom_node_unref(adopted);
+	dom_node_unref(dst);
+}
+
+/* Clones of imported nodes stay in the importing document */
+static void test_clone(void)
+{
+	dom_document *src = document(DOM_IMPLEMENTATION_XML);
+	dom_document *dst = document(DOM_IMPLEMENTATION_XML);
+	dom_element *e = subtree(src);
+	dom_node *copy, *clone;
+
+	assert(dom_document_import_node(dst, e, true, &copy) == DOM_NO_ERR);
+	dom_node_unref(e);
+	dom_node_unref(src);
+
+	assert(dom_node_clone_node(copy, true, &clone) == DOM_NO_ERR);
+	dom_node_unref(copy);
+
+	check_subtree(dst, (dom_element *) clone);
+
+	dom_node_unref(clone);
+	dom_node_unref(dst);
+}
+
+/* HTML elements can only be imported into HTML documents */
+static void test_html(void)
+{
+	dom_document *html = document(DOM_IMPLEMENTATION_HTML);
+	dom_document *other = document(DOM_IMPLEMENTATION_HTML);
+	dom_document *xml = document(DOM_IMPLEMENTATION_XML);
+	dom_element *div = element(html, "div"), *e = element(xml, "e");
+	dom_node *copy = NULL, *mixed;
+
+	append_text(html, div, "d");
+
+	assert(dom_document_import_node(xml, div, true, &copy) ==
+			DOM_NOT_SUPPORTED_ERR);
+	assert(copy == NULL);
+
+	/* Nor can a subtree holding them */
+	assert(dom_document_import_node(html, e, true, &mixed) == DOM_NO_ERR);
+	append(mixed, div);
+	assert(dom_document_import_node(xml, mixed, true, &copy) ==
+			DOM_NOT_SUPPORTED_ERR);
+	assert(copy == NULL);
+	dom_node_unref(mixed);
+
+	assert(dom_document_import_node(other, div, true, &copy) ==
+			DOM_NO_ERR);
+	dom_node_unref(div);
+	dom_node_unref(html);
+	check_owner(copy, other);
+	check_text_content(copy, "d");
+	dom_node_unref(copy);
+
+	assert(dom_document_import_node(other, e, true, &copy) == DOM_NO_ERR);
+	dom_node_unref(e);
+	dom_node_unref(xml);
+	check_owner(copy, other);
+	check_text_content(copy, "");
+	dom_node_unref(copy);
+
+	dom_node_unref(other);
+}
+
+int main(int argc, char **argv)
+{
+	UNUSED(argc);
+	UNUSED(argv);
+
+	test_import();
+	test_adopt();
+	test_clone();
+	test_html();
+
+	printf("PASS\n");
+
+	return 0;
+}
@@ -0,0 +1,227 @@
+/*
+ * This file is part of libdom test suite.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <dom/dom.h>
+
+#include <domts.h>
+
+static dom_string *string(const char *s)
+{
+	dom_string *str;
+
+	assert(dom_string_create((const uint8_t *) s, strlen(s), &str) ==
+			DOM_NO_ERR);
+
+	return str;
+}
+
+static dom_element *element(dom_document *doc, const char *name)
+{
+	dom_string *str = string(name);
+	dom_element *e;
+
+	assert(dom_document_create_element(doc, str, &e) == DOM_NO_ERR);
+	dom_string_unref(str);
+
+	return e;
+}
+
+static void append(void *parent, void *child)
+{
+	dom_node *result;
+
+	assert(dom_node_append_child(parent, child, &result) == DOM_NO_ERR);
+	dom_node_unref(result);
+}
+
+static void insert_before(void *parent, void *child, void *ref)
+{
+	dom_node *result;
+
+	assert(dom_node_insert_before(parent, child, ref, &result) ==
+			DOM_NO_ERR);
+	dom_node_unref(result);
+}
+
+static void remove_child(void *parent, void *child)
+{
+	dom_node *result;
+
+	assert(dom_node_remove_child(parent, child, &result) == DOM_NO_ERR);
+	dom_node_unref(result);
+}
+
+/* Check a list's length, and that item i is nodes[i] for each of them */
+static void check(dom_nodelist *list, dom_element **nodes, uint32_t n)
+{
+	dom_node *item;
+	uint32_t len, i;
+
+	assert(dom_nodelist_get_length(list, &len) == DOM_NO_ERR);
+	if (len != n)
+		printf("length %u, not %u\n", len, n);
+	assert(len == n);
+
+	for (i = 0; i < n; i++) {
+		assert(dom_nodelist_item(list, i, &item) == DOM_NO_ERR);
+		assert(item == (dom_node *) nodes[i]);
+		dom_node_unref(item);
+	}
+
+	assert(dom_nodelist_item(list, n, &item) == DOM_NO_ERR);
+	assert(item == NULL);
+}
+
+/* Check a single item, without asking for the length first */
+static void check_item(dom_nodelist *list, uint32_t i, dom_element *expected)
+{
+	dom_node *item;
+
+	assert(dom_nodelist_item(list, i, &item) == DOM_NO_ERR);
+	assert(item == (dom_node *) expected);
+	if (item != NULL)
+		dom_node_unref(item);
+}
+
+/* A list by tag name, partly walked, then changed under it */
+static void test_by_name(dom_document *doc, dom_element *root)
+{
+	dom_element *p[4], *div, *span, *extra;
+	dom_nodelist *list;
+	dom_string *str = string("p");
+
+	p[0] = element(doc, "p");
+	p[1] = element(doc, "p");
+	div = element(doc, "div");
+	span = element(doc, "span");
+	append(root, p[0]);
+	append(root, div);
+	append(div, p[1]);
+	append(root, span);
+
+	assert(dom_element_get_elements_by_tag_name(root, str, &list) ==
+			DOM_NO_ERR);
+
+	/* Only the first member has been found when the tree changes */
+	check_item(list, 0, p[0]);
+	p[2] = element(doc, "p");
+	append(span, p[2]);
+	check_item(list, 2, p[2]);
+	check(list, p, 3);
+
+	/* A member inserted before those already found */
+	p[3] = element(doc, "p");
+	insert_before(root, p[3], p[0]);
+	check_item(list, 0, p[3]);
+	check_item(list, 1, p[0]);
+	check_item(list, 3, p[2]);
+
+	/* Removing a member between item() calls, then freeing it */
+	check_item(list, 2, p[1]);
+	remove_child(div, p[1]);
+	dom_node_unref(p[1]);
+	check_item(list, 2, p[2]);
+	check_item(list, 3, NULL);
+
+	/* Removing the subtree holding a member */
+	remove_child(root, span);
+	check_item(list, 2, NULL);
+	check_item(list, 1, p[0]);
+
+	/* Putting it back, deeper in the tree */
+	append(div, span);
+	p[1] = p[0];
+	p[0] = p[3];
+	check(list, p, 3);
+
+	/* Changes to the tree outside the list's root leave it alone */
+	remove_child(root, div);
+	check(list, p, 2);
+	extra = element(doc, "p");
+	append(div, extra);
+	check(list, p, 2);
+
+	dom_nodelist_unref(list);
+	dom_string_unref(str);
+
+	dom_node_unref(extra);
+	dom_node_unref(span);
+	dom_node_unref(div);
+	dom_node_unref(p[0]);
+	dom_node_unref(p[1]);
+	dom_node_unref(p[2]);
+}
+
+/* A list of an element's children */
+static void test_children(dom_document *doc, dom_element *root)
+{
+	dom_element *c[3], *x;
+	dom_nodelist *list;
+
+	c[0] = element(doc, "a");
+	c[1] = element(doc, "b");
+	append(root, c[0]);
+	append(root, c[1]);
+
+	assert(dom_node_get_child_nodes(root, &list) == DOM_NO_ERR);
+	check(list, c, 2);
+
+	/* Appends and removals between item() calls */
+	c[2] = element(doc, "c");
+	append(root, c[2]);
+	check_item(list, 2, c[2]);
+	remove_child(root, c[0]);
+	check_item(list, 0, c[1]);
+	check_item(list, 1, c[2]);
+	check_item(list, 2, NULL);
+
+	/* A child's own children are not members */
+	x = element(doc, "x");
+	append(c[1], x);
+	check(list, c + 1, 2);
+
+	/* Emptied */
+	remove_child(root, c[1]);
+	remove_child(root, c[2]);
+	check(list, c, 0);
+
+	dom_nodelist_unref(list);
+
+	dom_node_unref(x);
+	dom_node_unref(c[2]);
+	dom_node_unref(c[1]);
+	dom_node_unref(c[0]);
+}
+
+int main(int argc, char **argv)
+{
+	dom_document *doc;
+	dom_element *root, *div;
+
+	UNUSED(argc);
+	UNUSED(argv);
+
+	assert(dom_implementation_create_document(DOM_IMPLEMENTATION_XML,
+			NULL, "root", NULL, NULL, NULL, &doc) == DOM_NO_ERR);
+	assert(dom_document_get_document_element(doc, &root) == DOM_NO_ERR);
+
+	test_by_name(doc, root);
+
+	div = element(doc, "div");
+	append(root, div);
+	test_children(doc, div);
+
+	dom_node_unref(div);
+	dom_node_unref(root);
+	dom_node_unref(doc);
+
+	printf("PASS\n");
+
+	return 0;
+}
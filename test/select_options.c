@@ -0,0 +1,271 @@
+/*
+ * This file is part of libdom test suite.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <dom/dom.h>
+
+#include <domts.h>
+
+static dom_document *doc;
+
+static dom_string *string(const char *s)
+{
+	dom_string *str;
+
+	assert(dom_string_create((const uint8_t *) s, strlen(s), &str) ==
+			DOM_NO_ERR);
+
+	return str;
+}
+
+static dom_element *element(const char *name)
+{
+	dom_string *str = string(name);
+	dom_element *e;
+
+	assert(dom_document_create_element(doc, str, &e) == DOM_NO_ERR);
+	dom_string_unref(str);
+
+	return e;
+}
+
+static void append(void *parent, void *child)
+{
+	dom_node *result;
+
+	assert(dom_node_append_child(parent, child, &result) == DOM_NO_ERR);
+	dom_node_unref(result);
+}
+
+static void insert_before(void *parent, void *child, void *ref)
+{
+	dom_node *result;
+
+	assert(dom_node_insert_before(parent, child, ref, &result) ==
+			DOM_NO_ERR);
+	dom_node_unref(result);
+}
+
+static void remove_child(void *parent, void *child)
+{
+	dom_node *result;
+
+	assert(dom_node_remove_child(parent, child, &result) == DOM_NO_ERR);
+	dom_node_unref(result);
+}
+
+static void select_option(dom_element *option, bool selected)
+{
+	assert(dom_html_option_element_set_selected(
+			(dom_html_option_element *) option, selected) ==
+			DOM_NO_ERR);
+}
+
+static void check_index(dom_element *option, int32_t expected)
+{
+	int32_t index;
+
+	assert(dom_html_option_element_get_index(
+			(dom_html_option_element *) option, &index) ==
+			DOM_NO_ERR);
+	if (index != expected)
+		printf("index %d, not %d\n", index, expected);
+	assert(index == expected);
+}
+
+static void check_selected(dom_element *select, int32_t expected)
+{
+	int32_t index;
+
+	assert(dom_html_select_element_get_selected_index(
+			(dom_html_select_element *) select, &index) ==
+			DOM_NO_ERR);
+	if (index != expected)
+		printf("selectedIndex %d, not %d\n", index, expected);
+	assert(index == expected);
+}
+
+/* Check a select's options, in order, and that each knows its index */
+static void check(dom_element *select, dom_element **options, uint32_t n)
+{
+	dom_html_options_collection *col;
+	dom_node *item;
+	uint32_t len, i;
+
+	assert(dom_html_select_element_get_length(
+			(dom_html_select_element *) select, &len) ==
+			DOM_NO_ERR);
+	if (len != n)
+		printf("length %u, not %u\n", len, n);
+	assert(len == n);
+
+	assert(dom_html_select_element_get_options(select, &col) ==
+			DOM_NO_ERR);
+	assert(dom_html_options_collection_get_length(col, &len) ==
+			DOM_NO_ERR);
+	assert(len == n);
+
+	for (i = 0; i < n; i++) {
+		assert(dom_html_options_collection_item(col, i, &item) ==
+				DOM_NO_ERR);
+		assert(item == (dom_node *) options[i]);
+		dom_node_unref(item);
+
+		check_index(options[i], i);
+	}
+
+	dom_html_options_collection_unref(col);
+}
+
+/* Options added to and removed from a select, directly and in optgroups */
+static void test_select(dom_element *body)
+{
+	dom_element *select = element("select");
+	dom_element *group = element("optgroup");
+	dom_element *o[6];
+	int i;
+
+	for (i = 0; i < 6; i++)
+		o[i] = element("option");
+
+	append(body, select);
+	append(select, o[0]);
+	append(select, group);
+	append(group, o[1]);
+	append(group, o[2]);
+	append(select, o[3]);
+
+	/* Options in an optgroup are numbered among all the select's */
+	check(select, o, 4);
+	check_selected(select, -1);
+
+	select_option(o[2], true);
+	check_selected(select, 2);
+
+	/* An option inserted before the selected one moves it along */
+	insert_before(select, o[4], o[0]);
+	check(select, (dom_element *[]) { o[4], o[0], o[1], o[2], o[3] }, 5);
+	check_selected(select, 3);
+
+	/* As does one inserted into the optgroup */
+	insert_before(group, o[5], o[1]);
+	check(select, (dom_element *[]) { o[4], o[0], o[5], o[1], o[2],
+			o[3] }, 6);
+	check_selected(select, 4);
+
+	/* Removing the optgroup removes its options */
+	remove_child(select, group);
+	check(select, (dom_element *[]) { o[4], o[0], o[3] }, 3);
+	check_selected(select, -1);
+
+	/* Which are numbered among their siblings while outside a select */
+	check_index(o[5], 0);
+	check_index(o[2], 2);
+
+	/* Putting it back at the end */
+	append(select, group);
+	check(select, (dom_element *[]) { o[4], o[0], o[3], o[5], o[1],
+			o[2] }, 6);
+	check_selected(select, 5);
+
+	/* An earlier selected option becomes the selected index */
+	select_option(o[3], true);
+	check_selected(select, 2);
+	select_option(o[3], false);
+	check_selected(select, 5);
+
+	/* Setting the selected index */
+	assert(dom_html_select_element_set_selected_index(
+			(dom_html_select_element *) select, 1) == DOM_NO_ERR);
+	check_selected(select, 1);
+
+	/* Removing options by index, including the selected one */
+	assert(dom_html_select_element_remove(
+			(dom_html_select_element *) select, 1) == DOM_NO_ERR);
+	check(select, (dom_element *[]) { o[4], o[3], o[5], o[1], o[2] }, 5);
+	check_selected(select, 4);
+	assert(dom_html_select_element_remove(
+			(dom_html_select_element *) select, 3) == DOM_NO_ERR);
+	check(select, (dom_element *[]) { o[4], o[3], o[5], o[2] }, 4);
+	check_selected(select, 3);
+
+	/* Out of range indices are ignored */
+	assert(dom_html_select_element_remove(
+			(dom_html_select_element *) select, 4) == DOM_NO_ERR);
+	assert(dom_html_select_element_remove(
+			(dom_html_select_element *) select, -1) == DOM_NO_ERR);
+	check(select, (dom_element *[]) { o[4], o[3], o[5], o[2] }, 4);
+
+	/* The removed options have no parent */
+	check_index(o[0], 0);
+	check_index(o[1], 0);
+
+	for (i = 0; i < 6; i++)
+		dom_node_unref(o[i]);
+	dom_node_unref(group);
+	dom_node_unref(select);
+}
+
+/* An option moved between two selects is numbered in its new one */
+static void test_move(dom_element *body)
+{
+	dom_element *s1 = element("select"), *s2 = element("select");
+	dom_element *o[4];
+	int i;
+
+	append(body, s1);
+	append(body, s2);
+	for (i = 0; i < 4; i++) {
+		o[i] = element("option");
+		append(i < 2 ? s1 : s2, o[i]);
+	}
+
+	select_option(o[1], true);
+	check(s1, o, 2);
+	check(s2, o + 2, 2);
+	check_selected(s1, 1);
+	check_selected(s2, -1);
+
+	/* The selected option moves to the front of the other select */
+	insert_before(s2, o[1], o[2]);
+	check(s2, (dom_element *[]) { o[1], o[2], o[3] }, 3);
+	check(s1, o, 1);
+	check_selected(s1, -1);
+	check_selected(s2, 0);
+
+	for (i = 0; i < 4; i++)
+		dom_node_unref(o[i]);
+	dom_node_unref(s2);
+	dom_node_unref(s1);
+}
+
+int main(int argc, char **argv)
+{
+	dom_element *html, *body;
+
+	UNUSED(argc);
+	UNUSED(argv);
+
+	assert(dom_implementation_create_document(DOM_IMPLEMENTATION_HTML,
+			NULL, "html", NULL, NULL, NULL, &doc) == DOM_NO_ERR);
+	assert(dom_document_get_document_element(doc, &html) == DOM_NO_ERR);
+
+	body = element("body");
+	append(html, body);
+
+	test_select(body);
+	test_move(body);
+
+	dom_node_unref(body);
+	dom_node_unref(html);
+	dom_node_unref(doc);
+
+	printf("PASS\n");
+
+	return 0;
+}
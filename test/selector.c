@@ -0,0 +1,417 @@
+/*
+ * This file is part of libdom test suite.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <dom/dom.h>
+
+#include <domts.h>
+
+#define MAX_NODES 32
+
+static dom_node *nodes[MAX_NODES];
+static int n_nodes;
+
+static dom_string *string(const char *s)
+{
+	dom_string *str;
+
+	assert(dom_string_create((const uint8_t *) s, strlen(s), &str) ==
+			DOM_NO_ERR);
+
+	return str;
+}
+
+static void set_attribute(dom_element *e, const char *name, const char *value)
+{
+	dom_string *n = string(name), *v = string(value);
+
+	assert(dom_element_set_attribute(e, n, v) == DOM_NO_ERR);
+	dom_string_unref(n);
+	dom_string_unref(v);
+}
+
+static void append(void *parent, void *child)
+{
+	dom_node *result;
+
+	assert(dom_node_append_child(parent, child, &result) == DOM_NO_ERR);
+	dom_node_unref(result);
+
+	assert(n_nodes < MAX_NODES);
+	nodes[n_nodes++] = child;
+}
+
+/* Append an element, with an id and optionally a class, to a parent */
+static dom_element *add(dom_document *doc, void *parent, const char *name,
+		const char *id, const char *class)
+{
+	dom_string *str = string(name);
+	dom_element *e;
+
+	assert(dom_document_create_element(doc, str, &e) == DOM_NO_ERR);
+	dom_string_unref(str);
+
+	set_attribute(e, "id", id);
+	if (class != NULL)
+		set_attribute(e, "class", class);
+
+	append(parent, e);
+
+	return e;
+}
+
+static void add_text(dom_document *doc, void *parent, const char *data)
+{
+	dom_string *str = string(data);
+	dom_text *t;
+
+	assert(dom_document_create_text_node(doc, str, &t) == DOM_NO_ERR);
+	dom_string_unref(str);
+
+	append(parent, t);
+}
+
+static void add_comment(dom_document *doc, void *parent, const char *data)
+{
+	dom_string *str = string(data);
+	dom_comment *c;
+
+	assert(dom_document_create_comment(doc, str, &c) == DOM_NO_ERR);
+	dom_string_unref(str);
+
+	append(parent, c);
+}
+
+/* List the ids of a node list's elements, separated by spaces */
+static void list_ids(dom_nodelist *list, char *ids, size_t size)
+{
+	dom_string *id = string("id");
+	uint32_t len, i;
+
+	ids[0] = '\0';
+
+	assert(dom_nodelist_get_length(list, &len) == DOM_NO_ERR);
+	for (i = 0; i < len; i++) {
+		dom_node *node;
+		dom_string *value;
+
+		assert(dom_nodelist_item(list, i, &node) == DOM_NO_ERR);
+		assert(dom_element_get_attribute(node, id, &value) ==
+				DOM_NO_ERR);
+		assert(value != NULL);
+
+		if (i > 0)
+			strncat(ids, " ", size - strlen(ids) - 1);
+		strncat(ids, dom_string_data(value),
+				min(dom_string_byte_length(value),
+				size - strlen(ids) - 1));
+
+		dom_string_unref(value);
+		dom_node_unref(node);
+	}
+
+	dom_string_unref(id);
+}
+
+/* Check the ids of the elements a selector matches below an element */
+static void check(dom_element *root, const char *selectors,
+		const char *expected)
+{
+	dom_string *str = string(selectors);
+	dom_nodelist *list;
+	dom_element *first;
+	char ids[256];
+
+	assert(dom_element_query_selector_all(root, str, &list) ==
+			DOM_NO_ERR);
+	list_ids(list, ids, sizeof(ids));
+	dom_nodelist_unref(list);
+
+	if (strcmp(ids, expected) != 0)
+		printf("'%s' matched '%s', not '%s'\n",
+				selectors, ids, expected);
+	assert(strcmp(ids, expected) == 0);
+
+	/* The first match is the first in the list */
+	assert(dom_element_query_selector(root, str, &first) == DOM_NO_ERR);
+	assert((first == NULL) == (expected[0] == '\0'));
+	if (first != NULL) {
+		dom_string *id = string("id"), *value;
+
+		assert(dom_element_get_attribute(first, id, &value) ==
+				DOM_NO_ERR);
+		assert(dom_string_byte_length(value) ==
+				strcspn(expected, " "));
+		assert(strncmp(dom_string_data(value), expected,
+				dom_string_byte_length(value)) == 0);
+		dom_string_unref(value);
+		dom_string_unref(id);
+		dom_node_unref(first);
+	}
+
+	dom_string_unref(str);
+}
+
+/* Check a selector is refused */
+static void check_error(dom_element *root, const char *selectors,
+		dom_exception expected)
+{
+	dom_string *str = string(selectors);
+	dom_nodelist *list = NULL;
+	dom_element *first = NULL;
+
+	assert(dom_element_query_selector_all(root, str, &list) == expected);
+	assert(list == NULL);
+	assert(dom_element_query_selector(root, str, &first) == expected);
+	assert(first == NULL);
+
+	dom_string_unref(str);
+}
+
+static void test_static_list(dom_element *div, dom_element *p1)
+{
+	dom_string *str = string("body p");
+	dom_nodelist *list;
+	dom_node *removed, *item;
+	uint32_t len;
+
+	/* Ancestors above the element queried may match */
+	assert(dom_element_query_selector_all(div, str, &list) ==
+			DOM_NO_ERR);
+	assert(dom_nodelist_get_length(list, &len) == DOM_NO_ERR);
+	assert(len == 2);
+
+	/* The list does not change when its members are removed */
+	assert(dom_node_remove_child(div, p1, &removed) == DOM_NO_ERR);
+	dom_node_unref(removed);
+
+	assert(dom_nodelist_get_length(list, &len) == DOM_NO_ERR);
+	assert(len == 2);
+	assert(dom_nodelist_item(list, 0, &item) == DOM_NO_ERR);
+	assert(item == (dom_node *) p1);
+	dom_node_unref(item);
+
+	dom_nodelist_unref(list);
+	dom_string_unref(str);
+
+	check(div, "p", "p2");
+}
+
+/* Names of HTML elements in HTML documents are matched caselessly, but
+ * not those of elements imported from other documents */
+static void test_html(void)
+{
+	dom_document *doc, *xml;
+	dom_element *html, *body, *div, *e;
+	dom_string *name = string("Foo");
+	dom_node *imported;
+
+	assert(dom_implementation_create_document(DOM_IMPLEMENTATION_HTML,
+			NULL, "html", NULL, NULL, NULL, &doc) == DOM_NO_ERR);
+	assert(dom_document_get_document_element(doc, &html) == DOM_NO_ERR);
+
+	/* <html>
+	 *   <body id=b>
+	 *     <div id=d title=Foo><p id=p/></div>
+	 *     <Foo id=f Bar=x/>, from an XML document
+	 *   </body>
+	 * </html> */
+	body = add(doc, html, "body", "b", NULL);
+	div = add(doc, body, "div", "d", NULL);
+	set_attribute(div, "title", "Foo");
+	add(doc, div, "p", "p", NULL);
+
+	assert(dom_implementation_create_document(DOM_IMPLEMENTATION_XML,
+			NULL, "root", NULL, NULL, NULL, &xml) == DOM_NO_ERR);
+	assert(dom_document_create_element(xml, name, &e) == DOM_NO_ERR);
+	dom_string_unref(name);
+	set_attribute(e, "id", "f");
+	set_attribute(e, "Bar", "x");
+	assert(dom_document_import_node(doc, e, false, &imported) ==
+			DOM_NO_ERR);
+	append(body, imported);
+	dom_node_unref(e);
+	dom_node_unref(xml);
+
+	check(html, "p", "p");
+	check(html, "P", "p");
+	check(html, "DiV > p", "p");
+	check(html, "BODY *", "d p f");
+	check(html, "[title]", "d");
+	check(html, "[TITLE=Foo]", "d");
+	check(html, "[Title=foo i]", "d");
+
+	/* Values are still compared case sensitively */
+	check(html, "[title=foo]", "");
+
+	check(html, "Foo", "f");
+	check(html, "foo", "");
+	check(html, "[Bar]", "f");
+	check(html, "[bar]", "");
+
+	while (n_nodes > 0)
+		dom_node_unref(nodes[--n_nodes]);
+	dom_node_unref(html);
+	dom_node_unref(doc);
+}
+
+int main(int argc, char **argv)
+{
+	dom_document *doc;
+	dom_element *html, *body, *div1, *div2, *p1, *ul, *li3;
+
+	UNUSED(argc);
+	UNUSED(argv);
+
+	assert(dom_implementation_create_document(DOM_IMPLEMENTATION_XML,
+			NULL, "html", NULL, NULL, NULL, &doc) == DOM_NO_ERR);
+	assert(dom_document_get_document_element(doc, &html) == DOM_NO_ERR);
+
+	/* <html>
+	 *   <body id=b>
+	 *     <div id=d1 class="a b" lang=en-US>
+	 *       <p id=p1 class=x>t</p><span id=s1/><p id=p2/>
+	 *     </div>
+	 *     <div id=d2 class=B data-x="hello world" title=Foo>
+	 *       <em id=e1/>
+	 *     </div>
+	 *     <ul id=u>
+	 *       <li id=l1/><li id=l2 class=a/><li id=l3><!-- c --></li>
+	 *       <li id=x&#xfffd;/>
+	 *     </ul>
+	 *   </body>
+	 * </html> */
+	body = add(doc, html, "body", "b", NULL);
+	div1 = add(doc, body, "div", "d1", "a b");
+	set_attribute(div1, "lang", "en-US");
+	p1 = add(doc, div1, "p", "p1", "x");
+	add_text(doc, p1, "t");
+	add(doc, div1, "span", "s1", NULL);
+	add(doc, div1, "p", "p2", NULL);
+	div2 = add(doc, body, "div", "d2", "B");
+	set_attribute(div2, "data-x", "hello world");
+	set_attribute(div2, "title", "Foo");
+	add(doc, div2, "em", "e1", NULL);
+	ul = add(doc, body, "ul", "u", NULL);
+	add(doc, ul, "li", "l1", NULL);
+	add(doc, ul, "li", "l2", "a");
+	li3 = add(doc, ul, "li", "l3", NULL);
+	add_comment(doc, li3, " c ");
+	add(doc, ul, "li", "x\xef\xbf\xbd", NULL);
+
+	/* Type, universal, class and ID selectors */
+	check(html, "p", "p1 p2");
+	check(html, "P", "");
+	check(html, "*", "b d1 p1 s1 p2 d2 e1 u l1 l2 l3 x\xef\xbf\xbd");
+	check(html, ".a", "d1 l2");
+	check(html, ".A", "");
+	check(html, ".a.b", "d1");
+	check(html, "div.B", "d2");
+	check(html, "#d2", "d2");
+	check(html, "#D2", "");
+
+	/* Combinators */
+	check(html, "div p", "p1 p2");
+	check(html, "html p", "p1 p2");
+	check(html, "body div em", "e1");
+	check(html, "div div", "");
+	check(html, "div > p", "p1 p2");
+	check(html, "body > p", "");
+	check(html, "p + span", "s1");
+	check(html, "li + li", "l2 l3 x\xef\xbf\xbd");
+	check(html, "span + *", "p2");
+	check(html, "p ~ p", "p2");
+	check(html, "li ~ .a", "l2");
+	check(html, "ul li + li + li", "l3 x\xef\xbf\xbd");
+	check(html, "body div:first-child ~ div", "d2");
+
+	/* Attribute selectors */
+	check(html, "[lang]", "d1");
+	check(html, "[lang=en-US]", "d1");
+	check(html, "[lang=en]", "");
+	check(html, "[data-x~=world]", "d2");
+	check(html, "[data-x~=wor]", "");
+	check(html, "[lang|=en]", "d1");
+	check(html, "[lang|=e]", "");
+	check(html, "[data-x^=hel]", "d2");
+	check(html, "[data-x^=world]", "");
+	check(html, "[data-x$='rld']", "d2");
+	check(html, "[data-x$=hello]", "");
+	check(html, "[data-x*=\"o w\"]", "d2");
+	check(html, "[data-x*=ow]", "");
+	check(html, "[title=foo]", "");
+	check(html, "[title=foo i]", "d2");
+	check(html, "[ title = \"Foo\" s ]", "d2");
+
+	/* Names are matched case sensitively outside HTML documents */
+	check(html, "[TITLE]", "");
+	check(html, "[Title=Foo i]", "");
+	check(html, "DIV > p", "");
+
+	/* Pseudo-classes */
+	check(html, ":root", "");
+	check(body, ":root", "");
+	check(html, "li:first-child", "l1");
+	check(html, "li:last-child", "x\xef\xbf\xbd");
+	check(html, ":only-child", "b e1");
+	check(html, "p:empty", "p2");
+	check(html, "li:empty", "l1 l2 l3 x\xef\xbf\xbd");
+	check(html, ":EMPTY", "s1 p2 e1 l1 l2 l3 x\xef\xbf\xbd");
+
+	/* Selector lists and escapes */
+	check(html, "em, #p1, li.a", "p1 e1 l2");
+	check(html, "  div  >  p:first-child , ul>li:last-child ",
+			"p1 x\xef\xbf\xbd");
+	check(html, "#\\64 1", "d1");
+	check(html, ".\\61", "d1 l2");
+	check(html, "#x\\", "x\xef\xbf\xbd");
+	check(html, "#x\\0", "x\xef\xbf\xbd");
+	check(html, "a\\", "");
+
+	/* Syntax errors */
+	check_error(html, "", DOM_SYNTAX_ERR);
+	check_error(html, "a,", DOM_SYNTAX_ERR);
+	check_error(html, "a >", DOM_SYNTAX_ERR);
+	check_error(html, "> a", DOM_SYNTAX_ERR);
+	check_error(html, "[a", DOM_SYNTAX_ERR);
+	check_error(html, "[a=]", DOM_SYNTAX_ERR);
+	check_error(html, "[a='x", DOM_SYNTAX_ERR);
+	check_error(html, "[a=x y]", DOM_SYNTAX_ERR);
+	check_error(html, "#1", DOM_SYNTAX_ERR);
+	check_error(html, "a)", DOM_SYNTAX_ERR);
+
+	/* Unsupported selectors */
+	check_error(html, "a:hover", DOM_NOT_SUPPORTED_ERR);
+	check_error(html, "a::before", DOM_NOT_SUPPORTED_ERR);
+	check_error(html, ":not(a)", DOM_NOT_SUPPORTED_ERR);
+	check_error(html, "ns|a", DOM_NOT_SUPPORTED_ERR);
+	check_error(html, "[*|a]", DOM_NOT_SUPPORTED_ERR);
+
+	/* Class and ID selectors fold case in quirks mode */
+	assert(dom_document_set_quirks_mode(doc,
+			DOM_DOCUMENT_QUIRKS_MODE_FULL) == DOM_NO_ERR);
+	check(html, ".A", "d1 l2");
+	check(html, "#D2", "d2");
+	check(html, "[title=foo]", "");
+	assert(dom_document_set_quirks_mode(doc,
+			DOM_DOCUMENT_QUIRKS_MODE_NONE) == DOM_NO_ERR);
+	check(html, ".A", "");
+
+	test_static_list(div1, p1);
+
+	while (n_nodes > 0)
+		dom_node_unref(nodes[--n_nodes]);
+	dom_node_unref(html);
+	dom_node_unref(doc);
+
+	test_html();
+
+	printf("PASS\n");
+
+	return 0;
+}
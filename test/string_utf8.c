@@ -0,0 +1,520 @@
+/*
+ * This file is part of libdom test suite.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <dom/dom.h>
+
+#include <domts.h>
+
+/* Strings which are not ASCII record the byte offset of every 64th
+ * character, so characters either side of these are looked at closely */
+#define STRIDE 64
+
+#define MAX_CHARS 1024
+#define MAX_BYTES (MAX_CHARS * 4)
+
+/* Characters of each UTF-8 length, and ASCII ones among them */
+static const uint32_t sample[] = {
+	'a', 0xE9, 0x20AC, 0x1F600, 'z', 0x3B1, 0x4E2D, 0x10348
+};
+
+#define N_SAMPLE (sizeof(sample) / sizeof(sample[0]))
+
+static const uint32_t lengths[] = {
+	0, 1, 2, 63, 64, 65, 127, 128, 129, 130, 200, 257
+};
+
+#define N_LENGTHS (sizeof(lengths) / sizeof(lengths[0]))
+
+/* Character indices around the recorded offsets */
+static const uint32_t boundaries[] = {
+	0, 1, 62, 63, 64, 65, 66, 127, 128, 129, 191, 192, 193, 256, 257
+};
+
+#define N_BOUNDARIES (sizeof(boundaries) / sizeof(boundaries[0]))
+
+/* Some UTF-8 text */
+struct text {
+	uint8_t bytes[MAX_BYTES];
+	size_t len;
+};
+
+static size_t encode(uint32_t c, uint8_t *buf)
+{
+	if (c < 0x80) {
+		buf[0] = c;
+		return 1;
+	} else if (c < 0x800) {
+		buf[0] = 0xC0 | (c >> 6);
+		buf[1] = 0x80 | (c & 0x3F);
+		return 2;
+	} else if (c < 0x10000) {
+		buf[0] = 0xE0 | (c >> 12);
+		buf[1] = 0x80 | ((c >> 6) & 0x3F);
+		buf[2] = 0x80 | (c & 0x3F);
+		return 3;
+	}
+
+	buf[0] = 0xF0 | (c >> 18);
+	buf[1] = 0x80 | ((c >> 12) & 0x3F);
+	buf[2] = 0x80 | ((c >> 6) & 0x3F);
+	buf[3] = 0x80 | (c & 0x3F);
+	return 4;
+}
+
+/* Decode a text, which is valid UTF-8, giving each character and its
+ * byte offset, with the offset of the end after the last */
+static uint32_t decode(const struct text *t, uint32_t *chars,
+		size_t *offsets)
+{
+	uint32_t n = 0;
+	size_t i = 0;
+
+	while (i < t->len) {
+		uint8_t b = t->bytes[i];
+		size_t len = b < 0x80 ? 1 : b < 0xE0 ? 2 : b < 0xF0 ? 3 : 4;
+		uint32_t c = len == 1 ? b : b & (0x7F >> len);
+		size_t j;
+
+		for (j = 1; j < len; j++)
+			c = (c << 6) | (t->bytes[i + j] & 0x3F);
+
+		assert(n < MAX_CHARS);
+		offsets[n] = i;
+		chars[n++] = c;
+		i += len;
+	}
+
+	offsets[n] = i;
+
+	return n;
+}
+
+/* Make a text of n characters, all ASCII or mixed */
+static void make(struct text *t, uint32_t n, uint32_t seed, bool ascii)
+{
+	uint32_t i;
+
+	t->len = 0;
+	for (i = 0; i < n; i++) {
+		uint32_t c = ascii ? 'a' + (i + seed) % 26 :
+				sample[(i * 3 + seed + i / 7) % N_SAMPLE];
+
+		t->len += encode(c, t->bytes + t->len);
+	}
+}
+
+/* Make the text of characters i1 to i2 of another */
+static void slice(struct text *out, const struct text *t, uint32_t i1,
+		uint32_t i2)
+{
+	static uint32_t chars[MAX_CHARS + 1];
+	static size_t offsets[MAX_CHARS + 1];
+
+	decode(t, chars, offsets);
+	out->len = offsets[i2] - offsets[i1];
+	memcpy(out->bytes, t->bytes + offsets[i1], out->len);
+}
+
+/* Make the text of t with characters i1 to i2 replaced by s */
+static void splice(struct text *out, const struct text *t, uint32_t i1,
+		uint32_t i2, const struct text *s)
+{
+	static uint32_t chars[MAX_CHARS + 1];
+	static size_t offsets[MAX_CHARS + 1];
+	size_t b1, b2;
+
+	decode(t, chars, offsets);
+	b1 = offsets[i1];
+	b2 = offsets[i2];
+
+	assert(t->len - (b2 - b1) + s->len <= MAX_BYTES);
+
+	memcpy(out->bytes, t->bytes, b1);
+	memcpy(out->bytes + b1, s->bytes, s->len);
+	memcpy(out->bytes + b1 + s->len, t->bytes + b2, t->len - b2);
+	out->len = t->len - (b2 - b1) + s->len;
+}
+
+static dom_string *string(const struct text *t)
+{
+	dom_string *str;
+
+	assert(dom_string_create(t->bytes, t->len, &str) == DOM_NO_ERR);
+
+	return str;
+}
+
+static uint32_t length(const struct text *t)
+{
+	static uint32_t chars[MAX_CHARS + 1];
+	static size_t offsets[MAX_CHARS + 1];
+
+	return decode(t, chars, offsets);
+}
+
+/* Check a string holds a text, reading its characters in order, or from
+ * the last back to the first */
+static void check(dom_string *str, const struct text *t, bool backwards)
+{
+	static uint32_t chars[MAX_CHARS + 1];
+	static size_t offsets[MAX_CHARS + 1];
+	uint32_t n = decode(t, chars, offsets);
+	uint32_t i, c;
+
+	assert(dom_string_byte_length(str) == t->len);
+	assert(memcmp(dom_string_data(str), t->bytes, t->len) == 0);
+
+	for (i = 0; i < n; i++) {
+		uint32_t index = backwards ? n - 1 - i : i;
+
+		assert(dom_string_at(str, index, &c) == DOM_NO_ERR);
+		if (c != chars[index])
+			printf("character %u is %x, not %x\n", index, c,
+					chars[index]);
+		assert(c == chars[index]);
+	}
+
+	assert(dom_string_at(str, n, &c) == DOM_DOMSTRING_SIZE_ERR);
+
+	if (dom_string_length(str) != n)
+		printf("length %u, not %u\n", dom_string_length(str), n);
+	assert(dom_string_length(str) == n);
+}
+
+/* Characters read in any order, from created and interned strings */
+static void test_at(void)
+{
+	struct text t;
+	dom_string *str;
+	lwc_string *lwc;
+	uint32_t i, c;
+	int ascii;
+
+	for (ascii = 0; ascii < 2; ascii++) {
+		for (i = 0; i < N_LENGTHS; i++) {
+			make(&t, lengths[i], i, ascii);
+
+			str = string(&t);
+			check(str, &t, false);
+
+			/* Interning keeps what is known of the string */
+			assert(dom_string_intern(str, &lwc) == DOM_NO_ERR);
+			lwc_string_unref(lwc);
+			check(str, &t, true);
+			dom_string_unref(str);
+
+			/* The first character read is far into the string */
+			str = string(&t);
+			check(str, &t, true);
+			dom_string_unref(str);
+
+			assert(dom_string_create_interned(t.bytes, t.len,
+					&str) == DOM_NO_ERR);
+			if (lengths[i] > STRIDE) {
+				assert(dom_string_at(str, STRIDE, &c) ==
+						DOM_NO_ERR);
+			}
+			check(str, &t, false);
+			dom_string_unref(str);
+		}
+	}
+}
+
+/* Substrings starting and ending either side of the recorded offsets */
+static void test_substr(void)
+{
+	struct text t, expected;
+	dom_string *str, *sub;
+	uint32_t i, j, k, n;
+	int ascii;
+
+	for (ascii = 0; ascii < 2; ascii++) {
+		for (i = 0; i < N_LENGTHS; i++) {
+			n = lengths[i];
+			make(&t, n, i, ascii);
+			str = string(&t);
+
+			for (j = 0; j < N_BOUNDARIES; j++) {
+				for (k = j; k < N_BOUNDARIES; k++) {
+					uint32_t i1 = boundaries[j];
+					uint32_t i2 = boundaries[k];
+
+					if (i2 > n)
+						break;
+
+					assert(dom_string_substr(str, i1, i2,
+							&sub) == DOM_NO_ERR);
+					slice(&expected, &t, i1, i2);
+					check(sub, &expected, k % 2);
+					dom_string_unref(sub);
+				}
+			}
+
+			/* The whole string */
+			assert(dom_string_substr(str, 0, n, &sub) ==
+					DOM_NO_ERR);
+			check(sub, &t, false);
+			dom_string_unref(sub);
+
+			/* Past the end */
+			assert(dom_string_substr(str, 0, n + 1, &sub) !=
+					DOM_NO_ERR);
+
+			dom_string_unref(str);
+		}
+	}
+}
+
+/* Texts inserted and replacing others, from empty to longer than the
+ * distance between recorded offsets */
+static void sources(struct text *s)
+{
+	make(&s[0], 0, 0, true);
+	make(&s[1], 2, 0, true);
+	make(&s[2], 1, 1, false);
+	make(&s[3], 3, 2, false);
+	make(&s[4], STRIDE + 6, 3, false);
+	make(&s[5], 3 * STRIDE, 4, false);
+}
+
+#define N_SOURCES 6
+
+/* Insertions either side of the recorded offsets, in strings whose
+ * offsets have been recorded, and in those whose have not */
+static void test_insert(void)
+{
+	static struct text t, s[N_SOURCES], expected;
+	dom_string *str, *src, *res;
+	uint32_t i, j, k, n;
+	int ascii;
+
+	sources(s);
+
+	for (ascii = 0; ascii < 2; ascii++) {
+		for (i = 0; i < N_LENGTHS; i++) {
+			n = lengths[i];
+			make(&t, n, i, ascii);
+
+			for (k = 0; k < N_SOURCES; k++) {
+				src = string(&s[k]);
+
+				for (j = 0; j < N_BOUNDARIES; j++) {
+					uint32_t at = boundaries[j];
+
+					if (at > n)
+						break;
+
+					str = string(&t);
+					if (j % 2 == 0)
+						check(str, &t, false);
+
+					assert(dom_string_insert(str, src, at,
+							&res) == DOM_NO_ERR);
+					splice(&expected, &t, at, at, &s[k]);
+					check(res, &expected, j % 4 == 1);
+
+					dom_string_unref(res);
+					dom_string_unref(str);
+				}
+
+				/* Past the end */
+				str = string(&t);
+				assert(dom_string_insert(str, src, n + 1,
+						&res) == DOM_INDEX_SIZE_ERR);
+				dom_string_unref(str);
+
+				dom_string_unref(src);
+			}
+		}
+	}
+}
+
+/* Replacements of ranges starting and ending either side of the
+ * recorded offsets */
+static void test_replace(void)
+{
+	static struct text t, s[N_SOURCES], expected;
+	dom_string *str, *src, *res;
+	uint32_t i, j, k, l, n;
+	int ascii;
+
+	sources(s);
+
+	for (ascii = 0; ascii < 2; ascii++) {
+		for (i = 0; i < N_LENGTHS; i++) {
+			n = lengths[i];
+			make(&t, n, i, ascii);
+
+			str = string(&t);
+			check(str, &t, false);
+
+			for (l = 0; l < N_SOURCES; l++) {
+				src = string(&s[l]);
+
+				for (j = 0; j < N_BOUNDARIES; j++) {
+					for (k = j; k < N_BOUNDARIES; k++) {
+						uint32_t i1 = boundaries[j];
+						uint32_t i2 = boundaries[k];
+
+						if (i2 > n)
+							break;
+
+						assert(dom_string_replace(str,
+								src, i1, i2,
+								&res) ==
+								DOM_NO_ERR);
+						splice(&expected, &t, i1, i2,
+								&s[l]);
+						check(res, &expected, k % 2);
+						dom_string_unref(res);
+					}
+				}
+
+				dom_string_unref(src);
+			}
+
+			dom_string_unref(str);
+		}
+	}
+}
+
+/* A long string edited many times, each edit made to the last result,
+ * so that the recorded offsets are carried from string to string */
+static void test_edits(void)
+{
+	static struct text t, s, next;
+	dom_string *str, *src, *res;
+	uint32_t step, n, i1, i2, len;
+
+	make(&t, 300, 0, false);
+	str = string(&t);
+	check(str, &t, false);
+
+	for (step = 0; step < 200; step++) {
+		n = length(&t);
+		i1 = (step * 37) % (n + 1);
+		len = (step * 11) % (step % 5 == 0 ? 3 * STRIDE : 8);
+		i2 = i1 + len > n ? n : i1 + len;
+
+		/* Sometimes ASCII, sometimes long, sometimes nothing */
+		make(&s, (step * 13) % (step % 7 == 0 ? 2 * STRIDE + 10 : 6),
+				step, step % 3 == 0);
+
+		/* Keep the string from growing too long, or too short */
+		if (n > 600)
+			s.len = 0;
+		else if (n < 100)
+			i2 = i1;
+
+		src = string(&s);
+		if (step % 2 == 0) {
+			assert(dom_string_insert(str, src, i1, &res) ==
+					DOM_NO_ERR);
+			i2 = i1;
+		} else {
+			assert(dom_string_replace(str, src, i1, i2, &res) ==
+					DOM_NO_ERR);
+		}
+
+		splice(&next, &t, i1, i2, &s);
+		check(res, &next, step % 4 == 1);
+
+		dom_string_unref(src);
+		dom_string_unref(str);
+		str = res;
+		t = next;
+	}
+
+	dom_string_unref(str);
+}
+
+/* Whether a string is ASCII is carried to the strings made from it */
+static void test_ascii(void)
+{
+	static struct text a, m, c, expected, part;
+	dom_string *as, *ms, *cs, *res, *sub;
+
+	make(&a, 200, 0, true);
+	make(&m, 200, 0, false);
+	as = string(&a);
+	ms = string(&m);
+
+	/* Before anything is known of either */
+	assert(dom_string_concat(as, ms, &res) == DOM_NO_ERR);
+	splice(&expected, &a, 200, 200, &m);
+	check(res, &expected, true);
+
+	/* An ASCII substring of a string which is not */
+	assert(dom_string_substr(res, STRIDE - 1, 200, &sub) == DOM_NO_ERR);
+	slice(&part, &a, STRIDE - 1, 200);
+	check(sub, &part, true);
+	dom_string_unref(sub);
+	dom_string_unref(res);
+
+	/* Once each is known */
+	check(as, &a, false);
+	check(ms, &m, false);
+
+	assert(dom_string_concat(as, as, &res) == DOM_NO_ERR);
+	splice(&expected, &a, 200, 200, &a);
+	check(res, &expected, true);
+	dom_string_unref(res);
+
+	assert(dom_string_concat(ms, as, &res) == DOM_NO_ERR);
+	splice(&expected, &m, 200, 200, &a);
+	check(res, &expected, true);
+	dom_string_unref(res);
+
+	/* A single multibyte character put into an ASCII string */
+	assert(dom_string_substr(ms, 1, 2, &sub) == DOM_NO_ERR);
+	slice(&c, &m, 1, 2);
+	assert(c.len > 1);
+
+	assert(dom_string_insert(as, sub, STRIDE, &res) == DOM_NO_ERR);
+	splice(&expected, &a, STRIDE, STRIDE, &c);
+	check(res, &expected, true);
+	dom_string_unref(res);
+
+	assert(dom_string_replace(as, sub, STRIDE, STRIDE + 1, &res) ==
+			DOM_NO_ERR);
+	splice(&expected, &a, STRIDE, STRIDE + 1, &c);
+	check(res, &expected, true);
+	dom_string_unref(sub);
+
+	/* And replaced by an ASCII one, leaving an ASCII string */
+	assert(dom_string_substr(as, 0, 1, &sub) == DOM_NO_ERR);
+	assert(dom_string_replace(res, sub, STRIDE, STRIDE + 1, &cs) ==
+			DOM_NO_ERR);
+	slice(&c, &a, 0, 1);
+	splice(&expected, &a, STRIDE, STRIDE + 1, &c);
+	check(cs, &expected, true);
+
+	dom_string_unref(cs);
+	dom_string_unref(sub);
+	dom_string_unref(res);
+	dom_string_unref(ms);
+	dom_string_unref(as);
+}
+
+int main(int argc, char **argv)
+{
+	UNUSED(argc);
+	UNUSED(argv);
+
+	test_at();
+	test_substr();
+	test_insert();
+	test_replace();
+	test_edits();
+	test_ascii();
+
+	printf("PASS\n");
+
+	return 0;
+}
@@ -0,0 +1,322 @@
+/*
+ * This file is part of libdom test suite.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <dom/dom.h>
+
+#include <domts.h>
+
+static dom_document *doc;
+
+static dom_string *string(const char *s)
+{
+	dom_string *str;
+
+	assert(dom_string_create((const uint8_t *) s, strlen(s), &str) ==
+			DOM_NO_ERR);
+
+	return str;
+}
+
+static dom_element *element(const char *name)
+{
+	dom_string *str = string(name);
+	dom_element *e;
+
+	assert(dom_document_create_element(doc, str, &e) == DOM_NO_ERR);
+	dom_string_unref(str);
+
+	return e;
+}
+
+static void append(void *parent, void *child)
+{
+	dom_node *result;
+
+	assert(dom_node_append_child(parent, child, &result) == DOM_NO_ERR);
+	dom_node_unref(result);
+}
+
+static void insert_before(void *parent, void *child, void *ref)
+{
+	dom_node *result;
+
+	assert(dom_node_insert_before(parent, child, ref, &result) ==
+			DOM_NO_ERR);
+	dom_node_unref(result);
+}
+
+static void remove_child(void *parent, void *child)
+{
+	dom_node *result;
+
+	assert(dom_node_remove_child(parent, child, &result) == DOM_NO_ERR);
+	dom_node_unref(result);
+}
+
+/* Check a table's rows collection, which is in tree order */
+static void check_rows(dom_element *table, dom_element **rows, uint32_t n)
+{
+	dom_html_collection *col;
+	dom_node *item;
+	uint32_t len, i;
+
+	assert(dom_html_table_element_get_rows(
+			(dom_html_table_element *) table, &col) ==
+			DOM_NO_ERR);
+	assert(dom_html_collection_get_length(col, &len) == DOM_NO_ERR);
+	if (len != n)
+		printf("length %u, not %u\n", len, n);
+	assert(len == n);
+
+	for (i = 0; i < n; i++) {
+		assert(dom_html_collection_item(col, i, &item) == DOM_NO_ERR);
+		assert(item == (dom_node *) rows[i]);
+		dom_node_unref(item);
+	}
+
+	dom_html_collection_unref(col);
+}
+
+/* Check that each of a table's rows, in logical order, knows its rowIndex */
+static void check_index(dom_element **rows, uint32_t n)
+{
+	uint32_t i;
+	int32_t index;
+
+	for (i = 0; i < n; i++) {
+		assert(dom_html_table_row_element_get_row_index(
+				(dom_html_table_row_element *) rows[i],
+				&index) == DOM_NO_ERR);
+		if (index != (int32_t) i)
+			printf("rowIndex %d, not %u\n", index, i);
+		assert(index == (int32_t) i);
+	}
+}
+
+/* Check that each row of a section knows its sectionRowIndex */
+static void check_section(dom_element **rows, uint32_t n)
+{
+	uint32_t i;
+	int32_t index;
+
+	for (i = 0; i < n; i++) {
+		assert(dom_html_table_row_element_get_section_row_index(
+				(dom_html_table_row_element *) rows[i],
+				&index) == DOM_NO_ERR);
+		if (index != (int32_t) i)
+			printf("sectionRowIndex %d, not %u\n", index, i);
+		assert(index == (int32_t) i);
+	}
+}
+
+/* Check that each cell of a row knows its cellIndex */
+static void check_cells(dom_element **cells, uint32_t n)
+{
+	uint32_t i;
+	dom_long index;
+
+	for (i = 0; i < n; i++) {
+		assert(dom_html_table_cell_element_get_cell_index(
+				(dom_html_table_cell_element *) cells[i],
+				&index) == DOM_NO_ERR);
+		if (index != (dom_long) i)
+			printf("cellIndex %d, not %u\n", (int) index, i);
+		assert(index == (dom_long) i);
+	}
+}
+
+/* Rows moved between the head, bodies and foot of a table */
+static void test_rows(dom_element *body)
+{
+	dom_element *table = element("table");
+	dom_element *head = element("thead"), *foot = element("tfoot");
+	dom_element *b1 = element("tbody"), *b2 = element("tbody");
+	dom_element *r[6];
+	int32_t index;
+	int i;
+
+	for (i = 0; i < 6; i++)
+		r[i] = element("tr");
+
+	append(body, table);
+	append(table, head);
+	append(table, b1);
+	append(table, b2);
+	append(table, foot);
+	append(head, r[0]);
+	append(b1, r[1]);
+	append(b1, r[2]);
+	append(b2, r[3]);
+	append(foot, r[4]);
+
+	check_rows(table, r, 5);
+	check_index(r, 5);
+	check_section((dom_element *[]) { r[1], r[2] }, 2);
+
+	/* A row moved from a body into the head */
+	append(head, r[2]);
+	check_rows(table, (dom_element *[]) { r[0], r[2], r[1], r[3], r[4] },
+			5);
+	check_index((dom_element *[]) { r[0], r[2], r[1], r[3], r[4] }, 5);
+	check_section((dom_element *[]) { r[0], r[2] }, 2);
+	check_section(r + 1, 1);
+
+	/* A row moved from the head into the foot */
+	insert_before(foot, r[0], r[4]);
+	check_index((dom_element *[]) { r[2], r[1], r[3], r[0], r[4] }, 5);
+	check_section((dom_element *[]) { r[0], r[4] }, 2);
+	check_section(r + 2, 1);
+
+	/* The head's rows come first wherever the head is */
+	append(table, head);
+	check_rows(table, (dom_element *[]) { r[1], r[3], r[0], r[4], r[2] },
+			5);
+	check_index((dom_element *[]) { r[2], r[1], r[3], r[0], r[4] }, 5);
+
+	/* A row moved between bodies */
+	insert_before(b1, r[3], r[1]);
+	check_index((dom_element *[]) { r[2], r[3], r[1], r[0], r[4] }, 5);
+	check_section((dom_element *[]) { r[3], r[1] }, 2);
+
+	/* A new row, added to the emptied body */
+	append(b2, r[5]);
+	check_rows(table, (dom_element *[]) { r[3], r[1], r[5], r[0], r[4],
+			r[2] }, 6);
+	check_index((dom_element *[]) { r[2], r[3], r[1], r[5], r[0],
+			r[4] }, 6);
+	check_section(r + 5, 1);
+
+	/* Rows leaving the table */
+	remove_child(b1, r[3]);
+	check_rows(table, (dom_element *[]) { r[1], r[5], r[0], r[4], r[2] },
+			5);
+	check_index((dom_element *[]) { r[2], r[1], r[5], r[0], r[4] }, 5);
+	assert(dom_html_table_row_element_get_row_index(
+			(dom_html_table_row_element *) r[3], &index) ==
+			DOM_HIERARCHY_REQUEST_ERR);
+	assert(dom_html_table_row_element_get_section_row_index(
+			(dom_html_table_row_element *) r[3], &index) ==
+			DOM_NO_ERR);
+	assert(index == -1);
+
+	/* A section removed from the table keeps numbering its rows */
+	remove_child(table, foot);
+	check_rows(table, (dom_element *[]) { r[1], r[5], r[2] }, 3);
+	check_index((dom_element *[]) { r[2], r[1], r[5] }, 3);
+	check_section((dom_element *[]) { r[0], r[4] }, 2);
+
+	/* And its rows, put in a new body, follow the others */
+	dom_node_unref(foot);
+	foot = element("tbody");
+	append(table, foot);
+	append(foot, r[4]);
+	append(foot, r[0]);
+	check_rows(table, (dom_element *[]) { r[1], r[5], r[2], r[4], r[0] },
+			5);
+	check_index((dom_element *[]) { r[2], r[1], r[5], r[4], r[0] }, 5);
+	check_section((dom_element *[]) { r[4], r[0] }, 2);
+
+	for (i = 0; i < 6; i++)
+		dom_node_unref(r[i]);
+	dom_node_unref(b2);
+	dom_node_unref(b1);
+	dom_node_unref(foot);
+	dom_node_unref(head);
+	dom_node_unref(table);
+}
+
+/* Cells moved within and between rows, and rows moved with their cells */
+static void test_cells(dom_element *body)
+{
+	dom_element *table = element("table"), *tbody = element("tbody");
+	dom_element *r1 = element("tr"), *r2 = element("tr");
+	dom_element *c[5], *inner, *row, *cell;
+	int i;
+
+	append(body, table);
+	append(table, tbody);
+	append(tbody, r1);
+	append(tbody, r2);
+
+	c[0] = element("td");
+	c[1] = element("th");
+	c[2] = element("td");
+	c[3] = element("td");
+	c[4] = element("td");
+	for (i = 0; i < 3; i++)
+		append(r1, c[i]);
+	append(r2, c[3]);
+	append(r2, c[4]);
+
+	check_cells(c, 3);
+	check_cells(c + 3, 2);
+
+	/* A cell moved to the front of another row */
+	insert_before(r2, c[1], c[3]);
+	check_cells((dom_element *[]) { c[0], c[2] }, 2);
+	check_cells((dom_element *[]) { c[1], c[3], c[4] }, 3);
+
+	/* Moving a row to another section leaves its cells' numbers */
+	remove_child(tbody, r1);
+	check_cells((dom_element *[]) { c[0], c[2] }, 2);
+	append(tbody, r1);
+	check_cells((dom_element *[]) { c[0], c[2] }, 2);
+
+	/* Cells of a table nested in a cell are not counted */
+	inner = element("table");
+	row = element("tr");
+	cell = element("td");
+	append(c[0], inner);
+	append(inner, row);
+	append(row, cell);
+	check_cells((dom_element *[]) { c[0], c[2] }, 2);
+	check_cells(&cell, 1);
+
+	/* Removing a cell renumbers those after it */
+	remove_child(r2, c[3]);
+	check_cells((dom_element *[]) { c[1], c[4] }, 2);
+	append(r2, c[3]);
+	check_cells((dom_element *[]) { c[1], c[4], c[3] }, 3);
+
+	dom_node_unref(cell);
+	dom_node_unref(row);
+	dom_node_unref(inner);
+	for (i = 0; i < 5; i++)
+		dom_node_unref(c[i]);
+	dom_node_unref(r2);
+	dom_node_unref(r1);
+	dom_node_unref(tbody);
+	dom_node_unref(table);
+}
+
+int main(int argc, char **argv)
+{
+	dom_element *html, *body;
+
+	UNUSED(argc);
+	UNUSED(argv);
+
+	assert(dom_implementation_create_document(DOM_IMPLEMENTATION_HTML,
+			NULL, "html", NULL, NULL, NULL, &doc) == DOM_NO_ERR);
+	assert(dom_document_get_document_element(doc, &html) == DOM_NO_ERR);
+
+	body = element("body");
+	append(html, body);
+
+	test_rows(body);
+	test_cells(body);
+
+	dom_node_unref(body);
+	dom_node_unref(html);
+	dom_node_unref(doc);
+
+	printf("PASS\n");
+
+	return 0;
+}
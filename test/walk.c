@@ -0,0 +1,290 @@
+/*
+ * This file is part of libdom test suite.
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <dom/dom.h>
+#include <dom/core/walk.h>
+
+#include <domts.h>
+
+#define MAX_ELEMENTS 32
+
+static dom_element *elements[MAX_ELEMENTS];
+static int n_elements;
+
+static dom_string *string(const char *s)
+{
+	dom_string *str;
+
+	assert(dom_string_create((const uint8_t *) s, strlen(s), &str) ==
+			DOM_NO_ERR);
+
+	return str;
+}
+
+static void set_attribute(dom_element *e, const char *name, const char *value)
+{
+	dom_string *n = string(name), *v = string(value);
+
+	assert(dom_element_set_attribute(e, n, v) == DOM_NO_ERR);
+	dom_string_unref(n);
+	dom_string_unref(v);
+}
+
+/* Append an element, with an id and optionally classes, to a parent */
+static dom_element *add(dom_document *doc, void *parent, const char *name,
+		const char *id, const char *class)
+{
+	dom_string *str = string(name);
+	dom_element *e;
+	dom_node *result;
+
+	assert(dom_document_create_element(doc, str, &e) == DOM_NO_ERR);
+	dom_string_unref(str);
+
+	set_attribute(e, "id", id);
+	if (class != NULL)
+		set_attribute(e, "class", class);
+
+	assert(dom_node_append_child(parent, e, &result) == DOM_NO_ERR);
+	dom_node_unref(result);
+
+	assert(n_elements < MAX_ELEMENTS);
+	elements[n_elements++] = e;
+
+	return e;
+}
+
+static bool may_have(dom_walk *walk, dom_walk_key key, const char *data,
+		size_t len)
+{
+	return dom_walk_ancestors_may_have(walk, key,
+			dom_walk_hash(key, (const uint8_t *) data, len));
+}
+
+/* Append an element's id to a string */
+static void append_id(dom_element *e, char *ids, size_t size)
+{
+	dom_string *id = string("id"), *value;
+
+	assert(dom_element_get_attribute(e, id, &value) == DOM_NO_ERR);
+	assert(value != NULL);
+
+	if (ids[0] != '\0')
+		strncat(ids, " ", size - strlen(ids) - 1);
+	strncat(ids, dom_string_data(value),
+			min(dom_string_byte_length(value),
+			size - strlen(ids) - 1));
+
+	dom_string_unref(value);
+	dom_string_unref(id);
+}
+
+/* Check the ids of the elements walked below a node, skipping the
+ * children of the element with id skip */
+static void check_order(void *root, const char *skip, const char *expected)
+{
+	dom_walk *walk;
+	dom_element *e;
+	char ids[256] = "";
+	size_t len;
+
+	assert(dom_walk_create(root, &walk) == DOM_NO_ERR);
+
+	while (dom_walk_next(walk, &e) == DOM_NO_ERR && e != NULL) {
+		len = strlen(ids);
+		append_id(e, ids, sizeof(ids));
+
+		if (skip != NULL && strcmp(ids + len + (len > 0), skip) == 0)
+			dom_walk_skip_children(walk);
+	}
+
+	if (strcmp(ids, expected) != 0)
+		printf("walked '%s', not '%s'\n", ids, expected);
+	assert(strcmp(ids, expected) == 0);
+
+	/* A finished walk stays finished */
+	assert(dom_walk_next(walk, &e) == DOM_NO_ERR);
+	assert(e == NULL);
+
+	dom_walk_destroy(walk);
+}
+
+/* Check the filter has each key of each kind tested of every ancestor of
+ * an element, including those above the root of the walk */
+static void check_ancestors(dom_walk *walk, dom_element *e, bool names,
+		bool ids, bool classes)
+{
+	dom_string *id = string("id"), *class = string("class");
+	dom_node *node, *parent;
+
+	assert(dom_node_get_parent_node(e, &node) == DOM_NO_ERR);
+
+	while (node != NULL) {
+		dom_node_type type;
+		dom_string *value;
+		const char *s;
+		size_t len;
+
+		assert(dom_node_get_node_type(node, &type) == DOM_NO_ERR);
+		if (type != DOM_ELEMENT_NODE)
+			goto next;
+
+		assert(dom_node_get_node_name(node, &value) == DOM_NO_ERR);
+		if (names)
+			assert(may_have(walk, DOM_WALK_KEY_NAME,
+					dom_string_data(value),
+					dom_string_byte_length(value)));
+		dom_string_unref(value);
+
+		assert(dom_element_get_attribute(node, id, &value) ==
+				DOM_NO_ERR);
+		if (ids && value != NULL)
+			assert(may_have(walk, DOM_WALK_KEY_ID,
+					dom_string_data(value),
+					dom_string_byte_length(value)));
+		if (value != NULL)
+			dom_string_unref(value);
+
+		assert(dom_element_get_attribute(node, class, &value) ==
+				DOM_NO_ERR);
+		if (classes && value != NULL) {
+			s = dom_string_data(value);
+			while (*s != '\0') {
+				len = strcspn(s, " ");
+				if (len > 0)
+					assert(may_have(walk,
+							DOM_WALK_KEY_CLASS,
+							s, len));
+				s += len + (s[len] == ' ');
+			}
+		}
+		if (value != NULL)
+			dom_string_unref(value);
+
+next:
+		assert(dom_node_get_parent_node(node, &parent) == DOM_NO_ERR);
+		dom_node_unref(node);
+		node = parent;
+	}
+
+	dom_string_unref(class);
+	dom_string_unref(id);
+}
+
+/* Walk below a node, testing the filter at every step'th element.  Names
+ * are tested from the start, IDs and classes only from later elements,
+ * so their keys are added to the filter part way through the walk */
+static void check_filter(void *root, int step, int first_id,
+		int first_class)
+{
+	dom_walk *walk;
+	dom_element *e;
+	int i = 0;
+
+	assert(dom_walk_create(root, &walk) == DOM_NO_ERR);
+
+	while (dom_walk_next(walk, &e) == DOM_NO_ERR && e != NULL) {
+		if (i % step == 0)
+			check_ancestors(walk, e, true, i >= first_id,
+					i >= first_class);
+		i++;
+	}
+
+	dom_walk_destroy(walk);
+}
+
+int main(int argc, char **argv)
+{
+	dom_document *doc;
+	dom_element *html, *body, *d1, *d2, *p1, *s1, *e1, *ul, *l2, *ol;
+	dom_walk *walk;
+	dom_element *e;
+	int step, first;
+
+	UNUSED(argc);
+	UNUSED(argv);
+
+	assert(dom_implementation_create_document(DOM_IMPLEMENTATION_XML,
+			NULL, "html", NULL, NULL, NULL, &doc) == DOM_NO_ERR);
+	assert(dom_document_get_document_element(doc, &html) == DOM_NO_ERR);
+	set_attribute(html, "id", "h");
+	set_attribute(html, "class", "top");
+
+	body = add(doc, html, "body", "b", NULL);
+	d1 = add(doc, body, "div", "d1", "a b");
+	p1 = add(doc, d1, "p", "p1", "x");
+	s1 = add(doc, p1, "span", "s1", "y  z");
+	e1 = add(doc, s1, "em", "e1", NULL);
+	add(doc, d1, "p", "p2", NULL);
+	d2 = add(doc, body, "div", "d2", "B c");
+	add(doc, d2, "em", "e2", NULL);
+	ul = add(doc, body, "ul", "u", NULL);
+	add(doc, ul, "li", "l1", NULL);
+	l2 = add(doc, ul, "li", "l2", "a");
+	ol = add(doc, l2, "ol", "o", NULL);
+	add(doc, ol, "li", "l4", NULL);
+	add(doc, ul, "li", "l3", NULL);
+
+	/* Walks visit elements below their root in document order */
+	check_order(doc, NULL, "h b d1 p1 s1 e1 p2 d2 e2 u l1 l2 o l4 l3");
+	check_order(html, NULL, "b d1 p1 s1 e1 p2 d2 e2 u l1 l2 o l4 l3");
+	check_order(d1, NULL, "p1 s1 e1 p2");
+	check_order(l2, NULL, "o l4");
+	check_order(e1, NULL, "");
+	check_order(html, "d1", "b d1 d2 e2 u l1 l2 o l4 l3");
+	check_order(html, "p1", "b d1 p1 p2 d2 e2 u l1 l2 o l4 l3");
+	check_order(html, "b", "b");
+	check_order(d1, "p2", "p1 s1 e1 p2");
+
+	/* The filter never misses a key of an ancestor */
+	for (step = 1; step <= 3; step++) {
+		for (first = 0; first < 8; first += 3) {
+			check_filter(doc, step, first, first + 2);
+			check_filter(html, step, first, first + 2);
+			check_filter(d1, step, first, first);
+			check_filter(ul, step, first + 1, first);
+		}
+	}
+
+	/* The filter excludes keys no ancestor has */
+	assert(dom_walk_create((dom_node *) body, &walk) == DOM_NO_ERR);
+	do {
+		assert(dom_walk_next(walk, &e) == DOM_NO_ERR);
+	} while (e != e1);
+	assert(may_have(walk, DOM_WALK_KEY_NAME, "SPAN", 4));
+	assert(may_have(walk, DOM_WALK_KEY_CLASS, "z", 1));
+	assert(may_have(walk, DOM_WALK_KEY_ID, "h", 1));
+	assert(may_have(walk, DOM_WALK_KEY_NAME, "em", 2) == false);
+	assert(may_have(walk, DOM_WALK_KEY_NAME, "ul", 2) == false);
+	assert(may_have(walk, DOM_WALK_KEY_ID, "d2", 2) == false);
+	assert(may_have(walk, DOM_WALK_KEY_CLASS, "div", 3) == false);
+	while (dom_walk_next(walk, &e) == DOM_NO_ERR && e != ol)
+		;
+	assert(may_have(walk, DOM_WALK_KEY_ID, "l2", 2));
+	assert(may_have(walk, DOM_WALK_KEY_ID, "d1", 2) == false);
+	assert(may_have(walk, DOM_WALK_KEY_NAME, "span", 4) == false);
+	assert(may_have(walk, DOM_WALK_KEY_CLASS, "z", 1) == false);
+	dom_walk_destroy(walk);
+
+	/* A walk ends when the tree changes */
+	assert(dom_walk_create((dom_node *) html, &walk) == DOM_NO_ERR);
+	assert(dom_walk_next(walk, &e) == DOM_NO_ERR);
+	add(doc, d2, "x", "x", NULL);
+	assert(dom_walk_next(walk, &e) == DOM_INVALID_STATE_ERR);
+	dom_walk_destroy(walk);
+
+	while (n_elements > 0)
+		dom_node_unref(elements[--n_elements]);
+	dom_node_unref(html);
+	dom_node_unref(doc);
+
+	printf("PASS\n");
+
+	return 0;
+}